@@ -1,17 +1,117 @@
 // Hit information, aka ray payload
-// This sample only carries a shading color and hit distance.
+// Carries the surface colour, hit distance, normal and instance index (normal.w) back to the path loop in RayGen.
+// On a miss the colour is the sky and the distance is negative.
 // Note that the payload should be kept as small as possible,
 // and that its size must be declared in the corresponding
 // D3D12_RAYTRACING_SHADER_CONFIG pipeline subobjet.
 struct HitInfo
 {
   float4 colorAndDistance;
-  uint depth;
+  float4 normal;
 };
 
+// Reflections followed after the primary hit, CpuRenderer::MaxBounces must match
+#define MAX_BOUNCES 30
+#define RAY_EPSILON 0.0000001f
+#define RAY_TMAX 100000
+
 // Attributes output by the raytracing when hitting a surface,
 // here the barycentric coordinates
 struct Attributes
 {
   float2 bary;
 };
+
+// PCG hash, mirrored in CpuMath.h so the CPU reference draws the same random numbers
+uint PcgHash(uint value)
+{
+	uint state = value * 747796405u + 2891336453u;
+	uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+float RandomFloat(inout uint state)
+{
+	state = PcgHash(state);
+	return float(state >> 8) * (1.0f / 16777216.0f);
+}
+
+uint RandomSeed(uint x, uint y, uint sampleIndex)
+{
+	return PcgHash(x + PcgHash(y + PcgHash(sampleIndex)));
+}
+
+// Adaptive sampling, mirrored in AdaptiveSampling.h
+#define ADAPTIVE_TILE_SIZE 16
+#define ADAPTIVE_ERROR_FLOOR 0.1f
+
+float Luminance(float3 color)
+{
+	return dot(color, float3(0.2126f, 0.7152f, 0.0722f));
+}
+
+// Standard error of the pixel's mean luminance relative to that mean.
+// sum holds the rgb sum and the sample count, luminanceSquares the sum of the squared sample luminances.
+float PixelError(float4 sum, float luminanceSquares)
+{
+	if (sum.w < 2.0f)
+		return asfloat(0x7F800000); // +infinity
+	float mean = Luminance(sum.rgb) / sum.w;
+	float variance = max(0.0f, (luminanceSquares - sum.w * mean * mean) / (sum.w - 1.0f));
+	return sqrt(variance / sum.w) / (mean + ADAPTIVE_ERROR_FLOOR);
+}
+
+// Temporal reprojection, mirrored in TemporalReprojection.h
+#define TEMPORAL_MAX_HISTORY 8.0f
+#define TEMPORAL_DEPTH_TOLERANCE 0.05f
+#define TEMPORAL_NORMAL_THRESHOLD 0.9f
+#define TEMPORAL_NO_MOTION 1.0e9f
+#define TEMPORAL_MIN_WEIGHT 0.01f
+#define TEMPORAL_PRIOR_KEEP 0
+#define TEMPORAL_PRIOR_REPROJECT 1
+#define TEMPORAL_PRIOR_CLEAR 2
+
+// current is a normal and hit distance of this frame, history one stored where the motion vector lands.
+// The sky has a zero normal and the maximum distance in both.
+bool IsHistoryCompatible(float4 current, float expectedDepth, float4 history)
+{
+	return abs(history.w - expectedDepth) <= TEMPORAL_DEPTH_TOLERANCE * expectedDepth
+		&& dot(current.xyz, history.xyz) >= TEMPORAL_NORMAL_THRESHOLD * dot(current.xyz, current.xyz);
+}
+
+// Interleaved ray dispatch, mirrored in InterleavedSampling.h
+#define INTERLEAVE_FULL 0
+#define INTERLEAVE_CHECKERBOARD 1
+#define INTERLEAVE_QUARTER 2
+
+uint GetInterleavePhaseCount(uint mode)
+{
+	return mode == INTERLEAVE_QUARTER ? 4 : mode == INTERLEAVE_CHECKERBOARD ? 2 : 1;
+}
+
+// Quarter mode visits the 2x2 block diagonally first, so two frames already give a checkerboard
+uint GetPixelPattern(uint mode, uint2 pixel)
+{
+	if (mode == INTERLEAVE_CHECKERBOARD)
+		return (pixel.x + pixel.y) & 1;
+	if (mode == INTERLEAVE_QUARTER)
+		return (0x1320u >> ((((pixel.y & 1) << 1) | (pixel.x & 1)) * 4)) & 0xF;
+	return 0;
+}
+
+// Pixel traced by a launch index in a frame with the given pattern, may lie past the right or bottom edge
+uint2 GetInterleavedPixel(uint mode, uint pattern, uint2 launchIndex)
+{
+	if (mode == INTERLEAVE_CHECKERBOARD)
+		return uint2(launchIndex.x * 2 + ((launchIndex.y + pattern) & 1), launchIndex.y);
+	if (mode == INTERLEAVE_QUARTER)
+		return launchIndex * 2 + uint2((0x6u >> pattern) & 1, (0xAu >> pattern) & 1);
+	return launchIndex;
+}
+
+// Sample index of the accumulation at which the pixel is traced first after a restart, sequence is the restart count
+uint GetFirstSample(uint mode, uint2 pixel, uint sequence)
+{
+	uint phaseCount = GetInterleavePhaseCount(mode);
+	return (GetPixelPattern(mode, pixel) + phaseCount - sequence % phaseCount) % phaseCount;
+}
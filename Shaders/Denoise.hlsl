@@ -0,0 +1,83 @@
+// One iteration of the edge-avoiding à-trous wavelet filter, CpuDenoiser is the reference implementation.
+// The first iteration reads the accumulation target directly, so every input stores the rgb sum and the sample count.
+
+struct DenoiseConstants
+{
+	uint stepWidth;
+	float invColorPhi;
+	float invNormalPhi;
+	float invDepthPhi;
+	float invAlbedoPhi;
+	uint writeOutput; // set on the last iteration
+	uint width; // render resolution, the textures may be larger
+	uint height;
+};
+
+ConstantBuffer<DenoiseConstants> constants : register(b0);
+
+// Colour to filter, rgb sum and sample count
+RWTexture2D< float4 > Input : register(u0);
+// Primary hit world normal and distance, written by RayGen
+RWTexture2D< float4 > NormalDepth : register(u1);
+// Primary hit surface colour, written by RayGen
+RWTexture2D< float4 > Albedo : register(u2);
+// Filtered colour with a count of 1, the next iteration's input
+RWTexture2D< float4 > Result : register(u3);
+// Displayed image, only written by the last iteration
+RWTexture2D< float4 > Output : register(u4);
+
+// B3 spline, h(0), h(+-1), h(+-2)
+static const float Kernel[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+// Taps weighted below e^-DENOISE_MAX_EXPONENT are dropped, like CpuDenoiser does to avoid denormals
+#define DENOISE_MAX_EXPONENT 60.0f
+
+float3 LoadColor(int2 pixel)
+{
+	float4 sum = Input[pixel];
+	return sum.w > 0.0f ? sum.rgb / sum.w : float3(0.0f, 0.0f, 0.0f);
+}
+
+[numthreads(8, 8, 1)]
+void Denoise(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+	uint width = constants.width;
+	uint height = constants.height;
+	int2 pixel = int2(dispatchThreadId.xy);
+	if (pixel.x >= (int)width || pixel.y >= (int)height)
+		return;
+
+	float3 color = LoadColor(pixel);
+	float4 normalDepth = NormalDepth[pixel];
+	float3 albedo = Albedo[pixel].rgb;
+	float3 sum = float3(0.0f, 0.0f, 0.0f);
+	float weightSum = 0.0f;
+	for (int dy = -2; dy <= 2; dy++)
+	{
+		for (int dx = -2; dx <= 2; dx++)
+		{
+			int2 tap = pixel + int2(dx, dy) * (int)constants.stepWidth;
+			if (tap.x < 0 || tap.y < 0 || tap.x >= (int)width || tap.y >= (int)height)
+				continue;
+			float3 tapColor = LoadColor(tap);
+			float4 tapNormalDepth = NormalDepth[tap];
+			float3 colorDelta = tapColor - color;
+			float3 normalDelta = tapNormalDepth.xyz - normalDepth.xyz;
+			float3 albedoDelta = Albedo[tap].rgb - albedo;
+			float exponent = dot(colorDelta, colorDelta) * constants.invColorPhi
+				+ dot(normalDelta, normalDelta) * constants.invNormalPhi
+				+ abs(tapNormalDepth.w - normalDepth.w) * constants.invDepthPhi
+				+ dot(albedoDelta, albedoDelta) * constants.invAlbedoPhi;
+			if (exponent >= DENOISE_MAX_EXPONENT)
+				continue;
+			float weight = Kernel[abs(dx)] * Kernel[abs(dy)] * exp(-exponent);
+			sum += tapColor * weight;
+			weightSum += weight;
+		}
+	}
+	float3 filtered = sum / max(weightSum, 1e-20f);
+	Result[pixel] = float4(filtered, 1.0f);
+	if (constants.writeOutput)
+	{
+		Output[pixel] = float4(filtered, 1.0f);
+	}
+}
@@ -3,8 +3,8 @@
 [shader("miss")]
 void Miss(inout HitInfo payload : SV_RayPayload)
 {
-    // Find out how to get ray direction
+    // Sky gradient from the ray direction, a negative distance ends the path
     float3 color = (WorldRayDirection() + 1.0f) / 2.0f;
-    payload.colorAndDistance = float4(color, 100000);
-
-}
\ No newline at end of file
+    payload.colorAndDistance = float4(color, -1.0f);
+    payload.normal = float4(0.0f, 0.0f, 0.0f, 0.0f);
+}
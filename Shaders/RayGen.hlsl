@@ -3,6 +3,19 @@
 // Raytracing output texture, accessed as a UAV
 RWTexture2D< float4 > Output : register(u0);
 
+// Running per-pixel sums of every sample since the last reset, w holds the sample count
+RWTexture2D< float4 > Accumulation : register(u1);
+
+// Running per-pixel sums of the squared luminance of every sample, for the variance estimate
+RWTexture2D< float > AccumulationLuminanceSquares : register(u3);
+
+// Denoiser guides from the primary ray of the latest sample: world normal and hit distance, and surface colour
+RWTexture2D< float4 > NormalDepth : register(u5);
+RWTexture2D< float4 > Albedo : register(u6);
+
+// Offset in pixels to where the latest sample's primary hit was in the previous frame, and its distance there
+RWTexture2D< float4 > Motion : register(u7);
+
 // Raytracing acceleration structure, accessed as a SRV
 RaytracingAccelerationStructure Scene : register(t0);
 
@@ -14,33 +27,179 @@ struct Camera
 	float4 up;
 };
 
-StructuredBuffer<Camera> cam : register (t1, space0);
+// Per-frame camera constants, bound by address from the upload ring
+ConstantBuffer<Camera> camera : register(b0);
+// The camera of the previous frame, for the motion vectors
+ConstantBuffer<Camera> previousCamera : register(b2);
+
+// Per instance, from this frame's world space to the previous frame's, rows of a 3x4 matrix
+struct MotionTransform
+{
+	float4 rows[3];
+};
+
+StructuredBuffer<MotionTransform> instanceMotion : register(t3);
+
+struct FrameConstants
+{
+	uint sampleIndex; // 0 restarts accumulation
+	uint rouletteStartBounce; // bounces always followed before Russian roulette may end a path
+	uint adaptiveMinSamples; // samples every pixel receives before converged tiles are skipped
+	float adaptiveThreshold; // relative error below which a tile stops sampling
+	uint randomSequence; // restarts so far, every accumulation draws from new random streams
+	uint jitterFirstSample; // set for temporal reuse, which needs the first samples at new positions
+	uint interleaveMode; // INTERLEAVE_FULL, _CHECKERBOARD or _QUARTER
+	uint renderWidth; // dynamic resolution renders into the top left corner of the textures
+	uint renderHeight;
+};
+
+// Root constants, set once per dispatch
+ConstantBuffer<FrameConstants> frame : register(b1);
+
+// Running totals of paths and rays traced, bound as a root UAV and read back by RayStatistics
+RWByteAddressBuffer rayCounters : register(u2);
+
+// Three rotating buffers of one flag per tile, set while a tile still has a pixel above the error threshold
+RWByteAddressBuffer tileFlags : register(u4);
+
+// Inverse of the primary ray direction: where a ray from the camera position crosses the image, in pixels.
+// Forward, right and up are orthogonal, so each image coordinate is a projection onto one of them.
+bool ProjectDirection(float3 direction, float3 forward, float3 right, float3 up, float2 dims, out float2 pixel)
+{
+	float depth = dot(direction, forward) / dot(forward, forward);
+	float2 d = float2(dot(direction, right) / dot(right, right), dot(direction, up) / dot(up, up)) / depth;
+	pixel = (d + 1.0f) * 0.5f * dims;
+	return depth > 0.0f;
+}
 
 [shader("raygeneration")]
 void RayGen()
 {
-	// Initialize the ray payload
-	HitInfo payload;
-	payload.colorAndDistance = float4(0.0, 0.0, 0.0, -1);
-	payload.depth = 0;
+	// The interleaved modes launch fewer threads than there are pixels, each traces one pixel of the frame's pattern
+	uint2 imageSize = uint2(frame.renderWidth, frame.renderHeight);
+	float2 dims = float2(imageSize);
+	uint phaseCount = GetInterleavePhaseCount(frame.interleaveMode);
+	uint2 launchIndex = GetInterleavedPixel(frame.interleaveMode, (frame.sampleIndex + frame.randomSequence) % phaseCount, DispatchRaysIndex().xy);
+	// A pixel is traced every phaseCount frames, this is its own sample index
+	uint pixelSample = frame.sampleIndex / phaseCount;
+
+	// Frame s reads the flags raised in frame s - 1, raises those for frame s + 1 and clears the buffer
+	// frame s + 1 raises, so the buffers are only trusted from adaptiveMinSamples >= 2 on.
+	// The tile is cleared by the first launch index in it, which lies in the tile in every mode even past the edge
+	uint2 tileCount = (imageSize + ADAPTIVE_TILE_SIZE - 1) / ADAPTIVE_TILE_SIZE;
+	uint2 tile = launchIndex / ADAPTIVE_TILE_SIZE;
+	uint tileOffset = (tile.y * tileCount.x + tile.x) * 4;
+	uint tileBufferSize = tileCount.x * tileCount.y * 4;
+	uint2 launchesPerTile = ADAPTIVE_TILE_SIZE / uint2(frame.interleaveMode == INTERLEAVE_FULL ? 1 : 2, frame.interleaveMode == INTERLEAVE_QUARTER ? 2 : 1);
+	if (all(DispatchRaysIndex().xy % launchesPerTile == 0))
+	{
+		tileFlags.Store(((frame.sampleIndex + 2) % 3) * tileBufferSize + tileOffset, 0);
+	}
+	if (any(launchIndex >= imageSize))
+		return;
+	if (frame.sampleIndex >= frame.adaptiveMinSamples && tileFlags.Load((frame.sampleIndex % 3) * tileBufferSize + tileOffset) == 0)
+		return;
 
-	uint2 launchIndex = DispatchRaysIndex().xy;
-	float2 dims = float2(DispatchRaysDimensions().xy);
-	float2 d = (((launchIndex.xy + 0.5f) / dims.xy) * 2.f - 1.f);
+	// The first sample goes through the pixel centre unless temporal reuse wants it jittered, later ones are jittered
+	uint seed = RandomSeed(launchIndex.x, launchIndex.y, frame.sampleIndex + (frame.randomSequence << 16));
+	float2 jitter = float2(0.5f, 0.5f);
+	if (pixelSample > 0 || frame.jitterFirstSample)
+	{
+		jitter.x = RandomFloat(seed);
+		jitter.y = RandomFloat(seed);
+	}
+	float2 d = (((launchIndex.xy + jitter) / dims.xy) * 2.f - 1.f);
 
 	// Get the location within the dispatched 2D grid of work items
 	// (often maps to pixels, so this could represent a pixel coordinate).
 
-	float3 up = cam[0].up.xyz * d.y;
-	float3 right = cam[0].right.xyz * d.x;
+	float3 up = camera.up.xyz * d.y;
+	float3 right = camera.right.xyz * d.x;
 	RayDesc ray;
-	ray.Origin = cam[0].position.xyz;
+	ray.Origin = camera.position.xyz;
 	ray.TMin = 0;
-	ray.Direction = normalize(cam[0].forward.xyz + up + right);
-	ray.TMax = 100000;
+	ray.Direction = normalize(camera.forward.xyz + up + right);
+	ray.TMax = RAY_TMAX;
+
+	// Follow the reflections here instead of recursing from ClosestHit, so the pipeline only needs a trace depth of 1.
+	// A path still hitting geometry after the last bounce contributes nothing, like the recursion limit did.
+	float3 throughput = float3(1.0f, 1.0f, 1.0f);
+	float3 radiance = float3(0.0f, 0.0f, 0.0f);
+	uint rays = 0;
+	float4 primaryNormalDepth = float4(0.0f, 0.0f, 0.0f, RAY_TMAX);
+	float4 primaryAlbedo = float4(0.0f, 0.0f, 0.0f, 1.0f);
+	float4 motion = float4(TEMPORAL_NO_MOTION, TEMPORAL_NO_MOTION, 0.0f, 0.0f);
+	for (uint bounce = 0; bounce <= MAX_BOUNCES; bounce++)
+	{
+		HitInfo payload;
+		TraceRay(Scene, RAY_FLAG_NONE, 0xFF, 0, 0, 0, ray, payload);
+		rays++;
+		if (bounce == 0)
+		{
+			// The sky has no normal and lies at the far end of the ray
+			bool sky = payload.colorAndDistance.w < 0.0f;
+			primaryNormalDepth = sky ? float4(0.0f, 0.0f, 0.0f, RAY_TMAX) : float4(payload.normal.xyz, payload.colorAndDistance.w);
+			primaryAlbedo = float4(payload.colorAndDistance.rgb, 1.0f);
+
+			// The sky moves with the camera's rotation only, surfaces are carried back by their instance's motion
+			float3 previousDirection = ray.Direction;
+			float previousDepth = RAY_TMAX;
+			if (!sky)
+			{
+				MotionTransform transform = instanceMotion[(uint)payload.normal.w];
+				float4 position = float4(ray.Origin + ray.Direction * payload.colorAndDistance.w, 1.0f);
+				previousDirection = float3(dot(transform.rows[0], position), dot(transform.rows[1], position), dot(transform.rows[2], position)) - previousCamera.position.xyz;
+				previousDepth = length(previousDirection);
+			}
+			float2 previousPixel;
+			if (ProjectDirection(previousDirection, previousCamera.forward.xyz, previousCamera.right.xyz, previousCamera.up.xyz, dims, previousPixel))
+			{
+				motion = float4(previousPixel - (launchIndex + jitter), previousDepth, 0.0f);
+			}
+		}
+		if (payload.colorAndDistance.w < 0.0f)
+		{
+			radiance = throughput * payload.colorAndDistance.rgb;
+			break;
+		}
+		throughput *= payload.colorAndDistance.rgb;
+		// Russian roulette: continue with a probability equal to the path's remaining weight and boost survivors
+		// by its inverse, so the expected value is unchanged while dim paths stop after a few bounces
+		if (bounce >= frame.rouletteStartBounce)
+		{
+			float survival = min(1.0f, max(throughput.r, max(throughput.g, throughput.b)));
+			if (RandomFloat(seed) >= survival)
+				break;
+			throughput /= survival;
+		}
+		float3 normal = payload.normal.xyz;
+		ray.Origin = ray.Origin + (normal * RAY_EPSILON * 10.0f) + (ray.Direction * payload.colorAndDistance.w);
+		ray.Direction = reflect(ray.Direction, normal);
+		ray.TMin = RAY_EPSILON;
+	}
+
+	// One atomic per wave instead of per pixel
+	uint waveRays = WaveActiveSum(rays);
+	uint wavePaths = WaveActiveCountBits(true);
+	if (WaveIsFirstLane())
+	{
+		rayCounters.InterlockedAdd(0, wavePaths);
+		rayCounters.InterlockedAdd(4, waveRays);
+	}
 
-	// Trace the ray
-	TraceRay(Scene, RAY_FLAG_NONE, 0xFF, 0, 0, 0, ray, payload);
+	float4 sum = pixelSample > 0 ? Accumulation[launchIndex] : float4(0.0f, 0.0f, 0.0f, 0.0f);
+	sum += float4(radiance, 1.0f);
+	Accumulation[launchIndex] = sum;
+	Output[launchIndex] = float4(sum.rgb / sum.w, 1.f);
+	NormalDepth[launchIndex] = primaryNormalDepth;
+	Albedo[launchIndex] = primaryAlbedo;
+	Motion[launchIndex] = motion;
 
-	Output[launchIndex] = float4(payload.colorAndDistance.rgb, 1.f);
+	float luminance = Luminance(radiance);
+	float luminanceSquares = (pixelSample > 0 ? AccumulationLuminanceSquares[launchIndex] : 0.0f) + luminance * luminance;
+	AccumulationLuminanceSquares[launchIndex] = luminanceSquares;
+	if (PixelError(sum, luminanceSquares) > frame.adaptiveThreshold)
+	{
+		tileFlags.Store(((frame.sampleIndex + 1) % 3) * tileBufferSize + tileOffset, 1);
+	}
 }
@@ -0,0 +1,92 @@
+#include "Common.hlsl"
+
+// Fills the pixels an interleaved frame has not traced since the restart, CpuReconstruction is the reference
+// implementation. Runs after the ray dispatch while some pixels are still without a sample.
+
+struct ReconstructConstants
+{
+	uint interleaveMode; // INTERLEAVE_CHECKERBOARD or _QUARTER
+	uint sampleIndex;
+	uint randomSequence; // restart count, selects the pattern of the first frame
+	uint width; // render resolution, the textures may be larger
+	uint height;
+};
+
+ConstantBuffer<ReconstructConstants> constants : register(b0);
+
+// Written in place by RayGen's layout: rgb sum and sample count, and the guides of the primary hit
+RWTexture2D< float4 > Accumulation : register(u0);
+RWTexture2D< float4 > NormalDepth : register(u1);
+RWTexture2D< float4 > Albedo : register(u2);
+RWTexture2D< float4 > Motion : register(u3);
+RWTexture2D< float4 > Output : register(u4);
+
+bool IsTraced(int2 pixel, int2 size)
+{
+	return all(pixel >= 0) && all(pixel < size) && GetFirstSample(constants.interleaveMode, uint2(pixel), constants.randomSequence) <= constants.sampleIndex;
+}
+
+// Averages the pair of traced neighbours closest in luminance, so edges are followed instead of blurred. Where no
+// pair is complete, at the image border, it averages whatever neighbours are traced. The guides are copied from
+// one of the neighbours used and the colour counts as one sample, replaced once the pixel is traced.
+// Only untraced pixels are written and only traced ones read, so the pass works in place.
+[numthreads(8, 8, 1)]
+void Reconstruct(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+	int2 size = int2(constants.width, constants.height);
+	int2 pixel = int2(dispatchThreadId.xy);
+	if (any(pixel >= size) || IsTraced(pixel, size))
+		return;
+
+	// Opposite neighbours: horizontal, vertical and the two diagonals
+	const int4 pairs[4] = { int4(-1, 0, 1, 0), int4(0, -1, 0, 1), int4(-1, -1, 1, 1), int4(1, -1, -1, 1) };
+	float3 color = float3(0.0f, 0.0f, 0.0f);
+	float count = 0.0f;
+	int2 source = pixel;
+	float bestDifference = asfloat(0x7F800000);
+	for (uint i = 0; i < 4; i++)
+	{
+		int2 a = pixel + pairs[i].xy;
+		int2 b = pixel + pairs[i].zw;
+		if (!IsTraced(a, size) || !IsTraced(b, size))
+			continue;
+		float4 sumA = Accumulation[a];
+		float4 sumB = Accumulation[b];
+		float difference = abs(Luminance(sumA.rgb / sumA.w) - Luminance(sumB.rgb / sumB.w));
+		if (difference < bestDifference)
+		{
+			bestDifference = difference;
+			color = (sumA.rgb / sumA.w + sumB.rgb / sumB.w) * 0.5f;
+			count = 1.0f;
+			source = a;
+		}
+	}
+	if (count == 0.0f)
+	{
+		for (int dy = -1; dy <= 1; dy++)
+		{
+			for (int dx = -1; dx <= 1; dx++)
+			{
+				int2 neighbour = pixel + int2(dx, dy);
+				if (!IsTraced(neighbour, size))
+					continue;
+				float4 sum = Accumulation[neighbour];
+				color += sum.rgb / sum.w;
+				if (count == 0.0f)
+					source = neighbour;
+				count += 1.0f;
+			}
+		}
+	}
+	if (count == 0.0f)
+	{
+		Accumulation[pixel] = float4(0.0f, 0.0f, 0.0f, 0.0f);
+		return;
+	}
+	color /= count;
+	Accumulation[pixel] = float4(color, 1.0f);
+	NormalDepth[pixel] = NormalDepth[source];
+	Albedo[pixel] = Albedo[source];
+	Motion[pixel] = Motion[source];
+	Output[pixel] = float4(color, 1.0f);
+}
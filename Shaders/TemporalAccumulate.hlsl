@@ -0,0 +1,130 @@
+#include "Common.hlsl"
+
+// Temporal accumulation after the ray dispatch, CpuTemporalAccumulator is the reference implementation.
+// Adds a prior reprojected from the previous frame to the accumulation, see TemporalReprojection.h.
+// Colours are stored like the accumulation target: the rgb sum and the sample count.
+
+struct TemporalConstants
+{
+	uint priorMode; // TEMPORAL_PRIOR_KEEP, _REPROJECT or _CLEAR
+	uint width; // render resolution, the textures may be larger
+	uint height;
+};
+
+ConstantBuffer<TemporalConstants> constants : register(b0);
+
+// This frame's accumulation and primary hit normal and distance, written by RayGen
+RWTexture2D< float4 > Accumulation : register(u0);
+RWTexture2D< float4 > NormalDepth : register(u1);
+// Offset to the previous frame's position in pixels and the distance expected there, written by RayGen
+RWTexture2D< float4 > Motion : register(u2);
+// Taken over from the history when accumulation last restarted
+RWTexture2D< float4 > Prior : register(u3);
+// Last frame's result and its normal and distance
+RWTexture2D< float4 > History : register(u4);
+RWTexture2D< float4 > HistoryNormalDepth : register(u5);
+// This frame's result, the next frame's history
+RWTexture2D< float4 > Result : register(u6);
+RWTexture2D< float4 > ResultNormalDepth : register(u7);
+// Displayed image
+RWTexture2D< float4 > Output : register(u8);
+
+// Reflections do not follow the surface's motion, so the history colour is limited to the range of the current
+// samples around the pixel, which also catches disocclusions the geometry test lets through
+float3 ClampToNeighbourhood(int2 pixel, int2 size, float3 color)
+{
+	float3 minimum = asfloat(0x7F800000).xxx;
+	float3 maximum = -minimum;
+	for (int dy = -1; dy <= 1; dy++)
+	{
+		for (int dx = -1; dx <= 1; dx++)
+		{
+			int2 tap = pixel + int2(dx, dy);
+			if (any(tap < 0) || any(tap >= size))
+				continue;
+			float4 sum = Accumulation[tap];
+			if (sum.w <= 0.0f)
+				continue;
+			minimum = min(minimum, sum.rgb / sum.w);
+			maximum = max(maximum, sum.rgb / sum.w);
+		}
+	}
+	return clamp(color, minimum, maximum);
+}
+
+// History showing a surface that is still around the pixel, so silhouettes keep theirs
+bool IsSurfaceInNeighbourhood(int2 pixel, int2 size, float4 history)
+{
+	for (int dy = -1; dy <= 1; dy++)
+	{
+		for (int dx = -1; dx <= 1; dx++)
+		{
+			int2 tap = pixel + int2(dx, dy);
+			if (any(tap < 0) || any(tap >= size))
+				continue;
+			if (IsHistoryCompatible(NormalDepth[tap], Motion[tap].z, history))
+				return true;
+		}
+	}
+	return false;
+}
+
+// Bilinear fetch from last frame's result where the motion vector lands, without the taps showing a surface that is gone
+float4 Reproject(int2 pixel, int2 size)
+{
+	// Pixel centres sit at .5, so subtracting it gives the position on the grid of taps
+	float2 previous = float2(pixel) + Motion[pixel].xy;
+	if (any(previous <= -1.0f) || any(previous >= float2(size)))
+		return float4(0.0f, 0.0f, 0.0f, 0.0f);
+	int2 origin = int2(floor(previous));
+	float2 fraction = previous - float2(origin);
+	float3 color = float3(0.0f, 0.0f, 0.0f);
+	float count = 0.0f;
+	float weightSum = 0.0f;
+	for (int j = 0; j < 2; j++)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			int2 tap = origin + int2(i, j);
+			if (any(tap < 0) || any(tap >= size))
+				continue;
+			float4 sum = History[tap];
+			if (sum.w <= 0.0f || !IsSurfaceInNeighbourhood(pixel, size, HistoryNormalDepth[tap]))
+				continue;
+			float weight = (i ? fraction.x : 1.0f - fraction.x) * (j ? fraction.y : 1.0f - fraction.y);
+			color += sum.rgb * (weight / sum.w);
+			count += sum.w * weight;
+			weightSum += weight;
+		}
+	}
+	if (weightSum < TEMPORAL_MIN_WEIGHT)
+		return float4(0.0f, 0.0f, 0.0f, 0.0f);
+	color = ClampToNeighbourhood(pixel, size, color / weightSum);
+	count = min(count / weightSum, TEMPORAL_MAX_HISTORY);
+	return float4(color * count, count);
+}
+
+[numthreads(8, 8, 1)]
+void TemporalAccumulate(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+	int2 size = int2(constants.width, constants.height);
+	int2 pixel = int2(dispatchThreadId.xy);
+	if (any(pixel >= size))
+		return;
+
+	float4 prior = Prior[pixel];
+	if (constants.priorMode == TEMPORAL_PRIOR_REPROJECT)
+	{
+		prior = Reproject(pixel, size);
+		Prior[pixel] = prior;
+	}
+	else if (constants.priorMode == TEMPORAL_PRIOR_CLEAR)
+	{
+		prior = float4(0.0f, 0.0f, 0.0f, 0.0f);
+		Prior[pixel] = prior;
+	}
+	float4 total = prior + Accumulation[pixel];
+	Result[pixel] = total;
+	ResultNormalDepth[pixel] = NormalDepth[pixel];
+	Output[pixel] = float4(total.rgb / total.w, 1.0f);
+}
@@ -0,0 +1,35 @@
+// Stretches the rendered corner of the output texture over the whole display texture, which is then copied to the
+// back buffer. Bilinear, the render resolution changes too often for anything that needs history.
+
+struct UpscaleConstants
+{
+	uint renderWidth;
+	uint renderHeight;
+};
+
+ConstantBuffer<UpscaleConstants> constants : register(b0);
+
+// Image at render resolution in the top left corner
+RWTexture2D< float4 > Output : register(u0);
+// Back buffer sized
+RWTexture2D< float4 > Display : register(u1);
+
+[numthreads(8, 8, 1)]
+void Upscale(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+	uint width, height;
+	Display.GetDimensions(width, height);
+	if (dispatchThreadId.x >= width || dispatchThreadId.y >= height)
+		return;
+
+	// Pixel centres of both images line up at .5
+	int2 renderSize = int2(constants.renderWidth, constants.renderHeight);
+	float2 position = (float2(dispatchThreadId.xy) + 0.5f) * float2(renderSize) / float2(width, height) - 0.5f;
+	position = clamp(position, 0.0f, float2(renderSize - 1));
+	int2 origin = int2(floor(position));
+	int2 next = min(origin + 1, renderSize - 1);
+	float2 fraction = position - float2(origin);
+	float4 top = lerp(Output[origin], Output[int2(next.x, origin.y)], fraction.x);
+	float4 bottom = lerp(Output[int2(origin.x, next.y)], Output[next], fraction.x);
+	Display[dispatchThreadId.xy] = lerp(top, bottom, fraction.y);
+}
@@ -3,34 +3,63 @@
 #include "Heap.h"
 #include "MeshData.h"
 #include "DX12Utility.h"
+#include "Hash.h"
 
 using Microsoft::WRL::ComPtr;
 
-void SceneAccelerationStructure::Init(ID3D12Device11* device, HeapManager* heap)
+void SceneAccelerationStructure::Init(ID3D12Device11* device, HeapManager* heap, UploadRing* uploadRing)
 {
 	m_Device = device;
 	m_Heap = heap;
+	m_UploadRing = uploadRing;
+	m_ScratchPool.Create(device, heap, ScratchDefaultHeap, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+}
+
+// Scratch buffers go back to the pool once the frame that built with them has completed
+void SceneAccelerationStructure::BeginFrame(UINT64 completedFenceValue)
+{
+	m_ScratchPool.Retire(completedFenceValue);
+	while (!m_InFlightBLAS.empty() && m_InFlightBLAS.front().first <= completedFenceValue)
+	{
+		m_InFlightBLAS.pop_front();
+	}
+}
+
+// Every pending BLAS build must have been recorded into work submitted under this fence value
+void SceneAccelerationStructure::EndFrame(UINT64 fenceValue)
+{
+	m_ScratchPool.EndFrame(fenceValue);
+	if (!m_PendingBLAS.empty())
+	{
+		m_InFlightBLAS.emplace_back(fenceValue, std::move(m_PendingBLAS));
+		m_PendingBLAS.clear();
+	}
 }
 
 void SceneAccelerationStructure::Reset()
 {
 	m_InstanceDescs.clear();
-	m_Heap->ResetHeapOffset(TLASHeap);
 }
 
-void SceneAccelerationStructure::AddMesh(ID3D12GraphicsCommandList6* commandList, BLASIdentifier id, MeshData* mesh)
+// Uploads the mesh and allocates its BLAS; the build itself is recorded later through RecordPendingBuild
+void SceneAccelerationStructure::AddMesh(BLASIdentifier id, MeshData* mesh)
 {
-	Microsoft::WRL::ComPtr<ID3D12Resource2> blas;
-	BLAS_Generator blasgen(m_Device, m_Heap, mesh);
-	blasgen.Generate(commandList, blas);
-	BLAS[id] = blas;
+	std::unique_ptr<BLAS_Generator> blasgen = std::make_unique<BLAS_Generator>(m_Device, m_Heap, mesh);
+	blasgen->Prepare(&m_ScratchPool, BLAS[id]);
+	m_PendingBLAS.push_back(std::move(blasgen));
 }
 
-void SceneAccelerationStructure::AddInstance(BLASIdentifier id, DirectX::XMMATRIX* transform, UINT instanceID, UINT hitGroupIndex)
+// Safe to call concurrently for different indices
+void SceneAccelerationStructure::RecordPendingBuild(ID3D12GraphicsCommandList6* commandList, UINT index)
+{
+	m_PendingBLAS[index]->Record(commandList);
+}
+
+void SceneAccelerationStructure::AddInstance(BLASIdentifier id, const Transform3x4& transform, UINT instanceID, UINT hitGroupIndex)
 {
-	DirectX::XMMATRIX matrix = XMMatrixTranspose(*transform);
 	D3D12_RAYTRACING_INSTANCE_DESC instanceDesc = {};
-	memcpy(&instanceDesc.Transform, &matrix, sizeof(instanceDesc.Transform));
+	static_assert(sizeof(instanceDesc.Transform) == sizeof(transform.m));
+	memcpy(&instanceDesc.Transform, transform.m, sizeof(instanceDesc.Transform));
 	instanceDesc.InstanceID = instanceID; // Instance ID visible in the shader in InstanceID()
 	instanceDesc.InstanceMask = 0xFF; // Visibility mask, always visible here
 	instanceDesc.InstanceContributionToHitGroupIndex = hitGroupIndex; // Index of the hit group invoked upon intersection
@@ -39,22 +68,28 @@ void SceneAccelerationStructure::AddInstance(BLASIdentifier id, DirectX::XMMATRI
 	m_InstanceDescs.push_back(instanceDesc);
 }
 
+// Changes whenever an instance moves, is added or removed, used to restart accumulation
+UINT64 SceneAccelerationStructure::GetInstanceHash() const
+{
+	return HashBytes(m_InstanceDescs.data(), m_InstanceDescs.size() * sizeof(D3D12_RAYTRACING_INSTANCE_DESC));
+}
+
+// Returns true when the TLAS had to be reallocated and views of it need to be recreated
+bool SceneAccelerationStructure::PrepareBuild()
+{
+	return m_TLAS.Prepare(m_Device, m_Heap, &m_ScratchPool, m_UploadRing, m_InstanceDescs);
+}
+
 void SceneAccelerationStructure::Build(ID3D12GraphicsCommandList6* commandList)
 {
-	TLAS_Generator tlas(m_Device, m_Heap);
-	tlas.Generate(commandList, TLAS, m_InstanceDescs);
+	m_TLAS.Record(commandList);
 }
 
 
 
 // TLAS_Generator
 
-TLAS_Generator::TLAS_Generator(ID3D12Device11* device, HeapManager* heap) :
-	m_Device(device),
-	m_Heap(heap)
-{}
-
-void TLAS_Generator::Generate(ID3D12GraphicsCommandList6* commandList, Microsoft::WRL::ComPtr<ID3D12Resource2>& resultTlas, std::vector<D3D12_RAYTRACING_INSTANCE_DESC>& instanceDescs)
+bool TLAS_Generator::Prepare(ID3D12Device11* device, HeapManager* heap, BufferPool* scratchPool, UploadRing* uploadRing, const std::vector<D3D12_RAYTRACING_INSTANCE_DESC>& instanceDescs)
 {
 	D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS prebuildDesc = {};
 	prebuildDesc.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
@@ -64,43 +99,53 @@ void TLAS_Generator::Generate(ID3D12GraphicsCommandList6* commandList, Microsoft
 
 	D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuild_info = {};
 
-	m_Device->GetRaytracingAccelerationStructurePrebuildInfo(&prebuildDesc, &prebuild_info);
+	device->GetRaytracingAccelerationStructurePrebuildInfo(&prebuildDesc, &prebuild_info);
 
-	const UINT64 instanceDescsSize = Align64(sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * instanceDescs.size(), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
 	const UINT64 scratchSize = Align64(prebuild_info.ScratchDataSizeInBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
 	const UINT64 resultSize = Align64(prebuild_info.ResultDataMaxSizeInBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
 
-	m_Scratch = m_Heap->CreateBufferResource(m_Device, ScratchDefaultHeap, D3D12_RESOURCE_STATE_COMMON, scratchSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-	resultTlas = m_Heap->CreateBufferResource(m_Device, TLASHeap, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, resultSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-	m_DescriptorsBuffer = m_Heap->CreateBufferResource(m_Device, ScratchUploadHeap, D3D12_RESOURCE_STATE_GENERIC_READ, instanceDescsSize);
-
-	void* Destination = nullptr;
-	const UINT Size = (UINT)sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * (UINT)instanceDescs.size();
-	const D3D12_RANGE readRange = { 0, 0 };
-	ThrowIfFailed(m_DescriptorsBuffer->Map(0, &readRange, &Destination));
-	memcpy(Destination, instanceDescs.data(), Size);
-	m_DescriptorsBuffer->Unmap(0, nullptr);
+	// Grow in the pool's size classes so a slowly increasing instance count does not reallocate every frame
+	bool reallocated = false;
+	if (m_ResultCapacity < resultSize)
+	{
+		if (m_Result)
+		{
+			heap->FreeDeferred(m_Result);
+		}
+		m_ResultCapacity = BufferPool::GetClassSize(resultSize);
+		m_Result = heap->CreateBufferResource(device, TLASHeap, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, m_ResultCapacity, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+		reallocated = true;
+	}
+	ID3D12Resource2* scratch = scratchPool->Acquire(scratchSize);
+
+	const UINT64 Size = sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * instanceDescs.size();
+	UploadAllocation descriptors = uploadRing->Allocate(std::max<UINT64>(Size, 1), D3D12_RAYTRACING_INSTANCE_DESCS_BYTE_ALIGNMENT);
+	memcpy(descriptors.CPUAddress, instanceDescs.data(), Size);
 
 	// Create a descriptor of the requested builder work, to generate a top-level AS from the input parameters
-	D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
-	buildDesc.DestAccelerationStructureData = { resultTlas->GetGPUVirtualAddress() };
-	buildDesc.Inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
-	buildDesc.Inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
-	buildDesc.Inputs.NumDescs = prebuildDesc.NumDescs;
-	buildDesc.Inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-	buildDesc.Inputs.InstanceDescs = m_DescriptorsBuffer->GetGPUVirtualAddress();
-	buildDesc.ScratchAccelerationStructureData = m_Scratch->GetGPUVirtualAddress();
-	buildDesc.SourceAccelerationStructureData = 0;
+	m_BuildDesc = {};
+	m_BuildDesc.DestAccelerationStructureData = { m_Result->GetGPUVirtualAddress() };
+	m_BuildDesc.Inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+	m_BuildDesc.Inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+	m_BuildDesc.Inputs.NumDescs = prebuildDesc.NumDescs;
+	m_BuildDesc.Inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+	m_BuildDesc.Inputs.InstanceDescs = descriptors.GPUAddress;
+	m_BuildDesc.ScratchAccelerationStructureData = scratch->GetGPUVirtualAddress();
+	m_BuildDesc.SourceAccelerationStructureData = 0;
+	return reallocated;
+}
 
+void TLAS_Generator::Record(ID3D12GraphicsCommandList6* commandList)
+{
 	// Build the top-level AS
-	commandList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+	commandList->BuildRaytracingAccelerationStructure(&m_BuildDesc, 0, nullptr);
 
 	// Wait for the builder to complete by setting a barrier on the resulting
 	// buffer. This can be important in case the rendering is triggered
 	// immediately afterwards, without executing the command list
 	D3D12_RESOURCE_BARRIER uavBarrier = {};
 	uavBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-	uavBarrier.UAV.pResource = resultTlas.Get();
+	uavBarrier.UAV.pResource = m_Result.Get();
 	uavBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 	commandList->ResourceBarrier(1, &uavBarrier);
 }
@@ -125,9 +170,15 @@ BLAS_Generator::BLAS_Generator(ID3D12Device11* device, HeapManager* heap, MeshDa
 	CopyDataToUploadResource(meshdata->m_Indices.data(), m_IndexBuffer.Get(), sizeinBytes);
 }
 
-void BLAS_Generator::Generate(ID3D12GraphicsCommandList6* commandList, ComPtr<ID3D12Resource2>& resultBlas)
+BLAS_Generator::~BLAS_Generator()
+{
+	m_Heap->Free(m_VertexBuffer.Get());
+	m_Heap->Free(m_IndexBuffer.Get());
+}
+
+void BLAS_Generator::Prepare(BufferPool* scratchPool, ComPtr<ID3D12Resource2>& resultBlas)
 {
-	D3D12_RAYTRACING_GEOMETRY_DESC geometry_Desc = {};
+	D3D12_RAYTRACING_GEOMETRY_DESC& geometry_Desc = m_GeometryDesc;
 	geometry_Desc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
 	geometry_Desc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
 	geometry_Desc.Triangles.Transform3x4 = 0;
@@ -152,20 +203,24 @@ void BLAS_Generator::Generate(ID3D12GraphicsCommandList6* commandList, ComPtr<ID
 
 	UINT64 scratchSize = Align64(prebuild_info.ScratchDataSizeInBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
 	UINT64 resultSize = Align64(prebuild_info.ResultDataMaxSizeInBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
-	m_Scratch = m_Heap->CreateBufferResource(m_Device, ScratchDefaultHeap, D3D12_RESOURCE_STATE_COMMON, scratchSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+	ID3D12Resource2* scratch = scratchPool->Acquire(scratchSize);
 	resultBlas = m_Heap->CreateBufferResource(m_Device, BLASHeap, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, resultSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
 
-	D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC AS_BuildDesc = {};
-	AS_BuildDesc.DestAccelerationStructureData = resultBlas->GetGPUVirtualAddress();
-	AS_BuildDesc.Inputs = AS_Inputs;
-	AS_BuildDesc.SourceAccelerationStructureData = 0;
-	AS_BuildDesc.ScratchAccelerationStructureData = m_Scratch->GetGPUVirtualAddress();
+	m_Result = resultBlas.Get();
+	m_BuildDesc.DestAccelerationStructureData = resultBlas->GetGPUVirtualAddress();
+	m_BuildDesc.Inputs = AS_Inputs;
+	m_BuildDesc.SourceAccelerationStructureData = 0;
+	m_BuildDesc.ScratchAccelerationStructureData = scratch->GetGPUVirtualAddress();
+}
 
-	commandList->BuildRaytracingAccelerationStructure(&AS_BuildDesc, 0, nullptr);
+void BLAS_Generator::Record(ID3D12GraphicsCommandList6* commandList)
+{
+	m_BuildDesc.Inputs.pGeometryDescs = &m_GeometryDesc;
+	commandList->BuildRaytracingAccelerationStructure(&m_BuildDesc, 0, nullptr);
 
 	D3D12_RESOURCE_BARRIER uavBarrier = {};
 	uavBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-	uavBarrier.UAV.pResource = resultBlas.Get();
+	uavBarrier.UAV.pResource = m_Result;
 	uavBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 	commandList->ResourceBarrier(1, &uavBarrier);
 }
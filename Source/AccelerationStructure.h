@@ -1,6 +1,9 @@
 #pragma once
 #include "PCH.h"
 #include "MeshData.h"
+#include "BufferPool.h"
+#include "UploadRing.h"
+#include "CpuMath.h"
 
 // TODO id and hitGroupIndex need to be ENUMS
 
@@ -12,47 +15,72 @@ enum BLASIdentifier
 	MeshCube = 0
 };
 
-class SceneAccelerationStructure
-{
-public:
-	void Init(ID3D12Device11* device, HeapManager* heap);
-	void Reset();
-	void AddMesh(ID3D12GraphicsCommandList6* commandList, BLASIdentifier id, MeshData* mesh);
-	void AddInstance(BLASIdentifier id, DirectX::XMMATRIX* transform, UINT instanceID, UINT hitGroupIndex);
-	void Build(ID3D12GraphicsCommandList6* commandList);
-	inline D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() { return TLAS->GetGPUVirtualAddress(); }
-private:
-	ID3D12Device11* m_Device = nullptr;
-	HeapManager* m_Heap = nullptr;
-	std::map<BLASIdentifier, Microsoft::WRL::ComPtr<ID3D12Resource2>> BLAS;
-	Microsoft::WRL::ComPtr<ID3D12Resource2> TLAS;
-	std::vector<D3D12_RAYTRACING_INSTANCE_DESC> m_InstanceDescs;
-};
-
+// Persistent TLAS builder. The result buffer is kept across frames and only regrown when the
+// instance count outgrows it; instance descriptors are written to the per-frame upload ring.
+// Like BLAS_Generator, Prepare allocates on the calling thread and Record only writes into the command list.
 class TLAS_Generator
 {
 public:
-	TLAS_Generator(ID3D12Device11* device, HeapManager* heap);
-	void Generate(ID3D12GraphicsCommandList6* commandList, Microsoft::WRL::ComPtr<ID3D12Resource2>& resultTlas, std::vector<D3D12_RAYTRACING_INSTANCE_DESC>& instanceDescs);
+	// Returns true when the result buffer was reallocated
+	bool Prepare(ID3D12Device11* device, HeapManager* heap, BufferPool* scratchPool, UploadRing* uploadRing, const std::vector<D3D12_RAYTRACING_INSTANCE_DESC>& instanceDescs);
+	void Record(ID3D12GraphicsCommandList6* commandList);
+	inline ID3D12Resource2* GetResult() { return m_Result.Get(); }
 private:
-	Microsoft::WRL::ComPtr<ID3D12Resource2> m_Scratch;
-	Microsoft::WRL::ComPtr<ID3D12Resource2> m_DescriptorsBuffer;
-	ID3D12Device11* m_Device;
-	HeapManager* m_Heap;
+	D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC m_BuildDesc = {};
+	Microsoft::WRL::ComPtr<ID3D12Resource2> m_Result;
+	UINT64 m_ResultCapacity = 0;
 };
 
+// Prepare allocates everything on the calling thread, Record only writes into the command list
+// so builds of different meshes can be recorded in parallel. The owner destroys it once the build has completed
+// on the GPU, which returns the input buffers to the heap.
 class BLAS_Generator
 {
 public:
 	BLAS_Generator(ID3D12Device11* device, HeapManager* heap, MeshData* meshdata);
-	void Generate(ID3D12GraphicsCommandList6* commandList, Microsoft::WRL::ComPtr<ID3D12Resource2>& resultBlas);
+	~BLAS_Generator();
+	BLAS_Generator(const BLAS_Generator&) = delete;
+	BLAS_Generator& operator=(const BLAS_Generator&) = delete;
+	void Prepare(BufferPool* scratchPool, Microsoft::WRL::ComPtr<ID3D12Resource2>& resultBlas);
+	void Record(ID3D12GraphicsCommandList6* commandList);
 private:
+	D3D12_RAYTRACING_GEOMETRY_DESC m_GeometryDesc = {};
+	D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC m_BuildDesc = {};
+	ID3D12Resource2* m_Result = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12Resource2> m_VertexBuffer;
 	Microsoft::WRL::ComPtr<ID3D12Resource2> m_IndexBuffer;
-	Microsoft::WRL::ComPtr<ID3D12Resource2> m_Scratch;
 	ID3D12Device11* m_Device;
 	HeapManager* m_Heap;
 	UINT m_IndexCount;
 	UINT m_VertexCount;
 	UINT m_Stride;
+};
+
+class SceneAccelerationStructure
+{
+public:
+	void Init(ID3D12Device11* device, HeapManager* heap, UploadRing* uploadRing);
+	void BeginFrame(UINT64 completedFenceValue);
+	void EndFrame(UINT64 fenceValue);
+	void Reset();
+	void AddMesh(BLASIdentifier id, MeshData* mesh);
+	inline UINT GetPendingBuildCount() const { return (UINT)m_PendingBLAS.size(); }
+	void RecordPendingBuild(ID3D12GraphicsCommandList6* commandList, UINT index);
+	void AddInstance(BLASIdentifier id, const Transform3x4& transform, UINT instanceID, UINT hitGroupIndex);
+	UINT64 GetInstanceHash() const;
+	// Allocates for this frame's TLAS build, must run before the build is recorded on another thread
+	bool PrepareBuild();
+	void Build(ID3D12GraphicsCommandList6* commandList);
+	inline D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() { return m_TLAS.GetResult()->GetGPUVirtualAddress(); }
+private:
+	ID3D12Device11* m_Device = nullptr;
+	HeapManager* m_Heap = nullptr;
+	UploadRing* m_UploadRing = nullptr;
+	BufferPool m_ScratchPool;
+	std::map<BLASIdentifier, Microsoft::WRL::ComPtr<ID3D12Resource2>> BLAS;
+	TLAS_Generator m_TLAS;
+	std::vector<D3D12_RAYTRACING_INSTANCE_DESC> m_InstanceDescs;
+	// BLAS builds waiting to be recorded, then kept with their input buffers until the GPU has run them
+	std::vector<std::unique_ptr<BLAS_Generator>> m_PendingBLAS;
+	std::deque<std::pair<UINT64, std::vector<std::unique_ptr<BLAS_Generator>>>> m_InFlightBLAS;
 };
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+// Decides when progressive accumulation starts over. The caller hashes everything the image depends on
+// (view, instance transforms, resolution); any change restarts at sample 0, otherwise samples keep adding up.
+class AccumulationState
+{
+public:
+	inline uint32_t BeginFrame(uint64_t stateHash)
+	{
+		if (!m_Valid || stateHash != m_StateHash)
+		{
+			m_StateHash = stateHash;
+			m_Valid = true;
+			m_SampleCount = 0;
+			m_RestartCount++;
+		}
+		return m_SampleCount++;
+	}
+	inline void Reset() { m_Valid = false; }
+	inline uint32_t GetSampleCount() const { return m_SampleCount; }
+	// Number of restarts so far, salts the random streams so consecutive accumulations draw different samples
+	inline uint32_t GetRestartCount() const { return m_RestartCount; }
+private:
+	uint64_t m_StateHash = 0;
+	bool m_Valid = false;
+	uint32_t m_SampleCount = 0;
+	uint32_t m_RestartCount = 0;
+};
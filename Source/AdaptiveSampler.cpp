@@ -0,0 +1,44 @@
+#include "PCH.h"
+#include "AdaptiveSampler.h"
+#include "AdaptiveSampling.h"
+#include "Heap.h"
+
+void AdaptiveSampler::Create(ID3D12Device11* device, HeapManager* heap, DescriptorHeap* descriptorHeap, UINT width, UINT height)
+{
+	m_Device = device;
+	m_Heap = heap;
+	m_DescriptorHeap = descriptorHeap;
+	m_LuminanceSquaresDescriptor = descriptorHeap->AllocatePersistent();
+	Resize(width, height);
+}
+
+// The flags start out undefined; RayGen ignores them until every buffer has been cleared once
+void AdaptiveSampler::Resize(UINT width, UINT height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+	m_Width = width;
+	m_Height = height;
+	m_LuminanceSquares.Create(m_Device, width, height, m_DescriptorHeap->GetCPUHandle(m_LuminanceSquaresDescriptor), DXGI_FORMAT_R32_FLOAT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	if (m_TileFlags)
+	{
+		m_Heap->FreeDeferred(m_TileFlags);
+	}
+	const UINT64 tileCount = (UINT64)AdaptiveSampling::GetTileCount(width) * AdaptiveSampling::GetTileCount(height);
+	m_TileFlags = m_Heap->CreateBufferResource(m_Device, DefaultHeap, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, TileFlagBuffers * tileCount * sizeof(UINT32), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+}
+
+// Last frame's flags and luminance sums must be written before this frame reads them
+void AdaptiveSampler::UAVBarrier(ID3D12GraphicsCommandList6* commandList)
+{
+	D3D12_RESOURCE_BARRIER barrier = {};
+	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+	barrier.UAV.pResource = m_TileFlags.Get();
+	commandList->ResourceBarrier(1, &barrier);
+	m_LuminanceSquares.UAVBarrier(commandList);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE AdaptiveSampler::GetLuminanceSquaresDescriptor()
+{
+	return m_DescriptorHeap->GetGPUHandle(m_LuminanceSquaresDescriptor);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "PCH.h"
+#include "OutputBuffer.h"
+#include "DescriptorHeap.h"
+
+class HeapManager;
+
+// GPU state of adaptive sampling, see AdaptiveSampling.h. Next to the accumulation target it keeps the per-pixel sum
+// of squared luminance, and three rotating buffers of one flag per tile: in frame s RayGen reads the flags raised in
+// frame s - 1, raises the ones frame s + 1 reads and clears the buffer frame s + 1 raises, all without a separate pass.
+class AdaptiveSampler
+{
+public:
+	void Create(ID3D12Device11* device, HeapManager* heap, DescriptorHeap* descriptorHeap, UINT width, UINT height);
+	// The caller has flushed the queue, like SwapChain::Resize
+	void Resize(UINT width, UINT height);
+	void UAVBarrier(ID3D12GraphicsCommandList6* commandList);
+	D3D12_GPU_DESCRIPTOR_HANDLE GetLuminanceSquaresDescriptor();
+	inline D3D12_GPU_VIRTUAL_ADDRESS GetTileFlagsAddress() const { return m_TileFlags->GetGPUVirtualAddress(); }
+private:
+	static constexpr UINT TileFlagBuffers = 3;
+	ID3D12Device11* m_Device = nullptr;
+	HeapManager* m_Heap = nullptr;
+	DescriptorHeap* m_DescriptorHeap = nullptr;
+	OutputBuffer m_LuminanceSquares;
+	DescriptorRange m_LuminanceSquaresDescriptor;
+	Microsoft::WRL::ComPtr<ID3D12Resource2> m_TileFlags;
+	UINT m_Width = 0;
+	UINT m_Height = 0;
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include "CpuMath.h"
+
+// Variance-driven adaptive sampling, shared by CpuRenderer and RayGen.hlsl. Every pixel keeps the sum of its
+// samples and of their squared luminance; once a 16x16 tile has MinSamples and every pixel traced in it last
+// frame has a relative standard error below the threshold, the tile stops receiving samples until the next reset.
+namespace AdaptiveSampling
+{
+	constexpr uint32_t TileSize = 16; // ADAPTIVE_TILE_SIZE in Common.hlsl
+	// Uniform sampling up to here. At least 2, RayGen only has valid tile flags from the third frame on
+	constexpr uint32_t DefaultMinSamples = 16;
+	constexpr uint32_t Disabled = 0xFFFFFFFF;
+	constexpr float DefaultThreshold = 0.005f;
+	// Keeps the relative error of dark pixels from blowing up, in the same units as the radiance
+	constexpr float ErrorFloor = 0.1f;
+
+	inline float Luminance(Float3 color)
+	{
+		return color.x * 0.2126f + color.y * 0.7152f + color.z * 0.0722f;
+	}
+
+	// Standard error of the pixel's mean luminance relative to that mean, same as PixelError in Common.hlsl.
+	// sum holds the rgb sum and the sample count, luminanceSquares the sum of the squared sample luminances.
+	inline float PixelError(Float4 sum, float luminanceSquares)
+	{
+		if (sum.w < 2.0f)
+			return INFINITY;
+		const float mean = Luminance({ sum.x, sum.y, sum.z }) / sum.w;
+		const float variance = std::fmax(0.0f, (luminanceSquares - sum.w * mean * mean) / (sum.w - 1.0f));
+		return std::sqrt(variance / sum.w) / (mean + ErrorFloor);
+	}
+
+	inline uint32_t GetTileCount(uint32_t size)
+	{
+		return (size + TileSize - 1) / TileSize;
+	}
+}
@@ -5,16 +5,18 @@
 #include "RootSignatureGenerator.h"
 #include "Heap.h"
 #include "PipelineStateObject.h"
+#include "Hash.h"
 
 #define WINDOWTITLE L"Hello World RTX"
 #define FULLSCREENMODE false
 #define TITLE_BUFFER_SIZE 256
+#define TITLE_TIMER_ID 1
 
 using namespace DirectX;
 
 Application* Application::AppPtr = nullptr;
 
-Application::Application(HINSTANCE hInstance) : m_hInstance(hInstance), m_FrameTime(0.0f), m_TitleBuffer(nullptr)
+Application::Application(HINSTANCE hInstance, const std::string& scenePath) : m_hInstance(hInstance), m_FrameTime(0.0f), m_TitleBuffer(nullptr), m_ScenePath(scenePath)
 {}
 
 Application::~Application()
@@ -26,10 +28,16 @@ Application::~Application()
 int Application::Run()
 {
 	m_TitleBuffer = new WCHAR[TITLE_BUFFER_SIZE];  //TODO Temporary to show stats in title bar
+	wcscpy_s(m_TitleBuffer, TITLE_BUFFER_SIZE, WINDOWTITLE);
 	try
 	{
 		m_Window.Create(m_hInstance, this, WINDOWTITLE, 1200, 800, FULLSCREENMODE, &Application::WindProcInit);
-		m_Renderer.Create(&m_Window);
+		{
+			PROFILE_SCOPE("Scene load");
+			SceneFile::Load(m_ScenePath, &m_SceneContent);
+		}
+		// Every frame uploads an instance descriptor and a motion transform per instance
+		m_Renderer.Create(&m_Window, m_SceneContent.Instances.size() * (sizeof(D3D12_RAYTRACING_INSTANCE_DESC) + sizeof(Transform3x4)));
 		OnInit();
 	}
 	catch (const std::exception& e)
@@ -39,6 +47,12 @@ int Application::Run()
 	}
 	m_Window.Show();
 	InitializeInput();
+	SetTimer(m_Window.GetHandle(), TITLE_TIMER_ID, 250, nullptr);
+
+	// The message thread only translates events from here on, Update and Render run on their own thread
+	m_ClientSize = ((UINT64)m_Window.GetClientWidth() << 32) | m_Window.GetClientHeight();
+	m_Running = true;
+	m_RenderThread = std::thread(&Application::RenderLoop, this);
 
 	MSG msg = {};
 
@@ -53,70 +67,300 @@ int Application::Run()
 	return 0;
 }
 
-void Application::Resize()
+void Application::Resize(const FrameSnapshot& snapshot)
 {
-	m_Window.ResizedWindow();
-	m_Camera.SetAspectRatio((float)m_Window.GetClientWidth() / m_Window.GetClientHeight());
-	m_Renderer.m_SwapChain.Resize(m_Window.GetClientWidth(), m_Window.GetClientHeight());
+	if (snapshot.Width != m_Renderer.m_SwapChain.GetWidth() || snapshot.Height != m_Renderer.m_SwapChain.GetHeight())
+	{
+		m_Camera.SetAspectRatio((float)snapshot.Width / snapshot.Height);
+		m_Renderer.m_SwapChain.Resize(snapshot.Width, snapshot.Height);
+		m_AdaptiveSampler.Resize(snapshot.Width, snapshot.Height);
+		m_Denoiser.Resize(snapshot.Width, snapshot.Height);
+		m_TemporalAccumulator.Resize(snapshot.Width, snapshot.Height);
+		m_Upscaler.Resize(snapshot.Width, snapshot.Height);
+		m_ResolutionController.Reset();
+	}
 }
 
-void Application::Update()
+void Application::RenderLoop()
 {
-	UpdateFrameTime();
+	Profiler::SetThreadName("Render");
+	try
+	{
+		while (m_Running)
+		{
+			// Nothing to present while minimized
+			if (!(UINT)m_ClientSize || !(UINT)(m_ClientSize >> 32))
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				continue;
+			}
+			Update();
+			Render();
+		}
+	}
+	catch (const std::exception& e)
+	{
+		MessageBoxA(nullptr, e.what(), "Exception", MB_OK);
+		PostMessage(m_Window.GetHandle(), WM_CLOSE, 0, 0);
+	}
+}
 
-	ID3D12CommandAllocator* commandAllocator = m_Renderer.m_CommandAllocator.Get();
-	ID3D12GraphicsCommandList6* commandList = m_Renderer.GetCommandList();
+void Application::StopRenderThread()
+{
+	if (!m_RenderThread.joinable())
+		return;
+	m_Running = false;
+	// Keep pumping while waiting, Present and ResizeBuffers may send messages to this thread to finish the frame
+	HANDLE thread = m_RenderThread.native_handle();
+	while (MsgWaitForMultipleObjects(1, &thread, FALSE, INFINITE, QS_ALLINPUT) != WAIT_OBJECT_0)
+	{
+		MSG msg = {};
+		while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+		{
+			TranslateMessage(&msg);
+			DispatchMessage(&msg);
+		}
+	}
+	m_RenderThread.join();
+	// Up to FramesInFlight frames may still read the scene, shader table and pass resources, which are members
+	// declared after m_Renderer and so released before its destructor flushes
+	m_Renderer.m_CommandQueue.Flush();
+}
 
-	ThrowIfFailed(commandAllocator->Reset());
-	ThrowIfFailed(commandList->Reset(commandAllocator, nullptr));
+FrameSnapshot Application::TakeSnapshot()
+{
+	const UINT64 clientSize = m_ClientSize;
+	FrameSnapshot snapshot = {};
+	snapshot.Input = Input::TakeSnapshot();
+	snapshot.Width = (UINT)(clientSize >> 32);
+	snapshot.Height = (UINT)clientSize;
+	return snapshot;
+}
 
-	m_Renderer.GetHeap()->ResetHeapOffset(ScratchDefaultHeap);
-	m_Renderer.GetHeap()->ResetHeapOffset(ScratchUploadHeap);
+void Application::Update()
+{
+	UpdateFrameTime();
+	m_FrameStats.EndFrame(m_FrameTime * 1000.0);
+	if (m_DumpFrameStats.exchange(false))
+	{
+		m_FrameStats.WriteCSV("FrameStats.csv");
+	}
+	if (m_ToggleTraceCapture.exchange(false))
+	{
+		if (Profiler::IsCapturing())
+		{
+			Profiler::SetCapturing(false);
+			Profiler::WriteChromeTrace("Trace.json");
+		}
+		else
+		{
+			Profiler::SetCapturing(true);
+		}
+	}
+	if (Profiler::IsCapturing())
+	{
+		Profiler::Collect();
+	}
 
-	angle1 += 0.512465799111f * m_FrameTime;
-	angle2 += 0.812465799111f * m_FrameTime * 0.38712f;
+	FrameSnapshot snapshot;
+	{
+		FrameStats::ScopedPhase phase(&m_FrameStats, FrameStats::PhaseUpdate);
+		PROFILE_SCOPE("Update");
+		snapshot = TakeSnapshot();
+		Resize(snapshot);
+
+		m_Renderer.BeginFrame();
+		m_FrameCapture.BeginFrame(m_Renderer.GetFrameIndex(), &m_ImageWriter);
+		for (const std::string& failure : m_ImageWriter.TakeFailures())
+		{
+			OutputDebugStringA(("Could not write " + failure + "\n").c_str());
+		}
 
-	BuildScene(commandList);
+		m_LastFrameAllocations = m_Renderer.GetHeap()->GetFrameStats();
+		m_Renderer.GetHeap()->ResetFrameStats();
+		m_Scene.BeginFrame(m_Renderer.GetCompletedFenceValue());
+		m_ShaderTable.Commit(m_Renderer.GetFrameIndex());
 
-	SetTitle();
-	Input::Update();
-	m_Camera.Update(m_FrameTime);
+		if (!m_PauseAnimation)
+		{
+			m_AnimationTime += m_FrameTime;
+		}
+	}
+	{
+		FrameStats::ScopedPhase phase(&m_FrameStats, FrameStats::PhaseSceneBuild);
+		PROFILE_SCOPE("Scene build");
+		BuildScene();
+	}
+	FrameStats::ScopedPhase phase(&m_FrameStats, FrameStats::PhaseUpdate);
+	PROFILE_SCOPE("Camera update");
+	SetTitle(snapshot);
+	m_Camera.Update(m_FrameTime, snapshot.Input, m_Renderer.GetUploadRing());
+
+	// The textures keep the window size, a lower scale only traces their top left corner
+	float scale = 1.0f;
+	if (m_DynamicResolution)
+		scale = m_ResolutionController.Update(m_FrameTime * 1000.0f);
+	else
+		m_ResolutionController.Reset();
+	ResolutionController::GetRenderSize(scale, m_Renderer.m_SwapChain.GetWidth(), m_Renderer.m_SwapChain.GetHeight(), &m_FrameConstants.RenderWidth, &m_FrameConstants.RenderHeight);
+
+	// Keep averaging into the accumulation target until the view, the instances, the resolution or the interleave mode change
+	const InterleavedSampling::Mode interleaveMode = m_InterleaveMode;
+	const UINT64 accumulationState[] = { m_Camera.GetStateHash(), m_Scene.GetInstanceHash(), m_FrameConstants.RenderWidth, m_FrameConstants.RenderHeight, interleaveMode };
+	m_FrameConstants.SampleIndex = m_Accumulation.BeginFrame(HashBytes(accumulationState, sizeof(accumulationState)));
+	m_FrameConstants.RouletteStartBounce = m_RussianRoulette ? DefaultRouletteStartBounce : DisableRoulette;
+	// Interleaved pixels need PhaseCount frames per sample of their own
+	m_FrameConstants.AdaptiveMinSamples = m_AdaptiveSampling ? AdaptiveSampling::DefaultMinSamples * InterleavedSampling::GetPhaseCount(interleaveMode) : AdaptiveSampling::Disabled;
+	m_FrameConstants.AdaptiveThreshold = AdaptiveSampling::DefaultThreshold;
+	m_FrameConstants.RandomSequence = m_Accumulation.GetRestartCount();
+	m_FrameConstants.JitterFirstSample = m_TemporalReuse;
+	m_FrameConstants.InterleaveMode = interleaveMode;
 }
 
+// Every pass records into its own command list on the thread pool, submission follows PassOrder.
+// HeapManager is not thread safe, so everything the passes need is allocated here before recording.
 void Application::Render()
 {
-	ID3D12CommandAllocator* commandAllocator = m_Renderer.m_CommandAllocator.Get();
-	ID3D12GraphicsCommandList6* commandList = m_Renderer.GetCommandList();
+	CommandListPool* commandListPool = m_Renderer.GetCommandListPool();
+	GpuProfiler* gpuProfiler = m_Renderer.GetGpuProfiler();
+	const bool validateDenoiser = m_ValidateDenoiser.exchange(false);
+	if (m_CaptureFrame.exchange(false))
+	{
+		char name[32];
+		sprintf_s(name, "Capture_%04u.png", m_CaptureCount++);
+		// The texture RecordRaytracing presents
+		const bool upscale = m_FrameConstants.RenderWidth < m_Renderer.m_SwapChain.GetWidth() || m_FrameConstants.RenderHeight < m_Renderer.m_SwapChain.GetHeight();
+		m_FrameCapture.Request(upscale ? m_Upscaler.GetDisplay() : m_Renderer.m_SwapChain.GetRayTracingOutput(), name);
+	}
+	if (validateDenoiser)
+	{
+		m_Denoiser.PrepareValidation();
+	}
+	bool sceneReallocated = false;
+	{
+		FrameStats::ScopedPhase phase(&m_FrameStats, FrameStats::PhaseASBuild);
+		sceneReallocated = m_Scene.PrepareBuild();
+	}
+	m_Scheduler.AddPass("TLAS build", PassAccelerationStructure, [&](ID3D12GraphicsCommandList6* commandList)
+	{
+		GpuProfiler::ScopedEvent gpuEvent(gpuProfiler, commandList, "TLAS build");
+		m_Scene.Build(commandList);
+	});
+	m_Scheduler.AddPass("Ray dispatch", PassRaytrace, [&](ID3D12GraphicsCommandList6* commandList)
+	{
+		RecordRaytracing(commandList, validateDenoiser);
+	});
+	m_Scheduler.AddPass("Resolve timestamps", PassFrameEnd, [&](ID3D12GraphicsCommandList6* commandList)
+	{
+		gpuProfiler->Resolve(commandList);
+	}, true);
+	{
+		// Passes record concurrently, their own times are in m_Scheduler.GetTimings()
+		FrameStats::ScopedPhase phase(&m_FrameStats, FrameStats::PhaseRecord);
+		m_Scheduler.Record(commandListPool, m_Renderer.GetThreadPool());
+	}
+
+	if (sceneReallocated)
+	{
+		// The old view may still be read by frames in flight
+		m_Renderer.m_CommandQueue.Flush();
+		CreateSceneView();
+	}
+	m_Scheduler.Submit(commandListPool);
+	if (validateDenoiser)
+	{
+		// Debug aid, so waiting for the copies right away is fine
+		m_Renderer.m_CommandQueue.Flush();
+		const float difference = m_Denoiser.Validate(m_Renderer.GetThreadPool());
+		const std::wstring report = L"Denoiser validation, largest GPU to CPU difference: " + std::to_wstring(difference) + L"\n";
+		OutputDebugStringW(report.c_str());
+	}
+
+	FrameStats::ScopedPhase presentPhase(&m_FrameStats, FrameStats::PhasePresent);
+	PROFILE_SCOPE("Present");
+	m_Renderer.m_SwapChain.Present();
+	m_Scene.EndFrame(m_Renderer.EndFrame());
+}
 
+// Validation runs the denoiser even while it is switched off and reads back what it used
+void Application::RecordRaytracing(ID3D12GraphicsCommandList6* commandList, bool validateDenoiser)
+{
 	m_Renderer.m_SwapChain.PrepareFrameStart(commandList);
+	m_AdaptiveSampler.UAVBarrier(commandList);
 	commandList->SetPipelineState1(m_StateObject.Get());
 	commandList->SetDescriptorHeaps(1, m_Renderer.GetDescriptorHeap()->GetAddressOfHeap());
-
+	commandList->SetComputeRootSignature(m_GlobalSignature.Get());
+	commandList->SetComputeRootConstantBufferView(0, m_Camera.GetGPUVirtualAddress());
+	commandList->SetComputeRoot32BitConstants(1, sizeof(FrameConstants) / 4, &m_FrameConstants, 0);
+	commandList->SetComputeRootUnorderedAccessView(2, m_Renderer.GetRayStatistics()->GetGPUVirtualAddress());
+	commandList->SetComputeRootUnorderedAccessView(3, m_AdaptiveSampler.GetTileFlagsAddress());
+	commandList->SetComputeRootConstantBufferView(4, m_Camera.GetPreviousGPUVirtualAddress());
+	commandList->SetComputeRootShaderResourceView(5, m_InstanceMotionAddress);
+
+	// The interleaved modes launch one ray for every two or four pixels
+	const InterleavedSampling::Mode interleaveMode = (InterleavedSampling::Mode)m_FrameConstants.InterleaveMode;
+	const UINT width = m_FrameConstants.RenderWidth;
+	const UINT height = m_FrameConstants.RenderHeight;
 	D3D12_DISPATCH_RAYS_DESC DispatchDesc = {};
-	DispatchDesc.RayGenerationShaderRecord.StartAddress = m_ShaderBindingTable->GetGPUVirtualAddress();
-	DispatchDesc.RayGenerationShaderRecord.SizeInBytes = 64;
-	DispatchDesc.MissShaderTable.StartAddress = DispatchDesc.RayGenerationShaderRecord.StartAddress + DispatchDesc.RayGenerationShaderRecord.SizeInBytes;
-	DispatchDesc.MissShaderTable.SizeInBytes = 64;
-	DispatchDesc.MissShaderTable.StrideInBytes = 64;
-	DispatchDesc.HitGroupTable.StartAddress = DispatchDesc.MissShaderTable.StartAddress + DispatchDesc.MissShaderTable.SizeInBytes;
-	DispatchDesc.HitGroupTable.SizeInBytes = 64;
-	DispatchDesc.HitGroupTable.StrideInBytes = 64;
-	DispatchDesc.CallableShaderTable;
-	DispatchDesc.Width = m_Renderer.m_SwapChain.GetWidth();
-	DispatchDesc.Height = m_Renderer.m_SwapChain.GetHeight();
+	m_ShaderTable.FillDispatchDesc(&DispatchDesc);
+	InterleavedSampling::GetDispatchSize(interleaveMode, width, height, &DispatchDesc.Width, &DispatchDesc.Height);
 	DispatchDesc.Depth = 1;
-	commandList->DispatchRays(&DispatchDesc);
+	{
+		GpuProfiler::ScopedEvent gpuEvent(m_Renderer.GetGpuProfiler(), commandList, "DispatchRays");
+		commandList->DispatchRays(&DispatchDesc);
+	}
+	m_Renderer.GetRayStatistics()->Record(commandList);
+	if (InterleavedSampling::NeedsReconstruction(interleaveMode, m_FrameConstants.SampleIndex))
+	{
+		GpuProfiler::ScopedEvent gpuEvent(m_Renderer.GetGpuProfiler(), commandList, "Reconstruct");
+		m_Reconstructor.Record(commandList, interleaveMode, m_FrameConstants.SampleIndex, m_FrameConstants.RandomSequence, width, height, m_Renderer.GetAccumulationDescriptor(), m_Denoiser.GetNormalDepthDescriptor(), m_Denoiser.GetAlbedoDescriptor(), m_TemporalAccumulator.GetMotionDescriptor(), m_Renderer.GetOutputDescriptor());
+	}
 
-	m_Renderer.m_SwapChain.PrepareFrameEnd(commandList);
-	ThrowIfFailed(commandList->Close());
+	// With temporal reuse the denoiser filters the accumulation combined with the reprojected history
+	const bool temporalReuse = m_TemporalReuse;
+	if (temporalReuse)
+	{
+		GpuProfiler::ScopedEvent gpuEvent(m_Renderer.GetGpuProfiler(), commandList, "Temporal accumulation");
+		m_TemporalAccumulator.Record(commandList, m_FrameConstants.SampleIndex, width, height, m_Renderer.GetAccumulationDescriptor(), m_Denoiser.GetNormalDepthDescriptor(), m_Renderer.GetOutputDescriptor());
+	}
+	else
+	{
+		m_TemporalAccumulator.InvalidateHistory();
+	}
+	if (m_Denoise || validateDenoiser)
+	{
+		GpuProfiler::ScopedEvent gpuEvent(m_Renderer.GetGpuProfiler(), commandList, "Denoise");
+		const D3D12_GPU_DESCRIPTOR_HANDLE input = temporalReuse ? m_TemporalAccumulator.GetResultDescriptor() : m_Renderer.GetAccumulationDescriptor();
+		m_Denoiser.Record(commandList, width, height, input, m_Renderer.GetOutputDescriptor(), m_DenoiserSettings);
+	}
+	if (validateDenoiser)
+	{
+		m_Denoiser.RecordValidation(commandList, temporalReuse ? m_TemporalAccumulator.GetResult() : m_Renderer.m_SwapChain.GetAccumulation());
+	}
 
-	m_Renderer.m_CommandQueue.ExecuteCommandList(commandList);
-	m_Renderer.m_SwapChain.Present();
-	m_Renderer.m_CommandQueue.Flush();
+	if (width < m_Renderer.m_SwapChain.GetWidth() || height < m_Renderer.m_SwapChain.GetHeight())
+	{
+		{
+			GpuProfiler::ScopedEvent gpuEvent(m_Renderer.GetGpuProfiler(), commandList, "Upscale");
+			m_Upscaler.Record(commandList, m_Renderer.GetOutputDescriptor(), width, height);
+		}
+		m_FrameCapture.Record(commandList);
+		m_Renderer.m_SwapChain.PrepareFrameEnd(commandList, m_Upscaler.GetDisplay());
+	}
+	else
+	{
+		m_FrameCapture.Record(commandList);
+		m_Renderer.m_SwapChain.PrepareFrameEnd(commandList);
+	}
 }
 
-void Application::Exit() const
+void Application::Exit()
 {
+	// WM_CLOSE can arrive again while StopRenderThread pumps messages
+	if (m_Exiting)
+		return;
+	m_Exiting = true;
+	StopRenderThread();
 	DestroyWindow(m_Window.GetHandle());
 }
 
@@ -131,29 +375,6 @@ void Application::InitializeInput()
 	RegisterRawInputDevices(&Rid, 1, sizeof(Rid));
 }
 
-float Application::GetFPS() const
-{
-	float fps = 0.0;
-	if (m_FrameTime > 0.0001)
-	{
-		static UINT frameCount = 0;
-		const UINT CountMax = 120;
-		static float accumulator[CountMax] = {};
-		if (frameCount >= CountMax)
-		{
-			frameCount = 0;
-		}
-		accumulator[frameCount++] = 1.0f / m_FrameTime;
-
-		for (int i = 0; i < CountMax; i++)
-		{
-			fps += accumulator[i];
-		}
-		fps /= CountMax;
-	}
-	return fps;
-};
-
 void Application::UpdateFrameTime()
 {
 	static std::chrono::high_resolution_clock clock;
@@ -166,95 +387,136 @@ void Application::UpdateFrameTime()
 	m_FrameTime = deltaTime.count() * 1e-9f;
 }
 
-void Application::SetTitle() const
+// Only formats the title, the message thread applies it on a timer so rendering never waits on it
+void Application::SetTitle(const FrameSnapshot& snapshot)
 {
-	swprintf_s(m_TitleBuffer, TITLE_BUFFER_SIZE, L"%s Width:%d Height:%d FPS:%f\n", WINDOWTITLE, m_Window.GetClientWidth(), m_Window.GetClientHeight(), GetFPS());
-	SetWindowTextW(m_Window.GetHandle(), m_TitleBuffer);
+	m_TitleElapsed += m_FrameTime;
+	if (m_TitleElapsed < 0.25f)
+		return;
+	m_TitleElapsed = 0.0f;
+	const FrameStats::Summary frame = m_FrameStats.GetSummary(FrameStats::PhaseFrame);
+	const PathStatistics& rays = m_Renderer.GetRayStatistics()->GetLastFrame();
+	std::lock_guard<std::mutex> lock(m_TitleMutex);
+	swprintf_s(m_TitleBuffer, TITLE_BUFFER_SIZE, L"%s Width:%d Height:%d Scale:%.2f Frame p50:%.2fms p99:%.2fms max:%.2fms Samples:%u Traced:%.0f%% Bounces:%.2f Allocations:%u (%llu bytes) Dropped input:%u\n", WINDOWTITLE, snapshot.Width, snapshot.Height, m_ResolutionController.GetScale(), frame.P50, frame.P99, frame.Max, m_Accumulation.GetSampleCount(), 100.0 * rays.Paths / ((UINT64)m_FrameConstants.RenderWidth * m_FrameConstants.RenderHeight), rays.GetAverageBounces(), m_LastFrameAllocations.Allocations, m_LastFrameAllocations.Bytes, Input::GetDroppedEventCount());
 }
 
 void Application::OnInit()
 {
-	m_Camera.CreateResource(m_Renderer.GetDevice(), m_Renderer.GetHeap(), &m_Renderer.m_DescriptorHeap);
-
-	m_Scene.Init(m_Renderer.GetDevice(), m_Renderer.GetHeap());
+	m_Scene.Init(m_Renderer.GetDevice(), m_Renderer.GetHeap(), m_Renderer.GetUploadRing());
 	BuildAssets(m_Renderer.GetCommandList());
 
-	m_rayGenLibrary = CompileShaderLibrary(L"Shaders/RayGen.hlsl");
-	m_missLibrary = CompileShaderLibrary(L"Shaders/Miss.hlsl");
-	m_hitLibrary = CompileShaderLibrary(L"Shaders/Hit.hlsl");
+	{
+		PROFILE_SCOPE("Shader compilation");
+		m_ShaderCompiler.Create(L"ShaderCache");
+		std::vector<Microsoft::WRL::ComPtr<IDxcBlob>> libraries = m_ShaderCompiler.CompileLibraries({ L"Shaders/RayGen.hlsl", L"Shaders/Miss.hlsl", L"Shaders/Hit.hlsl" }, m_Renderer.GetThreadPool());
+		m_rayGenLibrary = libraries[0];
+		m_missLibrary = libraries[1];
+		m_hitLibrary = libraries[2];
+		const std::wstring cacheReport = L"Shader cache hits: " + std::to_wstring(m_ShaderCompiler.GetCacheHits()) + L" misses: " + std::to_wstring(m_ShaderCompiler.GetCacheMisses()) + L"\n";
+		OutputDebugStringW(cacheReport.c_str());
+	}
 	CreateRootSignatures(m_Renderer.GetDevice());
 	CreateRaytracingPipeline(m_Renderer.GetDevice());
-
-	// TODO move this somewhere?
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_RAYTRACING_ACCELERATION_STRUCTURE;
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.RaytracingAccelerationStructure.Location = m_Scene.GetGPUVirtualAddress();
-	D3D12_CPU_DESCRIPTOR_HANDLE srvHandle = m_Renderer.m_DescriptorHeap.GetCPUHandle(1);
-	m_Renderer.GetDevice()->CreateShaderResourceView(nullptr, &srvDesc, srvHandle);
-
+	CreateSceneView();
+	m_AdaptiveSampler.Create(m_Renderer.GetDevice(), m_Renderer.GetHeap(), m_Renderer.GetDescriptorHeap(), m_Renderer.m_SwapChain.GetWidth(), m_Renderer.m_SwapChain.GetHeight());
+	m_Denoiser.Create(m_Renderer.GetDevice(), m_Renderer.GetHeap(), m_Renderer.GetDescriptorHeap(), &m_ShaderCompiler, m_Renderer.m_SwapChain.GetWidth(), m_Renderer.m_SwapChain.GetHeight());
+	m_TemporalAccumulator.Create(m_Renderer.GetDevice(), m_Renderer.GetDescriptorHeap(), &m_ShaderCompiler, m_Renderer.m_SwapChain.GetWidth(), m_Renderer.m_SwapChain.GetHeight());
+	m_Reconstructor.Create(m_Renderer.GetDevice(), &m_ShaderCompiler);
+	m_Upscaler.Create(m_Renderer.GetDevice(), m_Renderer.GetDescriptorHeap(), &m_ShaderCompiler, m_Renderer.m_SwapChain.GetWidth(), m_Renderer.m_SwapChain.GetHeight());
+	m_FrameCapture.Create(m_Renderer.GetDevice(), m_Renderer.GetHeap(), Renderer::FramesInFlight);
 	CreateShaderBindingTable(m_Renderer.GetDevice(), m_Renderer.GetDescriptorHeap());
 
-	m_Renderer.ExecuteCommandList();
+	m_Scene.EndFrame(m_Renderer.ExecuteCommandList());
 }
 
 void Application::BuildAssets(ID3D12GraphicsCommandList6* commandList)
 {
-	std::vector<Vertex> vertices =
-	{ {0.25,0.25,0.25},{0.25,-0.25,0.25},{0.25,0.25,-0.25},{0.25,-0.25,-0.25},{-0.25,0.25,0.25},{-0.25,-0.25,0.25},{-0.25,0.25,-0.25},{-0.25,-0.25,-0.25} };
-	std::vector<UINT> indices = { 2,4,0,7,2,3,5,6,7,7,1,5,3,0,1,1,4,5,6,4,2,6,2,7,4,6,5,3,1,7,2,0,3,0,4,1 };
-	MeshData cube = { vertices, indices, sizeof(Vertex) };
+	const SceneCamera& view = m_SceneContent.Assets.Camera;
+	m_Camera.SetView(view.Position.x, view.Position.y, view.Position.z, view.Pitch, view.Heading);
+	m_Camera.SetFOV(view.FOV);
 
+	// The primitives of every mesh follow the previous mesh's in one buffer, instances find theirs through InstanceID
 	std::vector<StructuredVertex> structuredVertex;
-	float Color[4] = { 0.5, 0.5, 0.5, 1.0f };
-	for (int i = 0; i < indices.size(); i += 3)
-	{
-		Vertex v1 = vertices[indices[i]];
-		Vertex v2 = vertices[indices[i + 1]];
-		Vertex v3 = vertices[indices[i + 2]];
-		Vertex normal = Normalize(Cross(Subtract(v2, v1), Subtract(v3, v1)));
-		StructuredVertex sv = {};
-		sv.normal[0] = normal.x;
-		sv.normal[1] = normal.y;
-		sv.normal[2] = normal.z;
-		sv.normal[3] = 0.0f;
-		sv.color[0] = abs(normal.x);
-		sv.color[1] = abs(normal.y);
-		sv.color[2] = abs(normal.z);
-		sv.color[3] = 1.0f;
-		structuredVertex.push_back(sv);
+	static_assert(sizeof(StructuredVertex) == sizeof(CpuScene::PrimitiveAttributes));
+	static_assert(sizeof(Vertex) == sizeof(Float3));
+	const std::vector<SceneMesh>& meshes = m_SceneContent.Assets.Meshes;
+	for (UINT i = 0; i < (UINT)meshes.size(); i++)
+	{
+		m_FirstPrimitives.push_back((UINT)structuredVertex.size());
+		std::vector<Vertex> vertices(meshes[i].Positions.size());
+		memcpy(vertices.data(), meshes[i].Positions.data(), vertices.size() * sizeof(Vertex));
+		MeshData mesh = { vertices, meshes[i].Indices, sizeof(Vertex) };
+		m_Scene.AddMesh((BLASIdentifier)i, &mesh);
+		structuredVertex.resize(structuredVertex.size() + meshes[i].Attributes.size());
+		memcpy(structuredVertex.data() + m_FirstPrimitives.back(), meshes[i].Attributes.data(), meshes[i].Attributes.size() * sizeof(StructuredVertex));
 	}
+	// InstanceID has 24 bits
+	if (structuredVertex.size() > 0xFFFFFF)
+		throw std::runtime_error(m_ScenePath + " has more primitives than instance IDs can address");
 
 	UINT64 size = structuredVertex.size() * sizeof(StructuredVertex);
-	m_StructuredBuffer.CreateResource(m_Renderer.GetDevice(), m_Renderer.GetHeap(), &m_Renderer.m_DescriptorHeap, size, 3);
+	m_VertexDescriptor = m_Renderer.GetDescriptorHeap()->AllocatePersistent();
+	m_StructuredBuffer.CreateResource(m_Renderer.GetDevice(), m_Renderer.GetHeap(), m_Renderer.GetDescriptorHeap(), size, m_VertexDescriptor.Index);
 	m_StructuredBuffer.Upload(structuredVertex.data(), size);
-	m_Scene.AddMesh(commandList, MeshCube, &cube);
 
-	BuildScene(commandList);
+	// One list per mesh, recorded in parallel and submitted ahead of the setup list that builds the TLAS
+	for (UINT i = 0; i < m_Scene.GetPendingBuildCount(); i++)
+	{
+		m_Scheduler.AddPass("BLAS build", PassAccelerationStructure, [this, i](ID3D12GraphicsCommandList6* blasList)
+		{
+			m_Scene.RecordPendingBuild(blasList, i);
+		});
+	}
+	m_Scheduler.Record(m_Renderer.GetCommandListPool(), m_Renderer.GetThreadPool());
+	m_Scheduler.Submit(m_Renderer.GetCommandListPool());
+
+	BuildScene();
+	m_Scene.PrepareBuild();
+	m_Scene.Build(commandList);
+}
+
+// TLAS view, recreated whenever the scene had to grow its TLAS buffer
+void Application::CreateSceneView()
+{
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_RAYTRACING_ACCELERATION_STRUCTURE;
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.RaytracingAccelerationStructure.Location = m_Scene.GetGPUVirtualAddress();
+	if (!m_SceneDescriptor.IsValid())
+	{
+		m_SceneDescriptor = m_Renderer.GetDescriptorHeap()->AllocatePersistent();
+	}
+	D3D12_CPU_DESCRIPTOR_HANDLE srvHandle = m_Renderer.GetDescriptorHeap()->GetCPUHandle(m_SceneDescriptor);
+	m_Renderer.GetDevice()->CreateShaderResourceView(nullptr, &srvDesc, srvHandle);
 }
 
-// Rebuild Scene every frame
-void Application::BuildScene(ID3D12GraphicsCommandList6* commandList)
+// Rebuild Scene every frame, the acceleration structure is built from it afterwards.
+// Also uploads each instance's motion, from this frame's world space to the previous frame's, in instance order
+void Application::BuildScene()
 {
 	m_Scene.Reset();
-	XMVECTOR quat = XMQuaternionRotationAxis({ 1.5f,4.0f,13.0f }, angle2 * 2.3f);
-	XMVECTOR quat2 = XMQuaternionRotationAxis({ 1.5f,1.0f,4.0f }, angle2 * 8.3f);
-	XMMATRIX matrix1 = XMMatrixRotationZ(angle2) * XMMatrixTranslation(1, 0, 0) * XMMatrixRotationZ(angle1);
-	XMMATRIX matrix2 = XMMatrixTranslation(0.2f, 1.0f, 0.0f) * XMMatrixRotationQuaternion(quat);
-	XMMATRIX matrix3 = XMMatrixRotationZ(angle2 * -2.0f);
-	XMMATRIX matrix4 = XMMatrixRotationQuaternion(quat2) * XMMatrixTranslation(0.0f, 0.0f, 1.6f);
-	XMMATRIX matrixIdentity = XMMatrixIdentity();
-	m_Scene.AddInstance(MeshCube, &matrix1, 0, 0);
-	m_Scene.AddInstance(MeshCube, &matrix2, 0, 0);
-	m_Scene.AddInstance(MeshCube, &matrix3, 0, 0);
-	m_Scene.AddInstance(MeshCube, &matrix4, 0, 0);
-	m_Scene.Build(commandList);
+	const std::vector<SceneInstance>& instances = m_SceneContent.Instances;
+	m_PreviousTransforms.resize(instances.size());
+	UploadAllocation allocation = m_Renderer.GetUploadRing()->Allocate(instances.size() * sizeof(Transform3x4));
+	Transform3x4* motion = (Transform3x4*)allocation.CPUAddress;
+	for (size_t i = 0; i < instances.size(); i++)
+	{
+		const SceneInstance& instance = instances[i];
+		const Transform3x4 transform = m_SceneContent.Assets.GetInstanceTransform(instance, m_AnimationTime);
+		m_Scene.AddInstance((BLASIdentifier)instance.Mesh, transform, m_FirstPrimitives[instance.Mesh], MaterialDefault);
+		// Static instances skip the inverse, most of a large scene does not move
+		const bool moved = m_HasPreviousTransforms && instance.Animation != SceneInstance::NoAnimation;
+		motion[i] = moved ? TransformConcatenate(TransformInverse(transform), m_PreviousTransforms[i]) : TransformIdentity();
+		m_PreviousTransforms[i] = transform;
+	}
+	m_HasPreviousTransforms = true;
+	m_InstanceMotionAddress = allocation.GPUAddress;
 }
 
 void Application::CreateRaytracingPipeline(ID3D12Device11* device)
 {
-	const UINT payloadSize = 5 * sizeof(float);
+	const UINT payloadSize = 8 * sizeof(float);
 	const UINT attribSize = 2 * sizeof(float);
 	StateObjectGenerator stateObjectGenerator;
 	stateObjectGenerator.AddDXIL_Library(m_rayGenLibrary->GetBufferPointer(), m_rayGenLibrary->GetBufferSize(), { L"RayGen" });
@@ -263,20 +525,75 @@ void Application::CreateRaytracingPipeline(ID3D12Device11* device)
 	stateObjectGenerator.AddHitGroup(L"HitGroup", D3D12_HIT_GROUP_TYPE_TRIANGLES, L"", L"ClosestHit", L"");
 	int shaderConfigIndex = stateObjectGenerator.AddShaderConfig(payloadSize, attribSize);
 	stateObjectGenerator.AddExportsAssociation({ L"RayGen", L"Miss", L"ClosestHit" }, shaderConfigIndex);
+	stateObjectGenerator.AddGlobalRootSignature(m_GlobalSignature.Get());
 	int raygenRootSigIndex = stateObjectGenerator.AddLocalRootSignature(m_rayGenSignature.Get());
 	int missRootSigIndex = stateObjectGenerator.AddLocalRootSignature(m_missSignature.Get());
 	int hitRootSigIndex = stateObjectGenerator.AddLocalRootSignature(m_hitSignature.Get());
 	stateObjectGenerator.AddExportsAssociation({ L"RayGen" }, raygenRootSigIndex);
 	stateObjectGenerator.AddExportsAssociation({ L"Miss" }, missRootSigIndex);
 	stateObjectGenerator.AddExportsAssociation({ L"ClosestHit" }, hitRootSigIndex);
-	stateObjectGenerator.AddPipelineConfig(31);
+	// Bounces are looped in RayGen, only primary and reflection rays are traced from there
+	stateObjectGenerator.AddPipelineConfig(1);
 	m_StateObject = stateObjectGenerator.Build(device);
 }
 
 void Application::CreateRootSignatures(ID3D12Device11* device)
 {
 	{
-		D3D12_DESCRIPTOR_RANGE ranges[2] = {};
+		// Per-frame data lives in the upload ring and is bound by address
+		D3D12_ROOT_PARAMETER parameter = {};
+		parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+		parameter.Descriptor.ShaderRegister = 0;
+		parameter.Descriptor.RegisterSpace = 0;
+		parameter.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+		// Small per-dispatch values go straight into the root signature
+		D3D12_ROOT_PARAMETER constants = {};
+		constants.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+		constants.Constants.ShaderRegister = 1;
+		constants.Constants.RegisterSpace = 0;
+		constants.Constants.Num32BitValues = sizeof(FrameConstants) / 4;
+		constants.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+		// Ray counters are a raw buffer, bound by address like the camera
+		D3D12_ROOT_PARAMETER counters = {};
+		counters.ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV;
+		counters.Descriptor.ShaderRegister = 2;
+		counters.Descriptor.RegisterSpace = 0;
+		counters.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+		// So are the adaptive sampling tile flags
+		D3D12_ROOT_PARAMETER tileFlags = counters;
+		tileFlags.Descriptor.ShaderRegister = 4;
+
+		// Last frame's camera and the instance motion for the motion vectors, b2 and t3
+		D3D12_ROOT_PARAMETER previousCamera = parameter;
+		previousCamera.Descriptor.ShaderRegister = 2;
+		D3D12_ROOT_PARAMETER instanceMotion = parameter;
+		instanceMotion.ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+		instanceMotion.Descriptor.ShaderRegister = 3;
+
+		RootSignatureGenerator globalRootSignatureGenerator(device);
+		globalRootSignatureGenerator.AddParameter(parameter);
+		globalRootSignatureGenerator.AddParameter(constants);
+		globalRootSignatureGenerator.AddParameter(counters);
+		globalRootSignatureGenerator.AddParameter(tileFlags);
+		globalRootSignatureGenerator.AddParameter(previousCamera);
+		globalRootSignatureGenerator.AddParameter(instanceMotion);
+		m_GlobalSignature = globalRootSignatureGenerator.Generate();
+	}
+	// Every descriptor is its own single-entry table, so the allocator may place them anywhere in the heap
+	auto DescriptorTable = [](const D3D12_DESCRIPTOR_RANGE* range)
+	{
+		D3D12_ROOT_PARAMETER parameter = {};
+		parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+		parameter.DescriptorTable.NumDescriptorRanges = 1;
+		parameter.DescriptorTable.pDescriptorRanges = range;
+		parameter.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		return parameter;
+	};
+	{
+		D3D12_DESCRIPTOR_RANGE ranges[7] = {};
 		ranges[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
 		ranges[0].NumDescriptors = 1;
 		ranges[0].BaseShaderRegister = 0;
@@ -284,19 +601,38 @@ void Application::CreateRootSignatures(ID3D12Device11* device)
 		ranges[0].OffsetInDescriptorsFromTableStart = 0;
 
 		ranges[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-		ranges[1].NumDescriptors = 2;
+		ranges[1].NumDescriptors = 1;
 		ranges[1].BaseShaderRegister = 0;
 		ranges[1].RegisterSpace = 0;
-		ranges[1].OffsetInDescriptorsFromTableStart = 1;
-
-		D3D12_ROOT_PARAMETER parameter = {};
-		parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-		parameter.DescriptorTable.NumDescriptorRanges = 2;
-		parameter.DescriptorTable.pDescriptorRanges = ranges;
-		parameter.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		ranges[1].OffsetInDescriptorsFromTableStart = 0;
+
+		ranges[2].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+		ranges[2].NumDescriptors = 1;
+		ranges[2].BaseShaderRegister = 1;
+		ranges[2].RegisterSpace = 0;
+		ranges[2].OffsetInDescriptorsFromTableStart = 0;
+
+		ranges[3].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+		ranges[3].NumDescriptors = 1;
+		ranges[3].BaseShaderRegister = 3;
+		ranges[3].RegisterSpace = 0;
+		ranges[3].OffsetInDescriptorsFromTableStart = 0;
+
+		// Denoiser guides, u5 and u6, and the motion vectors, u7
+		for (UINT i = 4; i < 7; i++)
+		{
+			ranges[i] = ranges[3];
+			ranges[i].BaseShaderRegister = i + 1;
+		}
 
 		RootSignatureGenerator RayGenRootSignatureGenerator(device, D3D12_ROOT_SIGNATURE_FLAG_LOCAL_ROOT_SIGNATURE);
-		RayGenRootSignatureGenerator.AddParameter(parameter);
+		RayGenRootSignatureGenerator.AddParameter(DescriptorTable(&ranges[0]));
+		RayGenRootSignatureGenerator.AddParameter(DescriptorTable(&ranges[1]));
+		RayGenRootSignatureGenerator.AddParameter(DescriptorTable(&ranges[2]));
+		RayGenRootSignatureGenerator.AddParameter(DescriptorTable(&ranges[3]));
+		RayGenRootSignatureGenerator.AddParameter(DescriptorTable(&ranges[4]));
+		RayGenRootSignatureGenerator.AddParameter(DescriptorTable(&ranges[5]));
+		RayGenRootSignatureGenerator.AddParameter(DescriptorTable(&ranges[6]));
 		m_rayGenSignature = RayGenRootSignatureGenerator.Generate();
 	}
 	{
@@ -304,79 +640,39 @@ void Application::CreateRootSignatures(ID3D12Device11* device)
 		m_missSignature = missRootSignatureGenerator.Generate();
 	}
 	{
-		D3D12_DESCRIPTOR_RANGE ranges[1] = {};
-		ranges[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-		ranges[0].NumDescriptors = 3;
-		ranges[0].BaseShaderRegister = 0;
-		ranges[0].RegisterSpace = 0;
-		ranges[0].OffsetInDescriptorsFromTableStart = 1;
-
-		D3D12_ROOT_PARAMETER parameter = {};
-		parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-		parameter.DescriptorTable.NumDescriptorRanges = 1;
-		parameter.DescriptorTable.pDescriptorRanges = ranges;
-		parameter.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		D3D12_DESCRIPTOR_RANGE range = {};
+		range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+		range.NumDescriptors = 1;
+		range.BaseShaderRegister = 2;
+		range.RegisterSpace = 0;
+		range.OffsetInDescriptorsFromTableStart = 0;
 
 		RootSignatureGenerator hitRootSignatureGenerator(device, D3D12_ROOT_SIGNATURE_FLAG_LOCAL_ROOT_SIGNATURE);
-		hitRootSignatureGenerator.AddParameter(parameter);
+		hitRootSignatureGenerator.AddParameter(DescriptorTable(&range));
 		m_hitSignature = hitRootSignatureGenerator.Generate();
 	}
 }
 
+// One raygen and miss record, one hit record per material. Instances select theirs through the hit group index
 void Application::CreateShaderBindingTable(ID3D12Device11* device, DescriptorHeap* descriptorHeap)
 {
-	D3D12_GPU_DESCRIPTOR_HANDLE srvUavHeapHandle = descriptorHeap->GetGPUHandle(0);
-	ComPtr<ID3D12StateObjectProperties> stateObjectProps;
-	UINT shaderIdentifierSize = D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
-	ThrowIfFailed(m_StateObject.As(&stateObjectProps));
-
-	void* rayGenShaderIdentifier = stateObjectProps->GetShaderIdentifier(L"RayGen");
-	void* missShaderIdentifier = stateObjectProps->GetShaderIdentifier(L"Miss");
-	void* hitGroupShaderIdentifier = stateObjectProps->GetShaderIdentifier(L"HitGroup");
-
-	UINT64 elementSize = 64ULL * 3;
-
-	m_ShaderBindingTable = m_Renderer.GetHeap()->CreateBufferResource(device, UploadHeap, D3D12_RESOURCE_STATE_GENERIC_READ, elementSize);
-	void* Source = nullptr;
+	ShaderTableLayout layout;
+	layout.AddRecord(ShaderTableLayout::SectionRayGen, 7 * sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
+	layout.AddRecord(ShaderTableLayout::SectionMiss, 0);
+	for (UINT i = 0; i < MaterialCount; i++)
 	{
-		void* DestinationStart = nullptr;
-		const D3D12_RANGE readRange = { 0, 0 };
-		ThrowIfFailed(m_ShaderBindingTable->Map(0, &readRange, &DestinationStart));
-		void* Destination = DestinationStart;
-
-		Source = rayGenShaderIdentifier;
-		memcpy(Destination, Source, shaderIdentifierSize);
-		Destination = (UINT8*)Destination + shaderIdentifierSize;
-
-		//Copy Arguments
-		{
-			D3D12_GPU_DESCRIPTOR_HANDLE descriptorhandle = m_Renderer.m_DescriptorHeap.GetGPUHandle(0);
-			UINT64 data = (UINT64)descriptorhandle.ptr;
-			memcpy(Destination, &data, sizeof(data));
-			Destination = (UINT8*)Destination + sizeof(data);
-		}
-
-		Source = missShaderIdentifier;
-		Destination = (UINT8*)DestinationStart + 64ULL;
-		memcpy(Destination, Source, shaderIdentifierSize);
-
-		Source = hitGroupShaderIdentifier;
-		Destination = (UINT8*)DestinationStart + 64ULL * 2;
-		memcpy(Destination, Source, shaderIdentifierSize);
-		Destination = (UINT8*)Destination + shaderIdentifierSize;
-
-		//Copy Arguments
-		{
-			D3D12_GPU_DESCRIPTOR_HANDLE descriptorhandle = m_Renderer.m_DescriptorHeap.GetGPUHandle(0);
-			UINT64 data = (UINT64)descriptorhandle.ptr;
-			memcpy(Destination, &data, sizeof(data));
-			Destination = (UINT8*)Destination + sizeof(data);
-		}
-
-		m_ShaderBindingTable->Unmap(0, nullptr);
+		layout.AddRecord(ShaderTableLayout::SectionHitGroup, sizeof(D3D12_GPU_DESCRIPTOR_HANDLE));
 	}
-
-	TransitionResource(m_Renderer.GetCommandList(), m_ShaderBindingTable.Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	layout.Finalize();
+	m_ShaderTable.Create(device, m_Renderer.GetHeap(), m_StateObject.Get(), layout, Renderer::FramesInFlight);
+
+	//Output UAV table, scene SRV table, accumulation UAV table, luminance squares UAV table, denoiser guide UAV tables, motion vector UAV table
+	const D3D12_GPU_DESCRIPTOR_HANDLE rayGenArguments[] = { m_Renderer.GetOutputDescriptor(), descriptorHeap->GetGPUHandle(m_SceneDescriptor), m_Renderer.GetAccumulationDescriptor(), m_AdaptiveSampler.GetLuminanceSquaresDescriptor(), m_Denoiser.GetNormalDepthDescriptor(), m_Denoiser.GetAlbedoDescriptor(), m_TemporalAccumulator.GetMotionDescriptor() };
+	m_ShaderTable.SetRecord(ShaderTableLayout::SectionRayGen, 0, L"RayGen", rayGenArguments, sizeof(rayGenArguments));
+	m_ShaderTable.SetRecord(ShaderTableLayout::SectionMiss, 0, L"Miss");
+	//Vertex attribute table
+	const D3D12_GPU_DESCRIPTOR_HANDLE hitArguments[] = { descriptorHeap->GetGPUHandle(m_VertexDescriptor) };
+	m_ShaderTable.SetRecord(ShaderTableLayout::SectionHitGroup, MaterialDefault, L"HitGroup", hitArguments, sizeof(hitArguments));
 }
 
 LRESULT CALLBACK Application::WindProcInit(HWND hwindow, UINT message, WPARAM wParam, LPARAM lParam)
@@ -415,10 +711,20 @@ LRESULT CALLBACK Application::WindProc(HWND hwindow, UINT message, WPARAM wParam
 		}
 		case WM_PAINT:
 		{
-			Update();
-			Render();
+			// Frames are produced by the render thread
+			ValidateRect(hwindow, nullptr);
 			return 0;
 		}
+		case WM_TIMER:
+		{
+			if (wParam == TITLE_TIMER_ID)
+			{
+				std::lock_guard<std::mutex> lock(m_TitleMutex);
+				SetWindowTextW(hwindow, m_TitleBuffer);
+				return 0;
+			}
+			break;
+		}
 		case WM_KILLFOCUS:
 		{
 			Input::KillFocus();
@@ -426,7 +732,8 @@ LRESULT CALLBACK Application::WindProc(HWND hwindow, UINT message, WPARAM wParam
 		}
 		case WM_SIZE:
 		{
-			Resize();
+			m_Window.ResizedWindow();
+			m_ClientSize = ((UINT64)m_Window.GetClientWidth() << 32) | m_Window.GetClientHeight();
 			return 0;
 		}
 		break;
@@ -442,7 +749,7 @@ LRESULT CALLBACK Application::WindProc(HWND hwindow, UINT message, WPARAM wParam
 			RAWINPUT pData = {};
 			if (GetRawInputData((HRAWINPUT)lParam, RID_INPUT, (void*)&pData, &dataSize, sizeof(RAWINPUTHEADER)) == dataSize)
 			{
-				Input::RawMouseAccumulator(pData.data.mouse.lLastX, pData.data.mouse.lLastY);
+				Input::RawMouseMove(pData.data.mouse.lLastX, pData.data.mouse.lLastY);
 			}
 			break;
 		}
@@ -519,6 +826,39 @@ LRESULT CALLBACK Application::WindProc(HWND hwindow, UINT message, WPARAM wParam
 			case 'V':
 				m_Renderer.ToggleVSync();
 				break;
+			case 'P':
+				m_PauseAnimation = !m_PauseAnimation;
+				break;
+			case 'R':
+				m_RussianRoulette = !m_RussianRoulette;
+				break;
+			case 'T':
+				m_AdaptiveSampling = !m_AdaptiveSampling;
+				break;
+			case 'N':
+				m_Denoise = !m_Denoise;
+				break;
+			case 'H':
+				m_TemporalReuse = !m_TemporalReuse;
+				break;
+			case 'I':
+				m_InterleaveMode = (InterleavedSampling::Mode)((m_InterleaveMode + 1) % InterleavedSampling::InterleaveModeCount);
+				break;
+			case 'G':
+				m_DynamicResolution = !m_DynamicResolution;
+				break;
+			case VK_F5:
+				m_ValidateDenoiser = true;
+				break;
+			case VK_F9:
+				m_CaptureFrame = true;
+				break;
+			case VK_F2:
+				m_DumpFrameStats = true;
+				break;
+			case VK_F3:
+				m_ToggleTraceCapture = true;
+				break;
 			case VK_ESCAPE:
 				Exit();
 				break;
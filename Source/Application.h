@@ -4,27 +4,86 @@
 #include "Renderer.h"
 #include "Camera.h"
 #include "AccelerationStructure.h"
+#include "Heap.h"
+#include "Input.h"
+#include "FrameStats.h"
+#include "Profiler.h"
+#include "CommandScheduler.h"
+#include "ShaderBindingTable.h"
+#include "ShaderCompiler.h"
+#include "AccumulationState.h"
+#include "AdaptiveSampler.h"
+#include "AdaptiveSampling.h"
+#include "Denoiser.h"
+#include "TemporalAccumulator.h"
+#include "Reconstructor.h"
+#include "Upscaler.h"
+#include "ResolutionController.h"
+#include "FrameCapture.h"
+#include "ImageWriter.h"
+#include "SceneFile.h"
 
-class HeapManager;
+// Submission order of the passes recorded each frame
+enum PassOrder
+{
+	PassAccelerationStructure = 0,
+	PassRaytrace = 1,
+	PassFrameEnd = 2
+};
+
+// Hit group records in the shader binding table, one per material
+enum Material
+{
+	MaterialDefault = 0,
+	MaterialCount
+};
+
+// Root constants of the global root signature, register b1
+struct FrameConstants
+{
+	UINT SampleIndex; // 0 restarts accumulation
+	UINT RouletteStartBounce; // bounces always followed before Russian roulette may end a path
+	UINT AdaptiveMinSamples; // samples every pixel receives before converged tiles are skipped
+	float AdaptiveThreshold; // relative error below which a tile stops sampling
+	UINT RandomSequence; // restarts so far, every accumulation draws from new random streams
+	UINT JitterFirstSample; // set for temporal reuse, which needs the first samples at new positions
+	UINT InterleaveMode; // InterleavedSampling::Mode, the share of pixels traced per frame
+	UINT RenderWidth; // traced part of the textures, smaller than the window with dynamic resolution
+	UINT RenderHeight;
+};
+constexpr UINT DefaultRouletteStartBounce = 2;
+constexpr UINT DisableRoulette = 0xFFFFFFFF;
+
+// Everything the render thread needs from the message thread for one frame, copied once at frame start
+struct FrameSnapshot
+{
+	Input::InputState Input;
+	UINT Width;
+	UINT Height;
+};
 
 class Application
 {
 public:
-	Application(HINSTANCE hInstance);
+	Application(HINSTANCE hInstance, const std::string& scenePath);
 	~Application();
 	int Run();
-	void Resize();
+	void Resize(const FrameSnapshot& snapshot);
 	void Update();
 	void Render();
-	void Exit() const;
+	void Exit();
 private:
+	void RenderLoop();
+	void StopRenderThread();
+	FrameSnapshot TakeSnapshot();
 	void InitializeInput();
 	void UpdateFrameTime();
-	float GetFPS() const;
-	void SetTitle() const;
+	void SetTitle(const FrameSnapshot& snapshot);
 	void OnInit();
 	void BuildAssets(ID3D12GraphicsCommandList6* commandList);
-	void BuildScene(ID3D12GraphicsCommandList6* commandList);
+	void BuildScene();
+	void RecordRaytracing(ID3D12GraphicsCommandList6* commandList, bool validateDenoiser);
+	void CreateSceneView();
 	void CreateRaytracingPipeline(ID3D12Device11* device);
 	void CreateRootSignatures(ID3D12Device11* device);
 	void CreateShaderBindingTable(ID3D12Device11* device, DescriptorHeap* descriptorHeap);
@@ -35,18 +94,60 @@ private:
 	Window m_Window;
 	Renderer m_Renderer;
 	float m_FrameTime;
+	HeapAllocationStats m_LastFrameAllocations;
+	FrameStats m_FrameStats;
+	std::atomic<bool> m_DumpFrameStats = false; // requested from the message thread
+	std::atomic<bool> m_ToggleTraceCapture = false;
+	std::atomic<bool> m_PauseAnimation = false;
+	std::atomic<bool> m_RussianRoulette = true;
+	std::atomic<bool> m_AdaptiveSampling = true;
+	std::atomic<bool> m_Denoise = false;
+	std::atomic<bool> m_TemporalReuse = true;
+	std::atomic<InterleavedSampling::Mode> m_InterleaveMode = InterleavedSampling::InterleaveFull;
+	std::atomic<bool> m_DynamicResolution = false;
+	std::atomic<bool> m_ValidateDenoiser = false; // requested from the message thread
+	std::atomic<bool> m_CaptureFrame = false; // requested from the message thread
+	UINT m_CaptureCount = 0;
+	float m_TitleElapsed = 0.0f;
 	WCHAR* m_TitleBuffer;
+	std::mutex m_TitleMutex;
+	std::thread m_RenderThread;
+	std::atomic<bool> m_Running = false;
+	bool m_Exiting = false;
+	std::atomic<UINT64> m_ClientSize = 0; // width in the high, height in the low 32 bits
 	SceneAccelerationStructure m_Scene;
+	CommandScheduler<CommandListPool> m_Scheduler;
+	DescriptorRange m_SceneDescriptor;
+	DescriptorRange m_VertexDescriptor;
+	AccumulationState m_Accumulation;
+	AdaptiveSampler m_AdaptiveSampler;
+	Denoiser m_Denoiser;
+	DenoiserSettings m_DenoiserSettings;
+	TemporalAccumulator m_TemporalAccumulator;
+	Reconstructor m_Reconstructor;
+	Upscaler m_Upscaler;
+	ResolutionController m_ResolutionController;
+	FrameCapture m_FrameCapture;
+	ImageWriter m_ImageWriter;
+	std::string m_ScenePath;
+	SceneContent m_SceneContent;
+	std::vector<UINT> m_FirstPrimitives; // per mesh, the instance ID of its instances
+	// Instance transforms of the previous frame, for the motion vectors
+	std::vector<Transform3x4> m_PreviousTransforms;
+	bool m_HasPreviousTransforms = false;
+	D3D12_GPU_VIRTUAL_ADDRESS m_InstanceMotionAddress = 0;
+	FrameConstants m_FrameConstants = {};
 	Microsoft::WRL::ComPtr<IDxcBlob> m_rayGenLibrary;
 	Microsoft::WRL::ComPtr<IDxcBlob> m_hitLibrary;
 	Microsoft::WRL::ComPtr<IDxcBlob> m_missLibrary;
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_GlobalSignature;
 	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_rayGenSignature;
 	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_hitSignature;
 	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_missSignature;
 	Microsoft::WRL::ComPtr<ID3D12StateObject> m_StateObject;
-	Microsoft::WRL::ComPtr<ID3D12Resource2> m_ShaderBindingTable;
+	ShaderBindingTable m_ShaderTable;
+	ShaderCompiler m_ShaderCompiler;
 	Camera m_Camera;
 	StructuredBuffer m_StructuredBuffer;
-	float angle1 = 0.0f;
-	float angle2 = 0.0f;
+	double m_AnimationTime = 0.0; // seconds of unpaused animation, the scene file's curves are evaluated at it
 };
@@ -0,0 +1,67 @@
+#include "PCH.h"
+#include "BufferPool.h"
+#include "DX12Utility.h"
+
+void BufferPool::Create(ID3D12Device11* device, HeapManager* heap, HeapType type, D3D12_RESOURCE_STATES state, D3D12_RESOURCE_FLAGS flags)
+{
+	m_Device = device;
+	m_Heap = heap;
+	m_HeapType = type;
+	m_State = state;
+	m_Flags = flags;
+}
+
+ID3D12Resource2* BufferPool::Acquire(UINT64 size)
+{
+	const UINT sizeClass = GetSizeClass(size);
+	ComPtr<ID3D12Resource2> resource;
+	if (m_Free[sizeClass].empty())
+	{
+		resource = m_Heap->CreateBufferResource(m_Device, m_HeapType, m_State, 1ULL << (sizeClass + MinClassShift), m_Flags);
+	}
+	else
+	{
+		resource = m_Free[sizeClass].back();
+		m_Free[sizeClass].pop_back();
+	}
+	m_InUse.push_back({ resource, sizeClass });
+	return resource.Get();
+}
+
+// Tags every buffer handed out since the last call with the fence value of the frame that used them
+void BufferPool::EndFrame(UINT64 fenceValue)
+{
+	m_InFlight.emplace_back(fenceValue, std::move(m_InUse));
+	m_InUse.clear();
+}
+
+void BufferPool::Retire(UINT64 completedFenceValue)
+{
+	while (!m_InFlight.empty() && m_InFlight.front().first <= completedFenceValue)
+	{
+		for (PooledBuffer& buffer : m_InFlight.front().second)
+		{
+			m_Free[buffer.SizeClass].push_back(buffer.Resource);
+		}
+		m_InFlight.pop_front();
+	}
+}
+
+UINT64 BufferPool::GetClassSize(UINT64 size)
+{
+	return 1ULL << (GetSizeClass(size) + MinClassShift);
+}
+
+UINT BufferPool::GetSizeClass(UINT64 size)
+{
+	UINT sizeClass = 0;
+	while ((1ULL << (sizeClass + MinClassShift)) < size)
+	{
+		sizeClass++;
+	}
+	if (sizeClass >= MaxSizeClasses)
+	{
+		throw std::runtime_error("BufferPool request exceeds largest size class");
+	}
+	return sizeClass;
+}
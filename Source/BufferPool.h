@@ -0,0 +1,32 @@
+#pragma once
+#include "PCH.h"
+#include "Heap.h"
+
+// Size-classed pool of GPU buffers. Buffers are handed out for the duration of a frame and
+// returned to their size class once that frame's fence has completed, so steady state building does not allocate.
+class BufferPool
+{
+public:
+	void Create(ID3D12Device11* device, HeapManager* heap, HeapType type, D3D12_RESOURCE_STATES state, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
+	ID3D12Resource2* Acquire(UINT64 size);
+	void EndFrame(UINT64 fenceValue);
+	void Retire(UINT64 completedFenceValue);
+	static UINT64 GetClassSize(UINT64 size);
+private:
+	static constexpr UINT MinClassShift = 16; // 64 KB, the default placement alignment
+	static constexpr UINT MaxSizeClasses = 24;
+	static UINT GetSizeClass(UINT64 size);
+	struct PooledBuffer
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource2> Resource;
+		UINT SizeClass;
+	};
+	ID3D12Device11* m_Device = nullptr;
+	HeapManager* m_Heap = nullptr;
+	HeapType m_HeapType = DefaultHeap;
+	D3D12_RESOURCE_STATES m_State = D3D12_RESOURCE_STATE_COMMON;
+	D3D12_RESOURCE_FLAGS m_Flags = D3D12_RESOURCE_FLAG_NONE;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource2>> m_Free[MaxSizeClasses];
+	std::vector<PooledBuffer> m_InUse;
+	std::deque<std::pair<UINT64, std::vector<PooledBuffer>>> m_InFlight;
+};
@@ -6,6 +6,7 @@
 #include "DescriptorHeap.h"
 #include "MathUtility.h"
 #include "DX12Utility.h"
+#include "Hash.h"
 
 #define MinPitch -DirectX::XM_PI / 2.0
 #define MaxPitch DirectX::XM_PI / 2.0
@@ -18,25 +19,30 @@ Camera::Camera() :
 	m_Heading(0.0f),
 	m_Pitch(0.5f),
 	m_FOV(1.25f),
-	m_AspectRatio(1.0f)
+	m_AspectRatio(1.0f),
+	m_GPUAddress(0),
+	m_PreviousGPUAddress(0)
 {}
 
-void Camera::CreateResource(ID3D12Device11* device, HeapManager* heap, DescriptorHeap* descriptorHeap)
+void Camera::SetView(float x, float y, float z, float pitch, float heading)
 {
-	m_StructuredBuffer.CreateResource(device, heap, descriptorHeap, sizeof(XMFLOAT4) * 4, 2);
+	m_CameraBuffer.CameraPosition = XMVectorSet(x, y, z, 1.0f);
+	m_Pitch = pitch;
+	m_Heading = heading;
 }
 
-void Camera::Update(float deltaTime)
+void Camera::Update(float deltaTime, const Input::InputState& input, UploadRing* uploadRing)
 {
-	if (Input::GetButtonState(0))
+	const CameraBuffer previous = m_CameraBuffer;
+	if (Input::GetButtonState(input, 0))
 	{
 		float MouseSensitivity = 1.65f;
-		m_Heading += Input::GetMouseXDelta() * MouseSensitivity;
+		m_Heading += Input::GetMouseXDelta(input) * MouseSensitivity;
 		if (m_Heading > PI2)
 			m_Heading -= PI2;
 		if (m_Heading < 0)
 			m_Heading += PI2;
-		m_Pitch = clamp(m_Pitch + Input::GetMouseYDelta() * MouseSensitivity, MinPitch, MaxPitch);
+		m_Pitch = clamp(m_Pitch + Input::GetMouseYDelta(input) * MouseSensitivity, MinPitch, MaxPitch);
 	}
 
 	XMMATRIX cameraLookMatrix = XMMatrixRotationY(m_Pitch) * XMMatrixRotationZ(m_Heading);
@@ -45,27 +51,27 @@ void Camera::Update(float deltaTime)
 	m_CameraBuffer.Up = XMVector3Transform({ 0.0f, 0.0f, -1.0f, 0.0f }, cameraLookMatrix);
 
 	XMVECTOR direction = {};
-	if (Input::GetKeyState('W'))
+	if (Input::GetKeyState(input, 'W'))
 	{
 		direction += { 1.0f, 0.0f, 0.0f, 0.0f };
 	}
-	if (Input::GetKeyState('S'))
+	if (Input::GetKeyState(input, 'S'))
 	{
 		direction += { -1.0f, 0.0f, 0.0f, 0.0f };
 	}
-	if (Input::GetKeyState('A'))
+	if (Input::GetKeyState(input, 'A'))
 	{
 		direction += { 0.0f, -1.0f, 0.0f, 0.0f };
 	}
-	if (Input::GetKeyState('D'))
+	if (Input::GetKeyState(input, 'D'))
 	{
 		direction += { 0.0f, 1.0f, 0.0f, 0.0f };
 	}
-	if (Input::GetKeyState('E'))
+	if (Input::GetKeyState(input, 'E'))
 	{
 		direction += { 0.0f, 0.0f, 1.0f, 0.0f };
 	}
-	if (Input::GetKeyState('Q'))
+	if (Input::GetKeyState(input, 'Q'))
 	{
 		direction += { 0.0f, 0.0f, -1.0f, 0.0f };
 	}
@@ -73,7 +79,23 @@ void Camera::Update(float deltaTime)
 	direction *= MovementSensitivity * deltaTime;
 	direction = XMVector3Transform(direction, cameraLookMatrix);
 	m_CameraBuffer.CameraPosition += direction;
-	m_StructuredBuffer.Upload(&m_CameraBuffer, sizeof(m_CameraBuffer));
+
+	// Before the first update there is no previous frame, it moved nowhere
+	m_PreviousCameraBuffer = m_GPUAddress ? previous : m_CameraBuffer;
+
+	// The GPU may still read last frame's copy, so every frame gets its own constants
+	UploadAllocation allocation = uploadRing->Allocate(sizeof(m_CameraBuffer));
+	memcpy(allocation.CPUAddress, &m_CameraBuffer, sizeof(m_CameraBuffer));
+	m_GPUAddress = allocation.GPUAddress;
+	UploadAllocation previousAllocation = uploadRing->Allocate(sizeof(m_PreviousCameraBuffer));
+	memcpy(previousAllocation.CPUAddress, &m_PreviousCameraBuffer, sizeof(m_PreviousCameraBuffer));
+	m_PreviousGPUAddress = previousAllocation.GPUAddress;
+}
+
+// Changes whenever anything the rays depend on moves, used to restart accumulation
+UINT64 Camera::GetStateHash() const
+{
+	return HashBytes(&m_CameraBuffer, sizeof(m_CameraBuffer));
 }
 
 //void Camera::Upload()
@@ -1,17 +1,22 @@
 #pragma once
 #include "PCH.h"
-#include "StructuredBuffer.h"
+#include "UploadRing.h"
+#include "Input.h"
 
 class Camera
 {
 public:
 	Camera();
-	void CreateResource(ID3D12Device11* device, HeapManager* heap, DescriptorHeap* descriptorHeap);
-	void Update(float deltaTime);
+	void Update(float deltaTime, const Input::InputState& input, UploadRing* uploadRing);
 	inline void SetFOV(float fov) { m_FOV = fov; }
+	// Starting view, for example from a scene file
+	void SetView(float x, float y, float z, float pitch, float heading);
 	inline void SetAspectRatio(float aspectRatio) { m_AspectRatio = aspectRatio; }
+	inline D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const { return m_GPUAddress; }
+	// Last frame's constants in this frame's upload, for the motion vectors
+	inline D3D12_GPU_VIRTUAL_ADDRESS GetPreviousGPUVirtualAddress() const { return m_PreviousGPUAddress; }
+	UINT64 GetStateHash() const;
 private:
-	StructuredBuffer m_StructuredBuffer;
 	struct CameraBuffer
 	{
 		DirectX::XMVECTOR CameraPosition;
@@ -19,9 +24,12 @@ private:
 		DirectX::XMVECTOR Right;
 		DirectX::XMVECTOR Up;
 	} m_CameraBuffer;
+	CameraBuffer m_PreviousCameraBuffer;
 	float m_Heading;
 	float m_Pitch;
 	float m_FOV;
 	float m_AspectRatio;
+	D3D12_GPU_VIRTUAL_ADDRESS m_GPUAddress;
+	D3D12_GPU_VIRTUAL_ADDRESS m_PreviousGPUAddress;
 };
 
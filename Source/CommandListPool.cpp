@@ -0,0 +1,44 @@
+#include "PCH.h"
+#include "CommandListPool.h"
+#include "CommandQueue.h"
+#include "DX12Utility.h"
+
+void CommandListPool::Create(ID3D12Device11* device, CommandQueue* commandQueue, UINT framesInFlight)
+{
+	m_Device = device;
+	m_CommandQueue = commandQueue;
+	m_Frames.resize(framesInFlight);
+}
+
+void CommandListPool::BeginFrame(UINT frameIndex)
+{
+	m_FrameIndex = frameIndex;
+	m_Frames[frameIndex].Used = 0;
+}
+
+// Lists are created closed and reset when handed out, so an unused list never holds a stale allocator
+ID3D12GraphicsCommandList6* CommandListPool::Acquire()
+{
+	FrameLists& frame = m_Frames[m_FrameIndex];
+	if (frame.Used == frame.Entries.size())
+	{
+		Entry entry;
+		ThrowIfFailed(m_Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&entry.CommandAllocator)));
+		ThrowIfFailed(m_Device->CreateCommandList1(0, D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_FLAG_NONE, IID_PPV_ARGS(&entry.CommandList)));
+		frame.Entries.push_back(entry);
+	}
+	Entry& entry = frame.Entries[frame.Used++];
+	ThrowIfFailed(entry.CommandAllocator->Reset());
+	ThrowIfFailed(entry.CommandList->Reset(entry.CommandAllocator.Get(), nullptr));
+	return entry.CommandList.Get();
+}
+
+void CommandListPool::Close(ID3D12GraphicsCommandList6* commandList)
+{
+	ThrowIfFailed(commandList->Close());
+}
+
+void CommandListPool::Submit(ID3D12GraphicsCommandList6* const* commandLists, uint32_t count)
+{
+	m_CommandQueue->ExecuteCommandLists(commandLists, count);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "PCH.h"
+
+class CommandQueue;
+
+// Command lists with their own allocators, one set per frame in flight. Every pass of a frame gets a separate
+// list so passes can be recorded on different threads; a set is reset only after its frame's fence completed.
+// This is the D3D12 backend of CommandScheduler.
+class CommandListPool
+{
+public:
+	using CommandList = ID3D12GraphicsCommandList6;
+	void Create(ID3D12Device11* device, CommandQueue* commandQueue, UINT framesInFlight);
+	void BeginFrame(UINT frameIndex);
+	ID3D12GraphicsCommandList6* Acquire();
+	void Close(ID3D12GraphicsCommandList6* commandList);
+	void Submit(ID3D12GraphicsCommandList6* const* commandLists, uint32_t count);
+private:
+	struct Entry
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CommandAllocator;
+		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList6> CommandList;
+	};
+	struct FrameLists
+	{
+		std::vector<Entry> Entries;
+		UINT Used = 0;
+	};
+	ID3D12Device11* m_Device = nullptr;
+	CommandQueue* m_CommandQueue = nullptr;
+	std::vector<FrameLists> m_Frames;
+	UINT m_FrameIndex = 0;
+};
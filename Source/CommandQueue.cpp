@@ -36,6 +36,13 @@ void CommandQueue::ExecuteCommandList(ID3D12GraphicsCommandList6* commandList)
 	m_CommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
 }
 
+// One submission for the whole batch, executed in array order
+void CommandQueue::ExecuteCommandLists(ID3D12GraphicsCommandList6* const* commandLists, UINT count)
+{
+	std::vector<ID3D12CommandList*> ppCommandLists(commandLists, commandLists + count);
+	m_CommandQueue->ExecuteCommandLists(count, ppCommandLists.data());
+}
+
 UINT64 CommandQueue::Signal()
 {
 	m_FenceValue++;
@@ -46,9 +53,9 @@ UINT64 CommandQueue::Signal()
 
 void CommandQueue::WaitForFenceValue(UINT64 fenceValue)
 {
-	if (m_Fence->GetCompletedValue() < m_FenceValue)
+	if (m_Fence->GetCompletedValue() < fenceValue)
 	{
-		ThrowIfFailed(m_Fence->SetEventOnCompletion(m_FenceValue, m_EventHandle));
+		ThrowIfFailed(m_Fence->SetEventOnCompletion(fenceValue, m_EventHandle));
 		WaitForSingleObject(m_EventHandle, INFINITE);
 	}
 }
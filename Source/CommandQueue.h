@@ -8,8 +8,10 @@ public:
 	~CommandQueue();
 	void Create(ID3D12Device11* device, D3D12_COMMAND_LIST_TYPE type);
 	void ExecuteCommandList(ID3D12GraphicsCommandList6* commandList);
+	void ExecuteCommandLists(ID3D12GraphicsCommandList6* const* commandLists, UINT count);
 	inline ID3D12CommandQueue* GetPtr() { return m_CommandQueue.Get(); }
 	UINT64 Signal();
+	inline UINT64 GetCompletedFenceValue() { return m_Fence->GetCompletedValue(); }
 	void WaitForFenceValue(UINT64 fenceValue);
 	void Flush();
 private:
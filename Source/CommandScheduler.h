@@ -0,0 +1,84 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+// Records a frame's passes into separate command lists on the thread pool, then submits them in pass order
+// with a single call, independent of which worker finished first. The backend supplies the lists:
+//   CommandList* Acquire();                                    called serially before recording
+//   void Close(CommandList* list);                              called on the recording thread
+//   void Submit(CommandList* const* lists, uint32_t count);
+// CommandListPool is the D3D12 backend, RecordedCommandBackend a device-free stand-in.
+template<typename Backend>
+class CommandScheduler
+{
+public:
+	using CommandList = typename Backend::CommandList;
+	using RecordFunction = std::function<void(CommandList* commandList)>;
+	struct PassTiming
+	{
+		const char* Name;
+		double RecordMilliseconds;
+	};
+	// recordLast passes are recorded on the calling thread after all others, e.g. to resolve queries they issued
+	void AddPass(const char* name, uint32_t order, RecordFunction record, bool recordLast = false)
+	{
+		m_Passes.push_back({ name, order, std::move(record), recordLast, nullptr, 0.0 });
+	}
+	void Record(Backend* backend, ThreadPool* threadPool)
+	{
+		std::stable_sort(m_Passes.begin(), m_Passes.end(), [](const Pass& a, const Pass& b) { return a.Order < b.Order; });
+		std::vector<uint32_t> parallel;
+		for (uint32_t i = 0; i < (uint32_t)m_Passes.size(); i++)
+		{
+			m_Passes[i].List = backend->Acquire();
+			if (!m_Passes[i].RecordLast)
+				parallel.push_back(i);
+		}
+		threadPool->Dispatch((uint32_t)parallel.size(), [&](uint32_t task) { RecordPass(backend, m_Passes[parallel[task]]); });
+		for (Pass& pass : m_Passes)
+		{
+			if (pass.RecordLast)
+				RecordPass(backend, pass);
+		}
+	}
+	void Submit(Backend* backend)
+	{
+		std::vector<CommandList*> lists;
+		lists.reserve(m_Passes.size());
+		m_Timings.clear();
+		for (const Pass& pass : m_Passes)
+		{
+			lists.push_back(pass.List);
+			m_Timings.push_back({ pass.Name, pass.RecordMilliseconds });
+		}
+		backend->Submit(lists.data(), (uint32_t)lists.size());
+		m_Passes.clear();
+	}
+	// Recording time of every pass of the last submitted frame, in submission order
+	inline const std::vector<PassTiming>& GetTimings() const { return m_Timings; }
+private:
+	struct Pass
+	{
+		const char* Name;
+		uint32_t Order;
+		RecordFunction Record;
+		bool RecordLast;
+		CommandList* List;
+		double RecordMilliseconds;
+	};
+	static void RecordPass(Backend* backend, Pass& pass)
+	{
+		Profiler::ScopedEvent event(pass.Name);
+		const auto start = std::chrono::steady_clock::now();
+		pass.Record(pass.List);
+		backend->Close(pass.List);
+		pass.RecordMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+	std::vector<Pass> m_Passes;
+	std::vector<PassTiming> m_Timings;
+};
@@ -0,0 +1,171 @@
+#include "CpuDenoiser.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+static constexpr uint32_t RowsPerTask = 8;
+// B3 spline, h(0), h(+-1), h(+-2)
+static constexpr float Kernel[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+// Taps weighted below e^-MaxExponent are dropped, which keeps the sums clear of denormals (DENOISE_MAX_EXPONENT)
+static constexpr float MaxExponent = 60.0f;
+
+DenoiserPass DenoiserPass::Get(const DenoiserSettings& settings, uint32_t iteration)
+{
+	DenoiserPass pass;
+	pass.StepWidth = 1u << iteration;
+	pass.InvColorPhi = (float)pass.StepWidth / settings.ColorPhi;
+	pass.InvNormalPhi = 1.0f / settings.NormalPhi;
+	pass.InvDepthPhi = 1.0f / (settings.DepthPhi * (float)pass.StepWidth);
+	pass.InvAlbedoPhi = 1.0f / settings.AlbedoPhi;
+	return pass;
+}
+
+void CpuDenoiser::Denoise(const Float4* color, const Float4* normalDepth, const Float4* albedo, uint32_t width, uint32_t height, const DenoiserSettings& settings, ThreadPool* threadPool, std::vector<Float4>* result)
+{
+	m_Width = width;
+	m_Height = height;
+	m_Stride = (width + SimdFloat::Width - 1) / SimdFloat::Width * SimdFloat::Width;
+	m_Planes.assign((size_t)PlaneCount * m_Stride * height, 0.0f);
+	const uint32_t taskCount = (height + RowsPerTask - 1) / RowsPerTask;
+
+	threadPool->Dispatch(taskCount, [&](uint32_t task)
+	{
+		const uint32_t rowEnd = std::min(height, (task + 1) * RowsPerTask);
+		for (uint32_t y = task * RowsPerTask; y < rowEnd; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				const size_t pixel = (size_t)y * width + x;
+				const size_t element = (size_t)y * m_Stride + x;
+				const Float4& sum = color[pixel];
+				const float inverseCount = sum.w > 0.0f ? 1.0f / sum.w : 0.0f;
+				GetPlane(PlaneColor)[element] = sum.x * inverseCount;
+				GetPlane(PlaneColor + 1)[element] = sum.y * inverseCount;
+				GetPlane(PlaneColor + 2)[element] = sum.z * inverseCount;
+				GetPlane(PlaneNormalX)[element] = normalDepth[pixel].x;
+				GetPlane(PlaneNormalY)[element] = normalDepth[pixel].y;
+				GetPlane(PlaneNormalZ)[element] = normalDepth[pixel].z;
+				GetPlane(PlaneDepth)[element] = normalDepth[pixel].w;
+				GetPlane(PlaneAlbedoR)[element] = albedo[pixel].x;
+				GetPlane(PlaneAlbedoG)[element] = albedo[pixel].y;
+				GetPlane(PlaneAlbedoB)[element] = albedo[pixel].z;
+			}
+		}
+	});
+
+	uint32_t source = PlaneColor;
+	uint32_t destination = PlaneColor + 3;
+	for (uint32_t iteration = 0; iteration < settings.Iterations; iteration++)
+	{
+		const DenoiserPass pass = DenoiserPass::Get(settings, iteration);
+		threadPool->Dispatch(taskCount, [&](uint32_t task)
+		{
+			FilterRows(pass, source, destination, task * RowsPerTask, std::min(height, (task + 1) * RowsPerTask));
+		});
+		std::swap(source, destination);
+	}
+
+	result->resize((size_t)width * height);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			const size_t element = (size_t)y * m_Stride + x;
+			(*result)[(size_t)y * width + x] = { GetPlane(source)[element], GetPlane(source + 1)[element], GetPlane(source + 2)[element], 1.0f };
+		}
+	}
+}
+
+// Groups of four pixels in a row. Taps whose four neighbours are all inside the image are plain loads;
+// near the left and right borders the lanes are gathered one by one and the ones outside get no weight.
+void CpuDenoiser::FilterRows(const DenoiserPass& pass, uint32_t source, uint32_t destination, uint32_t rowBegin, uint32_t rowEnd)
+{
+	constexpr uint32_t ChannelCount = 10;
+	const float* planes[ChannelCount] = {
+		GetPlane(source), GetPlane(source + 1), GetPlane(source + 2),
+		GetPlane(PlaneNormalX), GetPlane(PlaneNormalY), GetPlane(PlaneNormalZ), GetPlane(PlaneDepth),
+		GetPlane(PlaneAlbedoR), GetPlane(PlaneAlbedoG), GetPlane(PlaneAlbedoB) };
+	float* outputs[3] = { GetPlane(destination), GetPlane(destination + 1), GetPlane(destination + 2) };
+	const SimdFloat invColorPhi = SimdSet(pass.InvColorPhi);
+	const SimdFloat invNormalPhi = SimdSet(pass.InvNormalPhi);
+	const SimdFloat invDepthPhi = SimdSet(pass.InvDepthPhi);
+	const SimdFloat invAlbedoPhi = SimdSet(pass.InvAlbedoPhi);
+	const SimdFloat maxExponent = SimdSet(MaxExponent);
+	const int width = (int)m_Width;
+	const int height = (int)m_Height;
+	const int step = (int)pass.StepWidth;
+
+	for (uint32_t y = rowBegin; y < rowEnd; y++)
+	{
+		for (int x = 0; x < width; x += SimdFloat::Width)
+		{
+			SimdFloat center[ChannelCount];
+			for (uint32_t channel = 0; channel < ChannelCount; channel++)
+			{
+				center[channel] = SimdLoad(planes[channel] + (size_t)y * m_Stride + x);
+			}
+			SimdFloat sum[3] = { SimdSet(0.0f), SimdSet(0.0f), SimdSet(0.0f) };
+			SimdFloat weightSum = SimdSet(0.0f);
+			for (int dy = -2; dy <= 2; dy++)
+			{
+				const int qy = (int)y + dy * step;
+				if (qy < 0 || qy >= height)
+					continue;
+				for (int dx = -2; dx <= 2; dx++)
+				{
+					const int qx = x + dx * step;
+					SimdFloat tap[ChannelCount];
+					SimdFloat valid;
+					if (qx >= 0 && qx + (int)SimdFloat::Width <= width)
+					{
+						for (uint32_t channel = 0; channel < ChannelCount; channel++)
+						{
+							tap[channel] = SimdLoad(planes[channel] + (size_t)qy * m_Stride + qx);
+						}
+						valid = SimdSet(1.0f);
+					}
+					else
+					{
+						float lanes[ChannelCount][SimdFloat::Width] = {};
+						float laneValid[SimdFloat::Width] = {};
+						for (uint32_t lane = 0; lane < SimdFloat::Width; lane++)
+						{
+							const int lx = qx + (int)lane;
+							if (lx < 0 || lx >= width || x + (int)lane >= width)
+								continue;
+							laneValid[lane] = 1.0f;
+							for (uint32_t channel = 0; channel < ChannelCount; channel++)
+							{
+								lanes[channel][lane] = planes[channel][(size_t)qy * m_Stride + lx];
+							}
+						}
+						for (uint32_t channel = 0; channel < ChannelCount; channel++)
+						{
+							tap[channel] = SimdLoad(lanes[channel]);
+						}
+						valid = SimdLoad(laneValid);
+					}
+					auto Distance3 = [&](uint32_t first)
+					{
+						const SimdFloat d0 = tap[first] - center[first];
+						const SimdFloat d1 = tap[first + 1] - center[first + 1];
+						const SimdFloat d2 = tap[first + 2] - center[first + 2];
+						return d0 * d0 + d1 * d1 + d2 * d2;
+					};
+					const SimdFloat exponent = Distance3(0) * invColorPhi + Distance3(3) * invNormalPhi + SimdAbs(tap[6] - center[6]) * invDepthPhi + Distance3(7) * invAlbedoPhi;
+					const SimdFloat weight = SimdSet(Kernel[dx < 0 ? -dx : dx] * Kernel[dy < 0 ? -dy : dy]) * valid * SimdLess(exponent, maxExponent) * SimdExp(SimdSet(0.0f) - exponent);
+					sum[0] = sum[0] + tap[0] * weight;
+					sum[1] = sum[1] + tap[1] * weight;
+					sum[2] = sum[2] + tap[2] * weight;
+					weightSum = weightSum + weight;
+				}
+			}
+			// Padding lanes past the last column have no valid taps, keep them finite
+			const SimdFloat inverseWeight = SimdSet(1.0f) / SimdMax(weightSum, SimdSet(1e-20f));
+			for (uint32_t channel = 0; channel < 3; channel++)
+			{
+				SimdStore(outputs[channel] + (size_t)y * m_Stride + x, sum[channel] * inverseWeight);
+			}
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "CpuMath.h"
+
+class ThreadPool;
+
+// Edge-stopping parameters of the à-trous filter, passed to Denoise.hlsl as root constants
+struct DenoiserSettings
+{
+	uint32_t Iterations = 5; // step widths 1, 2, 4, ... 2^(Iterations - 1)
+	float ColorPhi = 0.05f; // halved every iteration, the image gets smoother as it goes
+	float NormalPhi = 0.1f;
+	float DepthPhi = 0.05f; // per unit of step width
+	float AlbedoPhi = 0.01f;
+};
+
+// Per-iteration values both implementations derive from the settings. Weights are
+// h(dx) h(dy) exp(-(|dc|^2 InvColorPhi + |dn|^2 InvNormalPhi + |dz| InvDepthPhi + |da|^2 InvAlbedoPhi)).
+struct DenoiserPass
+{
+	uint32_t StepWidth;
+	float InvColorPhi;
+	float InvNormalPhi;
+	float InvDepthPhi;
+	float InvAlbedoPhi;
+	static DenoiserPass Get(const DenoiserSettings& settings, uint32_t iteration);
+};
+
+// Edge-avoiding à-trous wavelet filter (Dammertz et al. 2010) on the CPU, the reference for Denoise.hlsl.
+// Inputs use the accumulation layout: color holds the rgb sum and the sample count, normalDepth the primary
+// hit's world normal and distance, albedo its surface colour. Works on planes of floats four pixels at a time,
+// one task per band of rows on the thread pool.
+class CpuDenoiser
+{
+public:
+	void Denoise(const Float4* color, const Float4* normalDepth, const Float4* albedo, uint32_t width, uint32_t height, const DenoiserSettings& settings, ThreadPool* threadPool, std::vector<Float4>* result);
+private:
+	enum Plane
+	{
+		PlaneNormalX,
+		PlaneNormalY,
+		PlaneNormalZ,
+		PlaneDepth,
+		PlaneAlbedoR,
+		PlaneAlbedoG,
+		PlaneAlbedoB,
+		PlaneColor, // two sets of rgb, read and written alternately
+		PlaneCount = PlaneColor + 6
+	};
+	inline float* GetPlane(uint32_t plane) { return m_Planes.data() + (size_t)plane * m_Stride * m_Height; }
+	void FilterRows(const DenoiserPass& pass, uint32_t source, uint32_t destination, uint32_t rowBegin, uint32_t rowEnd);
+	std::vector<float> m_Planes;
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+	uint32_t m_Stride = 0; // row length padded to whole SIMD groups
+};
@@ -0,0 +1,151 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+// Minimal vector math for the CPU ray tracer and for scene data shared with the GPU.
+// Kept free of DirectXMath so the CPU path builds on any platform.
+struct Float3
+{
+	float x, y, z;
+};
+
+struct Float4
+{
+	float x, y, z, w;
+};
+
+inline Float3 operator+(Float3 a, Float3 b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline Float3 operator-(Float3 a, Float3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline Float3 operator*(Float3 a, Float3 b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+inline Float3 operator*(Float3 a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+inline Float3 operator/(Float3 a, float s) { return { a.x / s, a.y / s, a.z / s }; }
+inline Float3& operator+=(Float3& a, Float3 b) { a = a + b; return a; }
+inline Float3& operator*=(Float3& a, Float3 b) { a = a * b; return a; }
+
+inline float Dot(Float3 a, Float3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Float3 Cross(Float3 a, Float3 b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+inline float Length(Float3 v) { return std::sqrt(Dot(v, v)); }
+inline Float3 Normalize(Float3 v) { return v / Length(v); }
+inline float MaxComponent(Float3 v) { return std::fmax(v.x, std::fmax(v.y, v.z)); }
+// Same as HLSL reflect, the normal is expected to be unit length
+inline Float3 Reflect(Float3 direction, Float3 normal) { return direction - normal * (2.0f * Dot(direction, normal)); }
+
+// Affine transform in the layout of D3D12_RAYTRACING_INSTANCE_DESC::Transform: rows of a 3x4 matrix applied to column vectors
+struct Transform3x4
+{
+	float m[3][4];
+};
+
+inline Transform3x4 TransformIdentity()
+{
+	return { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 } } };
+}
+
+inline Transform3x4 TransformTranslation(float x, float y, float z)
+{
+	return { { { 1, 0, 0, x }, { 0, 1, 0, y }, { 0, 0, 1, z } } };
+}
+
+inline Transform3x4 TransformScale(float x, float y, float z)
+{
+	return { { { x, 0, 0, 0 }, { 0, y, 0, 0 }, { 0, 0, z, 0 } } };
+}
+
+inline Transform3x4 TransformRotationZ(float angle)
+{
+	const float c = std::cos(angle);
+	const float s = std::sin(angle);
+	return { { { c, -s, 0, 0 }, { s, c, 0, 0 }, { 0, 0, 1, 0 } } };
+}
+
+// Rotation by angle around an arbitrary axis, matching XMQuaternionRotationAxis followed by XMMatrixRotationQuaternion
+inline Transform3x4 TransformRotationAxis(Float3 axis, float angle)
+{
+	const Float3 a = Normalize(axis);
+	const float c = std::cos(angle);
+	const float s = std::sin(angle);
+	const float t = 1.0f - c;
+	return { {
+		{ t * a.x * a.x + c, t * a.x * a.y - s * a.z, t * a.x * a.z + s * a.y, 0 },
+		{ t * a.x * a.y + s * a.z, t * a.y * a.y + c, t * a.y * a.z - s * a.x, 0 },
+		{ t * a.x * a.z - s * a.y, t * a.y * a.z + s * a.x, t * a.z * a.z + c, 0 } } };
+}
+
+// Applies first, then second; the same order as multiplying DirectXMath matrices first * second
+inline Transform3x4 TransformConcatenate(const Transform3x4& first, const Transform3x4& second)
+{
+	Transform3x4 result = {};
+	for (int row = 0; row < 3; row++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			float value = column == 3 ? second.m[row][3] : 0.0f;
+			for (int k = 0; k < 3; k++)
+			{
+				value += second.m[row][k] * first.m[k][column];
+			}
+			result.m[row][column] = value;
+		}
+	}
+	return result;
+}
+
+inline Float3 TransformPoint(const Transform3x4& t, Float3 p)
+{
+	return {
+		t.m[0][0] * p.x + t.m[0][1] * p.y + t.m[0][2] * p.z + t.m[0][3],
+		t.m[1][0] * p.x + t.m[1][1] * p.y + t.m[1][2] * p.z + t.m[1][3],
+		t.m[2][0] * p.x + t.m[2][1] * p.y + t.m[2][2] * p.z + t.m[2][3] };
+}
+
+inline Float3 TransformVector(const Transform3x4& t, Float3 v)
+{
+	return {
+		t.m[0][0] * v.x + t.m[0][1] * v.y + t.m[0][2] * v.z,
+		t.m[1][0] * v.x + t.m[1][1] * v.y + t.m[1][2] * v.z,
+		t.m[2][0] * v.x + t.m[2][1] * v.y + t.m[2][2] * v.z };
+}
+
+inline Transform3x4 TransformInverse(const Transform3x4& t)
+{
+	const float(*m)[4] = t.m;
+	const float determinant =
+		m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+		m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+		m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+	const float inverseDeterminant = 1.0f / determinant;
+	Transform3x4 result = {};
+	result.m[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) * inverseDeterminant;
+	result.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inverseDeterminant;
+	result.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inverseDeterminant;
+	result.m[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) * inverseDeterminant;
+	result.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inverseDeterminant;
+	result.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inverseDeterminant;
+	result.m[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) * inverseDeterminant;
+	result.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inverseDeterminant;
+	result.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inverseDeterminant;
+	const Float3 translation = TransformVector(result, { m[0][3], m[1][3], m[2][3] });
+	result.m[0][3] = -translation.x;
+	result.m[1][3] = -translation.y;
+	result.m[2][3] = -translation.z;
+	return result;
+}
+
+// PCG hash, mirrored in Common.hlsl so both paths draw the same random numbers
+inline uint32_t PcgHash(uint32_t value)
+{
+	const uint32_t state = value * 747796405u + 2891336453u;
+	const uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+inline float RandomFloat(uint32_t* state)
+{
+	*state = PcgHash(*state);
+	return (float)(*state >> 8) * (1.0f / 16777216.0f);
+}
+
+inline uint32_t RandomSeed(uint32_t x, uint32_t y, uint32_t sampleIndex)
+{
+	return PcgHash(x + PcgHash(y + PcgHash(sampleIndex)));
+}
@@ -0,0 +1,103 @@
+#include "CpuReconstruction.h"
+#include "AdaptiveSampling.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+static constexpr uint32_t RowsPerTask = 8;
+
+// Opposite neighbours to interpolate between: horizontal, vertical and the two diagonals
+static constexpr int Pairs[4][4] = { { -1, 0, 1, 0 }, { 0, -1, 0, 1 }, { -1, -1, 1, 1 }, { 1, -1, -1, 1 } };
+
+static Float3 GetMean(const Float4& sum)
+{
+	return Float3{ sum.x, sum.y, sum.z } / sum.w;
+}
+
+// Averages the pair of traced neighbours closest in luminance, so edges are followed instead of blurred. Where no
+// pair is complete, at the image border, it averages whatever neighbours are traced. The guides are copied from
+// one of the neighbours used and the colour counts as one sample, replaced once the pixel is traced.
+void CpuReconstruction::Reconstruct(InterleavedSampling::Mode mode, uint32_t sampleIndex, uint32_t sequence, uint32_t width, uint32_t height, Float4* sums, Float4* normalDepth, Float4* albedo, Float4* motion, ThreadPool* threadPool)
+{
+	if (!InterleavedSampling::NeedsReconstruction(mode, sampleIndex))
+		return;
+	PROFILE_SCOPE("Reconstruct");
+	auto IsTraced = [&](int x, int y)
+	{
+		return x >= 0 && y >= 0 && x < (int)width && y < (int)height && InterleavedSampling::GetFirstSample(mode, x, y, sequence) <= sampleIndex;
+	};
+	const uint32_t taskCount = (height + RowsPerTask - 1) / RowsPerTask;
+	threadPool->Dispatch(taskCount, [&](uint32_t task)
+	{
+		const uint32_t rowEnd = std::min(height, (task + 1) * RowsPerTask);
+		for (uint32_t y = task * RowsPerTask; y < rowEnd; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				if (IsTraced(x, y))
+					continue;
+				Float3 color = { 0.0f, 0.0f, 0.0f };
+				float count = 0.0f;
+				size_t source = 0;
+				float bestDifference = INFINITY;
+				for (const int* pair : Pairs)
+				{
+					const int ax = (int)x + pair[0], ay = (int)y + pair[1];
+					const int bx = (int)x + pair[2], by = (int)y + pair[3];
+					if (!IsTraced(ax, ay) || !IsTraced(bx, by))
+						continue;
+					const Float3 a = GetMean(sums[(size_t)ay * width + ax]);
+					const Float3 b = GetMean(sums[(size_t)by * width + bx]);
+					const float difference = std::fabs(AdaptiveSampling::Luminance(a) - AdaptiveSampling::Luminance(b));
+					if (difference < bestDifference)
+					{
+						bestDifference = difference;
+						color = (a + b) * 0.5f;
+						count = 1.0f;
+						source = (size_t)ay * width + ax;
+					}
+				}
+				if (count == 0.0f)
+				{
+					for (int dy = -1; dy <= 1; dy++)
+					{
+						for (int dx = -1; dx <= 1; dx++)
+						{
+							if (!IsTraced((int)x + dx, (int)y + dy))
+								continue;
+							const size_t neighbour = (size_t)((int)y + dy) * width + ((int)x + dx);
+							color += GetMean(sums[neighbour]);
+							if (count == 0.0f)
+								source = neighbour;
+							count += 1.0f;
+						}
+					}
+				}
+				const size_t pixel = (size_t)y * width + x;
+				if (count == 0.0f)
+				{
+					sums[pixel] = {};
+					continue;
+				}
+				color = color / count;
+				sums[pixel] = { color.x, color.y, color.z, 1.0f };
+				normalDepth[pixel] = normalDepth[source];
+				albedo[pixel] = albedo[source];
+				motion[pixel] = motion[source];
+			}
+		}
+	});
+}
+
+float CpuReconstruction::MeasureError(const Float4* sums, const Float4* reference, size_t pixelCount)
+{
+	double squares = 0.0;
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		const Float3 a = sums[i].w > 0.0f ? GetMean(sums[i]) : Float3{ 0.0f, 0.0f, 0.0f };
+		const Float3 b = reference[i].w > 0.0f ? GetMean(reference[i]) : Float3{ 0.0f, 0.0f, 0.0f };
+		const Float3 difference = a - b;
+		squares += Dot(difference, difference);
+	}
+	return pixelCount ? (float)std::sqrt(squares / (3.0 * pixelCount)) : 0.0f;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "CpuMath.h"
+#include "InterleavedSampling.h"
+
+class ThreadPool;
+
+// Fills the pixels an interleaved frame has not traced yet, the reference for Reconstruct.hlsl. Buffers use the
+// CpuRenderer layout and are written in place; only pixels without a sample since the restart are touched.
+namespace CpuReconstruction
+{
+	void Reconstruct(InterleavedSampling::Mode mode, uint32_t sampleIndex, uint32_t sequence, uint32_t width, uint32_t height, Float4* sums, Float4* normalDepth, Float4* albedo, Float4* motion, ThreadPool* threadPool);
+	// Root mean square difference of the pixel means, to check an interleaved render against a full-rate one
+	float MeasureError(const Float4* sums, const Float4* reference, size_t pixelCount);
+}
@@ -0,0 +1,380 @@
+#include "CpuRenderer.h"
+#include "CpuReconstruction.h"
+#include "ThreadPool.h"
+#include "Hash.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+
+static constexpr uint32_t BinGridSize = 4; // cells per axis the wavefront bins ray origins into
+
+void CpuRenderer::Resize(uint32_t width, uint32_t height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+	m_Width = width;
+	m_Height = height;
+	m_Sums.assign((size_t)width * height, {});
+	m_NormalDepth.assign((size_t)width * height, {});
+	m_Albedo.assign((size_t)width * height, {});
+	m_Motion.assign((size_t)width * height, {});
+	m_LuminanceSquares.assign((size_t)width * height, 0.0f);
+	m_TileFlags.assign((size_t)AdaptiveSampling::GetTileCount(width) * AdaptiveSampling::GetTileCount(height), 0);
+	m_Accumulation.Reset();
+}
+
+void CpuRenderer::SetInterleaveMode(InterleavedSampling::Mode mode)
+{
+	if (mode == m_InterleaveMode)
+		return;
+	m_InterleaveMode = mode;
+	m_Accumulation.Reset();
+}
+
+CameraState CpuRenderer::GetCameraState(Float3 position, float pitch, float heading, float fov, float aspectRatio)
+{
+	// Row vectors times XMMatrixRotationY(pitch) * XMMatrixRotationZ(heading)
+	const float cp = std::cos(pitch), sp = std::sin(pitch);
+	const float ch = std::cos(heading), sh = std::sin(heading);
+	auto Rotate = [&](Float3 v)
+	{
+		const Float3 pitched = { v.x * cp + v.z * sp, v.y, v.z * cp - v.x * sp };
+		return Float3{ pitched.x * ch - pitched.y * sh, pitched.x * sh + pitched.y * ch, pitched.z };
+	};
+	return { position, Rotate({ fov, 0.0f, 0.0f }), Rotate({ 0.0f, aspectRatio, 0.0f }), Rotate({ 0.0f, 0.0f, -1.0f }) };
+}
+
+uint64_t CpuRenderer::HashState(const CpuScene& scene, const CameraState& camera, uint32_t width, uint32_t height)
+{
+	uint64_t hash = HashBytes(&camera, sizeof(camera), scene.GetInstanceHash());
+	hash = HashBytes(&width, sizeof(width), hash);
+	return HashBytes(&height, sizeof(height), hash);
+}
+
+// Unjittered rays go through the pixel centre like the original renderer, jittered ones anywhere across the pixel.
+// The seed is the pixel's random stream, shared with TracePath in the same order as RayGen draws from it.
+Float3 CpuRenderer::GetPrimaryRayDirection(const CameraState& camera, uint32_t x, uint32_t y, uint32_t width, uint32_t height, bool jitter, uint32_t* seed)
+{
+	float jitterX = 0.5f;
+	float jitterY = 0.5f;
+	if (jitter)
+	{
+		jitterX = RandomFloat(seed);
+		jitterY = RandomFloat(seed);
+	}
+	const float dx = ((x + jitterX) / (float)width) * 2.0f - 1.0f;
+	const float dy = ((y + jitterY) / (float)height) * 2.0f - 1.0f;
+	return Normalize(camera.Forward + camera.Up * dy + camera.Right * dx);
+}
+
+// Inverse of GetPrimaryRayDirection: where a ray from the camera position crosses the image, in pixels with
+// pixel centres at .5. Fails for directions that point behind the camera.
+bool CpuRenderer::ProjectDirection(const CameraState& camera, Float3 direction, uint32_t width, uint32_t height, float* x, float* y)
+{
+	// Forward, right and up are orthogonal, so each image coordinate is a projection onto one of them
+	const float forward = Dot(direction, camera.Forward) / Dot(camera.Forward, camera.Forward);
+	if (forward <= 0.0f)
+		return false;
+	const float dx = Dot(direction, camera.Right) / (Dot(camera.Right, camera.Right) * forward);
+	const float dy = Dot(direction, camera.Up) / (Dot(camera.Up, camera.Up) * forward);
+	*x = (dx + 1.0f) * 0.5f * (float)width;
+	*y = (dy + 1.0f) * 0.5f * (float)height;
+	return true;
+}
+
+// Same as the motion vector RayGen writes: the sky moves with the camera's rotation only, surfaces are carried
+// back to the previous frame by their instance's motion transform and projected with the previous camera
+Float4 CpuRenderer::ComputeMotion(const CameraState& camera, Float3 direction, const PrimarySurface& surface) const
+{
+	const Float4 noMotion = { TemporalReprojection::NoMotion, TemporalReprojection::NoMotion, 0.0f, 0.0f };
+	if (!m_HasPrevious)
+		return noMotion;
+	Float3 previousDirection = direction;
+	float previousDepth = RayTMax;
+	if (surface.Instance != CpuScene::InvalidInstance)
+	{
+		if (surface.Instance >= m_MotionTransforms.size())
+			return noMotion;
+		const Float3 position = camera.Position + direction * surface.NormalDepth.w;
+		previousDirection = TransformPoint(m_MotionTransforms[surface.Instance], position) - m_PreviousCamera.Position;
+		previousDepth = Length(previousDirection);
+	}
+	// Measured from where the sample crossed the image, which is off the pixel centre when it was jittered
+	float currentX, currentY, previousX, previousY;
+	ProjectDirection(camera, direction, m_Width, m_Height, &currentX, &currentY);
+	if (!ProjectDirection(m_PreviousCamera, previousDirection, m_Width, m_Height, &previousX, &previousY))
+		return noMotion;
+	return { previousX - currentX, previousY - currentY, previousDepth, 0.0f };
+}
+
+// Mirrors the path loop in RayGen: the closest hit only reports the surface, the loop reflects and tints.
+// A path still hitting geometry after the last bounce contributes nothing.
+Float3 CpuRenderer::TracePath(const CpuScene& scene, Float3 origin, Float3 direction, uint32_t rouletteStartBounce, uint32_t* seed, uint32_t* rays, PrimarySurface* surface)
+{
+	PathVertex path = { origin, direction, { 1.0f, 1.0f, 1.0f }, 0.0f, *seed };
+	Float3 radiance = { 0.0f, 0.0f, 0.0f };
+	for (uint32_t bounce = 0; bounce <= MaxBounces; bounce++)
+	{
+		const CpuScene::Hit hit = scene.Intersect(path.Origin, path.Direction, path.TMin, RayTMax);
+		*rays += 1;
+		if (!ContinuePath(scene, hit, bounce, rouletteStartBounce, &path, &radiance, surface))
+			break;
+	}
+	*seed = path.Seed;
+	return radiance;
+}
+
+// One iteration of the path loop after the ray of the given bounce was traced. Returns false once the path ends;
+// radiance is only written when it escapes to the sky, a path ended by Russian roulette contributes nothing.
+bool CpuRenderer::ContinuePath(const CpuScene& scene, const CpuScene::Hit& hit, uint32_t bounce, uint32_t rouletteStartBounce, PathVertex* path, Float3* radiance, PrimarySurface* surface)
+{
+	if (!hit.IsValid())
+	{
+		const Float3 sky = (path->Direction + Float3{ 1.0f, 1.0f, 1.0f }) / 2.0f;
+		if (bounce == 0)
+		{
+			*surface = { { 0.0f, 0.0f, 0.0f, RayTMax }, { sky.x, sky.y, sky.z, 1.0f }, CpuScene::InvalidInstance };
+		}
+		*radiance = path->Throughput * sky;
+		return false;
+	}
+	// InstanceID is the first primitive of the instance's mesh, like InstanceID() + PrimitiveIndex() in Hit.hlsl
+	const CpuScene::Instance& instance = scene.GetInstance(hit.Instance);
+	const CpuScene::PrimitiveAttributes& attributes = scene.GetAttributes(instance.InstanceID + hit.Primitive);
+	const Float3 normal = TransformVector(instance.ObjectToWorld, { attributes.Normal.x, attributes.Normal.y, attributes.Normal.z });
+	if (bounce == 0)
+	{
+		*surface = { { normal.x, normal.y, normal.z, hit.T }, { attributes.Color.x, attributes.Color.y, attributes.Color.z, 1.0f }, hit.Instance };
+	}
+	path->Throughput *= Float3{ attributes.Color.x, attributes.Color.y, attributes.Color.z };
+	// Russian roulette, unbiased: survivors are boosted by the inverse of their survival probability
+	if (bounce >= rouletteStartBounce)
+	{
+		const float survival = std::fmin(1.0f, MaxComponent(path->Throughput));
+		if (RandomFloat(&path->Seed) >= survival)
+			return false;
+		path->Throughput = path->Throughput / survival;
+	}
+	path->Origin = path->Origin + (normal * (Epsilon * 10.0f)) + (path->Direction * hit.T);
+	path->Direction = Reflect(path->Direction, normal);
+	path->TMin = Epsilon;
+	return true;
+}
+
+// Bin of a ray in the wavefront: its origin's cell in a grid over the scene bounds and the octant of its direction
+static uint32_t GetBinKey(Float3 origin, Float3 direction, Float3 boundsMin, Float3 cellScale)
+{
+	auto GetCell = [](float position, float minimum, float scale)
+	{
+		return (uint32_t)std::clamp((position - minimum) * scale, 0.0f, (float)(BinGridSize - 1));
+	};
+	const uint32_t cell = (GetCell(origin.z, boundsMin.z, cellScale.z) * BinGridSize + GetCell(origin.y, boundsMin.y, cellScale.y)) * BinGridSize + GetCell(origin.x, boundsMin.x, cellScale.x);
+	const uint32_t octant = (direction.x < 0.0f ? 1 : 0) | (direction.y < 0.0f ? 2 : 0) | (direction.z < 0.0f ? 4 : 0);
+	return cell * 8 + octant;
+}
+
+// Traces the paths of a tile one bounce at a time. Primary rays leave the camera in pixel order and are coherent
+// already; the reflections of every later bounce are sorted by bin and each bin is intersected together.
+// Every path keeps its own random stream, so the result matches tracing the paths one by one.
+void CpuRenderer::TraceWavefront(const CpuScene& scene, Float3 boundsMin, Float3 cellScale, std::vector<WavefrontPath>* paths) const
+{
+	thread_local std::vector<uint64_t> order;
+	thread_local std::vector<CpuScene::Ray> rays;
+	thread_local std::vector<CpuScene::Hit> hits;
+	order.clear();
+	for (uint32_t i = 0; i < (uint32_t)paths->size(); i++)
+	{
+		order.push_back(i);
+	}
+	for (uint32_t bounce = 0; bounce <= MaxBounces && !order.empty(); bounce++)
+	{
+		// The bin in the high, the path in the low 32 bits, so sorting groups the bins and keeps each in path order
+		if (bounce > 0)
+		{
+			for (uint64_t& entry : order)
+			{
+				const PathVertex& vertex = (*paths)[(uint32_t)entry].Vertex;
+				entry = ((uint64_t)GetBinKey(vertex.Origin, vertex.Direction, boundsMin, cellScale) << 32) | (uint32_t)entry;
+			}
+			std::sort(order.begin(), order.end());
+		}
+		rays.resize(order.size());
+		hits.resize(order.size());
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			const PathVertex& vertex = (*paths)[(uint32_t)order[i]].Vertex;
+			rays[i] = { vertex.Origin, vertex.Direction, vertex.TMin, RayTMax };
+		}
+		for (size_t binStart = 0; binStart < order.size();)
+		{
+			size_t binEnd = binStart + 1;
+			while (binEnd < order.size() && (order[binEnd] >> 32) == (order[binStart] >> 32))
+			{
+				binEnd++;
+			}
+			scene.IntersectBin(&rays[binStart], (uint32_t)(binEnd - binStart), &hits[binStart]);
+			binStart = binEnd;
+		}
+		size_t continuing = 0;
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			WavefrontPath& path = (*paths)[(uint32_t)order[i]];
+			path.Rays++;
+			if (ContinuePath(scene, hits[i], bounce, m_RouletteStartBounce, &path.Vertex, &path.Radiance, &path.Surface))
+				order[continuing++] = (uint32_t)order[i];
+		}
+		order.resize(continuing);
+	}
+}
+
+// Returns the index of the frame just added, 0 when the accumulation was restarted. Interleaved modes trace one pixel
+// in PhaseCount per frame, a pixel's own sample index is the frame's divided by PhaseCount.
+// One task per active tile; a tile only writes its own pixels and flag, so the tasks never share data.
+// In wavefront mode a tile first sets up all its primary rays and accumulates once every path has ended.
+uint32_t CpuRenderer::Render(const CpuScene& scene, const CameraState& camera, ThreadPool* threadPool)
+{
+	PROFILE_SCOPE("CPU render");
+	const uint32_t sampleIndex = m_Accumulation.BeginFrame(HashState(scene, camera, m_Width, m_Height));
+	// Same as FrameConstants::randomSequence, every restart draws from new streams
+	const uint32_t randomSequence = m_Accumulation.GetRestartCount();
+	// Instances are matched by index, a changed instance count leaves them without motion
+	m_MotionTransforms.clear();
+	if (scene.GetInstanceCount() == m_PreviousTransforms.size())
+	{
+		for (uint32_t i = 0; i < scene.GetInstanceCount(); i++)
+		{
+			m_MotionTransforms.push_back(TransformConcatenate(scene.GetInstance(i).WorldToObject, m_PreviousTransforms[i]));
+		}
+	}
+	const uint32_t phaseCount = InterleavedSampling::GetPhaseCount(m_InterleaveMode);
+	const uint32_t pattern = InterleavedSampling::GetFramePattern(m_InterleaveMode, sampleIndex, randomSequence);
+	const uint32_t pixelSample = sampleIndex / phaseCount;
+	// Every pixel gets the minimum samples of its own, which takes PhaseCount times as many frames
+	const uint64_t adaptiveMinFrames = (uint64_t)m_AdaptiveMinSamples * phaseCount;
+	const uint32_t tilesX = AdaptiveSampling::GetTileCount(m_Width);
+	m_ActiveTiles.clear();
+	for (uint32_t tile = 0; tile < (uint32_t)m_TileFlags.size(); tile++)
+	{
+		if (sampleIndex < adaptiveMinFrames || m_TileFlags[tile])
+			m_ActiveTiles.push_back(tile);
+		m_TileFlags[tile] = 0;
+	}
+	Float3 boundsMin, boundsMax;
+	scene.GetBounds(&boundsMin, &boundsMax);
+	const Float3 boundsSize = boundsMax - boundsMin;
+	const Float3 cellScale = { BinGridSize / std::fmax(boundsSize.x, 1e-6f), BinGridSize / std::fmax(boundsSize.y, 1e-6f), BinGridSize / std::fmax(boundsSize.z, 1e-6f) };
+	std::atomic<uint64_t> totalPaths = 0;
+	std::atomic<uint64_t> totalRays = 0;
+	threadPool->Dispatch((uint32_t)m_ActiveTiles.size(), [&](uint32_t task)
+	{
+		PROFILE_SCOPE("Trace tile");
+		const uint32_t tile = m_ActiveTiles[task];
+		const uint32_t tileX = (tile % tilesX) * AdaptiveSampling::TileSize;
+		const uint32_t tileY = (tile / tilesX) * AdaptiveSampling::TileSize;
+		const uint32_t xEnd = std::min(m_Width, tileX + AdaptiveSampling::TileSize);
+		const uint32_t yEnd = std::min(m_Height, tileY + AdaptiveSampling::TileSize);
+		uint32_t rays = 0;
+		uint32_t paths = 0;
+		bool aboveThreshold = false;
+		auto AddSample = [&](size_t pixel, Float3 direction, Float3 radiance, const PrimarySurface& surface)
+		{
+			m_NormalDepth[pixel] = surface.NormalDepth;
+			m_Albedo[pixel] = surface.Albedo;
+			m_Motion[pixel] = ComputeMotion(camera, direction, surface);
+			Float4& sum = m_Sums[pixel];
+			float& luminanceSquares = m_LuminanceSquares[pixel];
+			if (pixelSample == 0)
+			{
+				sum = {};
+				luminanceSquares = 0.0f;
+			}
+			sum = { sum.x + radiance.x, sum.y + radiance.y, sum.z + radiance.z, sum.w + 1.0f };
+			const float luminance = AdaptiveSampling::Luminance(radiance);
+			luminanceSquares += luminance * luminance;
+			aboveThreshold |= AdaptiveSampling::PixelError(sum, luminanceSquares) > m_AdaptiveThreshold;
+		};
+		thread_local std::vector<WavefrontPath> wavefront;
+		wavefront.clear();
+		for (uint32_t y = tileY; y < yEnd; y++)
+		{
+			for (uint32_t x = tileX; x < xEnd; x++)
+			{
+				if (InterleavedSampling::GetPixelPattern(m_InterleaveMode, x, y) != pattern)
+					continue;
+				paths++;
+				uint32_t seed = RandomSeed(x, y, sampleIndex + (randomSequence << 16));
+				const Float3 direction = GetPrimaryRayDirection(camera, x, y, m_Width, m_Height, pixelSample > 0 || m_JitterFirstSample, &seed);
+				const size_t pixel = (size_t)y * m_Width + x;
+				if (m_Wavefront)
+				{
+					wavefront.push_back({ { camera.Position, direction, { 1.0f, 1.0f, 1.0f }, 0.0f, seed }, direction, { 0.0f, 0.0f, 0.0f }, {}, (uint32_t)pixel, 0 });
+					continue;
+				}
+				PrimarySurface surface;
+				const Float3 radiance = TracePath(scene, camera.Position, direction, m_RouletteStartBounce, &seed, &rays, &surface);
+				AddSample(pixel, direction, radiance, surface);
+			}
+		}
+		if (!wavefront.empty())
+		{
+			TraceWavefront(scene, boundsMin, cellScale, &wavefront);
+			for (const WavefrontPath& path : wavefront)
+			{
+				rays += path.Rays;
+				AddSample(path.Pixel, path.PrimaryDirection, path.Radiance, path.Surface);
+			}
+		}
+		m_TileFlags[tile] = aboveThreshold;
+		totalPaths += paths;
+		totalRays += rays;
+	});
+	m_LastFrame.Paths = totalPaths;
+	m_LastFrame.Rays = totalRays;
+	CpuReconstruction::Reconstruct(m_InterleaveMode, sampleIndex, randomSequence, m_Width, m_Height, m_Sums.data(), m_NormalDepth.data(), m_Albedo.data(), m_Motion.data(), threadPool);
+
+	m_HasPrevious = true;
+	m_PreviousCamera = camera;
+	m_PreviousTransforms.clear();
+	for (uint32_t i = 0; i < scene.GetInstanceCount(); i++)
+	{
+		m_PreviousTransforms.push_back(scene.GetInstance(i).ObjectToWorld);
+	}
+	return sampleIndex;
+}
+
+Float3 CpuRenderer::GetPixel(uint32_t x, uint32_t y) const
+{
+	const Float4& sum = m_Sums[(size_t)y * m_Width + x];
+	return sum.w > 0.0f ? Float3{ sum.x, sum.y, sum.z } / sum.w : Float3{ 0.0f, 0.0f, 0.0f };
+}
+
+// Converted the way a R8G8B8A8_UNORM UAV store would: saturate, scale and round, red in the lowest byte
+void CpuRenderer::Resolve(std::vector<uint32_t>* pixels) const
+{
+	pixels->resize((size_t)m_Width * m_Height);
+	auto ToUnorm = [](float value)
+	{
+		return (uint32_t)(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	};
+	for (uint32_t y = 0; y < m_Height; y++)
+	{
+		for (uint32_t x = 0; x < m_Width; x++)
+		{
+			const Float3 color = GetPixel(x, y);
+			(*pixels)[(size_t)y * m_Width + x] = ToUnorm(color.x) | (ToUnorm(color.y) << 8) | (ToUnorm(color.z) << 16) | (255u << 24);
+		}
+	}
+}
+
+void CpuRenderer::ResolveRadiance(std::vector<Float4>* pixels) const
+{
+	pixels->resize((size_t)m_Width * m_Height);
+	for (uint32_t y = 0; y < m_Height; y++)
+	{
+		for (uint32_t x = 0; x < m_Width; x++)
+		{
+			const Float3 color = GetPixel(x, y);
+			(*pixels)[(size_t)y * m_Width + x] = { color.x, color.y, color.z, 1.0f };
+		}
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "CpuMath.h"
+#include "CpuScene.h"
+#include "AccumulationState.h"
+#include "PathStatistics.h"
+#include "AdaptiveSampling.h"
+#include "TemporalReprojection.h"
+#include "InterleavedSampling.h"
+
+class ThreadPool;
+
+// The constants the ray generation shader reads, in the same order
+struct CameraState
+{
+	Float3 Position;
+	Float3 Forward;
+	Float3 Right;
+	Float3 Up;
+};
+
+// Guide buffers for the denoiser, taken from the primary ray of the latest sample like RayGen writes them
+struct PrimarySurface
+{
+	Float4 NormalDepth; // world normal and hit distance, a zero normal and RayTMax for the sky
+	Float4 Albedo; // surface colour, the sky colour on a miss
+	uint32_t Instance; // CpuScene::InvalidInstance for the sky
+};
+
+// Reference implementation of the DXR shaders on the CPU. Every Render call traces one sample per pixel of every
+// active tile into a floating-point accumulation buffer that keeps averaging until the camera, the scene or the
+// resolution changes. Tiles drop out once their error is low enough, see AdaptiveSampling.h. Traced pixels also get
+// a motion vector from the camera and instance transforms of the previous Render call, see TemporalReprojection.h.
+// In the interleaved modes only part of the pixels are traced per call, see InterleavedSampling.h; the others are
+// reconstructed with CpuReconstruction until they have their first sample.
+class CpuRenderer
+{
+public:
+	static constexpr uint32_t MaxBounces = 30; // MAX_BOUNCES in Common.hlsl
+	static constexpr float RayTMax = 100000.0f;
+	static constexpr float Epsilon = 0.0000001f;
+	static constexpr uint32_t DefaultRouletteStartBounce = 2;
+	static constexpr uint32_t DisableRoulette = 0xFFFFFFFF;
+	void Resize(uint32_t width, uint32_t height);
+	uint32_t Render(const CpuScene& scene, const CameraState& camera, ThreadPool* threadPool);
+	void Resolve(std::vector<uint32_t>* pixels) const;
+	// Unclamped means with alpha 1, for HDR output
+	void ResolveRadiance(std::vector<Float4>* pixels) const;
+	Float3 GetPixel(uint32_t x, uint32_t y) const;
+	inline void ResetAccumulation() { m_Accumulation.Reset(); }
+	inline uint32_t GetSampleCount() const { return m_Accumulation.GetSampleCount(); }
+	inline uint32_t GetWidth() const { return m_Width; }
+	inline uint32_t GetHeight() const { return m_Height; }
+	inline void SetRouletteStartBounce(uint32_t bounce) { m_RouletteStartBounce = bounce; }
+	inline void SetAdaptiveSampling(uint32_t minSamples, float threshold) { m_AdaptiveMinSamples = minSamples; m_AdaptiveThreshold = threshold; }
+	// Temporal reuse needs the first sample of every restart at a new position, otherwise it gathers the same one
+	inline void SetJitterFirstSample(bool jitter) { m_JitterFirstSample = jitter; }
+	// Restarts the accumulation, like a resize
+	void SetInterleaveMode(InterleavedSampling::Mode mode);
+	// Traces each tile bounce by bounce instead of path by path, with the rays of a bounce sorted into bins of similar
+	// origin and direction. The image is identical, only the order of the work changes.
+	inline void SetWavefront(bool wavefront) { m_Wavefront = wavefront; }
+	inline uint32_t GetActiveTileCount() const { return (uint32_t)m_ActiveTiles.size(); }
+	inline const PathStatistics& GetLastFrame() const { return m_LastFrame; }
+	// The vectors Camera::Update derives from its position and angles, pitch rotates about y before heading about z
+	static CameraState GetCameraState(Float3 position, float pitch, float heading, float fov, float aspectRatio);
+	static uint64_t HashState(const CpuScene& scene, const CameraState& camera, uint32_t width, uint32_t height);
+	static Float3 GetPrimaryRayDirection(const CameraState& camera, uint32_t x, uint32_t y, uint32_t width, uint32_t height, bool jitter, uint32_t* seed);
+	static bool ProjectDirection(const CameraState& camera, Float3 direction, uint32_t width, uint32_t height, float* x, float* y);
+	static Float3 TracePath(const CpuScene& scene, Float3 origin, Float3 direction, uint32_t rouletteStartBounce, uint32_t* seed, uint32_t* rays, PrimarySurface* surface);
+	inline const std::vector<Float4>& GetSums() const { return m_Sums; }
+	inline const std::vector<Float4>& GetNormalDepth() const { return m_NormalDepth; }
+	inline const std::vector<Float4>& GetAlbedo() const { return m_Albedo; }
+	inline const std::vector<Float4>& GetMotion() const { return m_Motion; }
+private:
+	// A path between bounces, carried by TracePath and by the wavefront
+	struct PathVertex
+	{
+		Float3 Origin;
+		Float3 Direction;
+		Float3 Throughput;
+		float TMin;
+		uint32_t Seed;
+	};
+	struct WavefrontPath
+	{
+		PathVertex Vertex;
+		Float3 PrimaryDirection; // for the motion vector
+		Float3 Radiance;
+		PrimarySurface Surface;
+		uint32_t Pixel;
+		uint32_t Rays;
+	};
+	static bool ContinuePath(const CpuScene& scene, const CpuScene::Hit& hit, uint32_t bounce, uint32_t rouletteStartBounce, PathVertex* path, Float3* radiance, PrimarySurface* surface);
+	void TraceWavefront(const CpuScene& scene, Float3 boundsMin, Float3 cellScale, std::vector<WavefrontPath>* paths) const;
+	Float4 ComputeMotion(const CameraState& camera, Float3 direction, const PrimarySurface& surface) const;
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+	std::vector<Float4> m_Sums; // rgb sum and sample count per pixel
+	std::vector<Float4> m_NormalDepth;
+	std::vector<Float4> m_Albedo;
+	std::vector<Float4> m_Motion; // offset to the pixel's position in the previous frame and the hit distance expected there
+	std::vector<float> m_LuminanceSquares; // sum of squared sample luminance per pixel
+	std::vector<uint8_t> m_TileFlags; // tiles still above the error threshold, written by the tiles traced this frame
+	std::vector<uint32_t> m_ActiveTiles;
+	AccumulationState m_Accumulation;
+	uint32_t m_RouletteStartBounce = DefaultRouletteStartBounce;
+	uint32_t m_AdaptiveMinSamples = AdaptiveSampling::DefaultMinSamples;
+	float m_AdaptiveThreshold = AdaptiveSampling::DefaultThreshold;
+	bool m_JitterFirstSample = false;
+	bool m_Wavefront = false;
+	InterleavedSampling::Mode m_InterleaveMode = InterleavedSampling::InterleaveFull;
+	PathStatistics m_LastFrame;
+	// What the previous Render call saw, motion vectors are taken against it
+	bool m_HasPrevious = false;
+	CameraState m_PreviousCamera = {};
+	std::vector<Transform3x4> m_PreviousTransforms;
+	std::vector<Transform3x4> m_MotionTransforms; // current world to previous world per instance
+};
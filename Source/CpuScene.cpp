@@ -0,0 +1,212 @@
+#include "CpuScene.h"
+#include "Hash.h"
+#include <algorithm>
+#include <cmath>
+
+// Rays IntersectBin transforms and culls at once, bins are processed in chunks of this many
+static constexpr uint32_t BinChunk = 64;
+
+static inline float GetAxis(Float3 v, int axis)
+{
+	return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+}
+
+void CpuScene::AddMesh(uint32_t id, const std::vector<Float3>& positions, const std::vector<uint32_t>& indices)
+{
+	if (id >= m_Meshes.size())
+	{
+		m_Meshes.resize(id + 1);
+	}
+	Float3 minimum = { INFINITY, INFINITY, INFINITY };
+	Float3 maximum = { -INFINITY, -INFINITY, -INFINITY };
+	for (const Float3& position : positions)
+	{
+		minimum = { std::fmin(minimum.x, position.x), std::fmin(minimum.y, position.y), std::fmin(minimum.z, position.z) };
+		maximum = { std::fmax(maximum.x, position.x), std::fmax(maximum.y, position.y), std::fmax(maximum.z, position.z) };
+	}
+	const Float3 padding = (maximum - minimum) * 0.001f + Float3{ 0.0001f, 0.0001f, 0.0001f };
+	m_Meshes[id] = { positions, indices, minimum - padding, maximum + padding };
+}
+
+void CpuScene::Reset()
+{
+	m_Instances.clear();
+}
+
+void CpuScene::AddInstance(uint32_t mesh, const Transform3x4& transform, uint32_t instanceID, uint32_t hitGroupIndex)
+{
+	const Mesh& bounds = m_Meshes[mesh];
+	Float3 minimum = { INFINITY, INFINITY, INFINITY };
+	Float3 maximum = { -INFINITY, -INFINITY, -INFINITY };
+	for (uint32_t corner = 0; corner < 8; corner++)
+	{
+		const Float3 local = { corner & 1 ? bounds.BoundsMax.x : bounds.BoundsMin.x, corner & 2 ? bounds.BoundsMax.y : bounds.BoundsMin.y, corner & 4 ? bounds.BoundsMax.z : bounds.BoundsMin.z };
+		const Float3 world = TransformPoint(transform, local);
+		minimum = { std::fmin(minimum.x, world.x), std::fmin(minimum.y, world.y), std::fmin(minimum.z, world.z) };
+		maximum = { std::fmax(maximum.x, world.x), std::fmax(maximum.y, world.y), std::fmax(maximum.z, world.z) };
+	}
+	m_Instances.push_back({ mesh, instanceID, hitGroupIndex, transform, TransformInverse(transform), minimum, maximum });
+}
+
+// Moeller-Trumbore, double sided like the acceleration structure. Shared by Intersect and IntersectBin so both
+// report bit-identical hits.
+static inline void IntersectTriangle(Float3 v0, Float3 edge1, Float3 edge2, Float3 origin, Float3 direction, float tMin, uint32_t instanceIndex, uint32_t primitive, CpuScene::Hit* hit)
+{
+	const Float3 p = Cross(direction, edge2);
+	const float determinant = Dot(edge1, p);
+	if (std::fabs(determinant) < 1e-12f)
+		return;
+	const float inverseDeterminant = 1.0f / determinant;
+	const Float3 s = origin - v0;
+	const float u = Dot(s, p) * inverseDeterminant;
+	if (u < 0.0f || u > 1.0f)
+		return;
+	const Float3 q = Cross(s, edge1);
+	const float v = Dot(direction, q) * inverseDeterminant;
+	if (v < 0.0f || u + v > 1.0f)
+		return;
+	const float t = Dot(edge2, q) * inverseDeterminant;
+	if (t < tMin || t >= hit->T)
+		return;
+	hit->T = t;
+	hit->Instance = instanceIndex;
+	hit->Primitive = primitive;
+	hit->Barycentrics[0] = u;
+	hit->Barycentrics[1] = v;
+}
+
+// Like DXR the ray is moved into object space without renormalising, so t is the same in both spaces
+CpuScene::Hit CpuScene::Intersect(Float3 origin, Float3 direction, float tMin, float tMax) const
+{
+	Hit hit = {};
+	hit.T = tMax;
+	for (uint32_t instanceIndex = 0; instanceIndex < (uint32_t)m_Instances.size(); instanceIndex++)
+	{
+		const Instance& instance = m_Instances[instanceIndex];
+		const Mesh& mesh = m_Meshes[instance.Mesh];
+		const Float3 objectOrigin = TransformPoint(instance.WorldToObject, origin);
+		const Float3 objectDirection = TransformVector(instance.WorldToObject, direction);
+		for (uint32_t primitive = 0; primitive * 3 + 2 < (uint32_t)mesh.Indices.size(); primitive++)
+		{
+			const Float3 v0 = mesh.Positions[mesh.Indices[primitive * 3]];
+			const Float3 edge1 = mesh.Positions[mesh.Indices[primitive * 3 + 1]] - v0;
+			const Float3 edge2 = mesh.Positions[mesh.Indices[primitive * 3 + 2]] - v0;
+			IntersectTriangle(v0, edge1, edge2, objectOrigin, objectDirection, tMin, instanceIndex, primitive, &hit);
+		}
+	}
+	return hit;
+}
+
+// Slab test against the padded mesh bounds. fmin and fmax drop the NaN of a zero direction component on a slab plane.
+bool CpuScene::IntersectBounds(const Mesh& mesh, Float3 origin, Float3 direction, float tMin, float tMax)
+{
+	const float minimum[3] = { mesh.BoundsMin.x, mesh.BoundsMin.y, mesh.BoundsMin.z };
+	const float maximum[3] = { mesh.BoundsMax.x, mesh.BoundsMax.y, mesh.BoundsMax.z };
+	const float o[3] = { origin.x, origin.y, origin.z };
+	const float d[3] = { direction.x, direction.y, direction.z };
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float inverse = 1.0f / d[axis];
+		const float t0 = (minimum[axis] - o[axis]) * inverse;
+		const float t1 = (maximum[axis] - o[axis]) * inverse;
+		tMin = std::fmax(tMin, std::fmin(t0, t1));
+		tMax = std::fmin(tMax, std::fmax(t0, t1));
+	}
+	return tMin <= tMax;
+}
+
+// Instances and triangles are visited in the same order as Intersect and tested with the same arithmetic,
+// so every ray ends with exactly the hit Intersect would report
+void CpuScene::IntersectBin(const Ray* rays, uint32_t count, Hit* hits) const
+{
+	for (uint32_t first = 0; first < count; first += BinChunk)
+	{
+		const uint32_t chunkSize = std::min(BinChunk, count - first);
+		const Ray* chunkRays = rays + first;
+		Hit* chunkHits = hits + first;
+		for (uint32_t i = 0; i < chunkSize; i++)
+		{
+			chunkHits[i] = {};
+			chunkHits[i].T = chunkRays[i].TMax;
+		}
+		// A direction sign shared by the whole chunk, 0 where the rays disagree, and the box around their origins
+		float sign[3] = { 0.0f, 0.0f, 0.0f };
+		float originMin[3] = { INFINITY, INFINITY, INFINITY };
+		float originMax[3] = { -INFINITY, -INFINITY, -INFINITY };
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const float first = GetAxis(chunkRays[0].Direction, axis);
+			sign[axis] = first > 0.0f ? 1.0f : first < 0.0f ? -1.0f : 0.0f;
+			for (uint32_t i = 0; i < chunkSize; i++)
+			{
+				const float direction = GetAxis(chunkRays[i].Direction, axis);
+				const float origin = GetAxis(chunkRays[i].Origin, axis);
+				if (direction * sign[axis] <= 0.0f)
+					sign[axis] = 0.0f;
+				originMin[axis] = std::fmin(originMin[axis], origin);
+				originMax[axis] = std::fmax(originMax[axis], origin);
+			}
+		}
+		Float3 objectOrigins[BinChunk];
+		Float3 objectDirections[BinChunk];
+		uint32_t active[BinChunk];
+		for (uint32_t instanceIndex = 0; instanceIndex < (uint32_t)m_Instances.size(); instanceIndex++)
+		{
+			const Instance& instance = m_Instances[instanceIndex];
+			const Mesh& mesh = m_Meshes[instance.Mesh];
+			// Rays all heading towards +x cannot reach an instance ending left of every origin, and so on per axis
+			bool behind = false;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				behind |= sign[axis] > 0.0f && GetAxis(instance.BoundsMax, axis) < originMin[axis];
+				behind |= sign[axis] < 0.0f && GetAxis(instance.BoundsMin, axis) > originMax[axis];
+			}
+			if (behind)
+				continue;
+			uint32_t activeCount = 0;
+			for (uint32_t i = 0; i < chunkSize; i++)
+			{
+				objectOrigins[i] = TransformPoint(instance.WorldToObject, chunkRays[i].Origin);
+				objectDirections[i] = TransformVector(instance.WorldToObject, chunkRays[i].Direction);
+				if (IntersectBounds(mesh, objectOrigins[i], objectDirections[i], chunkRays[i].TMin, chunkHits[i].T))
+					active[activeCount++] = i;
+			}
+			if (activeCount == 0)
+				continue;
+			for (uint32_t primitive = 0; primitive * 3 + 2 < (uint32_t)mesh.Indices.size(); primitive++)
+			{
+				const Float3 v0 = mesh.Positions[mesh.Indices[primitive * 3]];
+				const Float3 edge1 = mesh.Positions[mesh.Indices[primitive * 3 + 1]] - v0;
+				const Float3 edge2 = mesh.Positions[mesh.Indices[primitive * 3 + 2]] - v0;
+				for (uint32_t a = 0; a < activeCount; a++)
+				{
+					const uint32_t i = active[a];
+					IntersectTriangle(v0, edge1, edge2, objectOrigins[i], objectDirections[i], chunkRays[i].TMin, instanceIndex, primitive, &chunkHits[i]);
+				}
+			}
+		}
+	}
+}
+
+void CpuScene::GetBounds(Float3* minimum, Float3* maximum) const
+{
+	*minimum = { INFINITY, INFINITY, INFINITY };
+	*maximum = { -INFINITY, -INFINITY, -INFINITY };
+	for (const Instance& instance : m_Instances)
+	{
+		*minimum = { std::fmin(minimum->x, instance.BoundsMin.x), std::fmin(minimum->y, instance.BoundsMin.y), std::fmin(minimum->z, instance.BoundsMin.z) };
+		*maximum = { std::fmax(maximum->x, instance.BoundsMax.x), std::fmax(maximum->y, instance.BoundsMax.y), std::fmax(maximum->z, instance.BoundsMax.z) };
+	}
+}
+// Changes whenever an instance moves, is added or removed, used to restart accumulation
+uint64_t CpuScene::GetInstanceHash() const
+{
+	uint64_t hash = FNVOffsetBasis;
+	for (const Instance& instance : m_Instances)
+	{
+		hash = HashBytes(&instance.Mesh, sizeof(instance.Mesh), hash);
+		hash = HashBytes(&instance.HitGroupIndex, sizeof(instance.HitGroupIndex), hash);
+		hash = HashBytes(&instance.ObjectToWorld, sizeof(instance.ObjectToWorld), hash);
+	}
+	return hash;
+}
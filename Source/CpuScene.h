@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "CpuMath.h"
+
+// CPU copy of the scene the acceleration structures are built from: meshes, their per-primitive
+// attributes and a flat list of instances. Traced by brute force, which is plenty for reference images of a few instances.
+class CpuScene
+{
+public:
+	static constexpr uint32_t InvalidInstance = 0xFFFFFFFF;
+	// Matches TriVertex in Hit.hlsl. Every mesh's primitives follow the previous mesh's in one array, indexed by
+	// InstanceID() + PrimitiveIndex() like the GPU structured buffer.
+	struct PrimitiveAttributes
+	{
+		Float4 Normal;
+		Float4 Color;
+	};
+	struct Hit
+	{
+		float T;
+		uint32_t Instance = InvalidInstance;
+		uint32_t Primitive;
+		float Barycentrics[2];
+		inline bool IsValid() const { return Instance != InvalidInstance; }
+	};
+	struct Ray
+	{
+		Float3 Origin;
+		Float3 Direction;
+		float TMin;
+		float TMax;
+	};
+	struct Instance
+	{
+		uint32_t Mesh;
+		uint32_t InstanceID;
+		uint32_t HitGroupIndex;
+		Transform3x4 ObjectToWorld;
+		Transform3x4 WorldToObject;
+		Float3 BoundsMin; // world space
+		Float3 BoundsMax;
+	};
+	void AddMesh(uint32_t id, const std::vector<Float3>& positions, const std::vector<uint32_t>& indices);
+	inline void SetPrimitiveAttributes(const std::vector<PrimitiveAttributes>& attributes) { m_Attributes = attributes; }
+	void Reset();
+	void AddInstance(uint32_t mesh, const Transform3x4& transform, uint32_t instanceID, uint32_t hitGroupIndex);
+	Hit Intersect(Float3 origin, Float3 direction, float tMin, float tMax) const;
+	// Same hits as Intersect for every ray, faster when the rays are coherent. Rays sharing a direction octant skip
+	// the instances behind all their origins at once, the others are culled against the bounds ray by ray, and each
+	// triangle is set up once for all rays still overlapping its instance.
+	void IntersectBin(const Ray* rays, uint32_t count, Hit* hits) const;
+	// World space box around every instance
+	void GetBounds(Float3* minimum, Float3* maximum) const;
+	inline const Instance& GetInstance(uint32_t index) const { return m_Instances[index]; }
+	inline uint32_t GetInstanceCount() const { return (uint32_t)m_Instances.size(); }
+	inline const PrimitiveAttributes& GetAttributes(uint32_t primitive) const { return m_Attributes[primitive]; }
+	uint64_t GetInstanceHash() const;
+private:
+	struct Mesh
+	{
+		std::vector<Float3> Positions;
+		std::vector<uint32_t> Indices;
+		Float3 BoundsMin; // object space, padded so the slab test never rejects a hit on the surface
+		Float3 BoundsMax;
+	};
+	static bool IntersectBounds(const Mesh& mesh, Float3 origin, Float3 direction, float tMin, float tMax);
+	std::vector<Mesh> m_Meshes;
+	std::vector<PrimitiveAttributes> m_Attributes;
+	std::vector<Instance> m_Instances;
+};
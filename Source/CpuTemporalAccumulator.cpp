@@ -0,0 +1,139 @@
+#include "CpuTemporalAccumulator.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+static constexpr uint32_t RowsPerTask = 8;
+
+void CpuTemporalAccumulator::Resize(uint32_t width, uint32_t height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+	m_Width = width;
+	m_Height = height;
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		m_History[i].assign((size_t)width * height, {});
+		m_HistoryNormalDepth[i].assign((size_t)width * height, {});
+	}
+	m_Prior.assign((size_t)width * height, {});
+	m_HistoryValid = false;
+}
+
+// Reflections do not follow the surface's motion, so the history colour is limited to the range of the current
+// samples around the pixel, which also catches disocclusions the geometry test lets through
+Float3 CpuTemporalAccumulator::ClampToNeighbourhood(const Float4* sums, uint32_t x, uint32_t y, Float3 color) const
+{
+	Float3 minimum = { INFINITY, INFINITY, INFINITY };
+	Float3 maximum = { -INFINITY, -INFINITY, -INFINITY };
+	for (int dy = -1; dy <= 1; dy++)
+	{
+		for (int dx = -1; dx <= 1; dx++)
+		{
+			const int tapX = (int)x + dx;
+			const int tapY = (int)y + dy;
+			if (tapX < 0 || tapY < 0 || tapX >= (int)m_Width || tapY >= (int)m_Height)
+				continue;
+			const Float4& sum = sums[(size_t)tapY * m_Width + tapX];
+			if (sum.w <= 0.0f)
+				continue;
+			const Float3 mean = Float3{ sum.x, sum.y, sum.z } / sum.w;
+			minimum = { std::min(minimum.x, mean.x), std::min(minimum.y, mean.y), std::min(minimum.z, mean.z) };
+			maximum = { std::max(maximum.x, mean.x), std::max(maximum.y, mean.y), std::max(maximum.z, mean.z) };
+		}
+	}
+	return { std::clamp(color.x, minimum.x, maximum.x), std::clamp(color.y, minimum.y, maximum.y), std::clamp(color.z, minimum.z, maximum.z) };
+}
+
+// History showing a surface that is still around the pixel. Testing the whole neighbourhood rather than the pixel
+// alone keeps silhouettes, where jittered samples alternate between two surfaces, from rejecting their history.
+bool CpuTemporalAccumulator::IsSurfaceInNeighbourhood(const Float4* normalDepth, const Float4* motion, uint32_t x, uint32_t y, Float4 history) const
+{
+	for (int dy = -1; dy <= 1; dy++)
+	{
+		for (int dx = -1; dx <= 1; dx++)
+		{
+			const int tapX = (int)x + dx;
+			const int tapY = (int)y + dy;
+			if (tapX < 0 || tapY < 0 || tapX >= (int)m_Width || tapY >= (int)m_Height)
+				continue;
+			const size_t tap = (size_t)tapY * m_Width + tapX;
+			if (TemporalReprojection::IsHistoryCompatible(normalDepth[tap], motion[tap].z, history))
+				return true;
+		}
+	}
+	return false;
+}
+
+// Bilinear fetch from last frame's result where the motion vector lands. Taps showing a surface that is gone are
+// left out and the rest renormalized, the sample count is capped at MaxHistory.
+Float4 CpuTemporalAccumulator::Reproject(const Float4* sums, const Float4* normalDepth, const Float4* motion, uint32_t x, uint32_t y) const
+{
+	// Pixel centres sit at .5, so subtracting it gives the position on the grid of taps
+	const size_t pixel = (size_t)y * m_Width + x;
+	const float previousX = (float)x + motion[pixel].x;
+	const float previousY = (float)y + motion[pixel].y;
+	if (!(previousX > -1.0f && previousY > -1.0f && previousX < (float)m_Width && previousY < (float)m_Height))
+		return {};
+	const int x0 = (int)std::floor(previousX);
+	const int y0 = (int)std::floor(previousY);
+	const float fx = previousX - (float)x0;
+	const float fy = previousY - (float)y0;
+	const std::vector<Float4>& history = m_History[1 - m_Current];
+	const std::vector<Float4>& historyNormalDepth = m_HistoryNormalDepth[1 - m_Current];
+	Float3 color = { 0.0f, 0.0f, 0.0f };
+	float count = 0.0f;
+	float weightSum = 0.0f;
+	for (int j = 0; j < 2; j++)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			const int tapX = x0 + i;
+			const int tapY = y0 + j;
+			if (tapX < 0 || tapY < 0 || tapX >= (int)m_Width || tapY >= (int)m_Height)
+				continue;
+			const size_t tap = (size_t)tapY * m_Width + tapX;
+			const Float4& sum = history[tap];
+			if (sum.w <= 0.0f || !IsSurfaceInNeighbourhood(normalDepth, motion, x, y, historyNormalDepth[tap]))
+				continue;
+			const float weight = (i ? fx : 1.0f - fx) * (j ? fy : 1.0f - fy);
+			color += Float3{ sum.x, sum.y, sum.z } * (weight / sum.w);
+			count += sum.w * weight;
+			weightSum += weight;
+		}
+	}
+	if (weightSum < TemporalReprojection::MinWeight)
+		return {};
+	color = ClampToNeighbourhood(sums, x, y, color / weightSum);
+	count = std::min(count / weightSum, TemporalReprojection::MaxHistory);
+	return { color.x * count, color.y * count, color.z * count, count };
+}
+
+const std::vector<Float4>& CpuTemporalAccumulator::Accumulate(const Float4* sums, const Float4* normalDepth, const Float4* motion, uint32_t sampleIndex, ThreadPool* threadPool)
+{
+	const TemporalReprojection::PriorMode priorMode = TemporalReprojection::GetPriorMode(m_HistoryValid, sampleIndex);
+	m_Current = 1 - m_Current;
+	std::vector<Float4>& result = m_History[m_Current];
+	std::vector<Float4>& resultNormalDepth = m_HistoryNormalDepth[m_Current];
+	const uint32_t taskCount = (m_Height + RowsPerTask - 1) / RowsPerTask;
+	threadPool->Dispatch(taskCount, [&](uint32_t task)
+	{
+		const uint32_t rowEnd = std::min(m_Height, (task + 1) * RowsPerTask);
+		for (uint32_t y = task * RowsPerTask; y < rowEnd; y++)
+		{
+			for (uint32_t x = 0; x < m_Width; x++)
+			{
+				const size_t pixel = (size_t)y * m_Width + x;
+				Float4& prior = m_Prior[pixel];
+				if (priorMode == TemporalReprojection::PriorReproject)
+					prior = Reproject(sums, normalDepth, motion, x, y);
+				else if (priorMode == TemporalReprojection::PriorClear)
+					prior = {};
+				const Float4& sum = sums[pixel];
+				result[pixel] = { prior.x + sum.x, prior.y + sum.y, prior.z + sum.z, prior.w + sum.w };
+				resultNormalDepth[pixel] = normalDepth[pixel];
+			}
+		}
+	});
+	m_HistoryValid = true;
+	return result;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "CpuMath.h"
+#include "TemporalReprojection.h"
+
+class ThreadPool;
+
+// The temporal accumulation pass on the CPU, the reference for TemporalAccumulate.hlsl. Combines the renderer's
+// accumulation with a prior reprojected from the previous frame's result, see TemporalReprojection.h.
+// Inputs use the accumulation layout (rgb sum and sample count), the motion vectors are CpuRenderer::GetMotion.
+class CpuTemporalAccumulator
+{
+public:
+	// Drops the history
+	void Resize(uint32_t width, uint32_t height);
+	inline void InvalidateHistory() { m_HistoryValid = false; }
+	// Returns the combined image as rgb sums and sample counts, valid until the next call
+	const std::vector<Float4>& Accumulate(const Float4* sums, const Float4* normalDepth, const Float4* motion, uint32_t sampleIndex, ThreadPool* threadPool);
+private:
+	Float3 ClampToNeighbourhood(const Float4* sums, uint32_t x, uint32_t y, Float3 color) const;
+	bool IsSurfaceInNeighbourhood(const Float4* normalDepth, const Float4* motion, uint32_t x, uint32_t y, Float4 history) const;
+	Float4 Reproject(const Float4* sums, const Float4* normalDepth, const Float4* motion, uint32_t x, uint32_t y) const;
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+	// Result and primary normal and distance of the last two frames, m_Current is the one being written
+	std::vector<Float4> m_History[2];
+	std::vector<Float4> m_HistoryNormalDepth[2];
+	std::vector<Float4> m_Prior; // rgb sum and sample count taken over when accumulation last restarted
+	uint32_t m_Current = 0;
+	bool m_HistoryValid = false;
+};
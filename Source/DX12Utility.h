@@ -130,93 +130,4 @@ inline UINT64 Align64(UINT64 uLocation, UINT64 uAlign)
 {
 	assert(!((0 == uAlign) || (uAlign & (uAlign - 1))));
 	return ((uLocation + (uAlign - 1)) & ~(uAlign - 1));
-}
-
-//--------------------------------------------------------------------------------------------------
-// Compile a HLSL file into a DXIL library
-//
-inline IDxcBlob* CompileShaderLibrary(LPCWSTR fileName)
-{
-	static IDxcCompiler* pCompiler = nullptr;
-	static IDxcLibrary* pLibrary = nullptr;
-	static IDxcIncludeHandler* dxcIncludeHandler;
-
-	HRESULT hr;
-
-	// Initialize the DXC compiler and compiler helper
-	if (!pCompiler)
-	{
-		ThrowIfFailed(DxcCreateInstance(CLSID_DxcCompiler, __uuidof(IDxcCompiler), (void**)&pCompiler));
-		ThrowIfFailed(DxcCreateInstance(CLSID_DxcLibrary, __uuidof(IDxcLibrary), (void**)&pLibrary));
-		ThrowIfFailed(pLibrary->CreateIncludeHandler(&dxcIncludeHandler));
-	}
-	// Open and read the file
-	std::ifstream shaderFile(fileName);
-	if (shaderFile.good() == false)
-	{
-		CStringA errmsg = "Cannot find shader file: ";
-		errmsg.Append(CStringA(fileName));
-		throw std::logic_error(errmsg);
-	}
-	std::stringstream strStream;
-	strStream << shaderFile.rdbuf();
-	std::string sShader = strStream.str();
-
-	// Create blob from the string
-	IDxcBlobEncoding* pTextBlob;
-	ThrowIfFailed(pLibrary->CreateBlobWithEncodingFromPinned(
-		(LPBYTE)sShader.c_str(), (uint32_t)sShader.size(), 0, &pTextBlob));
-
-	// Compile
-	IDxcOperationResult* pResult;
-	ThrowIfFailed(pCompiler->Compile(pTextBlob, fileName, L"", L"lib_6_3", nullptr, 0, nullptr, 0,
-		dxcIncludeHandler, &pResult));
-
-	// Verify the result
-	HRESULT resultCode;
-	ThrowIfFailed(pResult->GetStatus(&resultCode));
-	if (FAILED(resultCode))
-	{
-		IDxcBlobEncoding* pError;
-		hr = pResult->GetErrorBuffer(&pError);
-		if (FAILED(hr))
-		{
-			throw std::logic_error("Failed to get shader compiler error");
-		}
-		// Convert error blob to a string
-		std::vector<char> infoLog(pError->GetBufferSize() + 1);
-		memcpy(infoLog.data(), pError->GetBufferPointer(), pError->GetBufferSize());
-		infoLog[pError->GetBufferSize()] = 0;
-
-		std::string errorMsg = "Shader Compiler Error:\n";
-		errorMsg.append(infoLog.data());
-
-		throw std::logic_error(errorMsg.c_str());
-	}
-#ifdef _DEBUG
-	{
-		IDxcBlobEncoding* pError;
-		hr = pResult->GetErrorBuffer(&pError);
-		if (FAILED(hr))
-		{
-			throw std::logic_error("Failed to get shader compiler error");
-		}
-		if (pError->GetBufferSize())
-		{
-			// Convert error blob to a string
-			std::vector<char> infoLog(pError->GetBufferSize() + 1);
-			memcpy(infoLog.data(), pError->GetBufferPointer(), pError->GetBufferSize());
-			infoLog[pError->GetBufferSize()] = 0;
-
-			std::string errorMsg = "\n";
-			errorMsg.append(infoLog.data());
-
-			OutputDebugStringA(errorMsg.c_str());
-		}
-	}
-#endif
-
-	IDxcBlob* pBlob;
-	ThrowIfFailed(pResult->GetResult(&pBlob));
-	return pBlob;
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "DemoScene.h"
+
+namespace DemoScene
+{
+	// Flat shaded: every triangle gets its face normal, coloured by the normal's absolute value
+	void CreateCube(std::vector<Float3>* positions, std::vector<uint32_t>* indices, std::vector<CpuScene::PrimitiveAttributes>* attributes)
+	{
+		*positions = { {0.25,0.25,0.25},{0.25,-0.25,0.25},{0.25,0.25,-0.25},{0.25,-0.25,-0.25},{-0.25,0.25,0.25},{-0.25,-0.25,0.25},{-0.25,0.25,-0.25},{-0.25,-0.25,-0.25} };
+		*indices = { 2,4,0,7,2,3,5,6,7,7,1,5,3,0,1,1,4,5,6,4,2,6,2,7,4,6,5,3,1,7,2,0,3,0,4,1 };
+		attributes->clear();
+		for (size_t i = 0; i + 2 < indices->size(); i += 3)
+		{
+			const Float3 v1 = (*positions)[(*indices)[i]];
+			const Float3 v2 = (*positions)[(*indices)[i + 1]];
+			const Float3 v3 = (*positions)[(*indices)[i + 2]];
+			const Float3 normal = Normalize(Cross(v2 - v1, v3 - v1));
+			CpuScene::PrimitiveAttributes primitive = {};
+			primitive.Normal = { normal.x, normal.y, normal.z, 0.0f };
+			primitive.Color = { std::fabs(normal.x), std::fabs(normal.y), std::fabs(normal.z), 1.0f };
+			attributes->push_back(primitive);
+		}
+	}
+
+	void GetAnimationAngles(double time, float* angle1, float* angle2)
+	{
+		*angle1 = (float)(0.512465799111 * time);
+		*angle2 = (float)(0.812465799111 * 0.38712 * time);
+	}
+
+	void GetInstanceTransforms(float angle1, float angle2, Transform3x4 transforms[InstanceCount])
+	{
+		const Transform3x4 rotation = TransformRotationAxis({ 1.5f, 4.0f, 13.0f }, angle2 * 2.3f);
+		const Transform3x4 rotation2 = TransformRotationAxis({ 1.5f, 1.0f, 4.0f }, angle2 * 8.3f);
+		transforms[0] = TransformConcatenate(TransformConcatenate(TransformRotationZ(angle2), TransformTranslation(1, 0, 0)), TransformRotationZ(angle1));
+		transforms[1] = TransformConcatenate(TransformTranslation(0.2f, 1.0f, 0.0f), rotation);
+		transforms[2] = TransformRotationZ(angle2 * -2.0f);
+		transforms[3] = TransformConcatenate(rotation2, TransformTranslation(0.0f, 0.0f, 1.6f));
+	}
+
+	// Mesh 0 and hit group 0 are MeshCube and MaterialDefault on the GPU side
+	void AddMeshes(CpuScene* scene)
+	{
+		std::vector<Float3> positions;
+		std::vector<uint32_t> indices;
+		std::vector<CpuScene::PrimitiveAttributes> attributes;
+		CreateCube(&positions, &indices, &attributes);
+		scene->AddMesh(0, positions, indices);
+		scene->SetPrimitiveAttributes(attributes);
+	}
+
+	void AddInstances(CpuScene* scene, float angle1, float angle2)
+	{
+		Transform3x4 transforms[InstanceCount];
+		GetInstanceTransforms(angle1, angle2, transforms);
+		scene->Reset();
+		for (uint32_t i = 0; i < InstanceCount; i++)
+		{
+			scene->AddInstance(0, transforms[i], 0, 0);
+		}
+	}
+}
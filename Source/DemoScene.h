@@ -0,0 +1,16 @@
+#pragma once
+#include <vector>
+#include "CpuMath.h"
+#include "CpuScene.h"
+
+// The rotating cubes shown by the application, described once so the GPU scene and the CPU reference trace the same geometry
+namespace DemoScene
+{
+	constexpr uint32_t InstanceCount = 4;
+	void CreateCube(std::vector<Float3>* positions, std::vector<uint32_t>* indices, std::vector<CpuScene::PrimitiveAttributes>* attributes);
+	// Rotation angles of the animation after the given seconds, the application and offline renders share the clock
+	void GetAnimationAngles(double time, float* angle1, float* angle2);
+	void GetInstanceTransforms(float angle1, float angle2, Transform3x4 transforms[InstanceCount]);
+	void AddMeshes(CpuScene* scene);
+	void AddInstances(CpuScene* scene, float angle1, float angle2);
+}
@@ -0,0 +1,216 @@
+#include "PCH.h"
+#include "Denoiser.h"
+#include "Heap.h"
+#include "ShaderCompiler.h"
+#include "RootSignatureGenerator.h"
+#include "DX12Utility.h"
+#include <algorithm>
+
+using Microsoft::WRL::ComPtr;
+
+static constexpr UINT ThreadGroupSize = 8; // numthreads in Denoise.hlsl
+static constexpr DXGI_FORMAT GuideFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
+
+// Root constants, same layout as DenoiseConstants in Denoise.hlsl
+struct DenoiseConstants
+{
+	UINT StepWidth;
+	float InvColorPhi;
+	float InvNormalPhi;
+	float InvDepthPhi;
+	float InvAlbedoPhi;
+	UINT WriteOutput;
+	UINT Width;
+	UINT Height;
+};
+
+// Root parameter order of the denoise root signature
+enum DenoiseParameter
+{
+	ParameterConstants,
+	ParameterInput,
+	ParameterNormalDepth,
+	ParameterAlbedo,
+	ParameterResult,
+	ParameterOutput,
+	ParameterCount
+};
+
+void Denoiser::Create(ID3D12Device11* device, HeapManager* heap, DescriptorHeap* descriptorHeap, ShaderCompiler* shaderCompiler, UINT width, UINT height)
+{
+	m_Device = device;
+	m_Heap = heap;
+	m_DescriptorHeap = descriptorHeap;
+	m_NormalDepthDescriptor = descriptorHeap->AllocatePersistent();
+	m_AlbedoDescriptor = descriptorHeap->AllocatePersistent();
+	m_ResultDescriptors[0] = descriptorHeap->AllocatePersistent();
+	m_ResultDescriptors[1] = descriptorHeap->AllocatePersistent();
+	CreatePipeline(shaderCompiler);
+	Resize(width, height);
+}
+
+void Denoiser::CreatePipeline(ShaderCompiler* shaderCompiler)
+{
+	D3D12_ROOT_PARAMETER constants = {};
+	constants.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+	constants.Constants.ShaderRegister = 0;
+	constants.Constants.RegisterSpace = 0;
+	constants.Constants.Num32BitValues = sizeof(DenoiseConstants) / 4;
+	constants.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+	// One single-entry UAV table per texture, u0 to u4, so the ping-pong results can swap roles per dispatch
+	D3D12_DESCRIPTOR_RANGE ranges[ParameterCount - 1] = {};
+	RootSignatureGenerator rootSignatureGenerator(m_Device);
+	rootSignatureGenerator.AddParameter(constants);
+	for (UINT i = 0; i < ParameterCount - 1; i++)
+	{
+		ranges[i].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+		ranges[i].NumDescriptors = 1;
+		ranges[i].BaseShaderRegister = i;
+		ranges[i].RegisterSpace = 0;
+		ranges[i].OffsetInDescriptorsFromTableStart = 0;
+
+		D3D12_ROOT_PARAMETER table = {};
+		table.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+		table.DescriptorTable.NumDescriptorRanges = 1;
+		table.DescriptorTable.pDescriptorRanges = &ranges[i];
+		table.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		rootSignatureGenerator.AddParameter(table);
+	}
+	m_RootSignature = rootSignatureGenerator.Generate();
+
+	ComPtr<IDxcBlob> shader = shaderCompiler->CompileShader(L"Shaders/Denoise.hlsl", L"Denoise", ShaderCompiler::ComputeTarget);
+	D3D12_COMPUTE_PIPELINE_STATE_DESC pipelineDesc = {};
+	pipelineDesc.pRootSignature = m_RootSignature.Get();
+	pipelineDesc.CS = { shader->GetBufferPointer(), shader->GetBufferSize() };
+	ThrowIfFailed(m_Device->CreateComputePipelineState(&pipelineDesc, IID_PPV_ARGS(&m_PipelineState)));
+}
+
+void Denoiser::Resize(UINT width, UINT height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+	m_Width = width;
+	m_Height = height;
+	m_NormalDepth.Create(m_Device, width, height, m_DescriptorHeap->GetCPUHandle(m_NormalDepthDescriptor), GuideFormat, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_Albedo.Create(m_Device, width, height, m_DescriptorHeap->GetCPUHandle(m_AlbedoDescriptor), GuideFormat, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	for (UINT i = 0; i < 2; i++)
+	{
+		m_Results[i].Create(m_Device, width, height, m_DescriptorHeap->GetCPUHandle(m_ResultDescriptors[i]), GuideFormat, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	}
+}
+
+void Denoiser::Record(ID3D12GraphicsCommandList6* commandList, UINT width, UINT height, D3D12_GPU_DESCRIPTOR_HANDLE accumulation, D3D12_GPU_DESCRIPTOR_HANDLE output, const DenoiserSettings& settings)
+{
+	commandList->SetComputeRootSignature(m_RootSignature.Get());
+	commandList->SetPipelineState(m_PipelineState.Get());
+	commandList->SetComputeRootDescriptorTable(ParameterNormalDepth, m_DescriptorHeap->GetGPUHandle(m_NormalDepthDescriptor));
+	commandList->SetComputeRootDescriptorTable(ParameterAlbedo, m_DescriptorHeap->GetGPUHandle(m_AlbedoDescriptor));
+	commandList->SetComputeRootDescriptorTable(ParameterOutput, output);
+	for (UINT iteration = 0; iteration < settings.Iterations; iteration++)
+	{
+		// Every iteration reads what the ray dispatch or the previous iteration wrote
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		barrier.UAV.pResource = nullptr;
+		commandList->ResourceBarrier(1, &barrier);
+
+		const DenoiserPass pass = DenoiserPass::Get(settings, iteration);
+		const DenoiseConstants constants = { pass.StepWidth, pass.InvColorPhi, pass.InvNormalPhi, pass.InvDepthPhi, pass.InvAlbedoPhi, iteration + 1 == settings.Iterations, width, height };
+		const UINT result = iteration % 2;
+		commandList->SetComputeRoot32BitConstants(ParameterConstants, sizeof(constants) / 4, &constants, 0);
+		commandList->SetComputeRootDescriptorTable(ParameterInput, iteration == 0 ? accumulation : m_DescriptorHeap->GetGPUHandle(m_ResultDescriptors[1 - result]));
+		commandList->SetComputeRootDescriptorTable(ParameterResult, m_DescriptorHeap->GetGPUHandle(m_ResultDescriptors[result]));
+		commandList->Dispatch((width + ThreadGroupSize - 1) / ThreadGroupSize, (height + ThreadGroupSize - 1) / ThreadGroupSize, 1);
+		m_LastResult = result;
+	}
+	m_LastSettings = settings;
+	m_LastWidth = width;
+	m_LastHeight = height;
+}
+
+// All four textures share format and size, so they share one footprint at consecutive offsets
+void Denoiser::PrepareValidation()
+{
+	const D3D12_RESOURCE_DESC desc = m_NormalDepth.GetResource()->GetDesc();
+	UINT64 totalBytes = 0;
+	m_Device->GetCopyableFootprints(&desc, 0, 1, 0, &m_Footprint, nullptr, nullptr, &totalBytes);
+	m_SliceSize = Align64(totalBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+	if (m_Readback)
+	{
+		m_Heap->FreeDeferred(m_Readback);
+	}
+	m_Readback = m_Heap->CreateBufferResource(m_Device, ReadbackHeap, D3D12_RESOURCE_STATE_COPY_DEST, SliceCount * m_SliceSize);
+}
+
+void Denoiser::RecordValidation(ID3D12GraphicsCommandList6* commandList, ID3D12Resource2* accumulation)
+{
+	ID3D12Resource2* sources[SliceCount] = { accumulation, m_NormalDepth.GetResource(), m_Albedo.GetResource(), m_Results[m_LastResult].GetResource() };
+	for (UINT slice = 0; slice < SliceCount; slice++)
+	{
+		TransitionResource(commandList, sources[slice], D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+		D3D12_TEXTURE_COPY_LOCATION destination = {};
+		destination.pResource = m_Readback.Get();
+		destination.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+		destination.PlacedFootprint = m_Footprint;
+		destination.PlacedFootprint.Offset = slice * m_SliceSize;
+		D3D12_TEXTURE_COPY_LOCATION source = {};
+		source.pResource = sources[slice];
+		source.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		source.SubresourceIndex = 0;
+		commandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+		TransitionResource(commandList, sources[slice], D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	}
+}
+
+void Denoiser::ReadSlice(const UINT8* data, ValidationSlice slice, std::vector<Float4>* pixels) const
+{
+	pixels->resize((size_t)m_LastWidth * m_LastHeight);
+	for (UINT y = 0; y < m_LastHeight; y++)
+	{
+		memcpy(pixels->data() + (size_t)y * m_LastWidth, data + slice * m_SliceSize + (UINT64)y * m_Footprint.Footprint.RowPitch, m_LastWidth * sizeof(Float4));
+	}
+}
+
+float Denoiser::Validate(ThreadPool* threadPool)
+{
+	if (!m_Readback)
+	{
+		throw std::logic_error("Denoiser::Validate called without RecordValidation");
+	}
+	std::vector<Float4> accumulation;
+	std::vector<Float4> normalDepth;
+	std::vector<Float4> albedo;
+	std::vector<Float4> gpuResult;
+	UINT8* data = nullptr;
+	const D3D12_RANGE readRange = { 0, SliceCount * m_SliceSize };
+	ThrowIfFailed(m_Readback->Map(0, &readRange, (void**)&data));
+	ReadSlice(data, SliceAccumulation, &accumulation);
+	ReadSlice(data, SliceNormalDepth, &normalDepth);
+	ReadSlice(data, SliceAlbedo, &albedo);
+	ReadSlice(data, SliceResult, &gpuResult);
+	const D3D12_RANGE writeRange = { 0, 0 };
+	m_Readback->Unmap(0, &writeRange);
+	m_Heap->FreeDeferred(m_Readback);
+	m_Readback.Reset();
+
+	CpuDenoiser cpuDenoiser;
+	std::vector<Float4> cpuResult;
+	cpuDenoiser.Denoise(accumulation.data(), normalDepth.data(), albedo.data(), m_LastWidth, m_LastHeight, m_LastSettings, threadPool, &cpuResult);
+	float maxDifference = 0.0f;
+	for (size_t i = 0; i < cpuResult.size(); i++)
+	{
+		maxDifference = std::max({ maxDifference, std::abs(cpuResult[i].x - gpuResult[i].x), std::abs(cpuResult[i].y - gpuResult[i].y), std::abs(cpuResult[i].z - gpuResult[i].z) });
+	}
+	return maxDifference;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE Denoiser::GetNormalDepthDescriptor()
+{
+	return m_DescriptorHeap->GetGPUHandle(m_NormalDepthDescriptor);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE Denoiser::GetAlbedoDescriptor()
+{
+	return m_DescriptorHeap->GetGPUHandle(m_AlbedoDescriptor);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "PCH.h"
+#include "OutputBuffer.h"
+#include "DescriptorHeap.h"
+#include "CpuDenoiser.h"
+
+class HeapManager;
+class ShaderCompiler;
+class ThreadPool;
+
+// The à-trous filter on the GPU: one compute dispatch per iteration after the ray dispatch, see Denoise.hlsl.
+// Owns the guide buffers RayGen writes and two ping-pong results. On request it reads the inputs and the result
+// back, so CpuDenoiser can check the GPU version against the same data.
+class Denoiser
+{
+public:
+	void Create(ID3D12Device11* device, HeapManager* heap, DescriptorHeap* descriptorHeap, ShaderCompiler* shaderCompiler, UINT width, UINT height);
+	// The caller has flushed the queue, like SwapChain::Resize
+	void Resize(UINT width, UINT height);
+	// Accumulation and output are in UNORDERED_ACCESS, the descriptor heap is already set on the list.
+	// Filters the top left width by height pixels, the render resolution
+	void Record(ID3D12GraphicsCommandList6* commandList, UINT width, UINT height, D3D12_GPU_DESCRIPTOR_HANDLE accumulation, D3D12_GPU_DESCRIPTOR_HANDLE output, const DenoiserSettings& settings);
+	// Allocates the readback buffer on the render thread, before RecordValidation is recorded on a worker
+	void PrepareValidation();
+	// Copies what the last Record read and wrote to the readback buffer
+	void RecordValidation(ID3D12GraphicsCommandList6* commandList, ID3D12Resource2* accumulation);
+	// Once the copies have executed: runs CpuDenoiser on the GPU's inputs and returns the largest channel difference
+	float Validate(ThreadPool* threadPool);
+	D3D12_GPU_DESCRIPTOR_HANDLE GetNormalDepthDescriptor();
+	D3D12_GPU_DESCRIPTOR_HANDLE GetAlbedoDescriptor();
+private:
+	enum ValidationSlice
+	{
+		SliceAccumulation,
+		SliceNormalDepth,
+		SliceAlbedo,
+		SliceResult,
+		SliceCount
+	};
+	void CreatePipeline(ShaderCompiler* shaderCompiler);
+	void ReadSlice(const UINT8* data, ValidationSlice slice, std::vector<Float4>* pixels) const;
+	ID3D12Device11* m_Device = nullptr;
+	HeapManager* m_Heap = nullptr;
+	DescriptorHeap* m_DescriptorHeap = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_RootSignature;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_PipelineState;
+	OutputBuffer m_NormalDepth;
+	OutputBuffer m_Albedo;
+	OutputBuffer m_Results[2];
+	DescriptorRange m_NormalDepthDescriptor;
+	DescriptorRange m_AlbedoDescriptor;
+	DescriptorRange m_ResultDescriptors[2];
+	UINT m_LastResult = 0;
+	DenoiserSettings m_LastSettings;
+	Microsoft::WRL::ComPtr<ID3D12Resource2> m_Readback;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT m_Footprint = {};
+	UINT64 m_SliceSize = 0;
+	UINT m_Width = 0;
+	UINT m_Height = 0;
+	// Render resolution of the last Record, validation compares that corner
+	UINT m_LastWidth = 0;
+	UINT m_LastHeight = 0;
+};
@@ -0,0 +1,69 @@
+#include "DescriptorAllocator.h"
+#include <cassert>
+
+void DescriptorAllocator::Reset(uint32_t persistentCount, uint32_t transientCount)
+{
+	m_PersistentCount = persistentCount;
+	m_Persistent.Reset(persistentCount);
+	m_Transient.Reset(transientCount);
+	m_PendingFrees.clear();
+	m_InFlightFrees.clear();
+}
+
+// Returns an invalid range when no contiguous run of count descriptors is free
+DescriptorAllocator::Range DescriptorAllocator::AllocatePersistent(uint32_t count)
+{
+	Range range;
+	OffsetAllocator::Allocation allocation;
+	if (!m_Persistent.Allocate(count, 1, &allocation))
+		return range;
+	range.Index = (uint32_t)allocation.Offset;
+	range.Count = count;
+	range.Node = allocation.Node;
+	return range;
+}
+
+// The caller must make sure the GPU no longer reads the descriptors
+void DescriptorAllocator::Free(const Range& range)
+{
+	assert(range.IsValid());
+	OffsetAllocator::Allocation allocation;
+	allocation.Offset = range.Index;
+	allocation.Node = range.Node;
+	m_Persistent.Free(allocation);
+}
+
+// Keeps the range reserved until the current frame has completed on the GPU
+void DescriptorAllocator::FreeDeferred(const Range& range)
+{
+	m_PendingFrees.push_back(range);
+}
+
+// Transient indices follow the persistent region. Returns InvalidIndex when the ring is full.
+uint32_t DescriptorAllocator::AllocateTransient(uint32_t count)
+{
+	const uint64_t offset = m_Transient.Allocate(count, 1);
+	if (offset == RingAllocator::InvalidOffset)
+		return InvalidIndex;
+	return m_PersistentCount + (uint32_t)offset;
+}
+
+void DescriptorAllocator::EndFrame(uint64_t fenceValue)
+{
+	m_Transient.EndFrame(fenceValue);
+	m_InFlightFrees.emplace_back(fenceValue, std::move(m_PendingFrees));
+	m_PendingFrees.clear();
+}
+
+void DescriptorAllocator::Retire(uint64_t completedFenceValue)
+{
+	m_Transient.Retire(completedFenceValue);
+	while (!m_InFlightFrees.empty() && m_InFlightFrees.front().first <= completedFenceValue)
+	{
+		for (const Range& range : m_InFlightFrees.front().second)
+		{
+			Free(range);
+		}
+		m_InFlightFrees.pop_front();
+	}
+}
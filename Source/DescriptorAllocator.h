@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "OffsetAllocator.h"
+#include "RingAllocator.h"
+
+// Index bookkeeping for one descriptor heap, split in two regions:
+// persistent ranges come from a free-list allocator and live until freed, transient ranges come from a ring
+// and are valid for the frame that allocated them only. Works on indices, so it runs without a device.
+class DescriptorAllocator
+{
+public:
+	static constexpr uint32_t InvalidIndex = 0xFFFFFFFF;
+	struct Range
+	{
+		uint32_t Index = InvalidIndex;
+		uint32_t Count = 0;
+		uint32_t Node = OffsetAllocator::InvalidNode;
+		inline bool IsValid() const { return Index != InvalidIndex; }
+	};
+	void Reset(uint32_t persistentCount, uint32_t transientCount);
+	Range AllocatePersistent(uint32_t count = 1);
+	void Free(const Range& range);
+	void FreeDeferred(const Range& range);
+	uint32_t AllocateTransient(uint32_t count);
+	void EndFrame(uint64_t fenceValue);
+	void Retire(uint64_t completedFenceValue);
+	inline uint32_t GetPersistentCount() const { return m_PersistentCount; }
+	inline uint32_t GetTransientCount() const { return (uint32_t)m_Transient.GetSize(); }
+	inline uint32_t GetPersistentUsed() const { return (uint32_t)m_Persistent.GetUsedSize(); }
+	inline uint32_t GetTransientUsed() const { return (uint32_t)m_Transient.GetUsedSize(); }
+private:
+	uint32_t m_PersistentCount = 0;
+	OffsetAllocator m_Persistent;
+	RingAllocator m_Transient;
+	std::vector<Range> m_PendingFrees;
+	std::deque<std::pair<uint64_t, std::vector<Range>>> m_InFlightFrees;
+};
@@ -2,18 +2,16 @@
 #include "DescriptorHeap.h"
 #include "DX12Utility.h"
 
-UINT DescriptorHeap::HEAPINDEX = 0;
-
 DescriptorHeap::DescriptorHeap() :
 	m_CPUHeapStart {},
 	m_GPUHeapStart {},
 	HandleIncrementSize {}
 {}
 
-void DescriptorHeap::Create(ID3D12Device11* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT numDescs, D3D12_DESCRIPTOR_HEAP_FLAGS flags)
+void DescriptorHeap::Create(ID3D12Device11* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT persistentCount, UINT transientCount, D3D12_DESCRIPTOR_HEAP_FLAGS flags)
 {
 	D3D12_DESCRIPTOR_HEAP_DESC desc = {};
-	desc.NumDescriptors = numDescs;
+	desc.NumDescriptors = persistentCount + transientCount;
 	desc.Type = type;
 	desc.Flags = flags;
 	ThrowIfFailed(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&m_DescriptorHeap)));
@@ -21,6 +19,33 @@ void DescriptorHeap::Create(ID3D12Device11* device, D3D12_DESCRIPTOR_HEAP_TYPE t
 	m_CPUHeapStart = m_DescriptorHeap->GetCPUDescriptorHandleForHeapStart();
 	if (flags == D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE)
 		m_GPUHeapStart = m_DescriptorHeap->GetGPUDescriptorHandleForHeapStart();
+	m_Allocator.Reset(persistentCount, transientCount);
+}
+
+DescriptorRange DescriptorHeap::AllocatePersistent(UINT count)
+{
+	DescriptorRange range = m_Allocator.AllocatePersistent(count);
+	if (!range.IsValid())
+	{
+		throw std::runtime_error("Descriptor heap has no free persistent range");
+	}
+	return range;
+}
+
+void DescriptorHeap::FreeDeferred(const DescriptorRange& range)
+{
+	m_Allocator.FreeDeferred(range);
+}
+
+// Valid until the frame that allocated it has completed on the GPU
+UINT DescriptorHeap::AllocateTransient(UINT count)
+{
+	const UINT index = m_Allocator.AllocateTransient(count);
+	if (index == DescriptorAllocator::InvalidIndex)
+	{
+		throw std::runtime_error("Descriptor heap transient ring is full");
+	}
+	return index;
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::GetCPUHandle(UINT index)
@@ -1,20 +1,31 @@
 #pragma once
 #include "PCH.h"
+#include "DescriptorAllocator.h"
 
+using DescriptorRange = DescriptorAllocator::Range;
+
+// Descriptor heap handing out persistent ranges (free list, deferred release) and per-frame transient ranges
+// (ring recycled by fence), so callers never pick slot numbers themselves
 class DescriptorHeap
 {
 public:
 	DescriptorHeap();
-	void Create(ID3D12Device11* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT numDescs, D3D12_DESCRIPTOR_HEAP_FLAGS flags);
+	void Create(ID3D12Device11* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT persistentCount, UINT transientCount, D3D12_DESCRIPTOR_HEAP_FLAGS flags);
+	DescriptorRange AllocatePersistent(UINT count = 1);
+	void FreeDeferred(const DescriptorRange& range);
+	UINT AllocateTransient(UINT count);
+	inline void EndFrame(UINT64 fenceValue) { m_Allocator.EndFrame(fenceValue); }
+	inline void Retire(UINT64 completedFenceValue) { m_Allocator.Retire(completedFenceValue); }
 	D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(UINT index);
 	D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(UINT index);
+	inline D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(const DescriptorRange& range) { return GetCPUHandle(range.Index); }
+	inline D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(const DescriptorRange& range) { return GetGPUHandle(range.Index); }
 	inline ID3D12DescriptorHeap* GetHeap() { return m_DescriptorHeap.Get(); }
 	inline ID3D12DescriptorHeap** GetAddressOfHeap() { return m_DescriptorHeap.GetAddressOf(); }
-	inline UINT GetUniqueHeapIndex() { return HEAPINDEX++; }
 private:
-	static UINT HEAPINDEX;
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_DescriptorHeap;
 	D3D12_CPU_DESCRIPTOR_HANDLE m_CPUHeapStart;
 	D3D12_GPU_DESCRIPTOR_HANDLE m_GPUHeapStart;
 	UINT HandleIncrementSize;
-};
\ No newline at end of file
+	DescriptorAllocator m_Allocator;
+};
@@ -0,0 +1,76 @@
+#include "PCH.h"
+#include "FrameCapture.h"
+#include "Heap.h"
+#include "DX12Utility.h"
+#include "ImageWriter.h"
+
+void FrameCapture::Create(ID3D12Device11* device, HeapManager* heap, UINT framesInFlight)
+{
+	m_Device = device;
+	m_Heap = heap;
+	m_Slots = std::make_unique<Slot[]>(framesInFlight);
+}
+
+// Acquire only waits when the writer still holds every buffer, i.e. captures were requested faster than they encode
+void FrameCapture::BeginFrame(UINT frameIndex, ImageWriter* writer)
+{
+	m_FrameIndex = frameIndex;
+	m_Texture = nullptr;
+	Slot& slot = m_Slots[frameIndex];
+	if (slot.Path.empty())
+		return;
+
+	const D3D12_SUBRESOURCE_FOOTPRINT& footprint = slot.Footprint.Footprint;
+	ImageBuffer* image = writer->Acquire();
+	image->Resize(footprint.Width, footprint.Height, ImagePixelRGBA8);
+	const D3D12_RANGE readRange = { 0, slot.Size };
+	UINT8* data = nullptr;
+	ThrowIfFailed(slot.Readback->Map(0, &readRange, (void**)&data));
+	for (UINT y = 0; y < footprint.Height; y++)
+	{
+		memcpy(image->RGBA8.data() + (size_t)y * footprint.Width, data + (UINT64)y * footprint.RowPitch, footprint.Width * sizeof(UINT32));
+	}
+	const D3D12_RANGE writeRange = { 0, 0 };
+	slot.Readback->Unmap(0, &writeRange);
+	writer->Submit(image, slot.Path);
+	slot.Path.clear();
+}
+
+// The readback buffer is kept for the next capture of the same size
+void FrameCapture::Request(ID3D12Resource2* texture, const std::string& path)
+{
+	Slot& slot = m_Slots[m_FrameIndex];
+	const D3D12_RESOURCE_DESC desc = texture->GetDesc();
+	UINT64 size = 0;
+	m_Device->GetCopyableFootprints(&desc, 0, 1, 0, &slot.Footprint, nullptr, nullptr, &size);
+	if (size != slot.Size)
+	{
+		if (slot.Readback)
+		{
+			m_Heap->FreeDeferred(slot.Readback);
+		}
+		slot.Readback = m_Heap->CreateBufferResource(m_Device, ReadbackHeap, D3D12_RESOURCE_STATE_COPY_DEST, size);
+		slot.Size = size;
+	}
+	slot.Path = path;
+	m_Texture = texture;
+}
+
+void FrameCapture::Record(ID3D12GraphicsCommandList6* commandList)
+{
+	if (!m_Texture)
+		return;
+	ID3D12Resource2* texture = m_Texture;
+	const Slot& slot = m_Slots[m_FrameIndex];
+	TransitionResource(commandList, texture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	D3D12_TEXTURE_COPY_LOCATION destination = {};
+	destination.pResource = slot.Readback.Get();
+	destination.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+	destination.PlacedFootprint = slot.Footprint;
+	D3D12_TEXTURE_COPY_LOCATION source = {};
+	source.pResource = texture;
+	source.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+	source.SubresourceIndex = 0;
+	commandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+	TransitionResource(commandList, texture, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "PCH.h"
+
+class HeapManager;
+class ImageWriter;
+
+// Saves displayed frames without stalling the GPU. Request allocates the frame slot's readback buffer on the render
+// thread and Record copies the image into it from whichever thread records the pass; once the slot comes around
+// again its frame has completed and BeginFrame hands the pixels to an ImageWriter.
+class FrameCapture
+{
+public:
+	void Create(ID3D12Device11* device, HeapManager* heap, UINT framesInFlight);
+	// The caller has already waited for the slot's previous frame, like RayStatistics::BeginFrame
+	void BeginFrame(UINT frameIndex, ImageWriter* writer);
+	// Captures texture, R8G8B8A8_UNORM, in this frame
+	void Request(ID3D12Resource2* texture, const std::string& path);
+	// Does nothing unless requested this frame. The texture is in UNORDERED_ACCESS and returns to it
+	void Record(ID3D12GraphicsCommandList6* commandList);
+private:
+	struct Slot
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource2> Readback;
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT Footprint = {};
+		UINT64 Size = 0;
+		std::string Path; // empty while nothing is recorded
+	};
+	ID3D12Device11* m_Device = nullptr;
+	HeapManager* m_Heap = nullptr;
+	std::unique_ptr<Slot[]> m_Slots;
+	UINT m_FrameIndex = 0;
+	ID3D12Resource2* m_Texture = nullptr; // requested this frame
+};
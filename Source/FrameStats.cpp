@@ -0,0 +1,107 @@
+#include "FrameStats.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+void FrameStats::AddPhaseTime(Phase phase, double milliseconds)
+{
+	m_Current[phase] += (float)milliseconds;
+}
+
+void FrameStats::EndFrame(double frameMilliseconds)
+{
+	m_Current[PhaseFrame] = (float)frameMilliseconds;
+	std::copy(m_Current, m_Current + PhaseCount, m_Samples[m_Next]);
+	std::fill(m_Current, m_Current + PhaseCount, 0.0f);
+	m_Next = (m_Next + 1) % Capacity;
+	m_Count = std::min(m_Count + 1, Capacity);
+	m_FrameNumber++;
+}
+
+// Nearest-rank percentiles over the recorded history
+FrameStats::Summary FrameStats::GetSummary(Phase phase) const
+{
+	Summary summary;
+	summary.Samples = m_Count;
+	if (!m_Count)
+		return summary;
+
+	float values[Capacity];
+	double sum = 0.0;
+	for (uint32_t i = 0; i < m_Count; i++)
+	{
+		values[i] = m_Samples[i][phase];
+		sum += values[i];
+	}
+	summary.Mean = sum / m_Count;
+	auto Percentile = [&](double p)
+	{
+		const uint32_t rank = (uint32_t)std::ceil(p * m_Count);
+		float* nth = values + (rank ? rank - 1 : 0);
+		std::nth_element(values, nth, values + m_Count);
+		return (double)*nth;
+	};
+	summary.P50 = Percentile(0.50);
+	summary.P95 = Percentile(0.95);
+	summary.P99 = Percentile(0.99);
+	summary.Max = *std::max_element(values, values + m_Count);
+	return summary;
+}
+
+// Samples oldest first, followed by a second table with the summary of every phase
+bool FrameStats::WriteCSV(const char* path) const
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+	file << std::fixed << std::setprecision(4);
+
+	auto WriteHeader = [&](const char* first)
+	{
+		file << first;
+		for (int phase = 0; phase < PhaseCount; phase++)
+			file << ',' << GetPhaseName((Phase)phase) << "_ms";
+		file << '\n';
+	};
+	WriteHeader("frame");
+	const uint32_t first = m_Count < Capacity ? 0 : m_Next;
+	for (uint32_t i = 0; i < m_Count; i++)
+	{
+		file << m_FrameNumber - m_Count + i;
+		const float* sample = m_Samples[(first + i) % Capacity];
+		for (int phase = 0; phase < PhaseCount; phase++)
+			file << ',' << sample[phase];
+		file << '\n';
+	}
+
+	Summary summaries[PhaseCount];
+	for (int phase = 0; phase < PhaseCount; phase++)
+		summaries[phase] = GetSummary((Phase)phase);
+	const char* names[] = { "p50", "p95", "p99", "max", "mean" };
+	double Summary::* fields[] = { &Summary::P50, &Summary::P95, &Summary::P99, &Summary::Max, &Summary::Mean };
+	file << '\n';
+	WriteHeader("stat");
+	for (int row = 0; row < 5; row++)
+	{
+		file << names[row];
+		for (int phase = 0; phase < PhaseCount; phase++)
+			file << ',' << summaries[phase].*fields[row];
+		file << '\n';
+	}
+	return (bool)file;
+}
+
+const char* FrameStats::GetPhaseName(Phase phase)
+{
+	switch (phase)
+	{
+	case PhaseUpdate: return "update";
+	case PhaseSceneBuild: return "scene_build";
+	case PhaseASBuild: return "as_build";
+	case PhaseRecord: return "record";
+	case PhasePresent: return "present";
+	case PhaseFrame: return "frame";
+	default: return "unknown";
+	}
+}
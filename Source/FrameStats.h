@@ -0,0 +1,56 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+// Per-phase CPU frame timings over the last Capacity frames. Percentiles and max expose the hitches
+// an average frame rate hides; the raw history can be dumped to CSV for offline analysis.
+// Owned by the thread that renders, nothing here is synchronized.
+class FrameStats
+{
+public:
+	enum Phase
+	{
+		PhaseUpdate,
+		PhaseSceneBuild,
+		PhaseASBuild, // preparing the TLAS build
+		PhaseRecord, // recording every pass, wall time on the render thread
+		PhasePresent,
+		PhaseFrame,
+		PhaseCount
+	};
+	struct Summary
+	{
+		double P50 = 0.0;
+		double P95 = 0.0;
+		double P99 = 0.0;
+		double Max = 0.0;
+		double Mean = 0.0;
+		uint32_t Samples = 0;
+	};
+	// Adds the elapsed time of its scope to a phase of the current frame
+	class ScopedPhase
+	{
+	public:
+		ScopedPhase(FrameStats* stats, Phase phase) : m_Stats(stats), m_Phase(phase), m_Start(std::chrono::steady_clock::now()) {}
+		~ScopedPhase() { m_Stats->AddPhaseTime(m_Phase, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Start).count()); }
+		ScopedPhase(const ScopedPhase&) = delete;
+		ScopedPhase& operator=(const ScopedPhase&) = delete;
+	private:
+		FrameStats* m_Stats;
+		Phase m_Phase;
+		std::chrono::steady_clock::time_point m_Start;
+	};
+	static constexpr uint32_t Capacity = 1024;
+	void AddPhaseTime(Phase phase, double milliseconds);
+	void EndFrame(double frameMilliseconds);
+	Summary GetSummary(Phase phase) const;
+	bool WriteCSV(const char* path) const;
+	inline uint32_t GetSampleCount() const { return m_Count; }
+	static const char* GetPhaseName(Phase phase);
+private:
+	float m_Samples[Capacity][PhaseCount] = {};
+	float m_Current[PhaseCount] = {};
+	uint32_t m_Next = 0;
+	uint32_t m_Count = 0;
+	uint64_t m_FrameNumber = 0;
+};
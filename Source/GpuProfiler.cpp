@@ -0,0 +1,87 @@
+#include "PCH.h"
+#include "GpuProfiler.h"
+#include "Heap.h"
+#include "DX12Utility.h"
+
+void GpuProfiler::Create(ID3D12Device11* device, HeapManager* heap, ID3D12CommandQueue* commandQueue, UINT framesInFlight)
+{
+	const UINT queryCount = MaxEventsPerFrame * 2 * framesInFlight;
+	D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+	queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	queryHeapDesc.Count = queryCount;
+	ThrowIfFailed(device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_QueryHeap)));
+	m_Readback = heap->CreateBufferResource(device, ReadbackHeap, D3D12_RESOURCE_STATE_COPY_DEST, queryCount * sizeof(UINT64));
+	m_Frames = std::make_unique<FrameEvents[]>(framesInFlight);
+
+	// One calibration at startup relates GPU ticks to QPC, which the profiler clock is based on with MSVC
+	LARGE_INTEGER qpcFrequency;
+	QueryPerformanceFrequency(&qpcFrequency);
+	UINT64 cpuCalibration = 0;
+	ThrowIfFailed(commandQueue->GetTimestampFrequency(&m_GpuFrequency));
+	ThrowIfFailed(commandQueue->GetClockCalibration(&m_GpuCalibration, &cpuCalibration));
+	m_CpuCalibrationNs = (double)cpuCalibration * 1e9 / (double)qpcFrequency.QuadPart;
+	m_Track = Profiler::RegisterTrack("GPU");
+}
+
+// The caller has already waited for the slot's previous frame, so its resolved timestamps are final
+void GpuProfiler::BeginFrame(UINT frameIndex)
+{
+	m_FrameIndex = frameIndex;
+	FrameEvents& frame = m_Frames[frameIndex];
+	// Timestamps resolved just before a capture stopped are dropped, the trace is already written
+	if (frame.Resolved && frame.Count && Profiler::IsCapturing())
+	{
+		const UINT first = frameIndex * MaxEventsPerFrame * 2;
+		const D3D12_RANGE readRange = { first * sizeof(UINT64), (first + frame.Count * 2) * sizeof(UINT64) };
+		UINT64* timestamps = nullptr;
+		ThrowIfFailed(m_Readback->Map(0, &readRange, (void**)&timestamps));
+		for (UINT i = 0; i < frame.Count; i++)
+		{
+			Profiler::RecordOnTrack(m_Track, frame.Names[i], ToProfilerTime(timestamps[first + i * 2]), ToProfilerTime(timestamps[first + i * 2 + 1]));
+		}
+		const D3D12_RANGE writeRange = { 0, 0 };
+		m_Readback->Unmap(0, &writeRange);
+	}
+	frame.Count = 0;
+	frame.Resolved = false;
+}
+
+UINT GpuProfiler::BeginEvent(ID3D12GraphicsCommandList6* commandList, const char* name)
+{
+	FrameEvents& frame = m_Frames[m_FrameIndex];
+	if (!Profiler::IsCapturing())
+		return InvalidEvent;
+	const UINT event = frame.Count.fetch_add(1);
+	if (event >= MaxEventsPerFrame)
+	{
+		frame.Count = MaxEventsPerFrame;
+		return InvalidEvent;
+	}
+	frame.Names[event] = name;
+	commandList->EndQuery(m_QueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, (m_FrameIndex * MaxEventsPerFrame + event) * 2);
+	return event;
+}
+
+void GpuProfiler::EndEvent(ID3D12GraphicsCommandList6* commandList, UINT event)
+{
+	if (event == InvalidEvent)
+		return;
+	commandList->EndQuery(m_QueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, (m_FrameIndex * MaxEventsPerFrame + event) * 2 + 1);
+}
+
+// Call once per frame, after every event of the frame was recorded, on a list submitted after them
+void GpuProfiler::Resolve(ID3D12GraphicsCommandList6* commandList)
+{
+	FrameEvents& frame = m_Frames[m_FrameIndex];
+	if (!frame.Count)
+		return;
+	const UINT first = m_FrameIndex * MaxEventsPerFrame * 2;
+	commandList->ResolveQueryData(m_QueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, first, frame.Count * 2, m_Readback.Get(), first * sizeof(UINT64));
+	frame.Resolved = true;
+}
+
+uint64_t GpuProfiler::ToProfilerTime(UINT64 gpuTimestamp) const
+{
+	const double deltaNs = ((double)gpuTimestamp - (double)m_GpuCalibration) * 1e9 / (double)m_GpuFrequency;
+	return (uint64_t)(m_CpuCalibrationNs + deltaNs);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "PCH.h"
+#include "Profiler.h"
+
+class HeapManager;
+
+// Timestamp queries around GPU work, resolved once per frame and read back when that frame slot is reused.
+// Results are converted to the CPU profiler clock and recorded on a "GPU" track.
+class GpuProfiler
+{
+public:
+	static constexpr UINT InvalidEvent = 0xFFFFFFFF;
+	void Create(ID3D12Device11* device, HeapManager* heap, ID3D12CommandQueue* commandQueue, UINT framesInFlight);
+	void BeginFrame(UINT frameIndex);
+	UINT BeginEvent(ID3D12GraphicsCommandList6* commandList, const char* name);
+	void EndEvent(ID3D12GraphicsCommandList6* commandList, UINT event);
+	void Resolve(ID3D12GraphicsCommandList6* commandList);
+	class ScopedEvent
+	{
+	public:
+		ScopedEvent(GpuProfiler* profiler, ID3D12GraphicsCommandList6* commandList, const char* name) : m_Profiler(profiler), m_CommandList(commandList), m_Event(profiler->BeginEvent(commandList, name)) {}
+		~ScopedEvent() { m_Profiler->EndEvent(m_CommandList, m_Event); }
+		ScopedEvent(const ScopedEvent&) = delete;
+		ScopedEvent& operator=(const ScopedEvent&) = delete;
+	private:
+		GpuProfiler* m_Profiler;
+		ID3D12GraphicsCommandList6* m_CommandList;
+		UINT m_Event;
+	};
+private:
+	static constexpr UINT MaxEventsPerFrame = 64;
+	struct FrameEvents
+	{
+		const char* Names[MaxEventsPerFrame] = {};
+		std::atomic<UINT> Count = 0; // passes may record events from several threads
+		bool Resolved = false;
+	};
+	uint64_t ToProfilerTime(UINT64 gpuTimestamp) const;
+	Microsoft::WRL::ComPtr<ID3D12QueryHeap> m_QueryHeap;
+	Microsoft::WRL::ComPtr<ID3D12Resource2> m_Readback;
+	std::unique_ptr<FrameEvents[]> m_Frames;
+	UINT m_FrameIndex = 0;
+	UINT64 m_GpuFrequency = 1;
+	UINT64 m_GpuCalibration = 0;
+	double m_CpuCalibrationNs = 0.0;
+	uint32_t m_Track = 0;
+};
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit FNV-1a, used for cache keys and change detection rather than anything adversarial
+constexpr uint64_t FNVOffsetBasis = 0xCBF29CE484222325ULL;
+constexpr uint64_t FNVPrime = 0x100000001B3ULL;
+
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = FNVOffsetBasis)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= FNVPrime;
+	}
+	return hash;
+}
@@ -0,0 +1,22 @@
+#include "OfflineRender.h"
+#include "RegressionTest.h"
+#include <iostream>
+
+// Entry point of the headless build, which contains only the portable CPU path and runs on any platform, see README.md.
+// The Windows executable renders the same way when started with --headless.
+int main(int argc, char** argv)
+{
+	const std::vector<std::string> arguments(argv + 1, argv + argc);
+	OfflineRenderSettings settings;
+	std::string error;
+	if (!OfflineRender::ParseArguments(arguments, &settings, &error))
+	{
+		std::cerr << error << (error.empty() ? "" : "\n") << OfflineRender::GetUsage();
+		return error.empty() ? 0 : 1;
+	}
+	if (!settings.Regression.empty())
+		return RegressionTest::Run(settings, std::cout);
+	if (!settings.ConvertScene.empty())
+		return OfflineRender::ConvertScene(settings, std::cout);
+	return OfflineRender::Run(settings, std::cout);
+}
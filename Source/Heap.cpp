@@ -4,35 +4,86 @@
 
 using namespace Microsoft::WRL;
 
-HeapManager::SingleHeap::SingleHeap() :
-	m_CurrentOffset(0)
-{}
-
-void HeapManager::SingleHeap::Create(ID3D12Device11* device, D3D12_HEAP_TYPE type, UINT64 heapsize)
+void HeapManager::HeapChain::Create(ID3D12Device11* device, D3D12_HEAP_TYPE type, UINT64 pageSize)
 {
-	D3D12_HEAP_DESC heapProperties = {};
-	heapProperties.SizeInBytes = Align64(heapsize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
-	heapProperties.Properties = { type };
-	heapProperties.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
-	heapProperties.Flags = D3D12_HEAP_FLAG_NONE;
-
-	ThrowIfFailed(device->CreateHeap(&heapProperties, IID_PPV_ARGS(&m_Heap)));
+	m_Type = type;
+	m_PageSize = Align64(pageSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	AddPage(device, m_PageSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
 }
 
-ComPtr<ID3D12Resource2> HeapManager::SingleHeap::CreateResource(ID3D12Device11* device, D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES state, D3D12_CLEAR_VALUE* clearvalue)
+ComPtr<ID3D12Resource2> HeapManager::HeapChain::CreateResource(ID3D12Device11* device, D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES state, D3D12_CLEAR_VALUE* clearvalue, Placement* placement)
 {
+	const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = device->GetResourceAllocationInfo(0, 1, desc);
+	const UINT64 size = Align64(allocationInfo.SizeInBytes, allocationInfo.Alignment);
+
+	UINT page = 0;
+	for (; page < (UINT)m_Pages.size(); page++)
+	{
+		if (m_Pages[page].Heap && m_Pages[page].Allocator.Allocate(size, allocationInfo.Alignment, &placement->Allocation))
+			break;
+	}
+	if (page == (UINT)m_Pages.size())
+	{
+		page = AddPage(device, std::max(m_PageSize, Align64(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)), allocationInfo.Alignment);
+		if (!m_Pages[page].Allocator.Allocate(size, allocationInfo.Alignment, &placement->Allocation))
+			throw std::runtime_error("Resource does not fit in a new heap page");
+	}
+	placement->Page = page;
+	placement->Size = size;
+
 	ComPtr<ID3D12Resource2> Resource;
-	UINT64 ResourceSize = 0;
-	device->GetCopyableFootprints(desc, 0, desc->MipLevels, 0, nullptr, nullptr, nullptr, &ResourceSize);
-	ResourceSize = Align64(ResourceSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
-	ThrowIfFailed(device->CreatePlacedResource(m_Heap.Get(), m_CurrentOffset, desc, state, clearvalue, IID_PPV_ARGS(&Resource)));
-	m_CurrentOffset += ResourceSize;
+	ThrowIfFailed(device->CreatePlacedResource(m_Pages[page].Heap.Get(), placement->Allocation.Offset, desc, state, clearvalue, IID_PPV_ARGS(&Resource)));
 	return Resource;
 }
 
-void HeapManager::SingleHeap::ResetOffset()
+void HeapManager::HeapChain::Free(const Placement& placement)
+{
+	m_Pages[placement.Page].Allocator.Free(placement.Allocation);
+}
+
+void HeapManager::HeapChain::Reset()
 {
-	m_CurrentOffset = 0;
+	for (Page& page : m_Pages)
+	{
+		if (page.Heap)
+			page.Allocator.Reset(page.Allocator.GetSize());
+	}
+}
+
+// Releases every overflow page that no longer holds a placement
+void HeapManager::HeapChain::Trim()
+{
+	for (size_t i = 1; i < m_Pages.size(); i++)
+	{
+		if (m_Pages[i].Heap && m_Pages[i].Allocator.GetAllocationCount() == 0)
+		{
+			m_Pages[i].Heap.Reset();
+			m_Pages[i].Allocator.Reset(0);
+		}
+	}
+}
+
+UINT HeapManager::HeapChain::AddPage(ID3D12Device11* device, UINT64 size, UINT64 alignment)
+{
+	D3D12_HEAP_DESC heapProperties = {};
+	heapProperties.SizeInBytes = size;
+	heapProperties.Properties = { m_Type };
+	heapProperties.Alignment = std::max<UINT64>(alignment, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	heapProperties.Flags = D3D12_HEAP_FLAG_NONE;
+
+	// Reuse a slot released by Trim so placements keep their page indices
+	UINT page = 0;
+	while (page < (UINT)m_Pages.size() && m_Pages[page].Heap)
+	{
+		page++;
+	}
+	if (page == (UINT)m_Pages.size())
+	{
+		m_Pages.emplace_back();
+	}
+	ThrowIfFailed(device->CreateHeap(&heapProperties, IID_PPV_ARGS(&m_Pages[page].Heap)));
+	m_Pages[page].Allocator.Reset(size);
+	return page;
 }
 
 void HeapManager::Create(ID3D12Device11* device)
@@ -43,17 +94,25 @@ void HeapManager::Create(ID3D12Device11* device)
 	constexpr UINT64 ScratchDefaultHeapSize = 1024ULL * 1024 * 20;
 	constexpr UINT64 BLASHeapSize = 1024ULL * 1024 * 20;
 	constexpr UINT64 TLASHeapSize = 1024ULL * 1024 * 20;
+	constexpr UINT64 ReadbackHeapSize = 1024ULL * 1024 * 4;
 	m_Heaps[UploadHeap].Create(device, D3D12_HEAP_TYPE_UPLOAD, UploadHeapSize);
 	m_Heaps[ScratchUploadHeap].Create(device, D3D12_HEAP_TYPE_UPLOAD, ScratchUploadHeapSize);
 	m_Heaps[DefaultHeap].Create(device, D3D12_HEAP_TYPE_DEFAULT, DefaultHeapSize);
 	m_Heaps[ScratchDefaultHeap].Create(device, D3D12_HEAP_TYPE_DEFAULT, ScratchDefaultHeapSize);
 	m_Heaps[BLASHeap].Create(device, D3D12_HEAP_TYPE_DEFAULT, BLASHeapSize);
 	m_Heaps[TLASHeap].Create(device, D3D12_HEAP_TYPE_DEFAULT, TLASHeapSize);
+	m_Heaps[ReadbackHeap].Create(device, D3D12_HEAP_TYPE_READBACK, ReadbackHeapSize);
 }
 
 ComPtr<ID3D12Resource2> HeapManager::CreateResource(ID3D12Device11* device, HeapType type, D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES state, D3D12_CLEAR_VALUE* clearvalue)
 {
-	return m_Heaps[type].CreateResource(device, desc, state, clearvalue);
+	Placement placement = {};
+	placement.Type = type;
+	ComPtr<ID3D12Resource2> resource = m_Heaps[type].CreateResource(device, desc, state, clearvalue, &placement);
+	m_Placements[resource.Get()] = placement;
+	m_FrameStats.Allocations++;
+	m_FrameStats.Bytes += placement.Size;
+	return resource;
 }
 
 ComPtr<ID3D12Resource2> HeapManager::CreateBufferResource(ID3D12Device11* device, HeapType type, D3D12_RESOURCE_STATES state, UINT64 size, D3D12_RESOURCE_FLAGS flags)
@@ -73,7 +132,50 @@ ComPtr<ID3D12Resource2> HeapManager::CreateBufferResource(ID3D12Device11* device
 	return CreateResource(device, type, &ResourceDesc, state);
 }
 
-void HeapManager::ResetHeapOffset(HeapType type)
+// Returns the placement of a resource to its heap. The caller must make sure the GPU is done with it.
+void HeapManager::Free(ID3D12Resource2* resource)
 {
-	m_Heaps[type].ResetOffset();
-}
\ No newline at end of file
+	auto it = m_Placements.find(resource);
+	assert(it != m_Placements.end());
+	m_Heaps[it->second.Type].Free(it->second);
+	m_Placements.erase(it);
+}
+
+// Keeps the resource alive and its placement reserved until the current frame has completed on the GPU
+void HeapManager::FreeDeferred(ComPtr<ID3D12Resource2> resource)
+{
+	m_PendingFrees.push_back(resource);
+}
+
+void HeapManager::EndFrame(UINT64 fenceValue)
+{
+	m_InFlightFrees.emplace_back(fenceValue, std::move(m_PendingFrees));
+	m_PendingFrees.clear();
+}
+
+void HeapManager::Retire(UINT64 completedFenceValue)
+{
+	while (!m_InFlightFrees.empty() && m_InFlightFrees.front().first <= completedFenceValue)
+	{
+		for (ComPtr<ID3D12Resource2>& resource : m_InFlightFrees.front().second)
+		{
+			Free(resource.Get());
+		}
+		m_InFlightFrees.pop_front();
+	}
+}
+
+// Forgets every placement in the heap at once, like the old bump allocator reset
+void HeapManager::ResetHeap(HeapType type)
+{
+	m_Heaps[type].Reset();
+	std::erase_if(m_Placements, [type](const auto& entry) { return entry.second.Type == type; });
+}
+
+void HeapManager::Trim()
+{
+	for (HeapChain& heap : m_Heaps)
+	{
+		heap.Trim();
+	}
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "PCH.h"
+#include "OffsetAllocator.h"
 
 enum HeapType
 {
@@ -8,27 +9,63 @@ enum HeapType
 	DefaultHeap = 2,
 	ScratchDefaultHeap = 3,
 	BLASHeap = 4,
-	TLASHeap = 5
+	TLASHeap = 5,
+	ReadbackHeap = 6
 };
 
+struct HeapAllocationStats
+{
+	UINT Allocations = 0;
+	UINT64 Bytes = 0;
+};
+
+// Not thread safe: allocate and free on the render thread, before CommandScheduler::Record hands passes to workers
 class HeapManager
 {
-	class SingleHeap
+	struct Placement
+	{
+		HeapType Type;
+		UINT Page;
+		UINT64 Size;
+		OffsetAllocator::Allocation Allocation;
+	};
+	// Chain of ID3D12Heaps of a single type, each one sub-allocated by an OffsetAllocator.
+	// A new page is added whenever a placement does not fit in any existing one.
+	class HeapChain
 	{
 	public:
-		SingleHeap();
-		void Create(ID3D12Device11* device, D3D12_HEAP_TYPE type, UINT64 heapsize);
-		Microsoft::WRL::ComPtr<ID3D12Resource2> CreateResource(ID3D12Device11* device, D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES state, D3D12_CLEAR_VALUE* clearvalue);
-		void ResetOffset();
+		void Create(ID3D12Device11* device, D3D12_HEAP_TYPE type, UINT64 pageSize);
+		Microsoft::WRL::ComPtr<ID3D12Resource2> CreateResource(ID3D12Device11* device, D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES state, D3D12_CLEAR_VALUE* clearvalue, Placement* placement);
+		void Free(const Placement& placement);
+		void Reset();
+		void Trim();
 	private:
-		UINT64 m_CurrentOffset;
-		Microsoft::WRL::ComPtr<ID3D12Heap> m_Heap;
+		struct Page
+		{
+			Microsoft::WRL::ComPtr<ID3D12Heap> Heap;
+			OffsetAllocator Allocator;
+		};
+		UINT AddPage(ID3D12Device11* device, UINT64 size, UINT64 alignment);
+		D3D12_HEAP_TYPE m_Type = D3D12_HEAP_TYPE_DEFAULT;
+		UINT64 m_PageSize = 0;
+		std::vector<Page> m_Pages;
 	};
 public:
 	void Create(ID3D12Device11* device);
 	Microsoft::WRL::ComPtr<ID3D12Resource2> CreateResource(ID3D12Device11* device, HeapType type, D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES state, D3D12_CLEAR_VALUE* clearvalue = nullptr);
 	Microsoft::WRL::ComPtr<ID3D12Resource2> CreateBufferResource(ID3D12Device11* device, HeapType type, D3D12_RESOURCE_STATES state, UINT64 size, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
-	void ResetHeapOffset(HeapType type);
+	void Free(ID3D12Resource2* resource);
+	void FreeDeferred(Microsoft::WRL::ComPtr<ID3D12Resource2> resource);
+	void EndFrame(UINT64 fenceValue);
+	void Retire(UINT64 completedFenceValue);
+	void ResetHeap(HeapType type);
+	void Trim();
+	inline const HeapAllocationStats& GetFrameStats() const { return m_FrameStats; }
+	inline void ResetFrameStats() { m_FrameStats = {}; }
 private:
-	SingleHeap m_Heaps[6];
-};
\ No newline at end of file
+	HeapChain m_Heaps[7];
+	std::unordered_map<ID3D12Resource2*, Placement> m_Placements;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource2>> m_PendingFrees;
+	std::deque<std::pair<UINT64, std::vector<Microsoft::WRL::ComPtr<ID3D12Resource2>>>> m_InFlightFrees;
+	HeapAllocationStats m_FrameStats;
+};
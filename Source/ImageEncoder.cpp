@@ -0,0 +1,506 @@
+#include "ImageEncoder.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+// Deflate's LZ77 window, and how many earlier positions with the same 3-byte hash are tried per match
+static constexpr uint32_t WindowSize = 32768;
+static constexpr uint32_t HashBits = 15;
+static constexpr uint32_t MaxChain = 16;
+static constexpr uint32_t MinMatch = 3;
+static constexpr uint32_t MaxMatch = 258;
+
+static const uint16_t LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static uint8_t ToUnorm(float value)
+{
+	return (uint8_t)(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static void GetRGB8(const ImageBuffer& image, size_t pixel, uint8_t rgb[3])
+{
+	if (image.Format == ImagePixelRGBA8)
+	{
+		const uint32_t value = image.RGBA8[pixel];
+		rgb[0] = (uint8_t)value;
+		rgb[1] = (uint8_t)(value >> 8);
+		rgb[2] = (uint8_t)(value >> 16);
+		return;
+	}
+	const Float4& value = image.RGBA32F[pixel];
+	rgb[0] = ToUnorm(value.x);
+	rgb[1] = ToUnorm(value.y);
+	rgb[2] = ToUnorm(value.z);
+}
+
+static void GetRGB32F(const ImageBuffer& image, size_t pixel, float rgb[3])
+{
+	if (image.Format == ImagePixelRGBA32F)
+	{
+		const Float4& value = image.RGBA32F[pixel];
+		rgb[0] = value.x;
+		rgb[1] = value.y;
+		rgb[2] = value.z;
+		return;
+	}
+	const uint32_t value = image.RGBA8[pixel];
+	rgb[0] = (float)(value & 0xFF) / 255.0f;
+	rgb[1] = (float)((value >> 8) & 0xFF) / 255.0f;
+	rgb[2] = (float)((value >> 16) & 0xFF) / 255.0f;
+}
+
+static void PutBigEndian32(std::vector<uint8_t>* out, uint32_t value)
+{
+	out->push_back((uint8_t)(value >> 24));
+	out->push_back((uint8_t)(value >> 16));
+	out->push_back((uint8_t)(value >> 8));
+	out->push_back((uint8_t)value);
+}
+
+static void PutLittleEndian(std::vector<uint8_t>* out, const void* value, size_t size)
+{
+	// Every platform the renderer targets is little endian
+	const uint8_t* bytes = (const uint8_t*)value;
+	out->insert(out->end(), bytes, bytes + size);
+}
+
+static uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+	static const struct Table
+	{
+		uint32_t Entries[256];
+		Table()
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++)
+				{
+					c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				}
+				Entries[i] = c;
+			}
+		}
+	} table;
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+	{
+		crc = table.Entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static uint32_t Adler32(const uint8_t* data, size_t size)
+{
+	uint32_t a = 1, b = 0;
+	while (size > 0)
+	{
+		// 5552 bytes is the most that can be summed before b has to be reduced
+		const size_t block = std::min<size_t>(size, 5552);
+		for (size_t i = 0; i < block; i++)
+		{
+			a += data[i];
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+		data += block;
+		size -= block;
+	}
+	return (b << 16) | a;
+}
+
+// Deflate's bit order: values least significant bit first, Huffman codes most significant bit first
+class BitWriter
+{
+public:
+	explicit BitWriter(std::vector<uint8_t>* out) : m_Out(out) {}
+	void Write(uint32_t bits, uint32_t count)
+	{
+		m_Buffer |= bits << m_Count;
+		m_Count += count;
+		while (m_Count >= 8)
+		{
+			m_Out->push_back((uint8_t)m_Buffer);
+			m_Buffer >>= 8;
+			m_Count -= 8;
+		}
+	}
+	void WriteCode(uint32_t code, uint32_t length)
+	{
+		uint32_t reversed = 0;
+		for (uint32_t i = 0; i < length; i++)
+		{
+			reversed |= ((code >> i) & 1) << (length - 1 - i);
+		}
+		Write(reversed, length);
+	}
+	void Flush()
+	{
+		if (m_Count > 0)
+			m_Out->push_back((uint8_t)m_Buffer);
+		m_Buffer = 0;
+		m_Count = 0;
+	}
+private:
+	std::vector<uint8_t>* m_Out;
+	uint32_t m_Buffer = 0;
+	uint32_t m_Count = 0;
+};
+
+// Literal and length symbols with the fixed Huffman code of RFC 1951 3.2.6
+static void WriteSymbol(BitWriter* bits, uint32_t symbol)
+{
+	if (symbol < 144)
+		bits->WriteCode(0x30 + symbol, 8);
+	else if (symbol < 256)
+		bits->WriteCode(0x190 + symbol - 144, 9);
+	else if (symbol < 280)
+		bits->WriteCode(symbol - 256, 7);
+	else
+		bits->WriteCode(0xC0 + symbol - 280, 8);
+}
+
+static void WriteMatch(BitWriter* bits, uint32_t length, uint32_t distance)
+{
+	uint32_t lengthCode = 28;
+	while (LengthBase[lengthCode] > length)
+	{
+		lengthCode--;
+	}
+	WriteSymbol(bits, 257 + lengthCode);
+	bits->Write(length - LengthBase[lengthCode], LengthExtra[lengthCode]);
+	uint32_t distanceCode = 29;
+	while (DistanceBase[distanceCode] > distance)
+	{
+		distanceCode--;
+	}
+	bits->WriteCode(distanceCode, 5);
+	bits->Write(distance - DistanceBase[distanceCode], DistanceExtra[distanceCode]);
+}
+
+// zlib stream of one fixed Huffman block, greedy LZ77 over hash chains
+static void Deflate(const std::vector<uint8_t>& data, std::vector<uint8_t>* out)
+{
+	out->push_back(0x78);
+	out->push_back(0x01);
+	BitWriter bits(out);
+	bits.Write(1, 1); // final block
+	bits.Write(1, 2); // fixed Huffman codes
+	std::vector<int32_t> head((size_t)1 << HashBits, -1);
+	std::vector<int32_t> previous(WindowSize, -1);
+	const size_t size = data.size();
+	auto Hash = [&](size_t position)
+	{
+		const uint32_t value = data[position] | (data[position + 1] << 8) | (data[position + 2] << 16);
+		return (value * 2654435761u) >> (32 - HashBits);
+	};
+	auto Insert = [&](size_t position)
+	{
+		if (position + MinMatch > size)
+			return;
+		const uint32_t hash = Hash(position);
+		previous[position % WindowSize] = head[hash];
+		head[hash] = (int32_t)position;
+	};
+	size_t position = 0;
+	while (position < size)
+	{
+		uint32_t bestLength = 0;
+		uint32_t bestDistance = 0;
+		if (position + MinMatch <= size)
+		{
+			const uint32_t maxLength = (uint32_t)std::min<size_t>(MaxMatch, size - position);
+			int32_t candidate = head[Hash(position)];
+			for (uint32_t chain = 0; chain < MaxChain && candidate >= 0 && position - candidate <= WindowSize; chain++)
+			{
+				uint32_t length = 0;
+				while (length < maxLength && data[candidate + length] == data[position + length])
+				{
+					length++;
+				}
+				if (length > bestLength)
+				{
+					bestLength = length;
+					bestDistance = (uint32_t)(position - candidate);
+					if (length == maxLength)
+						break;
+				}
+				const int32_t next = previous[candidate % WindowSize];
+				// The slot may already hold a newer position once the chain is older than the window
+				if (next >= candidate)
+					break;
+				candidate = next;
+			}
+		}
+		if (bestLength >= MinMatch)
+		{
+			WriteMatch(&bits, bestLength, bestDistance);
+			for (uint32_t i = 0; i < bestLength; i++)
+			{
+				Insert(position + i);
+			}
+			position += bestLength;
+		}
+		else
+		{
+			WriteSymbol(&bits, data[position]);
+			Insert(position);
+			position++;
+		}
+	}
+	WriteSymbol(&bits, 256);
+	bits.Flush();
+	PutBigEndian32(out, Adler32(data.data(), data.size()));
+}
+
+static uint8_t Paeth(int a, int b, int c)
+{
+	const int p = a + b - c;
+	const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+	return (uint8_t)(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+static void WriteChunk(std::vector<uint8_t>* file, const char type[4], const std::vector<uint8_t>& data)
+{
+	PutBigEndian32(file, (uint32_t)data.size());
+	const size_t start = file->size();
+	file->insert(file->end(), type, type + 4);
+	file->insert(file->end(), data.begin(), data.end());
+	PutBigEndian32(file, Crc32(file->data() + start, file->size() - start));
+}
+
+namespace ImageEncoder
+{
+	bool GetFileFormat(const std::string& path, ImageFileFormat* format)
+	{
+		const size_t dot = path.rfind('.');
+		if (dot == std::string::npos)
+			return false;
+		std::string extension = path.substr(dot + 1);
+		for (char& c : extension)
+		{
+			c = (char)std::tolower((unsigned char)c);
+		}
+		if (extension == "ppm")
+			*format = ImageFilePPM;
+		else if (extension == "png")
+			*format = ImageFilePNG;
+		else if (extension == "exr")
+			*format = ImageFileEXR;
+		else
+			return false;
+		return true;
+	}
+
+	void Encode(const ImageBuffer& image, ImageFileFormat format, std::vector<uint8_t>* file)
+	{
+		file->clear();
+		if (format == ImageFilePNG)
+			EncodePNG(image, file);
+		else if (format == ImageFileEXR)
+			EncodeEXR(image, file);
+		else
+			EncodePPM(image, file);
+	}
+
+	void EncodePPM(const ImageBuffer& image, std::vector<uint8_t>* file)
+	{
+		const std::string header = "P6\n" + std::to_string(image.Width) + " " + std::to_string(image.Height) + "\n255\n";
+		file->assign(header.begin(), header.end());
+		file->resize(header.size() + (size_t)image.Width * image.Height * 3);
+		uint8_t* rgb = file->data() + header.size();
+		for (size_t pixel = 0; pixel < (size_t)image.Width * image.Height; pixel++)
+		{
+			GetRGB8(image, pixel, rgb + pixel * 3);
+		}
+	}
+
+	// Header fields are separated by whitespace, # starts a comment up to the end of the line
+	bool DecodePPM(const std::vector<uint8_t>& file, ImageBuffer* image)
+	{
+		size_t position = 2;
+		auto ReadNumber = [&](uint32_t* value)
+		{
+			while (position < file.size() && (std::isspace(file[position]) || file[position] == '#'))
+			{
+				if (file[position] == '#')
+					while (position < file.size() && file[position] != '\n')
+						position++;
+				else
+					position++;
+			}
+			if (position >= file.size() || !std::isdigit(file[position]))
+				return false;
+			uint64_t number = 0;
+			while (position < file.size() && std::isdigit(file[position]) && number <= 0xFFFFFFFF)
+				number = number * 10 + (file[position++] - '0');
+			*value = (uint32_t)number;
+			return number <= 0xFFFFFFFF;
+		};
+		uint32_t width = 0, height = 0, maxValue = 0;
+		if (file.size() < 2 || file[0] != 'P' || file[1] != '6' || !ReadNumber(&width) || !ReadNumber(&height) || !ReadNumber(&maxValue))
+			return false;
+		// A single whitespace character ends the header
+		position++;
+		if (maxValue != 255 || width == 0 || height == 0 || (file.size() - std::min(position, file.size())) / 3 / width < height)
+			return false;
+		image->Resize(width, height, ImagePixelRGBA8);
+		const uint8_t* rgb = file.data() + position;
+		for (size_t pixel = 0; pixel < (size_t)width * height; pixel++)
+		{
+			image->RGBA8[pixel] = rgb[pixel * 3] | rgb[pixel * 3 + 1] << 8 | rgb[pixel * 3 + 2] << 16 | 0xFF000000u;
+		}
+		return true;
+	}
+
+	// 8-bit RGB. Every row gets the filter with the smallest sum of absolute differences, the usual heuristic.
+	void EncodePNG(const ImageBuffer& image, std::vector<uint8_t>* file)
+	{
+		const size_t rowSize = (size_t)image.Width * 3;
+		std::vector<uint8_t> previousRow(rowSize, 0);
+		std::vector<uint8_t> row(rowSize);
+		std::vector<uint8_t> candidates[5];
+		for (std::vector<uint8_t>& candidate : candidates)
+		{
+			candidate.resize(rowSize);
+		}
+		std::vector<uint8_t> filtered;
+		filtered.reserve((rowSize + 1) * image.Height);
+		for (uint32_t y = 0; y < image.Height; y++)
+		{
+			for (uint32_t x = 0; x < image.Width; x++)
+			{
+				GetRGB8(image, (size_t)y * image.Width + x, &row[(size_t)x * 3]);
+			}
+			uint32_t bestFilter = 0;
+			uint64_t bestCost = UINT64_MAX;
+			for (uint32_t filter = 0; filter < 5; filter++)
+			{
+				uint64_t cost = 0;
+				for (size_t i = 0; i < rowSize; i++)
+				{
+					const int a = i >= 3 ? row[i - 3] : 0;
+					const int b = previousRow[i];
+					const int c = i >= 3 ? previousRow[i - 3] : 0;
+					const int predictor = filter == 1 ? a : filter == 2 ? b : filter == 3 ? (a + b) / 2 : filter == 4 ? Paeth(a, b, c) : 0;
+					const uint8_t value = (uint8_t)(row[i] - predictor);
+					candidates[filter][i] = value;
+					cost += (uint64_t)std::abs((int8_t)value);
+				}
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestFilter = filter;
+				}
+			}
+			filtered.push_back((uint8_t)bestFilter);
+			filtered.insert(filtered.end(), candidates[bestFilter].begin(), candidates[bestFilter].end());
+			std::swap(previousRow, row);
+		}
+
+		static const uint8_t Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		file->assign(Signature, Signature + 8);
+		std::vector<uint8_t> header;
+		PutBigEndian32(&header, image.Width);
+		PutBigEndian32(&header, image.Height);
+		header.insert(header.end(), { 8, 2, 0, 0, 0 }); // 8 bits per channel, RGB, deflate, adaptive filters, no interlace
+		WriteChunk(file, "IHDR", header);
+		std::vector<uint8_t> compressed;
+		Deflate(filtered, &compressed);
+		WriteChunk(file, "IDAT", compressed);
+		WriteChunk(file, "IEND", {});
+	}
+
+	// Scanline file with one line per block, no compression and FLOAT B, G and R channels, stored in name order
+	void EncodeEXR(const ImageBuffer& image, std::vector<uint8_t>* file)
+	{
+		auto PutInt = [&](int32_t value) { PutLittleEndian(file, &value, sizeof(value)); };
+		auto PutFloat = [&](float value) { PutLittleEndian(file, &value, sizeof(value)); };
+		auto PutString = [&](const char* text) { file->insert(file->end(), text, text + strlen(text) + 1); };
+		auto PutAttribute = [&](const char* name, const char* type, int32_t size)
+		{
+			PutString(name);
+			PutString(type);
+			PutInt(size);
+		};
+		file->clear();
+		PutInt(20000630); // magic number
+		PutInt(2); // version 2, single part scanline
+		PutAttribute("channels", "chlist", 3 * 18 + 1);
+		for (const char* channel : { "B", "G", "R" })
+		{
+			PutString(channel);
+			PutInt(2); // FLOAT
+			file->insert(file->end(), { 0, 0, 0, 0 }); // pLinear and reserved
+			PutInt(1); // x and y sampling
+			PutInt(1);
+		}
+		file->push_back(0);
+		PutAttribute("compression", "compression", 1);
+		file->push_back(0); // NO_COMPRESSION
+		for (const char* window : { "dataWindow", "displayWindow" })
+		{
+			PutAttribute(window, "box2i", 16);
+			PutInt(0);
+			PutInt(0);
+			PutInt((int32_t)image.Width - 1);
+			PutInt((int32_t)image.Height - 1);
+		}
+		PutAttribute("lineOrder", "lineOrder", 1);
+		file->push_back(0); // INCREASING_Y
+		PutAttribute("pixelAspectRatio", "float", 4);
+		PutFloat(1.0f);
+		PutAttribute("screenWindowCenter", "v2f", 8);
+		PutFloat(0.0f);
+		PutFloat(0.0f);
+		PutAttribute("screenWindowWidth", "float", 4);
+		PutFloat(1.0f);
+		file->push_back(0); // end of header
+
+		const uint64_t lineSize = 8 + (uint64_t)image.Width * 3 * sizeof(float);
+		const uint64_t firstLine = file->size() + (uint64_t)image.Height * sizeof(uint64_t);
+		for (uint32_t y = 0; y < image.Height; y++)
+		{
+			const uint64_t offset = firstLine + y * lineSize;
+			PutLittleEndian(file, &offset, sizeof(offset));
+		}
+		file->reserve(firstLine + image.Height * lineSize);
+		std::vector<float> channels[3];
+		for (std::vector<float>& channel : channels)
+		{
+			channel.resize(image.Width);
+		}
+		for (uint32_t y = 0; y < image.Height; y++)
+		{
+			for (uint32_t x = 0; x < image.Width; x++)
+			{
+				float rgb[3];
+				GetRGB32F(image, (size_t)y * image.Width + x, rgb);
+				channels[0][x] = rgb[2];
+				channels[1][x] = rgb[1];
+				channels[2][x] = rgb[0];
+			}
+			PutInt((int32_t)y);
+			PutInt((int32_t)(image.Width * 3 * sizeof(float)));
+			for (const std::vector<float>& channel : channels)
+			{
+				PutLittleEndian(file, channel.data(), channel.size() * sizeof(float));
+			}
+		}
+	}
+}
+
+void ImageBuffer::Resize(uint32_t width, uint32_t height, ImagePixelFormat format)
+{
+	Width = width;
+	Height = height;
+	Format = format;
+	if (format == ImagePixelRGBA8)
+		RGBA8.resize((size_t)width * height);
+	else
+		RGBA32F.resize((size_t)width * height);
+}
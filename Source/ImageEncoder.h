@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "CpuMath.h"
+
+enum ImageFileFormat
+{
+	ImageFilePPM,
+	ImageFilePNG,
+	ImageFileEXR
+};
+
+enum ImagePixelFormat
+{
+	ImagePixelRGBA8, // red in the lowest byte, like R8G8B8A8_UNORM and CpuRenderer::Resolve
+	ImagePixelRGBA32F // linear radiance, kept unclamped for EXR
+};
+
+// One frame in memory, rows top to bottom. Only the vector matching Format holds the pixels.
+struct ImageBuffer
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	ImagePixelFormat Format = ImagePixelRGBA8;
+	std::vector<uint32_t> RGBA8;
+	std::vector<Float4> RGBA32F;
+	void Resize(uint32_t width, uint32_t height, ImagePixelFormat format);
+};
+
+// File encoders without external libraries. 8-bit formats clamp float pixels the way a UNORM store would,
+// EXR widens 8-bit pixels to float. PNG is deflated with fixed Huffman codes, EXR is uncompressed 32-bit float.
+namespace ImageEncoder
+{
+	// From the extension: .ppm, .png or .exr, case insensitive
+	bool GetFileFormat(const std::string& path, ImageFileFormat* format);
+	void Encode(const ImageBuffer& image, ImageFileFormat format, std::vector<uint8_t>* file);
+	void EncodePPM(const ImageBuffer& image, std::vector<uint8_t>* file);
+	// Binary PPM with 8-bit channels into RGBA8, enough to read back what EncodePPM writes
+	bool DecodePPM(const std::vector<uint8_t>& file, ImageBuffer* image);
+	void EncodePNG(const ImageBuffer& image, std::vector<uint8_t>* file);
+	void EncodeEXR(const ImageBuffer& image, std::vector<uint8_t>* file);
+}
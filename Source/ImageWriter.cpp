@@ -0,0 +1,103 @@
+#include "ImageWriter.h"
+#include "Profiler.h"
+#include <fstream>
+
+ImageWriter::ImageWriter(uint32_t bufferCount, uint32_t threadCount)
+{
+	for (uint32_t i = 0; i < bufferCount; i++)
+	{
+		m_Buffers.push_back(std::make_unique<ImageBuffer>());
+		m_FreeBuffers.push_back(m_Buffers.back().get());
+	}
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		m_Workers.emplace_back(&ImageWriter::WorkerLoop, this);
+	}
+}
+
+ImageWriter::~ImageWriter()
+{
+	Flush();
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_WorkAvailable.notify_all();
+	for (std::thread& worker : m_Workers)
+	{
+		worker.join();
+	}
+}
+
+// The buffer keeps the size and contents of its previous image, so filling one of the same size does not allocate
+ImageBuffer* ImageWriter::Acquire()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_BufferReturned.wait(lock, [this] { return !m_FreeBuffers.empty(); });
+	ImageBuffer* buffer = m_FreeBuffers.back();
+	m_FreeBuffers.pop_back();
+	return buffer;
+}
+
+void ImageWriter::Submit(ImageBuffer* buffer, const std::string& path)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Queue.push_back({ buffer, path });
+	}
+	m_WorkAvailable.notify_one();
+}
+
+void ImageWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_BufferReturned.wait(lock, [this] { return m_Queue.empty() && m_Busy == 0; });
+}
+
+std::vector<std::string> ImageWriter::TakeFailures()
+{
+	std::vector<std::string> failures;
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	failures.swap(m_Failures);
+	return failures;
+}
+
+// Each thread reuses its file buffer from one image to the next
+void ImageWriter::WorkerLoop()
+{
+	Profiler::SetThreadName("Image writer");
+	std::vector<uint8_t> file;
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkAvailable.wait(lock, [this] { return m_Stopping || !m_Queue.empty(); });
+			if (m_Queue.empty())
+				return;
+			job = std::move(m_Queue.front());
+			m_Queue.pop_front();
+			m_Busy++;
+		}
+		bool written = false;
+		ImageFileFormat format;
+		if (ImageEncoder::GetFileFormat(job.Path, &format))
+		{
+			PROFILE_SCOPE("Encode image");
+			ImageEncoder::Encode(*job.Buffer, format, &file);
+			std::ofstream stream(job.Path, std::ios::binary | std::ios::trunc);
+			stream.write((const char*)file.data(), file.size());
+			stream.close();
+			written = !stream.fail();
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (!written)
+				m_Failures.push_back(job.Path);
+			m_FreeBuffers.push_back(job.Buffer);
+			m_Busy--;
+		}
+		// Both Acquire and Flush wait on it
+		m_BufferReturned.notify_all();
+	}
+}
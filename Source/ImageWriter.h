@@ -0,0 +1,47 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ImageEncoder.h"
+
+// Encodes and writes images on background threads. It owns a fixed set of frame buffers: the producer acquires a
+// free one, fills it and submits it with a path, and a writer thread returns it to the free set once the file is
+// written. With two buffers one frame is filled while the previous one is encoded; Acquire blocks only when every
+// buffer is still queued, which caps the memory at BufferCount images however far rendering gets ahead.
+class ImageWriter
+{
+public:
+	explicit ImageWriter(uint32_t bufferCount = 2, uint32_t threadCount = 1);
+	~ImageWriter(); // writes everything submitted before returning
+	ImageWriter(const ImageWriter&) = delete;
+	ImageWriter& operator=(const ImageWriter&) = delete;
+	ImageBuffer* Acquire();
+	// The format follows the extension of path, see ImageEncoder::GetFileFormat; unknown ones fail
+	void Submit(ImageBuffer* buffer, const std::string& path);
+	// Blocks until every submitted image is written
+	void Flush();
+	// Paths that could not be encoded or written since the last call, does not wait
+	std::vector<std::string> TakeFailures();
+private:
+	struct Job
+	{
+		ImageBuffer* Buffer;
+		std::string Path;
+	};
+	void WorkerLoop();
+	std::vector<std::unique_ptr<ImageBuffer>> m_Buffers;
+	std::vector<ImageBuffer*> m_FreeBuffers;
+	std::deque<Job> m_Queue;
+	std::vector<std::string> m_Failures;
+	std::vector<std::thread> m_Workers;
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+	std::condition_variable m_BufferReturned;
+	uint32_t m_Busy = 0; // jobs taken off the queue but not finished
+	bool m_Stopping = false;
+};
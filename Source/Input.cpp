@@ -1,7 +1,65 @@
 #include "PCH.h"
 #include "Input.h"
+#include "SPSCQueue.h"
 
 namespace Input
 {
-	InputState state;
+	static SPSCQueue<InputEvent, 4096> events;
+	static std::atomic<UINT> droppedEvents = 0;
+	static InputState state; // owned by the consumer
+
+	void PostEvent(EventType type, UINT code, bool down, int x, int y)
+	{
+		LARGE_INTEGER time;
+		QueryPerformanceCounter(&time);
+		InputEvent event = { time.QuadPart, type, (BYTE)code, down, x, y };
+		if (!events.Push(event))
+			droppedEvents.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	InputState TakeSnapshot()
+	{
+		int rawX = 0;
+		int rawY = 0;
+		state.LatestEventTime = 0;
+		state.EventCount = 0;
+		InputEvent event;
+		while (events.Pop(&event))
+		{
+			switch (event.Type)
+			{
+			case EventType::Key:
+				state.key[event.Code] = event.Down;
+				break;
+			case EventType::Button:
+				state.button[event.Code] = event.Down;
+				break;
+			case EventType::MouseMove:
+				state.mouseX_Screen = event.X;
+				state.mouseY_Screen = event.Y;
+				break;
+			case EventType::RawMouse:
+				rawX += event.X;
+				rawY += event.Y;
+				break;
+			case EventType::KillFocus:
+				// Releases keys and buttons only, the event bookkeeping of this drain carries on
+				memset(state.key, 0, sizeof(state.key));
+				memset(state.button, 0, sizeof(state.button));
+				rawX = 0;
+				rawY = 0;
+				break;
+			}
+			state.LatestEventTime = event.Time;
+			state.EventCount++;
+		}
+		state.mouseXDeltaf = rawX / RawMouseCountsPerUnit;
+		state.mouseYDeltaf = rawY / RawMouseCountsPerUnit;
+		return state;
+	}
+
+	UINT GetDroppedEventCount()
+	{
+		return droppedEvents.load(std::memory_order_relaxed);
+	}
 }
@@ -6,6 +6,9 @@ namespace Input
 {
 #define MAX_KEY_STATES 256
 #define MAX_BUTTON_STATES 5
+	// Raw mouse counts that make up one unit of look delta handed to the camera
+	constexpr float RawMouseCountsPerUnit = 1500.0f;
+
 	struct InputState
 	{
 		BYTE key[MAX_KEY_STATES];
@@ -16,29 +19,44 @@ namespace Input
 		float mouseYf;
 		float mouseXDeltaf;
 		float mouseYDeltaf;
-		int MouseDeltaAccumulatorX;
-		int MouseDeltaAccumulatorY;
+		INT64 LatestEventTime; // QueryPerformanceCounter ticks of the newest event folded into this snapshot, 0 if none
+		UINT EventCount;
 	};
-	extern InputState state;
 
-	inline void Update()
+	enum class EventType : BYTE
 	{
-		state.mouseXDeltaf = state.MouseDeltaAccumulatorX / 1500.0f;
-		state.mouseYDeltaf = state.MouseDeltaAccumulatorY / 1500.0f;
-		state.MouseDeltaAccumulatorX = 0;
-		state.MouseDeltaAccumulatorY = 0;
-	}
+		Key,
+		Button,
+		MouseMove,
+		RawMouse,
+		KillFocus
+	};
+
+	struct InputEvent
+	{
+		INT64 Time;
+		EventType Type;
+		BYTE Code;
+		bool Down;
+		int X;
+		int Y;
+	};
+
+	// Producer side, called from the window thread only
+	void PostEvent(EventType type, UINT code = 0, bool down = false, int x = 0, int y = 0);
+	// Consumer side, called from the render thread only. Folds every event posted since the previous call into the
+	// persistent state and returns it, with mouse deltas covering just that interval
+	InputState TakeSnapshot();
+	UINT GetDroppedEventCount();
 
-	inline void RawMouseAccumulator(int x, int y)
+	inline void RawMouseMove(int x, int y)
 	{
-		state.MouseDeltaAccumulatorX += x;
-		state.MouseDeltaAccumulatorY += y;
+		PostEvent(EventType::RawMouse, 0, false, x, y);
 	}
 
 	inline void UpdateMouse(LPARAM lParam, Window* win)
 	{
-		state.mouseX_Screen = GET_X_LPARAM(lParam);
-		state.mouseY_Screen = GET_Y_LPARAM(lParam);
+		PostEvent(EventType::MouseMove, 0, false, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
 	}
 
 	inline void HideMouseCursor(bool hidden)
@@ -59,39 +77,39 @@ namespace Input
 	inline void SetButtonPressedState(UINT button, bool isDown)
 	{
 		assert(button < MAX_BUTTON_STATES);
-		Input::state.button[button] = isDown;
+		PostEvent(EventType::Button, button, isDown);
 	}
 
-	inline bool GetButtonState(UINT button)
+	inline bool GetButtonState(const InputState& input, UINT button)
 	{
 		assert(button < MAX_BUTTON_STATES);
-		return Input::state.button[button];
+		return input.button[button];
 	}
 
 	inline void SetKeyPressedState(UINT VK_Key, bool isDown)
 	{
 		assert(VK_Key < MAX_KEY_STATES);
-		Input::state.key[VK_Key] = isDown;
+		PostEvent(EventType::Key, VK_Key, isDown);
 	}
 
-	inline bool GetKeyState(UINT VK_Key)
+	inline bool GetKeyState(const InputState& input, UINT VK_Key)
 	{
 		assert(VK_Key < MAX_KEY_STATES);
-		return Input::state.key[VK_Key];
+		return input.key[VK_Key];
 	}
 
-	inline float GetMouseXDelta()
+	inline float GetMouseXDelta(const InputState& input)
 	{
-		return state.mouseXDeltaf;
+		return input.mouseXDeltaf;
 	}
 
-	inline float GetMouseYDelta()
+	inline float GetMouseYDelta(const InputState& input)
 	{
-		return state.mouseYDeltaf;
+		return input.mouseYDeltaf;
 	}
 
 	inline void KillFocus()
 	{
-		state = {};
+		PostEvent(EventType::KillFocus);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include "CpuMath.h"
+
+// Interleaved ray dispatch, shared by CpuRenderer, RayGen.hlsl and Reconstruct.hlsl. In checkerboard mode a frame
+// traces every other pixel, in quarter mode one pixel of every 2x2 block; the pattern advances every frame and
+// every restart, so each pixel still gets a sample every PhaseCount frames, also while the view keeps moving.
+// Until a pixel has its first sample since the restart it is reconstructed from its traced neighbours.
+namespace InterleavedSampling
+{
+	// INTERLEAVE_* in Common.hlsl
+	enum Mode : uint32_t
+	{
+		InterleaveFull,
+		InterleaveCheckerboard,
+		InterleaveQuarter,
+		InterleaveModeCount
+	};
+
+	inline uint32_t GetPhaseCount(Mode mode)
+	{
+		return mode == InterleaveQuarter ? 4 : mode == InterleaveCheckerboard ? 2 : 1;
+	}
+
+	// Launch grid of one frame, columns are halved in both interleaved modes and rows in quarter mode
+	inline void GetDispatchSize(Mode mode, uint32_t width, uint32_t height, uint32_t* dispatchWidth, uint32_t* dispatchHeight)
+	{
+		*dispatchWidth = mode == InterleaveFull ? width : (width + 1) / 2;
+		*dispatchHeight = mode == InterleaveQuarter ? (height + 1) / 2 : height;
+	}
+
+	// The pattern traced in the frame, sequence is the restart count
+	inline uint32_t GetFramePattern(Mode mode, uint32_t sampleIndex, uint32_t sequence)
+	{
+		return (sampleIndex + sequence) % GetPhaseCount(mode);
+	}
+
+	// Quarter mode visits the 2x2 block diagonally first, so two frames already give a checkerboard
+	inline uint32_t GetPixelPattern(Mode mode, uint32_t x, uint32_t y)
+	{
+		if (mode == InterleaveCheckerboard)
+			return (x + y) & 1;
+		if (mode == InterleaveQuarter)
+			return (0x1320u >> ((((y & 1) << 1) | (x & 1)) * 4)) & 0xF;
+		return 0;
+	}
+
+	// Pixel traced by a launch index in a frame with the given pattern, may lie past the right or bottom edge
+	inline void GetPixel(Mode mode, uint32_t pattern, uint32_t launchX, uint32_t launchY, uint32_t* x, uint32_t* y)
+	{
+		if (mode == InterleaveCheckerboard)
+		{
+			*x = launchX * 2 + ((launchY + pattern) & 1);
+			*y = launchY;
+		}
+		else if (mode == InterleaveQuarter)
+		{
+			*x = launchX * 2 + ((0x6u >> pattern) & 1);
+			*y = launchY * 2 + ((0xAu >> pattern) & 1);
+		}
+		else
+		{
+			*x = launchX;
+			*y = launchY;
+		}
+	}
+
+	// Sample index of the accumulation at which the pixel is traced first after a restart
+	inline uint32_t GetFirstSample(Mode mode, uint32_t x, uint32_t y, uint32_t sequence)
+	{
+		const uint32_t phaseCount = GetPhaseCount(mode);
+		return (GetPixelPattern(mode, x, y) + phaseCount - sequence % phaseCount) % phaseCount;
+	}
+
+	// Reconstruction is only needed while some pixels have not been traced since the restart
+	inline bool NeedsReconstruction(Mode mode, uint32_t sampleIndex)
+	{
+		return sampleIndex + 1 < GetPhaseCount(mode);
+	}
+}
@@ -1,8 +1,54 @@
 #include "PCH.h"
 #include "Application.h"
+#include "OfflineRender.h"
+#include "RegressionTest.h"
+#include <shellapi.h>
+
+// Offline render on the CPU path instead of opening a window, printing to the console the program was started from
+static int RunHeadless(const std::vector<std::string>& arguments)
+{
+	if (AttachConsole(ATTACH_PARENT_PROCESS))
+	{
+		FILE* stream = nullptr;
+		freopen_s(&stream, "CONOUT$", "w", stdout);
+		freopen_s(&stream, "CONOUT$", "w", stderr);
+	}
+	OfflineRenderSettings settings;
+	std::string error;
+	if (!OfflineRender::ParseArguments(arguments, &settings, &error))
+	{
+		std::cerr << error << (error.empty() ? "" : "\n") << OfflineRender::GetUsage();
+		return error.empty() ? 0 : 1;
+	}
+	if (!settings.Regression.empty())
+		return RegressionTest::Run(settings, std::cout);
+	if (!settings.ConvertScene.empty())
+		return OfflineRender::ConvertScene(settings, std::cout);
+	return OfflineRender::Run(settings, std::cout);
+}
 
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPWSTR lpCmdLine, _In_ int nCmdShow)
 {
-	Application application(hInstance);
+	int argumentCount = 0;
+	LPWSTR* wideArguments = CommandLineToArgvW(GetCommandLineW(), &argumentCount);
+	std::vector<std::string> arguments;
+	for (int i = 1; wideArguments && i < argumentCount; i++)
+	{
+		arguments.push_back(std::string(CW2A(wideArguments[i], CP_UTF8)));
+	}
+	LocalFree(wideArguments);
+	if (std::find(arguments.begin(), arguments.end(), "--headless") != arguments.end())
+	{
+		return RunHeadless(arguments);
+	}
+
+	// The windowed application only takes --scene, the rotating cubes by default
+	std::string scenePath = "Scenes/Demo.scene";
+	const auto scene = std::find(arguments.begin(), arguments.end(), "--scene");
+	if (scene != arguments.end() && scene + 1 != arguments.end())
+	{
+		scenePath = *(scene + 1);
+	}
+	Application application(hInstance, scenePath);
 	return application.Run();
 }
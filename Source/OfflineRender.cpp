@@ -0,0 +1,347 @@
+#include "OfflineRender.h"
+#include "CpuRenderer.h"
+#include "CpuScene.h"
+#include "DemoScene.h"
+#include "ImageWriter.h"
+#include "Profiler.h"
+#include "SceneFile.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdlib>
+
+// Largest width or height, the D3D12 texture limit, so a frame rendered here also fits the GPU path
+static constexpr uint32_t MaxImageDimension = 16384;
+
+static bool ParseUnsigned(const std::string& text, uint32_t* value)
+{
+	char* end = nullptr;
+	const unsigned long parsed = std::strtoul(text.c_str(), &end, 10);
+	if (text.empty() || *end != '\0' || parsed > 0xFFFFFFFFul)
+		return false;
+	*value = (uint32_t)parsed;
+	return true;
+}
+
+static bool ParseFloat(const std::string& text, float* value)
+{
+	char* end = nullptr;
+	*value = std::strtof(text.c_str(), &end);
+	return !text.empty() && *end == '\0' && std::isfinite(*value);
+}
+
+// Three comma separated numbers
+static bool ParseFloat3(const std::string& text, Float3* value)
+{
+	const size_t first = text.find(',');
+	const size_t second = first == std::string::npos ? first : text.find(',', first + 1);
+	if (second == std::string::npos)
+		return false;
+	return ParseFloat(text.substr(0, first), &value->x) && ParseFloat(text.substr(first + 1, second - first - 1), &value->y) && ParseFloat(text.substr(second + 1), &value->z);
+}
+
+// A single frame or an inclusive range first-last
+static bool ParseFrameRange(const std::string& text, uint32_t* first, uint32_t* last)
+{
+	const size_t dash = text.find('-');
+	if (dash == std::string::npos)
+		return ParseUnsigned(text, first) && ParseUnsigned(text, last);
+	return ParseUnsigned(text.substr(0, dash), first) && ParseUnsigned(text.substr(dash + 1), last) && *first <= *last;
+}
+
+namespace OfflineRender
+{
+	bool ParseArguments(const std::vector<std::string>& arguments, OfflineRenderSettings* settings, std::string* error)
+	{
+		for (size_t i = 0; i < arguments.size(); i++)
+		{
+			const std::string& name = arguments[i];
+			if (name == "--help")
+			{
+				error->clear();
+				return false;
+			}
+			// Selects this mode in the windowed executable, nothing to do here
+			if (name == "--headless")
+				continue;
+			if (name == "--depth-first")
+			{
+				settings->Wavefront = false;
+				continue;
+			}
+			if (name == "--update-references")
+			{
+				settings->UpdateReferences = true;
+				continue;
+			}
+			if (i + 1 >= arguments.size())
+			{
+				*error = "Missing value for " + name;
+				return false;
+			}
+			const std::string& value = arguments[++i];
+			bool valid = true;
+			if (name == "--camera" || name == "--pitch" || name == "--heading" || name == "--fov")
+				settings->CameraFromArguments = true;
+			if (name == "--scene")
+				settings->Scene = value;
+			else if (name == "--camera")
+				valid = ParseFloat3(value, &settings->CameraPosition);
+			else if (name == "--pitch")
+				valid = ParseFloat(value, &settings->CameraPitch);
+			else if (name == "--heading")
+				valid = ParseFloat(value, &settings->CameraHeading);
+			else if (name == "--fov")
+				valid = ParseFloat(value, &settings->CameraFOV) && settings->CameraFOV > 0.0f;
+			else if (name == "--width")
+				valid = ParseUnsigned(value, &settings->Width) && settings->Width > 0 && settings->Width <= MaxImageDimension;
+			else if (name == "--height")
+				valid = ParseUnsigned(value, &settings->Height) && settings->Height > 0 && settings->Height <= MaxImageDimension;
+			else if (name == "--frames")
+				valid = ParseFrameRange(value, &settings->FirstFrame, &settings->LastFrame);
+			else if (name == "--samples")
+				valid = ParseUnsigned(value, &settings->Samples) && settings->Samples > 0;
+			else if (name == "--fps")
+			{
+				float frameRate = 0.0f;
+				valid = ParseFloat(value, &frameRate) && frameRate > 0.0f;
+				settings->FrameRate = frameRate;
+			}
+			else if (name == "--output")
+			{
+				ImageFileFormat format;
+				valid = ImageEncoder::GetFileFormat(value, &format);
+				settings->Output = value;
+			}
+			else if (name == "--image-buffers")
+				valid = ParseUnsigned(value, &settings->ImageBuffers) && settings->ImageBuffers > 0;
+			else if (name == "--writer-threads")
+				valid = ParseUnsigned(value, &settings->WriterThreads) && settings->WriterThreads > 0;
+			else if (name == "--trace")
+				settings->Trace = value;
+			else if (name == "--convert-scene")
+				settings->ConvertScene = value;
+			else if (name == "--regression")
+				settings->Regression = value;
+			else if (name == "--tolerance")
+				valid = ParseFloat(value, &settings->RegressionTolerance) && settings->RegressionTolerance >= 0.0f;
+			else if (name == "--max-slowdown")
+				valid = ParseFloat(value, &settings->RegressionMaxSlowdown) && settings->RegressionMaxSlowdown >= 0.0f;
+			else
+			{
+				*error = "Unknown option " + name;
+				return false;
+			}
+			if (!valid)
+			{
+				*error = "Invalid value '" + value + "' for " + name;
+				return false;
+			}
+		}
+		if (settings->UpdateReferences && settings->Regression.empty())
+		{
+			*error = "--update-references needs --regression";
+			return false;
+		}
+		if (!settings->ConvertScene.empty() && settings->Scene == "demo")
+		{
+			*error = "--convert-scene needs a scene file in --scene";
+			return false;
+		}
+		if (settings->FirstFrame != settings->LastFrame && settings->Output.find('#') == std::string::npos)
+		{
+			*error = "Rendering several frames needs a # in --output for the frame number";
+			return false;
+		}
+		return true;
+	}
+
+	const char* GetUsage()
+	{
+		return
+			"Options:\n"
+			"  --scene name         'demo' or a .scene or .sceneb file, see README.md, default demo\n"
+			"  --camera x,y,z       camera position, default -1,0,0.5 or the scene file's camera\n"
+			"  --pitch radians      default 0.5\n"
+			"  --heading radians    default 0\n"
+			"  --fov scale          length of the forward vector, default 1.25\n"
+			"  --width pixels       default 1280, at most 16384\n"
+			"  --height pixels      default 720, at most 16384\n"
+			"  --frames first-last  inclusive range or a single frame, default 0\n"
+			"  --samples count      samples per pixel and frame, default 64\n"
+			"  --fps rate           animation frames per second, default 60\n"
+			"  --output pattern     .png, .ppm or .exr path, a run of # becomes the frame number, default frame_####.png\n"
+			"  --image-buffers n    frames that may be queued for writing before rendering waits, default 2\n"
+			"  --writer-threads n   threads encoding and writing images, default 1\n"
+			"  --depth-first        trace paths one by one instead of in wavefronts\n"
+			"  --trace path         write a Chrome trace of the render to path, for chrome://tracing or Perfetto\n"
+			"  --convert-scene path write the --scene file in the binary format instead of rendering\n"
+			"Regression test, fixed scenes and sizes, the options above do not apply:\n"
+			"  --regression dir     compare against the reference images and timings in dir\n"
+			"  --update-references  record new references and timings in dir instead\n"
+			"  --tolerance rmse     largest RMSE against a reference in 0-1 units, default 0.01\n"
+			"  --max-slowdown x     fail cases x times slower than their baseline, default 0 only reports\n";
+	}
+
+	std::string GetFramePath(const std::string& pattern, uint32_t frame)
+	{
+		const size_t start = pattern.find('#');
+		if (start == std::string::npos)
+			return pattern;
+		const size_t end = pattern.find_first_not_of('#', start);
+		const size_t digits = (end == std::string::npos ? pattern.size() : end) - start;
+		std::string number = std::to_string(frame);
+		if (number.size() < digits)
+			number.insert(0, digits - number.size(), '0');
+		return pattern.substr(0, start) + number + (end == std::string::npos ? std::string() : pattern.substr(end));
+	}
+
+	int ConvertScene(const OfflineRenderSettings& settings, std::ostream& log)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		try
+		{
+			SceneFile::ConvertToBinary(settings.Scene, settings.ConvertScene);
+		}
+		catch (const std::exception& e)
+		{
+			log << e.what() << std::endl;
+			return 1;
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		log << "Wrote " << settings.ConvertScene << " in " << seconds << " s" << std::endl;
+		return 0;
+	}
+
+	static int RenderFrames(const OfflineRenderSettings& settings, std::ostream& log)
+	{
+		// The built-in demo, or a scene file with its own camera unless the options set one
+		const bool demo = settings.Scene == "demo";
+		SceneContent content;
+		SceneCamera view = { settings.CameraPosition, settings.CameraPitch, settings.CameraHeading, settings.CameraFOV };
+		if (!demo)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			try
+			{
+				SceneFile::Load(settings.Scene, &content);
+			}
+			catch (const std::exception& e)
+			{
+				log << e.what() << std::endl;
+				return 1;
+			}
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			log << "Loaded " << settings.Scene << ": " << content.Assets.Meshes.size() << " meshes, " << content.Instances.size() << " instances in " << seconds << " s" << std::endl;
+			if (!settings.CameraFromArguments)
+				view = content.Assets.Camera;
+		}
+		ThreadPool threadPool;
+		CpuScene scene;
+		if (demo)
+			DemoScene::AddMeshes(&scene);
+		else
+			content.AddMeshes(&scene);
+		CpuRenderer renderer;
+		renderer.Resize(settings.Width, settings.Height);
+		renderer.SetAdaptiveSampling(AdaptiveSampling::Disabled, 0.0f);
+		renderer.SetJitterFirstSample(true);
+		renderer.SetWavefront(settings.Wavefront);
+		const CameraState camera = CpuRenderer::GetCameraState(view.Position, view.Pitch, view.Heading, view.FOV, (float)settings.Width / settings.Height);
+		ImageFileFormat format = ImageFilePNG;
+		ImageEncoder::GetFileFormat(settings.Output, &format);
+		ImageWriter writer(settings.ImageBuffers, settings.WriterThreads);
+		if (!settings.Trace.empty())
+		{
+			Profiler::SetThreadName("Main");
+			Profiler::SetCapturing(true);
+		}
+		bool failed = false;
+		// 64 bits so a range ending at the largest frame number still terminates
+		for (uint64_t frame = settings.FirstFrame; frame <= settings.LastFrame; frame++)
+		{
+			PROFILE_SCOPE("Frame");
+			const auto start = std::chrono::steady_clock::now();
+			const double time = (double)frame / settings.FrameRate;
+			if (demo)
+			{
+				float angle1, angle2;
+				DemoScene::GetAnimationAngles(time, &angle1, &angle2);
+				DemoScene::AddInstances(&scene, angle1, angle2);
+			}
+			else
+			{
+				content.AddInstances(&scene, time);
+			}
+			// Every frame gets exactly Samples samples, also where the scene did not move since the previous one
+			renderer.ResetAccumulation();
+			uint64_t rays = 0;
+			for (uint32_t sample = 0; sample < settings.Samples; sample++)
+			{
+				renderer.Render(scene, camera, &threadPool);
+				rays += renderer.GetLastFrame().Rays;
+				// Every sample records a scope per tile, collected before the worker queues fill up
+				if (!settings.Trace.empty())
+					Profiler::Collect();
+			}
+			// Waits only while every buffer is still queued or being written
+			ImageBuffer* image = writer.Acquire();
+			if (format == ImageFileEXR)
+			{
+				image->Resize(settings.Width, settings.Height, ImagePixelRGBA32F);
+				renderer.ResolveRadiance(&image->RGBA32F);
+			}
+			else
+			{
+				image->Resize(settings.Width, settings.Height, ImagePixelRGBA8);
+				renderer.Resolve(&image->RGBA8);
+			}
+			const std::string path = GetFramePath(settings.Output, (uint32_t)frame);
+			writer.Submit(image, path);
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			log << "Frame " << frame << ": " << seconds << " s, " << rays / seconds * 1e-6 << " Mrays/s, " << path << std::endl;
+			for (const std::string& failure : writer.TakeFailures())
+			{
+				log << "Could not write " << failure << std::endl;
+				failed = true;
+			}
+			if (failed)
+				break;
+		}
+		writer.Flush();
+		for (const std::string& failure : writer.TakeFailures())
+		{
+			log << "Could not write " << failure << std::endl;
+			failed = true;
+		}
+		if (!settings.Trace.empty())
+		{
+			Profiler::SetCapturing(false);
+			if (Profiler::WriteChromeTrace(settings.Trace.c_str()))
+			{
+				log << "Wrote " << settings.Trace << std::endl;
+			}
+			else
+			{
+				log << "Could not write " << settings.Trace << std::endl;
+				failed = true;
+			}
+			if (Profiler::GetDroppedEventCount())
+				log << Profiler::GetDroppedEventCount() << " trace events were dropped" << std::endl;
+		}
+		return failed ? 1 : 0;
+	}
+
+	// Large frames can still exceed the memory of the machine, which is reported like any other failure
+	int Run(const OfflineRenderSettings& settings, std::ostream& log)
+	{
+		try
+		{
+			return RenderFrames(settings, log);
+		}
+		catch (const std::exception& e)
+		{
+			log << "Rendering failed: " << e.what() << std::endl;
+			return 1;
+		}
+	}
+}
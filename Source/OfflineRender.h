@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "CpuMath.h"
+
+// Settings of a batch render, the defaults match the application's start-up view
+struct OfflineRenderSettings
+{
+	std::string Scene = "demo"; // or a scene file, see SceneFile.h
+	Float3 CameraPosition = { -1.0f, 0.0f, 0.5f };
+	float CameraPitch = 0.5f;
+	float CameraHeading = 0.0f;
+	float CameraFOV = 1.25f;
+	bool CameraFromArguments = false; // a camera option was given, it then wins over the scene file's camera
+	uint32_t Width = 1280;
+	uint32_t Height = 720;
+	uint32_t FirstFrame = 0;
+	uint32_t LastFrame = 0; // inclusive
+	uint32_t Samples = 64; // per pixel and frame, adaptive sampling is off so every pixel gets exactly this many
+	double FrameRate = 60.0;
+	std::string Output = "frame_####.png"; // the run of # is replaced by the zero-padded frame number, see ImageEncoder for the formats
+	uint32_t ImageBuffers = 2; // frames that may wait for or be in encoding, see ImageWriter
+	uint32_t WriterThreads = 1;
+	bool Wavefront = true;
+	std::string Trace; // Chrome trace JSON of the whole run, see Profiler.h
+	std::string ConvertScene; // binary scene file to write from Scene, done instead of rendering
+	std::string Regression; // reference directory, runs RegressionTest instead of rendering frames
+	bool UpdateReferences = false;
+	float RegressionTolerance = 0.01f; // largest RMSE against a reference image, in 0-1 units
+	float RegressionMaxSlowdown = 0.0f; // fails cases this many times slower than their baseline, 0 only reports
+};
+
+// Renders frames of the demo animation with the CPU path tracer and writes them to disk, for render farms and
+// machines without DXR. Frame n shows the animation at n / FrameRate seconds, independent of how long rendering takes.
+// Files are encoded and written by an ImageWriter while the next frame is traced.
+namespace OfflineRender
+{
+	// Options of the form --name value, see GetUsage. Returns false with a message for unknown options or bad values.
+	bool ParseArguments(const std::vector<std::string>& arguments, OfflineRenderSettings* settings, std::string* error);
+	const char* GetUsage();
+	std::string GetFramePath(const std::string& pattern, uint32_t frame);
+	// Returns the process exit code, progress and errors go to the log
+	int ConvertScene(const OfflineRenderSettings& settings, std::ostream& log);
+	int Run(const OfflineRenderSettings& settings, std::ostream& log);
+}
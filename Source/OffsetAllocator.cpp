@@ -0,0 +1,316 @@
+#include "OffsetAllocator.h"
+#include <bit>
+#include <cassert>
+
+static inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+OffsetAllocator::OffsetAllocator(uint64_t size)
+{
+	Reset(size);
+}
+
+void OffsetAllocator::Reset(uint64_t size)
+{
+	m_Size = size;
+	m_UsedSize = 0;
+	m_AllocationCount = 0;
+	m_FirstLevelBitmap = 0;
+	for (uint32_t i = 0; i < FirstLevelCount; i++)
+	{
+		m_SecondLevelBitmap[i] = 0;
+		for (uint32_t j = 0; j < SecondLevelCount; j++)
+		{
+			m_FreeHeads[i][j] = InvalidNode;
+		}
+	}
+	m_Nodes.clear();
+	m_UnusedNodes.clear();
+	m_FirstNode = InvalidNode;
+	if (size > 0)
+	{
+		m_FirstNode = CreateNode();
+		m_Nodes[m_FirstNode].Offset = 0;
+		m_Nodes[m_FirstNode].Size = size;
+		InsertFree(m_FirstNode);
+	}
+}
+
+// Sizes below SecondLevelCount get an exact list each, larger sizes are split into
+// SecondLevelCount linear subdivisions of every power of two.
+void OffsetAllocator::MappingInsert(uint64_t size, uint32_t* firstLevel, uint32_t* secondLevel)
+{
+	if (size < SecondLevelCount)
+	{
+		*firstLevel = 0;
+		*secondLevel = (uint32_t)size;
+	}
+	else
+	{
+		const uint32_t msb = 63 - (uint32_t)std::countl_zero(size);
+		*secondLevel = (uint32_t)(size >> (msb - SecondLevelBits)) - SecondLevelCount;
+		*firstLevel = msb - SecondLevelBits + 1;
+	}
+}
+
+// Rounds the size up to the next list boundary so that any block in the resulting list fits
+void OffsetAllocator::MappingSearch(uint64_t size, uint32_t* firstLevel, uint32_t* secondLevel)
+{
+	if (size >= SecondLevelCount)
+	{
+		const uint32_t msb = 63 - (uint32_t)std::countl_zero(size);
+		size += (1ULL << (msb - SecondLevelBits)) - 1;
+	}
+	MappingInsert(size, firstLevel, secondLevel);
+}
+
+uint32_t OffsetAllocator::FindFreeBlock(uint64_t size) const
+{
+	uint32_t firstLevel = 0;
+	uint32_t secondLevel = 0;
+	MappingSearch(size, &firstLevel, &secondLevel);
+	if (firstLevel >= FirstLevelCount)
+		return InvalidNode;
+
+	uint32_t secondLevelMap = m_SecondLevelBitmap[firstLevel] & (~0u << secondLevel);
+	if (!secondLevelMap)
+	{
+		const uint64_t firstLevelMap = firstLevel + 1 < 64 ? m_FirstLevelBitmap & (~0ULL << (firstLevel + 1)) : 0;
+		if (!firstLevelMap)
+			return InvalidNode;
+		firstLevel = (uint32_t)std::countr_zero(firstLevelMap);
+		secondLevelMap = m_SecondLevelBitmap[firstLevel];
+	}
+	secondLevel = (uint32_t)std::countr_zero(secondLevelMap);
+	return m_FreeHeads[firstLevel][secondLevel];
+}
+
+bool OffsetAllocator::Allocate(uint64_t size, uint64_t alignment, Allocation* allocation)
+{
+	if (size == 0)
+		return false;
+	alignment = alignment ? alignment : 1;
+
+	// Most placements are already aligned, so try the exact size before paying for worst case padding
+	uint32_t node = FindFreeBlock(size);
+	if (node != InvalidNode)
+	{
+		const uint64_t padding = AlignUp(m_Nodes[node].Offset, alignment) - m_Nodes[node].Offset;
+		if (m_Nodes[node].Size < size + padding)
+			node = FindFreeBlock(size + alignment - 1);
+	}
+	if (node == InvalidNode)
+		return false;
+
+	RemoveFree(node);
+	const uint64_t padding = AlignUp(m_Nodes[node].Offset, alignment) - m_Nodes[node].Offset;
+	if (padding)
+	{
+		InsertFree(SplitFront(node, padding));
+	}
+	if (m_Nodes[node].Size > size)
+	{
+		const uint32_t used = SplitFront(node, size);
+		InsertFree(node);
+		node = used;
+	}
+	m_Nodes[node].Used = true;
+	m_Nodes[node].Alignment = alignment;
+	m_UsedSize += size;
+	m_AllocationCount++;
+
+	allocation->Offset = m_Nodes[node].Offset;
+	allocation->Node = node;
+	return true;
+}
+
+void OffsetAllocator::Free(const Allocation& allocation)
+{
+	uint32_t node = allocation.Node;
+	assert(node < m_Nodes.size() && m_Nodes[node].Used);
+	m_Nodes[node].Used = false;
+	m_UsedSize -= m_Nodes[node].Size;
+	m_AllocationCount--;
+
+	// Coalesce with free physical neighbours
+	const uint32_t prev = m_Nodes[node].PrevPhysical;
+	if (prev != InvalidNode && !m_Nodes[prev].Used)
+	{
+		RemoveFree(prev);
+		m_Nodes[prev].Size += m_Nodes[node].Size;
+		m_Nodes[prev].NextPhysical = m_Nodes[node].NextPhysical;
+		if (m_Nodes[node].NextPhysical != InvalidNode)
+			m_Nodes[m_Nodes[node].NextPhysical].PrevPhysical = prev;
+		ReleaseNode(node);
+		node = prev;
+	}
+	const uint32_t next = m_Nodes[node].NextPhysical;
+	if (next != InvalidNode && !m_Nodes[next].Used)
+	{
+		RemoveFree(next);
+		m_Nodes[node].Size += m_Nodes[next].Size;
+		m_Nodes[node].NextPhysical = m_Nodes[next].NextPhysical;
+		if (m_Nodes[next].NextPhysical != InvalidNode)
+			m_Nodes[m_Nodes[next].NextPhysical].PrevPhysical = node;
+		ReleaseNode(next);
+	}
+	InsertFree(node);
+}
+
+// Packs every allocation towards offset zero, keeping their order and alignment.
+// Nodes stay valid; the caller moves the data described by the returned relocations, in order.
+void OffsetAllocator::Compact(std::vector<Relocation>* relocations)
+{
+	std::vector<uint32_t> usedNodes;
+	usedNodes.reserve(m_AllocationCount);
+	for (uint32_t node = m_FirstNode; node != InvalidNode;)
+	{
+		const uint32_t next = m_Nodes[node].NextPhysical;
+		if (m_Nodes[node].Used)
+			usedNodes.push_back(node);
+		else
+			ReleaseNode(node);
+		node = next;
+	}
+	m_FirstLevelBitmap = 0;
+	for (uint32_t i = 0; i < FirstLevelCount; i++)
+	{
+		m_SecondLevelBitmap[i] = 0;
+		for (uint32_t j = 0; j < SecondLevelCount; j++)
+		{
+			m_FreeHeads[i][j] = InvalidNode;
+		}
+	}
+
+	uint64_t cursor = 0;
+	uint32_t last = InvalidNode;
+	m_FirstNode = InvalidNode;
+	auto Link = [&](uint32_t node)
+	{
+		m_Nodes[node].PrevPhysical = last;
+		m_Nodes[node].NextPhysical = InvalidNode;
+		if (last != InvalidNode)
+			m_Nodes[last].NextPhysical = node;
+		else
+			m_FirstNode = node;
+		last = node;
+	};
+	auto AddGap = [&](uint64_t offset, uint64_t size)
+	{
+		const uint32_t gap = CreateNode();
+		m_Nodes[gap].Offset = offset;
+		m_Nodes[gap].Size = size;
+		Link(gap);
+		InsertFree(gap);
+	};
+	for (uint32_t node : usedNodes)
+	{
+		const uint64_t destination = AlignUp(cursor, m_Nodes[node].Alignment);
+		if (destination > cursor)
+			AddGap(cursor, destination - cursor);
+		if (destination != m_Nodes[node].Offset && relocations)
+			relocations->push_back({ node, m_Nodes[node].Offset, destination, m_Nodes[node].Size });
+		m_Nodes[node].Offset = destination;
+		Link(node);
+		cursor = destination + m_Nodes[node].Size;
+	}
+	if (cursor < m_Size)
+		AddGap(cursor, m_Size - cursor);
+}
+
+uint64_t OffsetAllocator::GetLargestFreeBlock() const
+{
+	if (!m_FirstLevelBitmap)
+		return 0;
+	const uint32_t firstLevel = 63 - (uint32_t)std::countl_zero(m_FirstLevelBitmap);
+	const uint32_t secondLevel = 31 - (uint32_t)std::countl_zero(m_SecondLevelBitmap[firstLevel]);
+	uint64_t largest = 0;
+	for (uint32_t node = m_FreeHeads[firstLevel][secondLevel]; node != InvalidNode; node = m_Nodes[node].NextFree)
+	{
+		largest = m_Nodes[node].Size > largest ? m_Nodes[node].Size : largest;
+	}
+	return largest;
+}
+
+uint32_t OffsetAllocator::CreateNode()
+{
+	uint32_t node;
+	if (m_UnusedNodes.empty())
+	{
+		node = (uint32_t)m_Nodes.size();
+		m_Nodes.emplace_back();
+	}
+	else
+	{
+		node = m_UnusedNodes.back();
+		m_UnusedNodes.pop_back();
+		m_Nodes[node] = {};
+	}
+	return node;
+}
+
+void OffsetAllocator::ReleaseNode(uint32_t node)
+{
+	m_UnusedNodes.push_back(node);
+}
+
+void OffsetAllocator::InsertFree(uint32_t node)
+{
+	uint32_t firstLevel = 0;
+	uint32_t secondLevel = 0;
+	MappingInsert(m_Nodes[node].Size, &firstLevel, &secondLevel);
+	const uint32_t head = m_FreeHeads[firstLevel][secondLevel];
+	m_Nodes[node].PrevFree = InvalidNode;
+	m_Nodes[node].NextFree = head;
+	if (head != InvalidNode)
+		m_Nodes[head].PrevFree = node;
+	m_FreeHeads[firstLevel][secondLevel] = node;
+	m_SecondLevelBitmap[firstLevel] |= 1u << secondLevel;
+	m_FirstLevelBitmap |= 1ULL << firstLevel;
+}
+
+void OffsetAllocator::RemoveFree(uint32_t node)
+{
+	uint32_t firstLevel = 0;
+	uint32_t secondLevel = 0;
+	MappingInsert(m_Nodes[node].Size, &firstLevel, &secondLevel);
+	const uint32_t prev = m_Nodes[node].PrevFree;
+	const uint32_t next = m_Nodes[node].NextFree;
+	if (prev != InvalidNode)
+		m_Nodes[prev].NextFree = next;
+	else
+		m_FreeHeads[firstLevel][secondLevel] = next;
+	if (next != InvalidNode)
+		m_Nodes[next].PrevFree = prev;
+	m_Nodes[node].PrevFree = InvalidNode;
+	m_Nodes[node].NextFree = InvalidNode;
+
+	if (m_FreeHeads[firstLevel][secondLevel] == InvalidNode)
+	{
+		m_SecondLevelBitmap[firstLevel] &= ~(1u << secondLevel);
+		if (!m_SecondLevelBitmap[firstLevel])
+			m_FirstLevelBitmap &= ~(1ULL << firstLevel);
+	}
+}
+
+// Cuts frontSize bytes off the start of a block that is not in any free list.
+// The returned node owns the front part, the original node keeps the rest.
+uint32_t OffsetAllocator::SplitFront(uint32_t node, uint64_t frontSize)
+{
+	const uint32_t front = CreateNode();
+	m_Nodes[front].Offset = m_Nodes[node].Offset;
+	m_Nodes[front].Size = frontSize;
+	m_Nodes[front].PrevPhysical = m_Nodes[node].PrevPhysical;
+	m_Nodes[front].NextPhysical = node;
+	if (m_Nodes[front].PrevPhysical != InvalidNode)
+		m_Nodes[m_Nodes[front].PrevPhysical].NextPhysical = front;
+	else
+		m_FirstNode = front;
+	m_Nodes[node].PrevPhysical = front;
+	m_Nodes[node].Offset += frontSize;
+	m_Nodes[node].Size -= frontSize;
+	return front;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Two level segregated fit (TLSF) allocator over an abstract range of offsets.
+// It never touches memory itself, so it backs GPU heaps here and can be exercised on any platform.
+class OffsetAllocator
+{
+public:
+	static constexpr uint32_t InvalidNode = 0xFFFFFFFF;
+	struct Allocation
+	{
+		uint64_t Offset = 0;
+		uint32_t Node = InvalidNode;
+	};
+	struct Relocation
+	{
+		uint32_t Node;
+		uint64_t SourceOffset;
+		uint64_t DestinationOffset;
+		uint64_t Size;
+	};
+	explicit OffsetAllocator(uint64_t size = 0);
+	void Reset(uint64_t size);
+	bool Allocate(uint64_t size, uint64_t alignment, Allocation* allocation);
+	void Free(const Allocation& allocation);
+	void Compact(std::vector<Relocation>* relocations);
+	inline uint64_t GetSize() const { return m_Size; }
+	inline uint64_t GetUsedSize() const { return m_UsedSize; }
+	inline uint64_t GetFreeSize() const { return m_Size - m_UsedSize; }
+	inline uint32_t GetAllocationCount() const { return m_AllocationCount; }
+	uint64_t GetLargestFreeBlock() const;
+private:
+	static constexpr uint32_t SecondLevelBits = 4;
+	static constexpr uint32_t SecondLevelCount = 1 << SecondLevelBits;
+	static constexpr uint32_t FirstLevelCount = 64 - SecondLevelBits + 1;
+	struct Node
+	{
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+		uint64_t Alignment = 1;
+		uint32_t PrevPhysical = InvalidNode;
+		uint32_t NextPhysical = InvalidNode;
+		uint32_t PrevFree = InvalidNode;
+		uint32_t NextFree = InvalidNode;
+		bool Used = false;
+	};
+	static void MappingInsert(uint64_t size, uint32_t* firstLevel, uint32_t* secondLevel);
+	static void MappingSearch(uint64_t size, uint32_t* firstLevel, uint32_t* secondLevel);
+	uint32_t FindFreeBlock(uint64_t size) const;
+	uint32_t CreateNode();
+	void ReleaseNode(uint32_t node);
+	void InsertFree(uint32_t node);
+	void RemoveFree(uint32_t node);
+	uint32_t SplitFront(uint32_t node, uint64_t frontSize);
+	uint64_t m_Size = 0;
+	uint64_t m_UsedSize = 0;
+	uint32_t m_AllocationCount = 0;
+	uint32_t m_FirstNode = InvalidNode;
+	uint64_t m_FirstLevelBitmap = 0;
+	uint32_t m_SecondLevelBitmap[FirstLevelCount] = {};
+	uint32_t m_FreeHeads[FirstLevelCount][SecondLevelCount];
+	std::vector<Node> m_Nodes;
+	std::vector<uint32_t> m_UnusedNodes;
+};
@@ -1,7 +1,7 @@
 #include "PCH.h"
 #include "OutputBuffer.h"
 
-void OutputBuffer::Create(ID3D12Device11* device, UINT width, UINT height, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
+void OutputBuffer::Create(ID3D12Device11* device, UINT width, UINT height, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle, DXGI_FORMAT format, D3D12_RESOURCE_STATES initialState)
 {
 	D3D12_RESOURCE_DESC ResourceDesc = {};
 	ResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
@@ -10,7 +10,7 @@ void OutputBuffer::Create(ID3D12Device11* device, UINT width, UINT height, D3D12
 	ResourceDesc.Height = height;
 	ResourceDesc.DepthOrArraySize = 1;
 	ResourceDesc.MipLevels = 1;
-	ResourceDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	ResourceDesc.Format = format;
 	ResourceDesc.SampleDesc.Count = 1;
 	ResourceDesc.SampleDesc.Quality = 0;
 	ResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
@@ -22,7 +22,7 @@ void OutputBuffer::Create(ID3D12Device11* device, UINT width, UINT height, D3D12
 	{
 		CreateHeap(device, alloc_info.SizeInBytes);
 	}
-	device->CreatePlacedResource(m_Heap.Get(), 0, &ResourceDesc, D3D12_RESOURCE_STATE_COPY_SOURCE, nullptr, IID_PPV_ARGS(&m_Resource));
+	device->CreatePlacedResource(m_Heap.Get(), 0, &ResourceDesc, initialState, nullptr, IID_PPV_ARGS(&m_Resource));
 
 	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
 	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
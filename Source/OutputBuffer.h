@@ -5,11 +5,18 @@
 class OutputBuffer
 {
 public:
-	void Create(ID3D12Device11* device, UINT width, UINT height, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle);
+	void Create(ID3D12Device11* device, UINT width, UINT height, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM, D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_COPY_SOURCE);
 	inline void Transition(ID3D12GraphicsCommandList6* commandList, D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES afterState)
 	{
 		TransitionResource(commandList, m_Resource.Get(), beforeState, afterState);
 	}
+	inline void UAVBarrier(ID3D12GraphicsCommandList6* commandList)
+	{
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		barrier.UAV.pResource = m_Resource.Get();
+		commandList->ResourceBarrier(1, &barrier);
+	}
 	inline ID3D12Resource2* GetResource() { return m_Resource.Get(); }
 private:
 	void CreateHeap(ID3D12Device11* device, UINT64 heapsize);
@@ -25,8 +25,14 @@
 #include <fstream>
 #include <sstream>
 #include <map>
+#include <unordered_map>
 #include <immintrin.h>
 #include <vector>
 #include <list>
+#include <deque>
+#include <optional>
 #include <atlstr.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
  
\ No newline at end of file
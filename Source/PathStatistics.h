@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+
+// Ray counts of one frame, reported by the GPU counters and by the CPU renderer alike
+struct PathStatistics
+{
+	uint64_t Paths = 0; // one per pixel sample
+	uint64_t Rays = 0; // every ray traced, primary rays included
+	inline double GetAverageBounces() const { return Paths ? (double)(Rays - Paths) / (double)Paths : 0.0; }
+};
@@ -0,0 +1,165 @@
+#include "Profiler.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Profiler
+{
+	struct ThreadBuffer
+	{
+		SPSCQueue<Event, 16384> Events;
+		uint32_t Track = 0;
+	};
+
+	static std::atomic<bool> capturing = false;
+	static std::atomic<uint32_t> droppedEvents = 0;
+	// Guards registration only, recording never takes it
+	static std::mutex registryMutex;
+	static std::vector<std::shared_ptr<ThreadBuffer>> threadBuffers;
+	static std::vector<std::string> trackNames;
+	// Consumer side of every thread queue
+	static std::mutex collectMutex;
+	static std::vector<Event> collected;
+	static thread_local ThreadBuffer* threadBuffer = nullptr;
+
+	static uint32_t AddTrack(std::string name)
+	{
+		trackNames.push_back(std::move(name));
+		return (uint32_t)trackNames.size() - 1;
+	}
+
+	// Buffers stay registered after their thread exits so late events are still collected
+	static ThreadBuffer* GetThreadBuffer()
+	{
+		if (!threadBuffer)
+		{
+			std::shared_ptr<ThreadBuffer> buffer = std::make_shared<ThreadBuffer>();
+			std::lock_guard<std::mutex> lock(registryMutex);
+			buffer->Track = AddTrack("Thread " + std::to_string(threadBuffers.size()));
+			threadBuffers.push_back(buffer);
+			threadBuffer = buffer.get();
+		}
+		return threadBuffer;
+	}
+
+	uint64_t Now()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void SetCapturing(bool capture)
+	{
+		capturing.store(capture, std::memory_order_relaxed);
+	}
+
+	bool IsCapturing()
+	{
+		return capturing.load(std::memory_order_relaxed);
+	}
+
+	void SetThreadName(const char* name)
+	{
+		ThreadBuffer* buffer = GetThreadBuffer();
+		std::lock_guard<std::mutex> lock(registryMutex);
+		trackNames[buffer->Track] = name;
+	}
+
+	uint32_t RegisterTrack(const char* name)
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		return AddTrack(name);
+	}
+
+	void Record(const char* name, uint64_t start, uint64_t end)
+	{
+		ThreadBuffer* buffer = GetThreadBuffer();
+		RecordOnTrack(buffer->Track, name, start, end);
+	}
+
+	void RecordOnTrack(uint32_t track, const char* name, uint64_t start, uint64_t end)
+	{
+		const Event event = { name, start, end > start ? end - start : 0, track };
+		if (!GetThreadBuffer()->Events.Push(event))
+			droppedEvents.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Collect()
+	{
+		std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+		{
+			std::lock_guard<std::mutex> lock(registryMutex);
+			buffers = threadBuffers;
+		}
+		std::lock_guard<std::mutex> lock(collectMutex);
+		Event event;
+		for (const std::shared_ptr<ThreadBuffer>& buffer : buffers)
+		{
+			while (buffer->Events.Pop(&event))
+				collected.push_back(event);
+		}
+	}
+
+	static void WriteJsonString(std::ofstream& file, const char* text)
+	{
+		file << '"';
+		for (; *text; text++)
+		{
+			if (*text == '"' || *text == '\\')
+				file << '\\';
+			file << *text;
+		}
+		file << '"';
+	}
+
+	// Writes everything collected since the previous trace and clears it. Timestamps start at the first event.
+	bool WriteChromeTrace(const char* path)
+	{
+		Collect();
+		std::vector<std::string> names;
+		{
+			std::lock_guard<std::mutex> lock(registryMutex);
+			names = trackNames;
+		}
+		std::lock_guard<std::mutex> lock(collectMutex);
+		std::ofstream file(path);
+		if (!file)
+			return false;
+
+		uint64_t origin = ~0ULL;
+		for (const Event& event : collected)
+			origin = event.Start < origin ? event.Start : origin;
+
+		file << std::fixed << std::setprecision(3);
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		for (size_t track = 0; track < names.size(); track++)
+		{
+			file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track << ",\"args\":{\"name\":";
+			WriteJsonString(file, names[track].c_str());
+			file << "}},\n";
+			file << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track << ",\"args\":{\"sort_index\":" << track << "}}";
+			file << (track + 1 < names.size() || !collected.empty() ? ",\n" : "\n");
+		}
+		for (size_t i = 0; i < collected.size(); i++)
+		{
+			const Event& event = collected[i];
+			file << "{\"name\":";
+			WriteJsonString(file, event.Name);
+			file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.Track;
+			file << ",\"ts\":" << (event.Start - origin) / 1000.0 << ",\"dur\":" << event.Duration / 1000.0 << "}";
+			file << (i + 1 < collected.size() ? ",\n" : "\n");
+		}
+		file << "]}\n";
+		collected.clear();
+		return (bool)file;
+	}
+
+	uint32_t GetDroppedEventCount()
+	{
+		return droppedEvents.load(std::memory_order_relaxed);
+	}
+}
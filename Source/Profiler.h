@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include "SPSCQueue.h"
+
+// Timeline profiler for CPU scopes and GPU timestamps. Every thread records into its own lock-free queue,
+// which is drained by Collect from one thread; nothing is recorded unless a capture is running.
+// Captures are written as Chrome trace JSON (chrome://tracing, Perfetto). Platform independent.
+namespace Profiler
+{
+	struct Event
+	{
+		const char* Name; // must outlive the capture, string literals in practice
+		uint64_t Start;   // nanoseconds on the Now() clock
+		uint64_t Duration;
+		uint32_t Track;
+	};
+
+	uint64_t Now();
+	void SetCapturing(bool capturing);
+	bool IsCapturing();
+	// Names the calling thread's track in the trace
+	void SetThreadName(const char* name);
+	// Adds a track that is not a thread, e.g. a GPU queue
+	uint32_t RegisterTrack(const char* name);
+	void Record(const char* name, uint64_t start, uint64_t end);
+	void RecordOnTrack(uint32_t track, const char* name, uint64_t start, uint64_t end);
+	// Moves recorded events out of the per-thread queues, call at least once per frame while capturing
+	void Collect();
+	bool WriteChromeTrace(const char* path);
+	uint32_t GetDroppedEventCount();
+
+	class ScopedEvent
+	{
+	public:
+		explicit ScopedEvent(const char* name) : m_Name(IsCapturing() ? name : nullptr), m_Start(m_Name ? Now() : 0) {}
+		~ScopedEvent() { if (m_Name) Record(m_Name, m_Start, Now()); }
+		ScopedEvent(const ScopedEvent&) = delete;
+		ScopedEvent& operator=(const ScopedEvent&) = delete;
+	private:
+		const char* m_Name;
+		uint64_t m_Start;
+	};
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) Profiler::ScopedEvent PROFILE_CONCAT(profileScope, __LINE__)(name)
@@ -0,0 +1,45 @@
+#include "PCH.h"
+#include "RayStatistics.h"
+#include "Heap.h"
+#include "DX12Utility.h"
+
+void RayStatistics::Create(ID3D12Device11* device, HeapManager* heap, UINT framesInFlight)
+{
+	m_Counters = heap->CreateBufferResource(device, DefaultHeap, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, CounterCount * sizeof(UINT32), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+	m_Readback = heap->CreateBufferResource(device, ReadbackHeap, D3D12_RESOURCE_STATE_COPY_DEST, framesInFlight * CounterCount * sizeof(UINT32));
+	m_Recorded = std::make_unique<bool[]>(framesInFlight);
+}
+
+// The caller has already waited for the slot's previous frame. Slots are read in submission order,
+// so unsigned wrap-around keeps the difference correct even after the totals overflow.
+void RayStatistics::BeginFrame(UINT frameIndex)
+{
+	m_FrameIndex = frameIndex;
+	if (!m_Recorded[frameIndex])
+		return;
+	m_Recorded[frameIndex] = false;
+
+	const UINT first = frameIndex * CounterCount;
+	const D3D12_RANGE readRange = { first * sizeof(UINT32), (first + CounterCount) * sizeof(UINT32) };
+	UINT32* counters = nullptr;
+	ThrowIfFailed(m_Readback->Map(0, &readRange, (void**)&counters));
+	if (m_HasPrevious)
+	{
+		m_LastFrame.Paths = counters[first] - m_Previous[0];
+		m_LastFrame.Rays = counters[first + 1] - m_Previous[1];
+	}
+	m_Previous[0] = counters[first];
+	m_Previous[1] = counters[first + 1];
+	m_HasPrevious = true;
+	const D3D12_RANGE writeRange = { 0, 0 };
+	m_Readback->Unmap(0, &writeRange);
+}
+
+// Call after the dispatch that counts, on the same list
+void RayStatistics::Record(ID3D12GraphicsCommandList6* commandList)
+{
+	TransitionResource(commandList, m_Counters.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	commandList->CopyBufferRegion(m_Readback.Get(), m_FrameIndex * CounterCount * sizeof(UINT32), m_Counters.Get(), 0, CounterCount * sizeof(UINT32));
+	TransitionResource(commandList, m_Counters.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_Recorded[m_FrameIndex] = true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "PCH.h"
+#include "PathStatistics.h"
+
+class HeapManager;
+
+// GPU ray counters. RayGen adds to two running 32-bit totals that are never cleared; every frame copies them to its
+// readback slot and the difference between consecutive completed frames becomes that frame's statistics.
+class RayStatistics
+{
+public:
+	void Create(ID3D12Device11* device, HeapManager* heap, UINT framesInFlight);
+	void BeginFrame(UINT frameIndex);
+	void Record(ID3D12GraphicsCommandList6* commandList);
+	inline D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const { return m_Counters->GetGPUVirtualAddress(); }
+	inline const PathStatistics& GetLastFrame() const { return m_LastFrame; }
+private:
+	static constexpr UINT CounterCount = 2; // paths, rays
+	Microsoft::WRL::ComPtr<ID3D12Resource2> m_Counters;
+	Microsoft::WRL::ComPtr<ID3D12Resource2> m_Readback;
+	std::unique_ptr<bool[]> m_Recorded;
+	UINT m_FrameIndex = 0;
+	UINT32 m_Previous[CounterCount] = {};
+	bool m_HasPrevious = false;
+	PathStatistics m_LastFrame;
+};
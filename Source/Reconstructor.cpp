@@ -0,0 +1,89 @@
+#include "PCH.h"
+#include "Reconstructor.h"
+#include "ShaderCompiler.h"
+#include "RootSignatureGenerator.h"
+#include "DX12Utility.h"
+
+using Microsoft::WRL::ComPtr;
+
+static constexpr UINT ThreadGroupSize = 8; // numthreads in Reconstruct.hlsl
+
+// Root constants, same layout as ReconstructConstants in Reconstruct.hlsl
+struct ReconstructConstants
+{
+	UINT InterleaveMode;
+	UINT SampleIndex;
+	UINT RandomSequence;
+	UINT Width;
+	UINT Height;
+};
+
+// Root parameter order of the reconstruction root signature, the tables are u0 to u4 in Reconstruct.hlsl
+enum ReconstructParameter
+{
+	ParameterConstants,
+	ParameterAccumulation,
+	ParameterNormalDepth,
+	ParameterAlbedo,
+	ParameterMotion,
+	ParameterOutput,
+	ParameterCount
+};
+
+void Reconstructor::Create(ID3D12Device11* device, ShaderCompiler* shaderCompiler)
+{
+	m_Device = device;
+	D3D12_ROOT_PARAMETER constants = {};
+	constants.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+	constants.Constants.ShaderRegister = 0;
+	constants.Constants.RegisterSpace = 0;
+	constants.Constants.Num32BitValues = sizeof(ReconstructConstants) / 4;
+	constants.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+	// One single-entry UAV table per texture, they come from different owners
+	D3D12_DESCRIPTOR_RANGE ranges[ParameterCount - 1] = {};
+	RootSignatureGenerator rootSignatureGenerator(m_Device);
+	rootSignatureGenerator.AddParameter(constants);
+	for (UINT i = 0; i < ParameterCount - 1; i++)
+	{
+		ranges[i].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+		ranges[i].NumDescriptors = 1;
+		ranges[i].BaseShaderRegister = i;
+		ranges[i].RegisterSpace = 0;
+		ranges[i].OffsetInDescriptorsFromTableStart = 0;
+
+		D3D12_ROOT_PARAMETER table = {};
+		table.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+		table.DescriptorTable.NumDescriptorRanges = 1;
+		table.DescriptorTable.pDescriptorRanges = &ranges[i];
+		table.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		rootSignatureGenerator.AddParameter(table);
+	}
+	m_RootSignature = rootSignatureGenerator.Generate();
+
+	ComPtr<IDxcBlob> shader = shaderCompiler->CompileShader(L"Shaders/Reconstruct.hlsl", L"Reconstruct", ShaderCompiler::ComputeTarget);
+	D3D12_COMPUTE_PIPELINE_STATE_DESC pipelineDesc = {};
+	pipelineDesc.pRootSignature = m_RootSignature.Get();
+	pipelineDesc.CS = { shader->GetBufferPointer(), shader->GetBufferSize() };
+	ThrowIfFailed(m_Device->CreateComputePipelineState(&pipelineDesc, IID_PPV_ARGS(&m_PipelineState)));
+}
+
+void Reconstructor::Record(ID3D12GraphicsCommandList6* commandList, InterleavedSampling::Mode mode, UINT sampleIndex, UINT randomSequence, UINT width, UINT height, D3D12_GPU_DESCRIPTOR_HANDLE accumulation, D3D12_GPU_DESCRIPTOR_HANDLE normalDepth, D3D12_GPU_DESCRIPTOR_HANDLE albedo, D3D12_GPU_DESCRIPTOR_HANDLE motion, D3D12_GPU_DESCRIPTOR_HANDLE output)
+{
+	// Reads what the ray dispatch wrote
+	D3D12_RESOURCE_BARRIER barrier = {};
+	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+	barrier.UAV.pResource = nullptr;
+	commandList->ResourceBarrier(1, &barrier);
+
+	const ReconstructConstants constants = { mode, sampleIndex, randomSequence, width, height };
+	commandList->SetComputeRootSignature(m_RootSignature.Get());
+	commandList->SetPipelineState(m_PipelineState.Get());
+	commandList->SetComputeRoot32BitConstants(ParameterConstants, sizeof(constants) / 4, &constants, 0);
+	commandList->SetComputeRootDescriptorTable(ParameterAccumulation, accumulation);
+	commandList->SetComputeRootDescriptorTable(ParameterNormalDepth, normalDepth);
+	commandList->SetComputeRootDescriptorTable(ParameterAlbedo, albedo);
+	commandList->SetComputeRootDescriptorTable(ParameterMotion, motion);
+	commandList->SetComputeRootDescriptorTable(ParameterOutput, output);
+	commandList->Dispatch((width + ThreadGroupSize - 1) / ThreadGroupSize, (height + ThreadGroupSize - 1) / ThreadGroupSize, 1);
+}
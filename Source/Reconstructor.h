@@ -0,0 +1,20 @@
+#pragma once
+#include "PCH.h"
+#include "InterleavedSampling.h"
+
+class ShaderCompiler;
+
+// Reconstruction of the pixels an interleaved ray dispatch skipped, one compute dispatch after it, see
+// Reconstruct.hlsl. Works in place on the textures RayGen writes, so it owns no resources of its own.
+class Reconstructor
+{
+public:
+	void Create(ID3D12Device11* device, ShaderCompiler* shaderCompiler);
+	// Only needed while InterleavedSampling::NeedsReconstruction. Textures are in UNORDERED_ACCESS, the descriptor
+	// heap is already set on the list
+	void Record(ID3D12GraphicsCommandList6* commandList, InterleavedSampling::Mode mode, UINT sampleIndex, UINT randomSequence, UINT width, UINT height, D3D12_GPU_DESCRIPTOR_HANDLE accumulation, D3D12_GPU_DESCRIPTOR_HANDLE normalDepth, D3D12_GPU_DESCRIPTOR_HANDLE albedo, D3D12_GPU_DESCRIPTOR_HANDLE motion, D3D12_GPU_DESCRIPTOR_HANDLE output);
+private:
+	ID3D12Device11* m_Device = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_RootSignature;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_PipelineState;
+};
@@ -0,0 +1,42 @@
+#include "RecordedCommandBackend.h"
+#include <stdexcept>
+
+uint32_t RecordedCommandBackend::CommandList::GetFirstOpcode() const
+{
+	if (m_Stream.empty())
+		return ~0u;
+	uint32_t opcode = 0;
+	memcpy(&opcode, m_Stream.data(), sizeof(opcode));
+	return opcode;
+}
+
+void RecordedCommandBackend::BeginFrame()
+{
+	m_Used = 0;
+}
+
+RecordedCommandBackend::CommandList* RecordedCommandBackend::Acquire()
+{
+	if (m_Used == m_Lists.size())
+		m_Lists.emplace_back();
+	CommandList* list = &m_Lists[m_Used++];
+	list->Reset();
+	return list;
+}
+
+void RecordedCommandBackend::Close(CommandList* list)
+{
+	if (list->m_Closed)
+		throw std::runtime_error("Command list closed twice");
+	list->m_Closed = true;
+}
+
+void RecordedCommandBackend::Submit(CommandList* const* lists, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (!lists[i]->m_Closed)
+			throw std::runtime_error("Submitted a command list that is still recording");
+		m_Submitted.push_back({ lists[i]->GetFirstOpcode(), lists[i]->GetCommandCount(), lists[i]->GetSize() });
+	}
+}
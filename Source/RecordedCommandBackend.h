@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+// Device-free command backend for CommandScheduler. Lists serialize their commands into byte streams
+// with the same per-command bookkeeping a driver does, so recording cost and submission order can be
+// measured on any platform.
+class RecordedCommandBackend
+{
+public:
+	class CommandList
+	{
+	public:
+		template<typename T>
+		void Write(uint32_t opcode, const T& payload)
+		{
+			const size_t offset = m_Stream.size();
+			m_Stream.resize(offset + sizeof(uint32_t) * 2 + sizeof(T));
+			const uint32_t header[2] = { opcode, (uint32_t)sizeof(T) };
+			memcpy(m_Stream.data() + offset, header, sizeof(header));
+			memcpy(m_Stream.data() + offset + sizeof(header), &payload, sizeof(T));
+			m_CommandCount++;
+		}
+		inline uint32_t GetCommandCount() const { return m_CommandCount; }
+		inline size_t GetSize() const { return m_Stream.size(); }
+		// Opcode of the first command, lets tests tell lists apart after submission
+		uint32_t GetFirstOpcode() const;
+	private:
+		friend class RecordedCommandBackend;
+		void Reset() { m_Stream.clear(); m_CommandCount = 0; m_Closed = false; }
+		std::vector<uint8_t> m_Stream;
+		uint32_t m_CommandCount = 0;
+		bool m_Closed = false;
+	};
+	struct SubmittedList
+	{
+		uint32_t FirstOpcode;
+		uint32_t CommandCount;
+		size_t Size;
+	};
+	void BeginFrame();
+	CommandList* Acquire();
+	void Close(CommandList* list);
+	void Submit(CommandList* const* lists, uint32_t count);
+	inline const std::vector<SubmittedList>& GetSubmitted() const { return m_Submitted; }
+	inline void ClearSubmitted() { m_Submitted.clear(); }
+private:
+	std::deque<CommandList> m_Lists; // deque keeps handed out pointers stable while growing
+	size_t m_Used = 0;
+	std::vector<SubmittedList> m_Submitted;
+};
@@ -0,0 +1,351 @@
+#include "RegressionTest.h"
+#include "CpuRenderer.h"
+#include "CpuReconstruction.h"
+#include "CpuScene.h"
+#include "CpuTemporalAccumulator.h"
+#include "DemoScene.h"
+#include "ImageEncoder.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+// Changing the list or the constants below invalidates the stored references
+struct RegressionCase
+{
+	const char* Name;
+	Float3 CameraPosition;
+	float CameraPitch;
+	float CameraHeading;
+	double Time; // animation seconds
+	bool Wavefront;
+};
+
+static const RegressionCase Cases[] =
+{
+	{ "start", { -1.0f, 0.0f, 0.5f }, 0.5f, 0.0f, 0.0, true },
+	{ "start_depth_first", { -1.0f, 0.0f, 0.5f }, 0.5f, 0.0f, 0.0, false },
+	{ "side", { 0.0f, -2.0f, 1.0f }, 0.4f, 1.5707964f, 1.0, true },
+	{ "close", { -0.6f, 0.5f, 0.3f }, 0.2f, -0.7f, 3.7, true },
+	{ "above", { -0.2f, 0.0f, 3.0f }, 1.4f, 0.0f, 6.2, true }
+};
+static constexpr uint32_t Width = 320;
+static constexpr uint32_t Height = 180;
+static constexpr uint32_t Samples = 16;
+static constexpr float CameraFOV = 1.25f;
+// The time reported is the fastest of these, the image is the same every time
+static constexpr uint32_t TimedRuns = 3;
+
+struct CaseResult
+{
+	double Seconds = 0.0;
+	uint64_t Rays = 0;
+};
+
+static bool ReadFile(const std::string& path, std::vector<uint8_t>* data)
+{
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream)
+		return false;
+	data->assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	return !stream.bad();
+}
+
+static bool WriteFile(const std::string& path, const std::vector<uint8_t>& data)
+{
+	std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+	stream.write((const char*)data.data(), data.size());
+	stream.close();
+	return !stream.fail();
+}
+
+// One line per case: name, seconds, rays
+static std::map<std::string, CaseResult> ReadBaseline(const std::string& path)
+{
+	std::map<std::string, CaseResult> baseline;
+	std::ifstream stream(path);
+	std::string name;
+	CaseResult result;
+	while (stream >> name >> result.Seconds >> result.Rays)
+	{
+		baseline[name] = result;
+	}
+	return baseline;
+}
+
+static bool WriteBaseline(const std::string& path, const std::map<std::string, CaseResult>& baseline)
+{
+	std::ofstream stream(path, std::ios::trunc);
+	for (const auto& entry : baseline)
+	{
+		stream << entry.first << ' ' << entry.second.Seconds << ' ' << entry.second.Rays << '\n';
+	}
+	stream.close();
+	return !stream.fail();
+}
+
+// Root mean square and largest difference over the RGB channels in 0-1 units. Difference gets the per-channel
+// differences magnified four times, so small deviations are visible.
+static void Compare(const ImageBuffer& image, const ImageBuffer& reference, double* rmse, double* maxDifference, ImageBuffer* difference)
+{
+	difference->Resize(image.Width, image.Height, ImagePixelRGBA8);
+	double sumSquares = 0.0;
+	int largest = 0;
+	for (size_t pixel = 0; pixel < image.RGBA8.size(); pixel++)
+	{
+		uint32_t magnified = 0xFF000000u;
+		for (uint32_t channel = 0; channel < 3; channel++)
+		{
+			const int a = (image.RGBA8[pixel] >> (channel * 8)) & 0xFF;
+			const int b = (reference.RGBA8[pixel] >> (channel * 8)) & 0xFF;
+			const int delta = std::abs(a - b);
+			sumSquares += (double)delta * delta;
+			largest = std::max(largest, delta);
+			magnified |= (uint32_t)std::min(delta * 4, 255) << (channel * 8);
+		}
+		difference->RGBA8[pixel] = magnified;
+	}
+	*rmse = std::sqrt(sumSquares / (image.RGBA8.size() * 3.0)) / 255.0;
+	*maxDifference = largest / 255.0;
+}
+
+// A new renderer for every run: the random streams depend on how often the accumulation restarted before
+static CaseResult RenderCase(const RegressionCase& regressionCase, CpuScene* scene, ThreadPool* threadPool, ImageBuffer* image)
+{
+	float angle1, angle2;
+	DemoScene::GetAnimationAngles(regressionCase.Time, &angle1, &angle2);
+	DemoScene::AddInstances(scene, angle1, angle2);
+	const CameraState camera = CpuRenderer::GetCameraState(regressionCase.CameraPosition, regressionCase.CameraPitch, regressionCase.CameraHeading, CameraFOV, (float)Width / Height);
+	CaseResult best;
+	best.Seconds = INFINITY;
+	for (uint32_t run = 0; run < TimedRuns; run++)
+	{
+		CpuRenderer renderer;
+		renderer.Resize(Width, Height);
+		renderer.SetAdaptiveSampling(AdaptiveSampling::Disabled, 0.0f);
+		renderer.SetJitterFirstSample(true);
+		renderer.SetWavefront(regressionCase.Wavefront);
+		const auto start = std::chrono::steady_clock::now();
+		uint64_t rays = 0;
+		for (uint32_t sample = 0; sample < Samples; sample++)
+		{
+			renderer.Render(*scene, camera, threadPool);
+			rays += renderer.GetLastFrame().Rays;
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (seconds < best.Seconds)
+		{
+			best = { seconds, rays };
+		}
+		if (run + 1 == TimedRuns)
+		{
+			image->Resize(Width, Height, ImagePixelRGBA8);
+			renderer.Resolve(&image->RGBA8);
+		}
+	}
+	return best;
+}
+
+// Low sample count modes checked against a converged full-rate render of the last frame's view. While the camera pans
+// every frame restarts the accumulation like in the application and gets one sample per pixel, so temporal reuse and
+// the reconstruction of untraced pixels are what is measured; in still cases the view holds and the interleaved
+// patterns have to cover every pixel. Errors are the RMSE of the pixel means in 0-1 units. full_rate is the panning
+// run without either, for comparison.
+enum ConvergenceMotion
+{
+	MotionStill, // the last frame's view throughout
+	MotionPan, // the camera pans, the cubes hold the last frame's angles
+	MotionAnimated // the camera pans and the cubes turn at the demo's speed
+};
+
+struct ConvergenceCase
+{
+	const char* Name;
+	ConvergenceMotion Motion;
+	bool TemporalReuse;
+	InterleavedSampling::Mode Interleave;
+	float MaxError;
+};
+
+static const ConvergenceCase ConvergenceCases[] =
+{
+	{ "full_rate", MotionAnimated, false, InterleavedSampling::InterleaveFull, 0.045f },
+	{ "temporal_pan", MotionPan, true, InterleavedSampling::InterleaveFull, 0.025f },
+	{ "temporal_animated", MotionAnimated, true, InterleavedSampling::InterleaveFull, 0.035f },
+	{ "checkerboard", MotionAnimated, false, InterleavedSampling::InterleaveCheckerboard, 0.037f },
+	{ "quarter", MotionAnimated, false, InterleavedSampling::InterleaveQuarter, 0.044f },
+	{ "quarter_temporal", MotionAnimated, true, InterleavedSampling::InterleaveQuarter, 0.04f },
+	{ "checkerboard_still", MotionStill, false, InterleavedSampling::InterleaveCheckerboard, 0.012f },
+	{ "quarter_still", MotionStill, false, InterleavedSampling::InterleaveQuarter, 0.016f },
+	{ "full_rate_still", MotionStill, false, InterleavedSampling::InterleaveFull, 0.009f }
+};
+static constexpr uint32_t ConvergenceWidth = 160;
+static constexpr uint32_t ConvergenceHeight = 90;
+static constexpr uint32_t ConvergenceFrames = 30;
+static constexpr uint32_t ReferenceSamples = 256;
+
+static void SetConvergenceFrame(uint32_t frame, ConvergenceMotion motion, CpuScene* scene, CameraState* camera)
+{
+	const uint32_t cameraFrame = motion == MotionStill ? ConvergenceFrames - 1 : frame;
+	const uint32_t sceneFrame = motion == MotionAnimated ? frame : ConvergenceFrames - 1;
+	float angle1, angle2;
+	DemoScene::GetAnimationAngles(sceneFrame / 60.0, &angle1, &angle2);
+	DemoScene::AddInstances(scene, angle1, angle2);
+	*camera = CpuRenderer::GetCameraState({ -1.0f, 0.0f, 0.5f }, 0.5f, 0.003f * cameraFrame, CameraFOV, (float)ConvergenceWidth / ConvergenceHeight);
+}
+
+static float RenderConvergenceCase(const ConvergenceCase& convergenceCase, const std::vector<Float4>& reference, CpuScene* scene, ThreadPool* threadPool)
+{
+	CpuRenderer renderer;
+	renderer.Resize(ConvergenceWidth, ConvergenceHeight);
+	renderer.SetAdaptiveSampling(AdaptiveSampling::Disabled, 0.0f);
+	renderer.SetJitterFirstSample(true);
+	renderer.SetWavefront(true);
+	renderer.SetInterleaveMode(convergenceCase.Interleave);
+	CpuTemporalAccumulator accumulator;
+	accumulator.Resize(ConvergenceWidth, ConvergenceHeight);
+	const Float4* result = nullptr;
+	for (uint32_t frame = 0; frame < ConvergenceFrames; frame++)
+	{
+		CameraState camera;
+		SetConvergenceFrame(frame, convergenceCase.Motion, scene, &camera);
+		const uint32_t sampleIndex = renderer.Render(*scene, camera, threadPool);
+		result = renderer.GetSums().data();
+		if (convergenceCase.TemporalReuse)
+			result = accumulator.Accumulate(result, renderer.GetNormalDepth().data(), renderer.GetMotion().data(), sampleIndex, threadPool).data();
+	}
+	return CpuReconstruction::MeasureError(result, reference.data(), reference.size());
+}
+
+// Returns the number of failed cases
+static uint32_t RunConvergenceCases(CpuScene* scene, ThreadPool* threadPool, std::ostream& log)
+{
+	CpuRenderer referenceRenderer;
+	referenceRenderer.Resize(ConvergenceWidth, ConvergenceHeight);
+	referenceRenderer.SetAdaptiveSampling(AdaptiveSampling::Disabled, 0.0f);
+	referenceRenderer.SetWavefront(true);
+	CameraState camera;
+	SetConvergenceFrame(ConvergenceFrames - 1, MotionStill, scene, &camera);
+	for (uint32_t sample = 0; sample < ReferenceSamples; sample++)
+	{
+		referenceRenderer.Render(*scene, camera, threadPool);
+	}
+	const std::vector<Float4> reference = referenceRenderer.GetSums();
+	uint32_t failures = 0;
+	for (const ConvergenceCase& convergenceCase : ConvergenceCases)
+	{
+		const float error = RenderConvergenceCase(convergenceCase, reference, scene, threadPool);
+		const bool passed = error <= convergenceCase.MaxError;
+		log << convergenceCase.Name << ": RMSE " << error << " against " << ReferenceSamples << " spp, limit " << convergenceCase.MaxError << (passed ? ", passed" : ", FAILED") << std::endl;
+		if (!passed)
+			failures++;
+	}
+	return failures;
+}
+
+namespace RegressionTest
+{
+	int Run(const OfflineRenderSettings& settings, std::ostream& log)
+	{
+		const std::string& directory = settings.Regression;
+		if (settings.UpdateReferences)
+		{
+			std::error_code error;
+			std::filesystem::create_directories(directory, error);
+		}
+		const std::string baselinePath = directory + "/baseline.txt";
+		const std::string historyPath = directory + "/history.csv";
+		std::map<std::string, CaseResult> baseline = ReadBaseline(baselinePath);
+		const bool newHistory = !std::ifstream(historyPath);
+		std::ofstream history(historyPath, std::ios::app);
+		if (newHistory)
+			history << "time,case,seconds,rays,rmse\n";
+
+		ThreadPool threadPool;
+		CpuScene scene;
+		DemoScene::AddMeshes(&scene);
+		ImageBuffer image;
+		ImageBuffer reference;
+		ImageBuffer difference;
+		std::vector<uint8_t> file;
+		uint32_t failures = 0;
+		for (const RegressionCase& regressionCase : Cases)
+		{
+			const std::string name = regressionCase.Name;
+			const std::string referencePath = directory + "/" + name + ".ppm";
+			const CaseResult result = RenderCase(regressionCase, &scene, &threadPool, &image);
+			log << name << ": " << result.Seconds << " s, " << result.Rays << " rays";
+			if (settings.UpdateReferences)
+			{
+				ImageEncoder::EncodePPM(image, &file);
+				if (!WriteFile(referencePath, file))
+				{
+					log << ", could not write " << referencePath << std::endl;
+					return 1;
+				}
+				baseline[name] = result;
+				log << ", reference updated" << std::endl;
+				continue;
+			}
+
+			if (!ReadFile(referencePath, &file) || !ImageEncoder::DecodePPM(file, &reference) || reference.Width != Width || reference.Height != Height)
+			{
+				log << ", FAILED: no valid reference " << referencePath << std::endl;
+				failures++;
+				continue;
+			}
+			double rmse = 0.0, maxDifference = 0.0;
+			Compare(image, reference, &rmse, &maxDifference, &difference);
+			log << ", RMSE " << rmse << ", largest difference " << maxDifference;
+			bool passed = rmse <= settings.RegressionTolerance;
+			const auto previous = baseline.find(name);
+			if (previous != baseline.end())
+			{
+				const double speedup = previous->second.Seconds / result.Seconds;
+				log << ", " << speedup << "x baseline speed, ray count change " << (int64_t)(result.Rays - previous->second.Rays);
+				if (settings.RegressionMaxSlowdown > 0.0f && result.Seconds > previous->second.Seconds * settings.RegressionMaxSlowdown)
+				{
+					log << ", too slow";
+					passed = false;
+				}
+			}
+			history << std::time(nullptr) << ',' << name << ',' << result.Seconds << ',' << result.Rays << ',' << rmse << '\n';
+			// Kept next to the reference for inspection until the case passes again
+			const std::string actualPath = directory + "/" + name + "_actual.png";
+			const std::string differencePath = directory + "/" + name + "_difference.png";
+			if (passed)
+			{
+				std::error_code error;
+				std::filesystem::remove(actualPath, error);
+				std::filesystem::remove(differencePath, error);
+				log << ", passed" << std::endl;
+				continue;
+			}
+			failures++;
+			ImageEncoder::EncodePNG(image, &file);
+			WriteFile(actualPath, file);
+			ImageEncoder::EncodePNG(difference, &file);
+			WriteFile(differencePath, file);
+			log << ", FAILED" << std::endl;
+		}
+
+		if (settings.UpdateReferences)
+		{
+			if (!WriteBaseline(baselinePath, baseline))
+			{
+				log << "Could not write " << baselinePath << std::endl;
+				return 1;
+			}
+			return 0;
+		}
+		failures += RunConvergenceCases(&scene, &threadPool, log);
+		const size_t caseCount = sizeof(Cases) / sizeof(Cases[0]) + sizeof(ConvergenceCases) / sizeof(ConvergenceCases[0]);
+		log << caseCount - failures << " of " << caseCount << " cases passed" << std::endl;
+		return failures ? 1 : 0;
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <ostream>
+#include "OfflineRender.h"
+
+// Golden-image check of the CPU path tracer. Renders a fixed list of camera poses and animation times of the demo
+// scene, compares each image with a stored reference and reports render time and ray count next to a stored
+// baseline. With UpdateReferences the current build records both: run that before a change and compare after it.
+namespace RegressionTest
+{
+	// Uses the Regression fields of settings, the case list fixes everything else. Returns the process exit code,
+	// 1 if a case is missing its reference, differs by more than the tolerance or is slower than allowed.
+	int Run(const OfflineRenderSettings& settings, std::ostream& log);
+}
@@ -86,7 +86,7 @@ Renderer::~Renderer()
 	}
 }
 
-void Renderer::Create(Window* window)
+void Renderer::Create(Window* window, UINT64 perFrameUploadSize)
 {
 	EnableDX12DebugLayer();
 	ComPtr<IDXGIAdapter4> dxgiAdapter = GetAdapter();
@@ -96,19 +96,61 @@ void Renderer::Create(Window* window)
 #endif
 
 	m_CommandQueue.Create(m_Device.Get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
-	m_DescriptorHeap.Create(m_Device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 10, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE);
-	m_SwapChain.Create(m_Device.Get(), &m_CommandQueue, m_DescriptorHeap.GetCPUHandle(0), window->GetHandle(), window->GetClientWidth(), window->GetClientHeight(), 3, TRUE);
+	m_DescriptorHeap.Create(m_Device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, PersistentDescriptorCount, TransientDescriptorCount, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE);
+	m_OutputDescriptor = m_DescriptorHeap.AllocatePersistent();
+	m_AccumulationDescriptor = m_DescriptorHeap.AllocatePersistent();
+	m_SwapChain.Create(m_Device.Get(), &m_CommandQueue, m_DescriptorHeap.GetCPUHandle(m_OutputDescriptor), m_DescriptorHeap.GetCPUHandle(m_AccumulationDescriptor), window->GetHandle(), window->GetClientWidth(), window->GetClientHeight(), 3, TRUE);
 	m_CommandAllocator = CreateCommandAllocator(m_Device.Get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
 	m_CommandList = CreateCommandList(m_Device.Get(), m_CommandAllocator.Get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
+	m_CommandListPool.Create(m_Device.Get(), &m_CommandQueue, FramesInFlight);
+	m_CommandListPool.BeginFrame(m_FrameIndex);
 
 	m_Heap.Create(m_Device.Get());
+	m_UploadRing.Create(m_Device.Get(), &m_Heap, UploadRingSize + (FramesInFlight + 1) * perFrameUploadSize);
+	m_GpuProfiler.Create(m_Device.Get(), &m_Heap, m_CommandQueue.GetPtr(), FramesInFlight);
+	m_RayStatistics.Create(m_Device.Get(), &m_Heap, FramesInFlight);
 }
 
-void Renderer::ExecuteCommandList()
+// Submits the immediate list after anything already submitted, waits for it and reopens it
+UINT64 Renderer::ExecuteCommandList()
 {
 	ThrowIfFailed(m_CommandList->Close());
 	m_CommandQueue.ExecuteCommandList(m_CommandList.Get());
-	m_CommandQueue.Flush();
+	const UINT64 fenceValue = EndFrame();
+	m_CommandQueue.WaitForFenceValue(fenceValue);
+	ThrowIfFailed(m_CommandAllocator->Reset());
+	ThrowIfFailed(m_CommandList->Reset(m_CommandAllocator.Get(), nullptr));
+	return fenceValue;
+}
+
+// Waits only if this frame slot's previous use is still executing, i.e. the CPU is FramesInFlight frames ahead
+void Renderer::BeginFrame()
+{
+	FrameContext& frame = m_Frames[m_FrameIndex];
+	{
+		PROFILE_SCOPE("Wait for frame slot");
+		m_CommandQueue.WaitForFenceValue(frame.FenceValue);
+	}
+
+	const UINT64 completedFenceValue = m_CommandQueue.GetCompletedFenceValue();
+	m_UploadRing.BeginFrame(completedFenceValue);
+	m_Heap.Retire(completedFenceValue);
+	m_DescriptorHeap.Retire(completedFenceValue);
+	m_GpuProfiler.BeginFrame(m_FrameIndex);
+	m_RayStatistics.BeginFrame(m_FrameIndex);
+	m_CommandListPool.BeginFrame(m_FrameIndex);
+}
+
+// Signals the work submitted so far and tags everything the frame used with its fence value
+UINT64 Renderer::EndFrame()
+{
+	UINT64 fenceValue = m_CommandQueue.Signal();
+	m_Frames[m_FrameIndex].FenceValue = fenceValue;
+	m_UploadRing.EndFrame(fenceValue);
+	m_Heap.EndFrame(fenceValue);
+	m_DescriptorHeap.EndFrame(fenceValue);
+	m_FrameIndex = (m_FrameIndex + 1) % FramesInFlight;
+	return fenceValue;
 }
 
 #ifdef _DEBUG
@@ -4,23 +4,44 @@
 #include "CommandQueue.h"
 #include "DescriptorHeap.h"
 #include "Heap.h"
+#include "UploadRing.h"
+#include "GpuProfiler.h"
+#include "RayStatistics.h"
+#include "CommandListPool.h"
+#include "ThreadPool.h"
 
 class Window;
 
 class Renderer
 {
 public:
+	static constexpr UINT FramesInFlight = 2;
+	static constexpr UINT PersistentDescriptorCount = 4096;
+	static constexpr UINT TransientDescriptorCount = 4096;
 	Renderer();
 	~Renderer();
-	void Create(Window* m_Window);
-	void ExecuteCommandList();
+	static constexpr UINT64 UploadRingSize = 1024ULL * 1024 * 4;
+	// The upload ring gets room for perFrameUploadSize more bytes in every frame that can be in flight or recorded
+	void Create(Window* m_Window, UINT64 perFrameUploadSize = 0);
+	UINT64 ExecuteCommandList();
+	void BeginFrame();
+	UINT64 EndFrame();
 	inline void ToggleVSync() { SetVSync(!GetVSync()); }
 	inline void SetVSync(bool vsync) { m_SwapChain.m_VSync = vsync; }
 	inline bool GetVSync() const { return m_SwapChain.m_VSync; }
 	inline ID3D12Device11* GetDevice() { return m_Device.Get(); }
 	inline ID3D12GraphicsCommandList6* GetCommandList() { return m_CommandList.Get(); }
 	inline DescriptorHeap* GetDescriptorHeap() { return &m_DescriptorHeap; }
+	inline D3D12_GPU_DESCRIPTOR_HANDLE GetOutputDescriptor() { return m_DescriptorHeap.GetGPUHandle(m_OutputDescriptor); }
+	inline D3D12_GPU_DESCRIPTOR_HANDLE GetAccumulationDescriptor() { return m_DescriptorHeap.GetGPUHandle(m_AccumulationDescriptor); }
 	inline HeapManager* GetHeap() { return &m_Heap; }
+	inline UploadRing* GetUploadRing() { return &m_UploadRing; }
+	inline GpuProfiler* GetGpuProfiler() { return &m_GpuProfiler; }
+	inline RayStatistics* GetRayStatistics() { return &m_RayStatistics; }
+	inline CommandListPool* GetCommandListPool() { return &m_CommandListPool; }
+	inline ThreadPool* GetThreadPool() { return &m_ThreadPool; }
+	inline UINT64 GetCompletedFenceValue() { return m_CommandQueue.GetCompletedFenceValue(); }
+	inline UINT GetFrameIndex() const { return m_FrameIndex; }
 private:
 #ifdef _DEBUG
 	//Gets Destructed Last Because it was created First
@@ -33,15 +54,30 @@ private:
 #endif
 	// DirectX 12 Objects
 	Microsoft::WRL::ComPtr<ID3D12Device11> m_Device;
+	// Immediate list for setup work, frames record through m_CommandListPool
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> m_CommandAllocator;
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList6> m_CommandList;
+	// Everything the CPU must not reuse before the GPU has finished the frame that recorded it
+	struct FrameContext
+	{
+		UINT64 FenceValue = 0;
+	};
+	FrameContext m_Frames[FramesInFlight];
+	DescriptorRange m_OutputDescriptor;
+	DescriptorRange m_AccumulationDescriptor;
+	UINT m_FrameIndex = 0;
 public:
 	CommandQueue m_CommandQueue;
 	SwapChain m_SwapChain;
 	DescriptorHeap m_DescriptorHeap;
 	//RootSignature m_RootSignature;
 	//Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pipelineState;
-	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> m_CommandAllocator;
 	HeapManager m_Heap;
+	UploadRing m_UploadRing;
+	GpuProfiler m_GpuProfiler;
+	RayStatistics m_RayStatistics;
+	CommandListPool m_CommandListPool;
+	ThreadPool m_ThreadPool;
 	friend class Camera;
 	friend class SwapChain;
 };
\ No newline at end of file
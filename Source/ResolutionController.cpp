@@ -0,0 +1,58 @@
+#include "ResolutionController.h"
+#include <algorithm>
+#include <cmath>
+
+ResolutionController::ResolutionController(const ResolutionSettings& settings) :
+	m_Settings(settings),
+	m_MinLevel(std::max(1u, (uint32_t)std::ceil(settings.MinScale * settings.Steps))),
+	m_Level(settings.Steps)
+{}
+
+float ResolutionController::Update(float frameTime)
+{
+	if (m_SettleFrames)
+	{
+		m_SettleFrames--;
+		return GetScale();
+	}
+	// A plain mean until the running average has its full window, so a single noisy timing after a change does not
+	// decide the next one
+	m_AveragedFrames++;
+	m_AverageFrameTime += (frameTime - m_AverageFrameTime) * std::max(m_Settings.Smoothing, 1.0f / m_AveragedFrames);
+	if (m_AveragedFrames * m_Settings.Smoothing < 1.0f)
+		return GetScale();
+	const bool overBudget = m_AverageFrameTime > m_Settings.TargetFrameTime;
+	const bool underBudget = m_AverageFrameTime < m_Settings.TargetFrameTime * m_Settings.Headroom;
+	if (!overBudget && !underBudget)
+		return GetScale();
+
+	// The scale that would land on the lower edge of the band, rounded down. Aiming at the budget itself would leave
+	// the next timing just under it, where noise soon pushes the average over again.
+	const float wanted = GetScale() * std::sqrt(m_Settings.TargetFrameTime * m_Settings.Headroom / m_AverageFrameTime);
+	uint32_t level = (uint32_t)std::clamp(std::floor(wanted * m_Settings.Steps), (float)m_MinLevel, (float)m_Settings.Steps);
+	if (overBudget)
+	{
+		level = std::min(level, std::max(m_MinLevel, m_Level - 1));
+	}
+	if (level == m_Level)
+		return GetScale();
+	m_Level = level;
+	m_SettleFrames = m_Settings.SettleFrames;
+	m_AveragedFrames = 0;
+	m_AverageFrameTime = 0.0f;
+	return GetScale();
+}
+
+void ResolutionController::Reset()
+{
+	m_Level = m_Settings.Steps;
+	m_SettleFrames = m_Settings.SettleFrames;
+	m_AveragedFrames = 0;
+	m_AverageFrameTime = 0.0f;
+}
+
+void ResolutionController::GetRenderSize(float scale, uint32_t width, uint32_t height, uint32_t* renderWidth, uint32_t* renderHeight)
+{
+	*renderWidth = std::clamp((uint32_t)(width * scale + 0.5f), 1u, width);
+	*renderHeight = std::clamp((uint32_t)(height * scale + 0.5f), 1u, height);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+// Frame budget and how quickly the render resolution may follow it
+struct ResolutionSettings
+{
+	float TargetFrameTime = 1000.0f / 60.0f; // milliseconds
+	float MinScale = 0.5f;
+	uint32_t Steps = 20; // scale granularity
+	float Headroom = 0.85f;
+	uint32_t SettleFrames = 8;
+	float Smoothing = 0.2f; // weight of the newest timing in the running average
+};
+
+// Picks the internal render resolution from measured frame times so frames stay within a budget. Ray cost grows
+// with the pixel count, so the frame time is modelled as proportional to the square of the scale. The scale moves
+// in steps of 1 / Steps: down as soon as the smoothed time is over budget, up only once it is below Headroom times
+// the budget, and after every change the next SettleFrames timings are skipped, they still include frames in
+// flight at the old resolution. Both directions aim at Headroom times the budget, inside the band, and decide only
+// once the average spans 1 / Smoothing timings. Portable, the application feeds it its frame times, see
+// Tests/ResolutionControllerTest.cpp for a simulated load.
+class ResolutionController
+{
+public:
+	explicit ResolutionController(const ResolutionSettings& settings = ResolutionSettings());
+	// Takes the last frame's time in milliseconds, returns the scale for the next frame
+	float Update(float frameTime);
+	// Back to full resolution, for when timings stop being comparable
+	void Reset();
+	inline float GetScale() const { return (float)m_Level / m_Settings.Steps; }
+	inline const ResolutionSettings& GetSettings() const { return m_Settings; }
+	// Keeps the aspect ratio, at least one pixel
+	static void GetRenderSize(float scale, uint32_t width, uint32_t height, uint32_t* renderWidth, uint32_t* renderHeight);
+private:
+	ResolutionSettings m_Settings;
+	uint32_t m_MinLevel;
+	uint32_t m_Level; // scale in steps
+	uint32_t m_SettleFrames = 0;
+	uint32_t m_AveragedFrames = 0; // timings in the average since the last change
+	float m_AverageFrameTime = 0.0f;
+};
@@ -0,0 +1,87 @@
+#include "RingAllocator.h"
+#include <cassert>
+
+RingAllocator::RingAllocator(uint64_t size)
+{
+	Reset(size);
+}
+
+void RingAllocator::Reset(uint64_t size)
+{
+	m_Size = size;
+	m_Head = 0;
+	m_Tail = 0;
+	m_UsedSize = 0;
+	m_CurrentFrameSize = 0;
+	m_Frames.clear();
+}
+
+// Returns InvalidOffset when the ring has no room left before the oldest frame still in flight
+uint64_t RingAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+	if (m_UsedSize + size > m_Size)
+		return InvalidOffset;
+	if (m_UsedSize == 0)
+	{
+		// Nothing in flight, start over at the beginning for the largest contiguous range
+		m_Head = 0;
+		m_Tail = 0;
+	}
+	else if (m_Head == m_Tail)
+	{
+		// Head caught up with the tail, the whole ring is in use
+		return InvalidOffset;
+	}
+	const uint64_t aligned = (m_Head + alignment - 1) & ~(alignment - 1);
+	uint64_t offset = InvalidOffset;
+	uint64_t consumed = 0;
+	if (m_Head >= m_Tail)
+	{
+		// Free space is [head, size) followed by [0, tail)
+		if (aligned + size <= m_Size)
+		{
+			offset = aligned;
+			consumed = aligned + size - m_Head;
+		}
+		else if (size <= m_Tail)
+		{
+			// The unused end of the ring belongs to this frame as well
+			offset = 0;
+			consumed = m_Size - m_Head + size;
+		}
+	}
+	else if (aligned + size <= m_Tail)
+	{
+		offset = aligned;
+		consumed = aligned + size - m_Head;
+	}
+	if (offset == InvalidOffset)
+		return InvalidOffset;
+
+	// Alignment padding is counted as used, so head == tail with used memory means the ring is full
+	m_Head = offset + size;
+	if (m_Head == m_Size)
+		m_Head = 0;
+	m_UsedSize += consumed;
+	m_CurrentFrameSize += consumed;
+	return offset;
+}
+
+void RingAllocator::EndFrame(uint64_t fenceValue)
+{
+	m_Frames.push_back({ m_Head, m_CurrentFrameSize, fenceValue });
+	m_CurrentFrameSize = 0;
+}
+
+void RingAllocator::Retire(uint64_t completedFenceValue)
+{
+	while (!m_Frames.empty() && m_Frames.front().FenceValue <= completedFenceValue)
+	{
+		// An empty frame may end before a restart at offset 0 and must not move the tail
+		if (m_Frames.front().Size != 0)
+			m_Tail = m_Frames.front().End;
+		m_UsedSize -= m_Frames.front().Size;
+		m_Frames.pop_front();
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Linear allocator over a circular range of offsets. Allocations made between two EndFrame calls form
+// a frame region that is reclaimed as a whole once the fence value it was closed with has completed.
+// Only offsets are managed, so the logic can be driven by a simulated fence.
+class RingAllocator
+{
+public:
+	static constexpr uint64_t InvalidOffset = ~0ULL;
+	explicit RingAllocator(uint64_t size = 0);
+	void Reset(uint64_t size);
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+	void EndFrame(uint64_t fenceValue);
+	void Retire(uint64_t completedFenceValue);
+	inline uint64_t GetSize() const { return m_Size; }
+	inline uint64_t GetUsedSize() const { return m_UsedSize; }
+	inline uint64_t GetCurrentFrameSize() const { return m_CurrentFrameSize; }
+	inline size_t GetFramesInFlight() const { return m_Frames.size(); }
+private:
+	struct FrameRegion
+	{
+		uint64_t End;
+		uint64_t Size;
+		uint64_t FenceValue;
+	};
+	uint64_t m_Size = 0;
+	uint64_t m_Head = 0;
+	uint64_t m_Tail = 0;
+	uint64_t m_UsedSize = 0;
+	uint64_t m_CurrentFrameSize = 0;
+	std::deque<FrameRegion> m_Frames;
+};
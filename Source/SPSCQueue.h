@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded single-producer/single-consumer ring. Push is only called from one thread and Pop from one other thread;
+// neither side takes a lock. Head and tail live on separate cache lines, and each side caches the other's index
+// so the shared line is only read when the cached value says the ring looks full or empty.
+template<typename T, size_t Capacity>
+class SPSCQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of two");
+public:
+	bool Push(const T& value)
+	{
+		const size_t tail = m_Tail.load(std::memory_order_relaxed);
+		if (tail - m_CachedHead == Capacity)
+		{
+			m_CachedHead = m_Head.load(std::memory_order_acquire);
+			if (tail - m_CachedHead == Capacity)
+				return false;
+		}
+		m_Items[tail & (Capacity - 1)] = value;
+		m_Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+	bool Pop(T* value)
+	{
+		const size_t head = m_Head.load(std::memory_order_relaxed);
+		if (head == m_CachedTail)
+		{
+			m_CachedTail = m_Tail.load(std::memory_order_acquire);
+			if (head == m_CachedTail)
+				return false;
+		}
+		*value = m_Items[head & (Capacity - 1)];
+		m_Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+	static constexpr size_t GetCapacity() { return Capacity; }
+private:
+	static constexpr size_t CacheLine = 64;
+	alignas(CacheLine) std::atomic<size_t> m_Tail = 0;
+	size_t m_CachedHead = 0; // producer side
+	alignas(CacheLine) std::atomic<size_t> m_Head = 0;
+	size_t m_CachedTail = 0; // consumer side
+	alignas(CacheLine) T m_Items[Capacity];
+};
@@ -0,0 +1,645 @@
+#include "SceneFile.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+// Binary layout, little endian:
+//   magic, version, camera (position, pitch, heading, fov)
+//   mesh count, per mesh: name, vertex count, triangle count, positions, indices, PrimitiveAttributes per triangle
+//   curve count, per curve: name, extrapolation, key count, times, values (double)
+//   animation count, per animation: name, step count, per step: type, vector, amount, curve
+//   instance count (64 bit), SceneInstance records
+// Names are a 32-bit length followed by the characters.
+static const char BinaryMagic[8] = { 'R', 'T', 'X', 'S', 'C', 'E', 'N', 'E' };
+static constexpr uint32_t BinaryVersion = 1;
+static constexpr size_t InstanceBatch = 65536;
+
+double AnimationCurve::Evaluate(double time) const
+{
+	if (Times.empty())
+		return 0.0;
+	if (Times.size() == 1)
+		return Values[0];
+	const double first = Times.front();
+	const double last = Times.back();
+	if (Mode == ExtrapolateCycle && last > first)
+	{
+		time = first + std::fmod(time - first, last - first);
+		if (time < first)
+			time += last - first;
+	}
+	else if (Mode == ExtrapolateClamp)
+	{
+		time = std::min(std::max(time, first), last);
+	}
+	// The segment containing time, the first or last one when extrapolating
+	const size_t upper = std::upper_bound(Times.begin(), Times.end(), time) - Times.begin();
+	const size_t segment = std::min(std::max(upper, (size_t)1), Times.size() - 1) - 1;
+	const double duration = Times[segment + 1] - Times[segment];
+	if (duration <= 0.0)
+		return Values[segment + 1];
+	return Values[segment] + (time - Times[segment]) * ((Values[segment + 1] - Values[segment]) / duration);
+}
+
+Transform3x4 TransformStep::Evaluate(const std::vector<AnimationCurve>& curves, double time) const
+{
+	const float factor = Curve == NoCurve ? 1.0f : (float)curves[Curve].Evaluate(time);
+	const Float3 vector = Type == StepRotate ? Vector : Vector * factor;
+	switch (Type)
+	{
+	case StepTranslate:
+		return TransformTranslation(vector.x, vector.y, vector.z);
+	case StepScale:
+		return TransformScale(vector.x, vector.y, vector.z);
+	default:
+		// The common axis gets the exact rotation the code built scenes use
+		if (vector.x == 0.0f && vector.y == 0.0f && vector.z == 1.0f)
+			return TransformRotationZ(Amount * factor);
+		return TransformRotationAxis(vector, Amount * factor);
+	}
+}
+
+Transform3x4 SceneAssets::GetInstanceTransform(const SceneInstance& instance, double time) const
+{
+	if (instance.Animation == SceneInstance::NoAnimation)
+		return instance.Transform;
+	const std::vector<TransformStep>& steps = Animations[instance.Animation].Steps;
+	if (steps.empty())
+		return instance.Transform;
+	Transform3x4 animation = steps[0].Evaluate(Curves, time);
+	for (size_t i = 1; i < steps.size(); i++)
+	{
+		animation = TransformConcatenate(animation, steps[i].Evaluate(Curves, time));
+	}
+	return TransformConcatenate(instance.Transform, animation);
+}
+
+void SceneContent::AddMeshes(CpuScene* scene) const
+{
+	std::vector<CpuScene::PrimitiveAttributes> attributes;
+	for (uint32_t i = 0; i < (uint32_t)Assets.Meshes.size(); i++)
+	{
+		const SceneMesh& mesh = Assets.Meshes[i];
+		scene->AddMesh(i, mesh.Positions, mesh.Indices);
+		attributes.insert(attributes.end(), mesh.Attributes.begin(), mesh.Attributes.end());
+	}
+	scene->SetPrimitiveAttributes(attributes);
+}
+
+void SceneContent::AddInstances(CpuScene* scene, double time) const
+{
+	std::vector<uint32_t> firstPrimitives;
+	uint32_t primitiveCount = 0;
+	for (const SceneMesh& mesh : Assets.Meshes)
+	{
+		firstPrimitives.push_back(primitiveCount);
+		primitiveCount += (uint32_t)mesh.Attributes.size();
+	}
+	scene->Reset();
+	for (const SceneInstance& instance : Instances)
+	{
+		scene->AddInstance(instance.Mesh, Assets.GetInstanceTransform(instance, time), firstPrimitives[instance.Mesh], 0);
+	}
+}
+
+void SceneReader::Open(const std::string& path)
+{
+	m_Path = path;
+	m_Stream.open(path, std::ios::binary);
+	if (!m_Stream)
+		throw std::runtime_error("Could not open " + path);
+	char magic[sizeof(BinaryMagic)] = {};
+	m_Stream.read(magic, sizeof(magic));
+	m_Binary = m_Stream.gcount() == sizeof(magic) && memcmp(magic, BinaryMagic, sizeof(magic)) == 0;
+	if (m_Binary)
+	{
+		m_Stream.seekg(0, std::ios::end);
+		m_RemainingBytes = (uint64_t)m_Stream.tellg() - sizeof(magic);
+		m_Stream.seekg(sizeof(magic));
+		ReadBinaryAssets();
+	}
+	else
+	{
+		m_Stream.clear();
+		m_Stream.seekg(0);
+		ReadTextAssets();
+	}
+	for (uint32_t i = 0; i < (uint32_t)m_Assets.Meshes.size(); i++)
+	{
+		m_MeshIndices[m_Assets.Meshes[i].Name] = i;
+	}
+	for (uint32_t i = 0; i < (uint32_t)m_Assets.Animations.size(); i++)
+	{
+		m_AnimationIndices[m_Assets.Animations[i].Name] = i;
+	}
+}
+
+size_t SceneReader::ReadInstances(SceneInstance* instances, size_t maxCount)
+{
+	size_t count = 0;
+	if (m_Binary)
+	{
+		count = (size_t)std::min<uint64_t>(maxCount, m_RemainingInstances);
+		ReadBinary(instances, count * sizeof(SceneInstance));
+		m_RemainingInstances -= count;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (instances[i].Mesh >= m_Assets.Meshes.size() || (instances[i].Animation != SceneInstance::NoAnimation && instances[i].Animation >= m_Assets.Animations.size()))
+				Fail("instance refers to a missing mesh or animation");
+		}
+		return count;
+	}
+	while (count < maxCount && (m_HasLine || ReadLine()))
+	{
+		m_HasLine = false;
+		if (ReadTextInstance(instances + count))
+			count++;
+	}
+	return count;
+}
+
+// Text format: one statement per line, tokens separated by whitespace, # starts a comment
+//   camera x y z pitch heading fov
+//   mesh name, then lines "vertex x y z" and "triangle a b c [r g b]", then end. Without a colour a triangle gets the
+//     absolute value of its normal, like the demo cube.
+//   curve name clamp|linear|cycle, then pairs of time and value
+//   animation name, then lines "translate x y z [curve]", "rotate ax ay az radians [curve]" and "scale x y z [curve]",
+//     then end
+//   instance mesh, then any of translate x y z, rotate ax ay az radians and scale x y z, then optionally animate name
+// Everything an instance refers to has to come before the first instance, which is what lets the instances stream.
+bool SceneReader::ReadLine()
+{
+	if (!std::getline(m_Stream, m_Line))
+		return false;
+	if (!m_Line.empty() && m_Line.back() == '\r')
+		m_Line.pop_back();
+	m_LinePosition = 0;
+	m_LineNumber++;
+	return true;
+}
+
+void SceneReader::SkipWhitespace()
+{
+	while (m_LinePosition < m_Line.size() && (m_Line[m_LinePosition] == ' ' || m_Line[m_LinePosition] == '\t'))
+		m_LinePosition++;
+}
+
+// False at the end of the line or at a comment
+bool SceneReader::ReadToken(std::string* token)
+{
+	SkipWhitespace();
+	if (m_LinePosition >= m_Line.size() || m_Line[m_LinePosition] == '#')
+		return false;
+	const size_t start = m_LinePosition;
+	while (m_LinePosition < m_Line.size() && m_Line[m_LinePosition] != ' ' && m_Line[m_LinePosition] != '\t' && m_Line[m_LinePosition] != '#')
+		m_LinePosition++;
+	token->assign(m_Line, start, m_LinePosition - start);
+	return true;
+}
+
+// Parsed in place, text scenes can have millions of numbers
+float SceneReader::ReadFloat()
+{
+	SkipWhitespace();
+	const char* start = m_Line.data() + m_LinePosition;
+	const char* end = m_Line.data() + m_Line.size();
+	if (start < end && *start == '+')
+		start++;
+	float value = 0.0f;
+	const std::from_chars_result result = std::from_chars(start, end, value);
+	if (result.ec != std::errc() || (result.ptr < end && *result.ptr != ' ' && *result.ptr != '\t' && *result.ptr != '#') || !std::isfinite(value))
+	{
+		std::string token;
+		if (!ReadToken(&token))
+			Fail("missing number");
+		Fail("invalid number '" + token + "'");
+	}
+	m_LinePosition = result.ptr - m_Line.data();
+	return value;
+}
+
+uint32_t SceneReader::ReadUnsigned()
+{
+	SkipWhitespace();
+	const char* start = m_Line.data() + m_LinePosition;
+	const char* end = m_Line.data() + m_Line.size();
+	uint32_t value = 0;
+	const std::from_chars_result result = std::from_chars(start, end, value);
+	if (result.ec != std::errc() || (result.ptr < end && *result.ptr != ' ' && *result.ptr != '\t' && *result.ptr != '#'))
+	{
+		std::string token;
+		if (!ReadToken(&token))
+			Fail("missing number");
+		Fail("invalid index '" + token + "'");
+	}
+	m_LinePosition = result.ptr - m_Line.data();
+	return value;
+}
+
+Float3 SceneReader::ReadFloat3()
+{
+	const float x = ReadFloat();
+	const float y = ReadFloat();
+	const float z = ReadFloat();
+	return { x, y, z };
+}
+
+uint32_t SceneReader::FindCurve(const std::string& name) const
+{
+	for (uint32_t i = 0; i < (uint32_t)m_Assets.Curves.size(); i++)
+	{
+		if (m_Assets.Curves[i].Name == name)
+			return i;
+	}
+	Fail("unknown curve '" + name + "'");
+}
+
+void SceneReader::ReadTextAssets()
+{
+	std::string keyword;
+	std::string name;
+	while (ReadLine())
+	{
+		if (!ReadToken(&keyword))
+			continue;
+		if (keyword == "instance")
+		{
+			// Left for ReadInstances
+			m_LinePosition = 0;
+			m_HasLine = true;
+			return;
+		}
+		if (keyword == "camera")
+		{
+			SceneCamera& camera = m_Assets.Camera;
+			camera.Position = ReadFloat3();
+			camera.Pitch = ReadFloat();
+			camera.Heading = ReadFloat();
+			camera.FOV = ReadFloat();
+		}
+		else if (keyword == "mesh" || keyword == "curve" || keyword == "animation")
+		{
+			if (!ReadToken(&name))
+				Fail(keyword + " needs a name");
+			if (keyword == "mesh")
+				ReadMesh(name);
+			else if (keyword == "animation")
+				ReadAnimation(name);
+			else
+			{
+				AnimationCurve curve;
+				curve.Name = name;
+				std::string mode;
+				ReadToken(&mode);
+				if (mode == "clamp")
+					curve.Mode = AnimationCurve::ExtrapolateClamp;
+				else if (mode == "linear")
+					curve.Mode = AnimationCurve::ExtrapolateLinear;
+				else if (mode == "cycle")
+					curve.Mode = AnimationCurve::ExtrapolateCycle;
+				else
+					Fail("curve extrapolation must be clamp, linear or cycle");
+				std::string token;
+				while (ReadToken(&token))
+				{
+					char* end = nullptr;
+					const double value = std::strtod(token.c_str(), &end);
+					if (*end != '\0' || !std::isfinite(value))
+						Fail("invalid number '" + token + "'");
+					if (curve.Times.size() == curve.Values.size())
+						curve.Times.push_back(value);
+					else
+						curve.Values.push_back(value);
+				}
+				if (curve.Times.empty() || curve.Times.size() != curve.Values.size())
+					Fail("curve needs pairs of time and value");
+				if (!std::is_sorted(curve.Times.begin(), curve.Times.end()))
+					Fail("curve times must ascend");
+				m_Assets.Curves.push_back(std::move(curve));
+			}
+		}
+		else
+		{
+			Fail("unknown statement '" + keyword + "'");
+		}
+	}
+}
+
+void SceneReader::ReadMesh(const std::string& name)
+{
+	SceneMesh mesh;
+	mesh.Name = name;
+	std::string keyword;
+	while (true)
+	{
+		if (!ReadLine())
+			Fail("mesh '" + name + "' has no end");
+		if (!ReadToken(&keyword))
+			continue;
+		if (keyword == "end")
+			break;
+		if (keyword == "vertex")
+		{
+			mesh.Positions.push_back(ReadFloat3());
+		}
+		else if (keyword == "triangle")
+		{
+			uint32_t indices[3];
+			for (uint32_t& index : indices)
+			{
+				index = ReadUnsigned();
+				if (index >= mesh.Positions.size())
+					Fail("triangle refers to a vertex not defined before it");
+				mesh.Indices.push_back(index);
+			}
+			const Float3 v1 = mesh.Positions[indices[0]];
+			const Float3 v2 = mesh.Positions[indices[1]];
+			const Float3 v3 = mesh.Positions[indices[2]];
+			const Float3 normal = Normalize(Cross(v2 - v1, v3 - v1));
+			CpuScene::PrimitiveAttributes primitive = {};
+			primitive.Normal = { normal.x, normal.y, normal.z, 0.0f };
+			primitive.Color = { std::fabs(normal.x), std::fabs(normal.y), std::fabs(normal.z), 1.0f };
+			const size_t position = m_LinePosition;
+			std::string token;
+			if (ReadToken(&token))
+			{
+				m_LinePosition = position;
+				const Float3 color = ReadFloat3();
+				primitive.Color = { color.x, color.y, color.z, 1.0f };
+			}
+			mesh.Attributes.push_back(primitive);
+		}
+		else
+		{
+			Fail("unknown mesh statement '" + keyword + "'");
+		}
+	}
+	if (mesh.Indices.empty())
+		Fail("mesh '" + name + "' has no triangles");
+	m_Assets.Meshes.push_back(std::move(mesh));
+}
+
+void SceneReader::ReadAnimation(const std::string& name)
+{
+	SceneAnimation animation;
+	animation.Name = name;
+	std::string keyword;
+	std::string curve;
+	while (true)
+	{
+		if (!ReadLine())
+			Fail("animation '" + name + "' has no end");
+		if (!ReadToken(&keyword))
+			continue;
+		if (keyword == "end")
+			break;
+		TransformStep step = {};
+		if (keyword == "translate")
+			step.Type = TransformStep::StepTranslate;
+		else if (keyword == "rotate")
+			step.Type = TransformStep::StepRotate;
+		else if (keyword == "scale")
+			step.Type = TransformStep::StepScale;
+		else
+			Fail("unknown animation statement '" + keyword + "'");
+		step.Vector = ReadFloat3();
+		step.Amount = step.Type == TransformStep::StepRotate ? ReadFloat() : 0.0f;
+		step.Curve = ReadToken(&curve) ? FindCurve(curve) : TransformStep::NoCurve;
+		animation.Steps.push_back(step);
+	}
+	m_Assets.Animations.push_back(std::move(animation));
+}
+
+// False for lines without a statement
+bool SceneReader::ReadTextInstance(SceneInstance* instance)
+{
+	std::string keyword;
+	if (!ReadToken(&keyword))
+		return false;
+	if (keyword != "instance")
+		Fail(keyword == "mesh" || keyword == "curve" || keyword == "animation" || keyword == "camera" ? "definitions have to come before the first instance" : "unknown statement '" + keyword + "'");
+	std::string name;
+	if (!ReadToken(&name))
+		Fail("instance needs a mesh");
+	const auto mesh = m_MeshIndices.find(name);
+	if (mesh == m_MeshIndices.end())
+		Fail("unknown mesh '" + name + "'");
+	instance->Mesh = mesh->second;
+	instance->Animation = SceneInstance::NoAnimation;
+	instance->Transform = TransformIdentity();
+	std::vector<AnimationCurve> noCurves;
+	while (ReadToken(&keyword))
+	{
+		if (keyword == "animate")
+		{
+			if (!ReadToken(&name))
+				Fail("animate needs a name");
+			const auto animation = m_AnimationIndices.find(name);
+			if (animation == m_AnimationIndices.end())
+				Fail("unknown animation '" + name + "'");
+			instance->Animation = animation->second;
+			continue;
+		}
+		TransformStep step = {};
+		if (keyword == "translate")
+			step.Type = TransformStep::StepTranslate;
+		else if (keyword == "rotate")
+			step.Type = TransformStep::StepRotate;
+		else if (keyword == "scale")
+			step.Type = TransformStep::StepScale;
+		else
+			Fail("unknown instance option '" + keyword + "'");
+		step.Vector = ReadFloat3();
+		step.Amount = step.Type == TransformStep::StepRotate ? ReadFloat() : 0.0f;
+		instance->Transform = TransformConcatenate(instance->Transform, step.Evaluate(noCurves, 0.0));
+	}
+	return true;
+}
+
+void SceneReader::ReadBinary(void* data, uint64_t size)
+{
+	if (size > m_RemainingBytes)
+		Fail("file is truncated");
+	m_Stream.read((char*)data, (std::streamsize)size);
+	if (!m_Stream)
+		Fail("could not read");
+	m_RemainingBytes -= size;
+}
+
+// Checked against the bytes left so a corrupt count cannot allocate more than the file holds
+uint32_t SceneReader::ReadBinaryCount(uint64_t elementSize)
+{
+	uint32_t count = 0;
+	ReadBinary(&count, sizeof(count));
+	if (count * elementSize > m_RemainingBytes)
+		Fail("file is truncated");
+	return count;
+}
+
+std::string SceneReader::ReadBinaryString()
+{
+	std::string text(ReadBinaryCount(1), '\0');
+	ReadBinary(text.data(), text.size());
+	return text;
+}
+
+void SceneReader::ReadBinaryAssets()
+{
+	uint32_t version = 0;
+	ReadBinary(&version, sizeof(version));
+	if (version != BinaryVersion)
+		Fail("unsupported version " + std::to_string(version));
+	SceneCamera& camera = m_Assets.Camera;
+	ReadBinary(&camera.Position, sizeof(camera.Position));
+	ReadBinary(&camera.Pitch, sizeof(camera.Pitch));
+	ReadBinary(&camera.Heading, sizeof(camera.Heading));
+	ReadBinary(&camera.FOV, sizeof(camera.FOV));
+
+	m_Assets.Meshes.resize(ReadBinaryCount(1));
+	for (SceneMesh& mesh : m_Assets.Meshes)
+	{
+		mesh.Name = ReadBinaryString();
+		mesh.Positions.resize(ReadBinaryCount(sizeof(Float3)));
+		const uint32_t triangleCount = ReadBinaryCount(3 * sizeof(uint32_t) + sizeof(CpuScene::PrimitiveAttributes));
+		mesh.Indices.resize((size_t)triangleCount * 3);
+		mesh.Attributes.resize(triangleCount);
+		ReadBinary(mesh.Positions.data(), mesh.Positions.size() * sizeof(Float3));
+		ReadBinary(mesh.Indices.data(), mesh.Indices.size() * sizeof(uint32_t));
+		ReadBinary(mesh.Attributes.data(), mesh.Attributes.size() * sizeof(CpuScene::PrimitiveAttributes));
+		for (uint32_t index : mesh.Indices)
+		{
+			if (index >= mesh.Positions.size())
+				Fail("mesh '" + mesh.Name + "' refers to a missing vertex");
+		}
+	}
+
+	m_Assets.Curves.resize(ReadBinaryCount(1));
+	for (AnimationCurve& curve : m_Assets.Curves)
+	{
+		curve.Name = ReadBinaryString();
+		ReadBinary(&curve.Mode, sizeof(curve.Mode));
+		curve.Times.resize(ReadBinaryCount(2 * sizeof(double)));
+		curve.Values.resize(curve.Times.size());
+		ReadBinary(curve.Times.data(), curve.Times.size() * sizeof(double));
+		ReadBinary(curve.Values.data(), curve.Values.size() * sizeof(double));
+		if (curve.Mode > AnimationCurve::ExtrapolateCycle || !std::is_sorted(curve.Times.begin(), curve.Times.end()))
+			Fail("invalid curve '" + curve.Name + "'");
+	}
+
+	m_Assets.Animations.resize(ReadBinaryCount(1));
+	for (SceneAnimation& animation : m_Assets.Animations)
+	{
+		animation.Name = ReadBinaryString();
+		animation.Steps.resize(ReadBinaryCount(24));
+		for (TransformStep& step : animation.Steps)
+		{
+			ReadBinary(&step.Type, sizeof(step.Type));
+			ReadBinary(&step.Vector, sizeof(step.Vector));
+			ReadBinary(&step.Amount, sizeof(step.Amount));
+			ReadBinary(&step.Curve, sizeof(step.Curve));
+			if (step.Type > TransformStep::StepScale || (step.Curve != TransformStep::NoCurve && step.Curve >= m_Assets.Curves.size()))
+				Fail("invalid step in animation '" + animation.Name + "'");
+		}
+	}
+
+	ReadBinary(&m_RemainingInstances, sizeof(m_RemainingInstances));
+	if (m_RemainingInstances > m_RemainingBytes / sizeof(SceneInstance))
+		Fail("file is truncated");
+}
+
+void SceneReader::Fail(const std::string& message) const
+{
+	if (m_Binary)
+		throw std::runtime_error(m_Path + ": " + message);
+	throw std::runtime_error(m_Path + "(" + std::to_string(m_LineNumber) + "): " + message);
+}
+
+namespace SceneFile
+{
+	void Load(const std::string& path, SceneContent* content)
+	{
+		SceneReader reader;
+		reader.Open(path);
+		content->Assets = reader.GetAssets();
+		content->Instances.clear();
+		size_t count = 0;
+		while (true)
+		{
+			content->Instances.resize(count + InstanceBatch);
+			const size_t read = reader.ReadInstances(content->Instances.data() + count, InstanceBatch);
+			count += read;
+			if (read == 0)
+				break;
+		}
+		content->Instances.resize(count);
+	}
+
+	void ConvertToBinary(const std::string& input, const std::string& output)
+	{
+		SceneReader reader;
+		reader.Open(input);
+		const SceneAssets& assets = reader.GetAssets();
+		std::ofstream stream(output, std::ios::binary | std::ios::trunc);
+		auto Write = [&](const void* data, size_t size) { stream.write((const char*)data, size); };
+		auto WriteCount = [&](size_t count) { const uint32_t value = (uint32_t)count; Write(&value, sizeof(value)); };
+		auto WriteString = [&](const std::string& text) { WriteCount(text.size()); Write(text.data(), text.size()); };
+
+		Write(BinaryMagic, sizeof(BinaryMagic));
+		Write(&BinaryVersion, sizeof(BinaryVersion));
+		Write(&assets.Camera.Position, sizeof(assets.Camera.Position));
+		Write(&assets.Camera.Pitch, sizeof(assets.Camera.Pitch));
+		Write(&assets.Camera.Heading, sizeof(assets.Camera.Heading));
+		Write(&assets.Camera.FOV, sizeof(assets.Camera.FOV));
+		WriteCount(assets.Meshes.size());
+		for (const SceneMesh& mesh : assets.Meshes)
+		{
+			WriteString(mesh.Name);
+			WriteCount(mesh.Positions.size());
+			WriteCount(mesh.Attributes.size());
+			Write(mesh.Positions.data(), mesh.Positions.size() * sizeof(Float3));
+			Write(mesh.Indices.data(), mesh.Indices.size() * sizeof(uint32_t));
+			Write(mesh.Attributes.data(), mesh.Attributes.size() * sizeof(CpuScene::PrimitiveAttributes));
+		}
+		WriteCount(assets.Curves.size());
+		for (const AnimationCurve& curve : assets.Curves)
+		{
+			WriteString(curve.Name);
+			Write(&curve.Mode, sizeof(curve.Mode));
+			WriteCount(curve.Times.size());
+			Write(curve.Times.data(), curve.Times.size() * sizeof(double));
+			Write(curve.Values.data(), curve.Values.size() * sizeof(double));
+		}
+		WriteCount(assets.Animations.size());
+		for (const SceneAnimation& animation : assets.Animations)
+		{
+			WriteString(animation.Name);
+			WriteCount(animation.Steps.size());
+			for (const TransformStep& step : animation.Steps)
+			{
+				Write(&step.Type, sizeof(step.Type));
+				Write(&step.Vector, sizeof(step.Vector));
+				Write(&step.Amount, sizeof(step.Amount));
+				Write(&step.Curve, sizeof(step.Curve));
+			}
+		}
+
+		// The count is only known at the end of a text file, so it is patched in afterwards
+		const std::streampos countPosition = stream.tellp();
+		uint64_t instanceCount = 0;
+		Write(&instanceCount, sizeof(instanceCount));
+		std::vector<SceneInstance> batch(InstanceBatch);
+		while (const size_t read = reader.ReadInstances(batch.data(), batch.size()))
+		{
+			Write(batch.data(), read * sizeof(SceneInstance));
+			instanceCount += read;
+		}
+		stream.seekp(countPosition);
+		Write(&instanceCount, sizeof(instanceCount));
+		stream.close();
+		if (stream.fail())
+			throw std::runtime_error("Could not write " + output);
+	}
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CpuMath.h"
+#include "CpuScene.h"
+
+// Scalar keyframes, linear in between. Times and values are double so long running clocks keep their precision.
+struct AnimationCurve
+{
+	enum Extrapolation : uint32_t
+	{
+		ExtrapolateClamp, // holds the first and last value
+		ExtrapolateLinear, // continues the slope of the first and last segment, for endless rotations
+		ExtrapolateCycle // repeats the keys
+	};
+	std::string Name;
+	Extrapolation Mode = ExtrapolateClamp;
+	std::vector<double> Times; // ascending
+	std::vector<double> Values;
+	double Evaluate(double time) const;
+};
+
+// One step of a transform, the steps of a list apply in order like TransformConcatenate
+struct TransformStep
+{
+	static constexpr uint32_t NoCurve = 0xFFFFFFFF;
+	enum Operation : uint32_t
+	{
+		StepTranslate, // by Vector
+		StepRotate, // around the axis Vector by Amount radians
+		StepScale // by Vector per axis
+	};
+	Operation Type;
+	Float3 Vector;
+	float Amount;
+	uint32_t Curve = NoCurve; // when set, Amount for rotations and Vector for the others are multiplied by the curve's value
+	Transform3x4 Evaluate(const std::vector<AnimationCurve>& curves, double time) const;
+};
+
+struct SceneAnimation
+{
+	std::string Name;
+	std::vector<TransformStep> Steps;
+};
+
+// Flat shaded triangles, one PrimitiveAttributes per triangle like the GPU structured buffer
+struct SceneMesh
+{
+	std::string Name;
+	std::vector<Float3> Positions;
+	std::vector<uint32_t> Indices;
+	std::vector<CpuScene::PrimitiveAttributes> Attributes;
+};
+
+struct SceneCamera
+{
+	Float3 Position = { -1.0f, 0.0f, 0.5f };
+	float Pitch = 0.5f;
+	float Heading = 0.0f;
+	float FOV = 1.25f;
+};
+
+// Also the binary file's instance record, so instance lists are read straight into place
+struct SceneInstance
+{
+	static constexpr uint32_t NoAnimation = 0xFFFFFFFF;
+	uint32_t Mesh;
+	uint32_t Animation;
+	Transform3x4 Transform; // placement, the animation applies after it
+};
+static_assert(sizeof(SceneInstance) == 56, "SceneInstance is stored as is in binary scene files");
+
+// Everything but the instances, which can be millions
+struct SceneAssets
+{
+	SceneCamera Camera;
+	std::vector<SceneMesh> Meshes;
+	std::vector<AnimationCurve> Curves;
+	std::vector<SceneAnimation> Animations;
+	Transform3x4 GetInstanceTransform(const SceneInstance& instance, double time) const;
+};
+
+// A scene loaded for rendering, see SceneFile::Load
+struct SceneContent
+{
+	SceneAssets Assets;
+	std::vector<SceneInstance> Instances;
+	// Meshes get their index as id, instances their mesh's first primitive as InstanceID
+	void AddMeshes(CpuScene* scene) const;
+	void AddInstances(CpuScene* scene, double time) const;
+};
+
+// Reads a text (.scene) or binary (.sceneb) scene file, told apart by the binary's magic. Open reads the assets, which
+// come first in both formats, and ReadInstances then streams the instance list in batches, so converting or loading a
+// scene never holds more than one batch of it in any intermediate form. Malformed files throw std::runtime_error
+// naming the file and, for text, the line.
+class SceneReader
+{
+public:
+	void Open(const std::string& path);
+	inline const SceneAssets& GetAssets() const { return m_Assets; }
+	// Fills up to maxCount instances and returns how many, 0 once the list is done
+	size_t ReadInstances(SceneInstance* instances, size_t maxCount);
+private:
+	bool ReadLine();
+	void SkipWhitespace();
+	bool ReadToken(std::string* token);
+	float ReadFloat();
+	uint32_t ReadUnsigned();
+	Float3 ReadFloat3();
+	uint32_t FindCurve(const std::string& name) const;
+	void ReadTextAssets();
+	void ReadMesh(const std::string& name);
+	void ReadAnimation(const std::string& name);
+	bool ReadTextInstance(SceneInstance* instance);
+	void ReadBinaryAssets();
+	void ReadBinary(void* data, uint64_t size);
+	uint32_t ReadBinaryCount(uint64_t elementSize);
+	std::string ReadBinaryString();
+	[[noreturn]] void Fail(const std::string& message) const;
+	std::ifstream m_Stream;
+	std::string m_Path;
+	SceneAssets m_Assets;
+	std::unordered_map<std::string, uint32_t> m_MeshIndices;
+	std::unordered_map<std::string, uint32_t> m_AnimationIndices;
+	bool m_Binary = false;
+	uint64_t m_RemainingInstances = 0; // binary only
+	uint64_t m_RemainingBytes = 0; // binary only, bounds the counts read from the file
+	// Text parsing works on the current line, which Open leaves at the first instance
+	std::string m_Line;
+	size_t m_LinePosition = 0;
+	uint64_t m_LineNumber = 0;
+	bool m_HasLine = false;
+};
+
+namespace SceneFile
+{
+	// Reads instances in batches straight into content->Instances
+	void Load(const std::string& path, SceneContent* content);
+	// Streams any scene file into the binary format
+	void ConvertToBinary(const std::string& input, const std::string& output);
+}
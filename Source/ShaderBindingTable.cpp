@@ -0,0 +1,99 @@
+#include "PCH.h"
+#include "ShaderBindingTable.h"
+#include "Heap.h"
+#include "DX12Utility.h"
+
+static_assert(ShaderTableLayout::IdentifierSize == D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES);
+static_assert(ShaderTableLayout::RecordAlignment == D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
+static_assert(ShaderTableLayout::TableAlignment == D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
+static_assert(ShaderTableLayout::MaxRecordStride == D3D12_RAYTRACING_MAX_SHADER_RECORD_STRIDE);
+
+ShaderBindingTable::~ShaderBindingTable()
+{
+	if (m_Resource)
+	{
+		m_Resource->Unmap(0, nullptr);
+	}
+}
+
+void ShaderBindingTable::Create(ID3D12Device11* device, HeapManager* heap, ID3D12StateObject* stateObject, const ShaderTableLayout& layout, UINT copyCount)
+{
+	m_Layout = layout;
+	ThrowIfFailed(stateObject->QueryInterface(IID_PPV_ARGS(&m_StateObjectProperties)));
+	m_Resource = heap->CreateBufferResource(device, UploadHeap, D3D12_RESOURCE_STATE_GENERIC_READ, m_Layout.GetTotalSize() * copyCount);
+	const D3D12_RANGE readRange = { 0, 0 };
+	ThrowIfFailed(m_Resource->Map(0, &readRange, (void**)&m_Mapped));
+	memset(m_Mapped, 0, m_Layout.GetTotalSize() * copyCount);
+	m_Shadow.assign(m_Layout.GetTotalSize(), 0);
+	m_Dirty.assign(copyCount, {});
+	m_DirtyFlags.assign(copyCount, std::vector<bool>(m_Layout.GetTotalRecordCount(), false));
+	m_CurrentCopy = 0;
+}
+
+// Rewriting a record with identical contents leaves it clean
+void ShaderBindingTable::SetRecord(ShaderTableLayout::Section section, UINT index, LPCWSTR exportName, const void* arguments, UINT argumentSize)
+{
+	if (index >= m_Layout.GetRecordCount(section) || argumentSize > m_Layout.GetArgumentSize(section, index))
+	{
+		throw std::runtime_error("Shader record does not match the table layout");
+	}
+	const void* identifier = m_StateObjectProperties->GetShaderIdentifier(exportName);
+	if (!identifier)
+	{
+		throw std::runtime_error("Unknown shader export in shader binding table");
+	}
+
+	UINT8 record[ShaderTableLayout::MaxRecordStride] = {};
+	const UINT stride = m_Layout.GetStride(section);
+	memcpy(record, identifier, ShaderTableLayout::IdentifierSize);
+	if (argumentSize)
+	{
+		memcpy(record + ShaderTableLayout::IdentifierSize, arguments, argumentSize);
+	}
+	const UINT64 offset = m_Layout.GetRecordOffset(section, index);
+	if (memcmp(&m_Shadow[offset], record, stride) == 0)
+		return;
+	memcpy(&m_Shadow[offset], record, stride);
+
+	const UINT key = m_Layout.GetRecordKey(section, index);
+	for (UINT copy = 0; copy < (UINT)m_Dirty.size(); copy++)
+	{
+		if (!m_DirtyFlags[copy][key])
+		{
+			m_DirtyFlags[copy][key] = true;
+			m_Dirty[copy].push_back({ offset, stride });
+		}
+	}
+}
+
+// The caller guarantees the GPU is done with this copy, i.e. the frame slot it belongs to has been waited on
+void ShaderBindingTable::Commit(UINT copyIndex)
+{
+	UINT8* destination = m_Mapped + m_Layout.GetTotalSize() * copyIndex;
+	for (const DirtyRecord& record : m_Dirty[copyIndex])
+	{
+		memcpy(destination + record.Offset, &m_Shadow[record.Offset], record.Size);
+	}
+	m_LastCommitRecordCount = (UINT)m_Dirty[copyIndex].size();
+	m_Dirty[copyIndex].clear();
+	m_DirtyFlags[copyIndex].assign(m_DirtyFlags[copyIndex].size(), false);
+	m_CurrentCopy = copyIndex;
+}
+
+// Points the dispatch at the copy of the last Commit, dimensions are left to the caller
+void ShaderBindingTable::FillDispatchDesc(D3D12_DISPATCH_RAYS_DESC* desc, UINT rayGenIndex) const
+{
+	const D3D12_GPU_VIRTUAL_ADDRESS start = m_Resource->GetGPUVirtualAddress() + m_Layout.GetTotalSize() * m_CurrentCopy;
+	desc->RayGenerationShaderRecord.StartAddress = start + m_Layout.GetRecordOffset(ShaderTableLayout::SectionRayGen, rayGenIndex);
+	desc->RayGenerationShaderRecord.SizeInBytes = m_Layout.GetStride(ShaderTableLayout::SectionRayGen);
+	desc->MissShaderTable.StartAddress = start + m_Layout.GetSectionOffset(ShaderTableLayout::SectionMiss);
+	desc->MissShaderTable.SizeInBytes = m_Layout.GetSectionSize(ShaderTableLayout::SectionMiss);
+	desc->MissShaderTable.StrideInBytes = m_Layout.GetStride(ShaderTableLayout::SectionMiss);
+	desc->HitGroupTable.StartAddress = start + m_Layout.GetSectionOffset(ShaderTableLayout::SectionHitGroup);
+	desc->HitGroupTable.SizeInBytes = m_Layout.GetSectionSize(ShaderTableLayout::SectionHitGroup);
+	desc->HitGroupTable.StrideInBytes = m_Layout.GetStride(ShaderTableLayout::SectionHitGroup);
+	const UINT callableCount = m_Layout.GetRecordCount(ShaderTableLayout::SectionCallable);
+	desc->CallableShaderTable.StartAddress = callableCount ? start + m_Layout.GetSectionOffset(ShaderTableLayout::SectionCallable) : 0;
+	desc->CallableShaderTable.SizeInBytes = m_Layout.GetSectionSize(ShaderTableLayout::SectionCallable);
+	desc->CallableShaderTable.StrideInBytes = m_Layout.GetStride(ShaderTableLayout::SectionCallable);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "PCH.h"
+#include "ShaderTableLayout.h"
+
+class HeapManager;
+
+// Shader binding table in a persistently mapped upload buffer holding one copy per frame in flight.
+// Records are written to a CPU shadow; Commit only copies the records that changed since the target copy was last updated,
+// so updating a few hit groups does not rewrite the whole table or touch a copy the GPU may still read.
+class ShaderBindingTable
+{
+public:
+	~ShaderBindingTable();
+	void Create(ID3D12Device11* device, HeapManager* heap, ID3D12StateObject* stateObject, const ShaderTableLayout& layout, UINT copyCount);
+	void SetRecord(ShaderTableLayout::Section section, UINT index, LPCWSTR exportName, const void* arguments = nullptr, UINT argumentSize = 0);
+	void Commit(UINT copyIndex);
+	void FillDispatchDesc(D3D12_DISPATCH_RAYS_DESC* desc, UINT rayGenIndex = 0) const;
+	inline const ShaderTableLayout& GetLayout() const { return m_Layout; }
+	inline UINT GetLastCommitRecordCount() const { return m_LastCommitRecordCount; }
+private:
+	ShaderTableLayout m_Layout;
+	Microsoft::WRL::ComPtr<ID3D12StateObjectProperties> m_StateObjectProperties;
+	Microsoft::WRL::ComPtr<ID3D12Resource2> m_Resource;
+	UINT8* m_Mapped = nullptr;
+	std::vector<UINT8> m_Shadow;
+	// Per copy, the records written since that copy was last committed
+	struct DirtyRecord
+	{
+		UINT64 Offset;
+		UINT Size;
+	};
+	std::vector<std::vector<DirtyRecord>> m_Dirty;
+	std::vector<std::vector<bool>> m_DirtyFlags;
+	UINT m_CurrentCopy = 0;
+	UINT m_LastCommitRecordCount = 0;
+};
@@ -0,0 +1,132 @@
+#include "ShaderCache.h"
+#include "Hash.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+// Bumped whenever the key layout changes so stale entries are never reused
+static constexpr uint32_t CacheFormatVersion = 1;
+
+static bool ReadFile(const std::filesystem::path& path, std::string* contents)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.good())
+		return false;
+	contents->assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+// Quoted includes only, resolved relative to the including file the way DXC's default handler does
+static void CollectIncludes(const std::string& source, std::vector<std::string>* includes)
+{
+	std::istringstream lines(source);
+	std::string line;
+	while (std::getline(lines, line))
+	{
+		size_t position = line.find_first_not_of(" \t");
+		if (position == std::string::npos || line[position] != '#')
+			continue;
+		position = line.find_first_not_of(" \t", position + 1);
+		if (position == std::string::npos || line.compare(position, 7, "include") != 0)
+			continue;
+		const size_t open = line.find('"', position + 7);
+		const size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+		if (close != std::string::npos)
+			includes->push_back(line.substr(open + 1, close - open - 1));
+	}
+}
+
+ShaderCache::ShaderCache(const std::filesystem::path& directory) : m_Directory(directory)
+{
+}
+
+// Walks the include graph depth first; each file is hashed once with its name so moving code between files changes the key
+uint64_t ShaderCache::ComputeKey(const std::filesystem::path& sourceFile, const std::vector<std::wstring>& arguments) const
+{
+	uint64_t hash = HashBytes(&CacheFormatVersion, sizeof(CacheFormatVersion));
+	for (const std::wstring& argument : arguments)
+	{
+		hash = HashBytes(argument.c_str(), (argument.size() + 1) * sizeof(wchar_t), hash);
+	}
+
+	std::vector<std::filesystem::path> visited;
+	std::vector<std::filesystem::path> pending = { sourceFile.lexically_normal() };
+	while (!pending.empty())
+	{
+		const std::filesystem::path path = pending.back();
+		pending.pop_back();
+		bool seen = false;
+		for (const std::filesystem::path& other : visited)
+		{
+			seen |= other == path;
+		}
+		if (seen)
+			continue;
+		visited.push_back(path);
+
+		std::string contents;
+		if (!ReadFile(path, &contents))
+		{
+			// The root must exist, a missing include is left for the compiler to report
+			if (visited.size() == 1)
+				throw std::runtime_error("Cannot find shader file: " + path.string());
+			hash = HashBytes("<missing>", 9, hash);
+			continue;
+		}
+		const std::string name = path.generic_string();
+		hash = HashBytes(name.c_str(), name.size() + 1, hash);
+		hash = HashBytes(contents.data(), contents.size(), hash);
+
+		std::vector<std::string> includes;
+		CollectIncludes(contents, &includes);
+		for (auto include = includes.rbegin(); include != includes.rend(); ++include)
+		{
+			pending.push_back((path.parent_path() / *include).lexically_normal());
+		}
+	}
+	return hash;
+}
+
+std::filesystem::path ShaderCache::GetEntryPath(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.dxil", (unsigned long long)key);
+	return m_Directory / name;
+}
+
+bool ShaderCache::Load(uint64_t key, std::vector<uint8_t>* binary) const
+{
+	std::ifstream file(GetEntryPath(key), std::ios::binary);
+	if (!file.good())
+		return false;
+	binary->assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return !binary->empty();
+}
+
+// Written under a unique temporary name and renamed, so a concurrent or interrupted writer never leaves a partial entry behind
+void ShaderCache::Store(uint64_t key, const void* binary, size_t size) const
+{
+	std::error_code error;
+	std::filesystem::create_directories(m_Directory, error);
+	const std::filesystem::path entry = GetEntryPath(key);
+	std::filesystem::path temporary = entry;
+	temporary += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file.good())
+			return;
+		file.write((const char*)binary, (std::streamsize)size);
+		if (!file.good())
+		{
+			file.close();
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+	}
+	std::filesystem::rename(temporary, entry, error);
+	if (error)
+		std::filesystem::remove(temporary, error);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// On-disk cache of compiled shader binaries. The key hashes the source, every file it #includes and the
+// compile arguments, so editing any of them misses the cache. Only files and bytes are handled, no compiler.
+class ShaderCache
+{
+public:
+	explicit ShaderCache(const std::filesystem::path& directory);
+	uint64_t ComputeKey(const std::filesystem::path& sourceFile, const std::vector<std::wstring>& arguments) const;
+	bool Load(uint64_t key, std::vector<uint8_t>* binary) const;
+	void Store(uint64_t key, const void* binary, size_t size) const;
+	std::filesystem::path GetEntryPath(uint64_t key) const;
+private:
+	std::filesystem::path m_Directory;
+};
@@ -0,0 +1,154 @@
+#include "PCH.h"
+#include "ShaderCompiler.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include "DX12Utility.h"
+
+using Microsoft::WRL::ComPtr;
+
+// DXC objects are not safe to share between threads, so every thread that compiles gets its own set
+struct DxcInstance
+{
+	ComPtr<IDxcCompiler> Compiler;
+	ComPtr<IDxcLibrary> Library;
+	ComPtr<IDxcIncludeHandler> IncludeHandler;
+};
+
+static DxcInstance& GetThreadInstance()
+{
+	thread_local DxcInstance instance;
+	if (!instance.Compiler)
+	{
+		ThrowIfFailed(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&instance.Compiler)));
+		ThrowIfFailed(DxcCreateInstance(CLSID_DxcLibrary, IID_PPV_ARGS(&instance.Library)));
+		ThrowIfFailed(instance.Library->CreateIncludeHandler(&instance.IncludeHandler));
+	}
+	return instance;
+}
+
+static std::string GetErrorString(IDxcOperationResult* result)
+{
+	ComPtr<IDxcBlobEncoding> error;
+	if (FAILED(result->GetErrorBuffer(&error)) || !error)
+	{
+		throw std::logic_error("Failed to get shader compiler error");
+	}
+	return std::string((const char*)error->GetBufferPointer(), error->GetBufferSize());
+}
+
+ShaderCompiler::ShaderCompiler() : m_Cache("ShaderCache")
+{
+}
+
+// A compiler update invalidates the cache, its version is part of every key. Builds within one minor version
+// differ in the commit count and hash, which compilers since 1.3 report.
+void ShaderCompiler::Create(const std::filesystem::path& cacheDirectory)
+{
+	m_Cache = ShaderCache(cacheDirectory);
+	m_KeyArguments.clear();
+	ComPtr<IDxcVersionInfo> versionInfo;
+	if (SUCCEEDED(GetThreadInstance().Compiler.As(&versionInfo)))
+	{
+		UINT32 major = 0;
+		UINT32 minor = 0;
+		ThrowIfFailed(versionInfo->GetVersion(&major, &minor));
+		m_KeyArguments.push_back(std::to_wstring(major) + L"." + std::to_wstring(minor));
+	}
+	ComPtr<IDxcVersionInfo2> commitInfo;
+	if (SUCCEEDED(GetThreadInstance().Compiler.As(&commitInfo)))
+	{
+		UINT32 commitCount = 0;
+		char* commitHash = nullptr;
+		ThrowIfFailed(commitInfo->GetCommitInfo(&commitCount, &commitHash));
+		std::wstring commit = std::to_wstring(commitCount) + L"-";
+		for (const char* c = commitHash; c && *c; c++)
+		{
+			commit += (wchar_t)*c;
+		}
+		CoTaskMemFree(commitHash);
+		m_KeyArguments.push_back(commit);
+	}
+}
+
+std::vector<ComPtr<IDxcBlob>> ShaderCompiler::CompileLibraries(const std::vector<std::wstring>& fileNames, ThreadPool* threadPool)
+{
+	std::vector<ComPtr<IDxcBlob>> libraries(fileNames.size());
+	threadPool->Dispatch((uint32_t)fileNames.size(), [&](uint32_t task)
+	{
+		libraries[task] = CompileLibrary(fileNames[task]);
+	});
+	return libraries;
+}
+
+ComPtr<IDxcBlob> ShaderCompiler::CompileLibrary(const std::wstring& fileName)
+{
+	return CompileShader(fileName, L"", LibraryTarget);
+}
+
+// Libraries take no entry point, pass an empty one
+ComPtr<IDxcBlob> ShaderCompiler::CompileShader(const std::wstring& fileName, LPCWSTR entryPoint, LPCWSTR target)
+{
+	PROFILE_SCOPE("Shader compile");
+	std::vector<std::wstring> keyArguments = m_KeyArguments;
+	keyArguments.push_back(entryPoint);
+	keyArguments.push_back(target);
+	const uint64_t key = m_Cache.ComputeKey(fileName, keyArguments);
+	std::vector<uint8_t> binary;
+	if (m_Cache.Load(key, &binary))
+	{
+		m_CacheHits++;
+		ComPtr<IDxcBlobEncoding> blob;
+		ThrowIfFailed(GetThreadInstance().Library->CreateBlobWithEncodingOnHeapCopy(binary.data(), (UINT32)binary.size(), 0, &blob));
+		return blob;
+	}
+	m_CacheMisses++;
+	ComPtr<IDxcBlob> shader = Compile(fileName, entryPoint, target);
+	m_Cache.Store(key, shader->GetBufferPointer(), shader->GetBufferSize());
+	return shader;
+}
+
+ComPtr<IDxcBlob> ShaderCompiler::Compile(const std::wstring& fileName, LPCWSTR entryPoint, LPCWSTR target)
+{
+	DxcInstance& dxc = GetThreadInstance();
+
+	// Open and read the file
+	std::ifstream shaderFile(fileName, std::ios::binary);
+	if (shaderFile.good() == false)
+	{
+		CStringA errmsg = "Cannot find shader file: ";
+		errmsg.Append(CStringA(fileName.c_str()));
+		throw std::logic_error(errmsg);
+	}
+	std::stringstream strStream;
+	strStream << shaderFile.rdbuf();
+	std::string sShader = strStream.str();
+
+	// Create blob from the string
+	ComPtr<IDxcBlobEncoding> textBlob;
+	ThrowIfFailed(dxc.Library->CreateBlobWithEncodingFromPinned((LPBYTE)sShader.c_str(), (uint32_t)sShader.size(), 0, &textBlob));
+
+	// Compile
+	ComPtr<IDxcOperationResult> result;
+	ThrowIfFailed(dxc.Compiler->Compile(textBlob.Get(), fileName.c_str(), entryPoint, target, nullptr, 0, nullptr, 0, dxc.IncludeHandler.Get(), &result));
+
+	// Verify the result
+	HRESULT resultCode;
+	ThrowIfFailed(result->GetStatus(&resultCode));
+	if (FAILED(resultCode))
+	{
+		throw std::logic_error("Shader Compiler Error:\n" + GetErrorString(result.Get()));
+	}
+#ifdef _DEBUG
+	{
+		const std::string warnings = GetErrorString(result.Get());
+		if (!warnings.empty())
+		{
+			OutputDebugStringA(("\n" + warnings).c_str());
+		}
+	}
+#endif
+
+	ComPtr<IDxcBlob> shader;
+	ThrowIfFailed(result->GetResult(&shader));
+	return shader;
+}
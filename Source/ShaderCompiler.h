@@ -0,0 +1,28 @@
+#pragma once
+#include "PCH.h"
+#include "ShaderCache.h"
+
+class ThreadPool;
+
+// Compiles HLSL files into DXIL libraries and compute shaders, one task per file on the thread pool with a compiler
+// instance per thread. Results are cached on disk, so a warm start only reads the binaries back.
+class ShaderCompiler
+{
+public:
+	static constexpr LPCWSTR LibraryTarget = L"lib_6_3";
+	static constexpr LPCWSTR ComputeTarget = L"cs_6_0";
+	ShaderCompiler();
+	void Create(const std::filesystem::path& cacheDirectory);
+	std::vector<Microsoft::WRL::ComPtr<IDxcBlob>> CompileLibraries(const std::vector<std::wstring>& fileNames, ThreadPool* threadPool);
+	Microsoft::WRL::ComPtr<IDxcBlob> CompileLibrary(const std::wstring& fileName);
+	Microsoft::WRL::ComPtr<IDxcBlob> CompileShader(const std::wstring& fileName, LPCWSTR entryPoint, LPCWSTR target);
+	inline UINT GetCacheHits() const { return m_CacheHits; }
+	inline UINT GetCacheMisses() const { return m_CacheMisses; }
+private:
+	Microsoft::WRL::ComPtr<IDxcBlob> Compile(const std::wstring& fileName, LPCWSTR entryPoint, LPCWSTR target);
+	ShaderCache m_Cache;
+	// Everything besides the files, entry point and target that changes the output, hashed into the cache key
+	std::vector<std::wstring> m_KeyArguments;
+	std::atomic<UINT> m_CacheHits = 0;
+	std::atomic<UINT> m_CacheMisses = 0;
+};
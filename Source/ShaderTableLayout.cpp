@@ -0,0 +1,50 @@
+#include "ShaderTableLayout.h"
+#include <stdexcept>
+
+static inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void ShaderTableLayout::Reset()
+{
+	for (SectionLayout& section : m_Sections)
+	{
+		section = {};
+	}
+	m_TotalRecordCount = 0;
+	m_TotalSize = 0;
+}
+
+// Returns the record's index within its section, offsets are valid after the next Finalize
+uint32_t ShaderTableLayout::AddRecord(Section section, uint32_t argumentSize)
+{
+	if (AlignUp(IdentifierSize + (uint64_t)argumentSize, RecordAlignment) > MaxRecordStride)
+	{
+		throw std::runtime_error("Shader record exceeds the maximum record stride");
+	}
+	m_Sections[section].ArgumentSizes.push_back(argumentSize);
+	return (uint32_t)m_Sections[section].ArgumentSizes.size() - 1;
+}
+
+// Sections are packed in enum order, each starting on a table boundary
+void ShaderTableLayout::Finalize()
+{
+	uint64_t offset = 0;
+	uint32_t key = 0;
+	for (SectionLayout& section : m_Sections)
+	{
+		uint32_t largestArguments = 0;
+		for (uint32_t argumentSize : section.ArgumentSizes)
+		{
+			largestArguments = argumentSize > largestArguments ? argumentSize : largestArguments;
+		}
+		section.Stride = section.ArgumentSizes.empty() ? 0 : (uint32_t)AlignUp(IdentifierSize + largestArguments, RecordAlignment);
+		section.Offset = AlignUp(offset, TableAlignment);
+		section.FirstKey = key;
+		offset = section.Offset + (uint64_t)section.Stride * section.ArgumentSizes.size();
+		key += (uint32_t)section.ArgumentSizes.size();
+	}
+	m_TotalRecordCount = key;
+	m_TotalSize = AlignUp(offset, TableAlignment);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Byte layout of a shader binding table with raygen, miss, hit group and callable sections.
+// Each section has its own stride, wide enough for the largest local root arguments in it.
+// Only sizes and offsets are computed, so the layout can be checked without a device.
+class ShaderTableLayout
+{
+public:
+	enum Section
+	{
+		SectionRayGen = 0,
+		SectionMiss,
+		SectionHitGroup,
+		SectionCallable,
+		SectionCount
+	};
+	static constexpr uint32_t IdentifierSize = 32; // D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES
+	static constexpr uint32_t RecordAlignment = 32; // D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT
+	static constexpr uint32_t TableAlignment = 64; // D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT
+	static constexpr uint32_t MaxRecordStride = 4096; // D3D12_RAYTRACING_MAX_SHADER_RECORD_STRIDE
+	void Reset();
+	uint32_t AddRecord(Section section, uint32_t argumentSize);
+	void Finalize();
+	inline uint32_t GetRecordCount(Section section) const { return (uint32_t)m_Sections[section].ArgumentSizes.size(); }
+	inline uint32_t GetArgumentSize(Section section, uint32_t index) const { return m_Sections[section].ArgumentSizes[index]; }
+	inline uint32_t GetStride(Section section) const { return m_Sections[section].Stride; }
+	inline uint64_t GetSectionOffset(Section section) const { return m_Sections[section].Offset; }
+	inline uint64_t GetSectionSize(Section section) const { return (uint64_t)m_Sections[section].Stride * GetRecordCount(section); }
+	inline uint64_t GetRecordOffset(Section section, uint32_t index) const { return m_Sections[section].Offset + (uint64_t)m_Sections[section].Stride * index; }
+	inline uint32_t GetRecordKey(Section section, uint32_t index) const { return m_Sections[section].FirstKey + index; }
+	inline uint32_t GetTotalRecordCount() const { return m_TotalRecordCount; }
+	inline uint64_t GetTotalSize() const { return m_TotalSize; }
+private:
+	struct SectionLayout
+	{
+		std::vector<uint32_t> ArgumentSizes;
+		uint32_t Stride = 0;
+		uint32_t FirstKey = 0;
+		uint64_t Offset = 0;
+	};
+	SectionLayout m_Sections[SectionCount];
+	uint32_t m_TotalRecordCount = 0;
+	uint64_t m_TotalSize = 0;
+};
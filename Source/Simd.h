@@ -0,0 +1,79 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Four float lanes, SSE2 where the compiler guarantees it and plain arrays otherwise,
+// so code written against it runs everywhere and vectorizes on x64
+struct SimdFloat
+{
+#ifdef SIMD_SSE2
+	__m128 v;
+#else
+	float v[4];
+#endif
+	static constexpr uint32_t Width = 4;
+};
+
+#ifdef SIMD_SSE2
+inline SimdFloat SimdSet(float value) { return { _mm_set1_ps(value) }; }
+inline SimdFloat SimdLoad(const float* p) { return { _mm_loadu_ps(p) }; }
+inline void SimdStore(float* p, SimdFloat a) { _mm_storeu_ps(p, a.v); }
+inline SimdFloat operator+(SimdFloat a, SimdFloat b) { return { _mm_add_ps(a.v, b.v) }; }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline SimdFloat operator/(SimdFloat a, SimdFloat b) { return { _mm_div_ps(a.v, b.v) }; }
+inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) { return { _mm_min_ps(a.v, b.v) }; }
+inline SimdFloat SimdMax(SimdFloat a, SimdFloat b) { return { _mm_max_ps(a.v, b.v) }; }
+inline SimdFloat SimdAbs(SimdFloat a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+// 1 where a < b, 0 elsewhere
+inline SimdFloat SimdLess(SimdFloat a, SimdFloat b) { return { _mm_and_ps(_mm_cmplt_ps(a.v, b.v), _mm_set1_ps(1.0f)) }; }
+inline SimdFloat SimdFloor(SimdFloat a)
+{
+	// Truncate, then step down where truncation rounded a negative value up
+	const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+	return { _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a.v), _mm_set1_ps(1.0f))) };
+}
+// 2^n for integral n in the normal exponent range
+inline SimdFloat SimdExp2Integer(SimdFloat n)
+{
+	return { _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n.v), _mm_set1_epi32(127)), 23)) };
+}
+#else
+inline SimdFloat SimdSet(float value) { return { { value, value, value, value } }; }
+inline SimdFloat SimdLoad(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+inline void SimdStore(float* p, SimdFloat a) { for (int i = 0; i < 4; i++) p[i] = a.v[i]; }
+#define SIMD_LANEWISE(expression) SimdFloat r; for (int i = 0; i < 4; i++) r.v[i] = expression; return r
+inline SimdFloat operator+(SimdFloat a, SimdFloat b) { SIMD_LANEWISE(a.v[i] + b.v[i]); }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b) { SIMD_LANEWISE(a.v[i] - b.v[i]); }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b) { SIMD_LANEWISE(a.v[i] * b.v[i]); }
+inline SimdFloat operator/(SimdFloat a, SimdFloat b) { SIMD_LANEWISE(a.v[i] / b.v[i]); }
+inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) { SIMD_LANEWISE(std::fmin(a.v[i], b.v[i])); }
+inline SimdFloat SimdMax(SimdFloat a, SimdFloat b) { SIMD_LANEWISE(std::fmax(a.v[i], b.v[i])); }
+inline SimdFloat SimdAbs(SimdFloat a) { SIMD_LANEWISE(std::fabs(a.v[i])); }
+inline SimdFloat SimdLess(SimdFloat a, SimdFloat b) { SIMD_LANEWISE(a.v[i] < b.v[i] ? 1.0f : 0.0f); }
+inline SimdFloat SimdFloor(SimdFloat a) { SIMD_LANEWISE(std::floor(a.v[i])); }
+inline SimdFloat SimdExp2Integer(SimdFloat n) { SIMD_LANEWISE(std::ldexp(1.0f, (int)n.v[i])); }
+#undef SIMD_LANEWISE
+#endif
+
+// e^x for x in [-87, 88], Cephes style: x = n ln2 + r with |r| <= ln2 / 2 and a degree 6 polynomial for e^r.
+// Within 2 ulp of expf, close enough to compare against the GPU's exp.
+inline SimdFloat SimdExp(SimdFloat x)
+{
+	x = SimdMax(SimdMin(x, SimdSet(88.0f)), SimdSet(-87.0f));
+	const SimdFloat n = SimdFloor(x * SimdSet(1.44269504088896341f) + SimdSet(0.5f));
+	const SimdFloat r = x - n * SimdSet(0.693359375f) + n * SimdSet(2.12194440e-4f);
+	SimdFloat p = SimdSet(1.9875691500e-4f);
+	p = p * r + SimdSet(1.3981999507e-3f);
+	p = p * r + SimdSet(8.3334519073e-3f);
+	p = p * r + SimdSet(4.1665795894e-2f);
+	p = p * r + SimdSet(1.6666665459e-1f);
+	p = p * r + SimdSet(5.0000001201e-1f);
+	p = p * r * r + r + SimdSet(1.0f);
+	return p * SimdExp2Integer(n);
+}
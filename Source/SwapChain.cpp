@@ -5,12 +5,13 @@
 SwapChain::SwapChain()
 {}
 
-void SwapChain::Create(ID3D12Device11* device, CommandQueue* commandQueue, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle, HWND hWin, UINT width, UINT height, UINT bufferCount, BOOL vsync)
+void SwapChain::Create(ID3D12Device11* device, CommandQueue* commandQueue, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle, D3D12_CPU_DESCRIPTOR_HANDLE accumulationHandle, HWND hWin, UINT width, UINT height, UINT bufferCount, BOOL vsync)
 {
 	m_CommandQueue = commandQueue;
 	m_Device = device;
 	m_SRVHandle = srvHandle;
-	m_VSync = vsync;
+	m_AccumulationHandle = accumulationHandle;
+	m_VSync = vsync != FALSE;
 	m_NumBuffers = bufferCount;
 
 	ComPtr<IDXGIFactory7> dxgiFactory = GetDXGIFactory();
@@ -49,6 +50,7 @@ void SwapChain::Create(ID3D12Device11* device, CommandQueue* commandQueue, D3D12
 
 	m_CurrentFrame = m_SwapChain->GetCurrentBackBufferIndex();
 	m_RayTracingOutput.Create(m_Device, m_BufferWidth, m_BufferHeight, m_SRVHandle);
+	m_Accumulation.Create(m_Device, m_BufferWidth, m_BufferHeight, m_AccumulationHandle, DXGI_FORMAT_R32G32B32A32_FLOAT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
 	for (UINT i = 0; i < m_NumBuffers; i++)
 	{
@@ -83,6 +85,7 @@ void SwapChain::Resize(UINT width, UINT height)
 		D3D12_RESOURCE_DESC ResourceDesc1 = m_RayTracingOutput.GetResource()->GetDesc();
 		m_CurrentFrame = m_SwapChain->GetCurrentBackBufferIndex();
 		m_RayTracingOutput.Create(m_Device, m_BufferWidth, m_BufferHeight, m_SRVHandle);
+		m_Accumulation.Create(m_Device, m_BufferWidth, m_BufferHeight, m_AccumulationHandle, DXGI_FORMAT_R32G32B32A32_FLOAT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 		for (UINT i = 0; i < m_NumBuffers; i++)
 		{
 			ThrowIfFailed(m_SwapChain->GetBuffer(i, IID_PPV_ARGS(&m_BackBuffers[i])));
@@ -96,11 +99,22 @@ void SwapChain::PrepareFrameStart(ID3D12GraphicsCommandList6* commandList)
 {
 	TransitionResource(commandList, m_BackBuffers[m_CurrentFrame].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_COPY_DEST);
 	m_RayTracingOutput.Transition(commandList, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	// Last frame's sums must be written before this frame reads them
+	m_Accumulation.UAVBarrier(commandList);
 }
 
-void SwapChain::PrepareFrameEnd(ID3D12GraphicsCommandList6* commandList)
+void SwapChain::PrepareFrameEnd(ID3D12GraphicsCommandList6* commandList, ID3D12Resource2* display)
 {
 	m_RayTracingOutput.Transition(commandList, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
-	commandList->CopyResource(m_BackBuffers[m_CurrentFrame].Get(), m_RayTracingOutput.GetResource());
+	if (display)
+	{
+		TransitionResource(commandList, display, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+		commandList->CopyResource(m_BackBuffers[m_CurrentFrame].Get(), display);
+		TransitionResource(commandList, display, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	}
+	else
+	{
+		commandList->CopyResource(m_BackBuffers[m_CurrentFrame].Get(), m_RayTracingOutput.GetResource());
+	}
 	TransitionResource(commandList, m_BackBuffers[m_CurrentFrame].Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PRESENT);
 }
@@ -9,22 +9,30 @@ class SwapChain
 {
 public:
 	SwapChain();
-	void Create(ID3D12Device11* device, CommandQueue* commandQueue, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle, HWND hWin, UINT width, UINT height, UINT bufferCount, BOOL vsync);
+	void Create(ID3D12Device11* device, CommandQueue* commandQueue, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle, D3D12_CPU_DESCRIPTOR_HANDLE accumulationHandle, HWND hWin, UINT width, UINT height, UINT bufferCount, BOOL vsync);
 	void Present();
 	void Resize(UINT width, UINT height);
 	void PrepareFrameStart(ID3D12GraphicsCommandList6* commandList);
-	void PrepareFrameEnd(ID3D12GraphicsCommandList6* commandList);
+	// Copies display to the back buffer when rendering below the back buffer size, the ray tracing output otherwise.
+	// Display is in UNORDERED_ACCESS and returns to it
+	void PrepareFrameEnd(ID3D12GraphicsCommandList6* commandList, ID3D12Resource2* display = nullptr);
 	UINT GetWidth() const { return (UINT)m_BufferWidth; }
 	UINT GetHeight() const { return (UINT)m_BufferHeight; }
+	inline ID3D12Resource2* GetAccumulation() { return m_Accumulation.GetResource(); }
+	// In UNORDERED_ACCESS until PrepareFrameEnd
+	inline ID3D12Resource2* GetRayTracingOutput() { return m_RayTracingOutput.GetResource(); }
 	inline float GetAspectRatio() const { return (float)m_BufferWidth / (float)m_BufferHeight; };
-	BOOL m_VSync;
+	std::atomic<bool> m_VSync = true; // toggled from the message thread
 private:
 	Microsoft::WRL::ComPtr<IDXGISwapChain4> m_SwapChain;
 	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource2>> m_BackBuffers;
 	OutputBuffer m_RayTracingOutput;
+	// Running per-pixel sums for progressive accumulation, stays in UNORDERED_ACCESS
+	OutputBuffer m_Accumulation;
 	CommandQueue* m_CommandQueue = nullptr;
 	ID3D12Device11* m_Device = nullptr;
 	D3D12_CPU_DESCRIPTOR_HANDLE m_SRVHandle = {};
+	D3D12_CPU_DESCRIPTOR_HANDLE m_AccumulationHandle = {};
 	const float m_ClearColor[4] = {};
 	UINT m_BufferWidth = 0;
 	UINT m_BufferHeight = 0;
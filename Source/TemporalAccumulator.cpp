@@ -0,0 +1,146 @@
+#include "PCH.h"
+#include "TemporalAccumulator.h"
+#include "ShaderCompiler.h"
+#include "RootSignatureGenerator.h"
+#include "DX12Utility.h"
+
+using Microsoft::WRL::ComPtr;
+
+static constexpr UINT ThreadGroupSize = 8; // numthreads in TemporalAccumulate.hlsl
+static constexpr DXGI_FORMAT HistoryFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
+
+// Root constants, same layout as TemporalConstants in TemporalAccumulate.hlsl
+struct TemporalConstants
+{
+	UINT PriorMode;
+	UINT Width;
+	UINT Height;
+};
+
+// Root parameter order of the temporal root signature, the tables are u0 to u8 in TemporalAccumulate.hlsl
+enum TemporalParameter
+{
+	ParameterConstants,
+	ParameterAccumulation,
+	ParameterNormalDepth,
+	ParameterMotion,
+	ParameterPrior,
+	ParameterHistory,
+	ParameterHistoryNormalDepth,
+	ParameterResult,
+	ParameterResultNormalDepth,
+	ParameterOutput,
+	ParameterCount
+};
+
+void TemporalAccumulator::Create(ID3D12Device11* device, DescriptorHeap* descriptorHeap, ShaderCompiler* shaderCompiler, UINT width, UINT height)
+{
+	m_Device = device;
+	m_DescriptorHeap = descriptorHeap;
+	m_MotionDescriptor = descriptorHeap->AllocatePersistent();
+	m_PriorDescriptor = descriptorHeap->AllocatePersistent();
+	for (UINT i = 0; i < 2; i++)
+	{
+		m_HistoryDescriptors[i] = descriptorHeap->AllocatePersistent();
+		m_HistoryNormalDepthDescriptors[i] = descriptorHeap->AllocatePersistent();
+	}
+	CreatePipeline(shaderCompiler);
+	Resize(width, height);
+}
+
+void TemporalAccumulator::CreatePipeline(ShaderCompiler* shaderCompiler)
+{
+	D3D12_ROOT_PARAMETER constants = {};
+	constants.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+	constants.Constants.ShaderRegister = 0;
+	constants.Constants.RegisterSpace = 0;
+	constants.Constants.Num32BitValues = sizeof(TemporalConstants) / 4;
+	constants.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+	// One single-entry UAV table per texture, so the histories can swap roles every frame
+	D3D12_DESCRIPTOR_RANGE ranges[ParameterCount - 1] = {};
+	RootSignatureGenerator rootSignatureGenerator(m_Device);
+	rootSignatureGenerator.AddParameter(constants);
+	for (UINT i = 0; i < ParameterCount - 1; i++)
+	{
+		ranges[i].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+		ranges[i].NumDescriptors = 1;
+		ranges[i].BaseShaderRegister = i;
+		ranges[i].RegisterSpace = 0;
+		ranges[i].OffsetInDescriptorsFromTableStart = 0;
+
+		D3D12_ROOT_PARAMETER table = {};
+		table.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+		table.DescriptorTable.NumDescriptorRanges = 1;
+		table.DescriptorTable.pDescriptorRanges = &ranges[i];
+		table.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		rootSignatureGenerator.AddParameter(table);
+	}
+	m_RootSignature = rootSignatureGenerator.Generate();
+
+	ComPtr<IDxcBlob> shader = shaderCompiler->CompileShader(L"Shaders/TemporalAccumulate.hlsl", L"TemporalAccumulate", ShaderCompiler::ComputeTarget);
+	D3D12_COMPUTE_PIPELINE_STATE_DESC pipelineDesc = {};
+	pipelineDesc.pRootSignature = m_RootSignature.Get();
+	pipelineDesc.CS = { shader->GetBufferPointer(), shader->GetBufferSize() };
+	ThrowIfFailed(m_Device->CreateComputePipelineState(&pipelineDesc, IID_PPV_ARGS(&m_PipelineState)));
+}
+
+void TemporalAccumulator::Resize(UINT width, UINT height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+	m_Width = width;
+	m_Height = height;
+	m_Motion.Create(m_Device, width, height, m_DescriptorHeap->GetCPUHandle(m_MotionDescriptor), HistoryFormat, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_Prior.Create(m_Device, width, height, m_DescriptorHeap->GetCPUHandle(m_PriorDescriptor), HistoryFormat, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	for (UINT i = 0; i < 2; i++)
+	{
+		m_History[i].Create(m_Device, width, height, m_DescriptorHeap->GetCPUHandle(m_HistoryDescriptors[i]), HistoryFormat, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		m_HistoryNormalDepth[i].Create(m_Device, width, height, m_DescriptorHeap->GetCPUHandle(m_HistoryNormalDepthDescriptors[i]), HistoryFormat, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	}
+	m_HistoryValid = false;
+}
+
+void TemporalAccumulator::Record(ID3D12GraphicsCommandList6* commandList, UINT sampleIndex, UINT width, UINT height, D3D12_GPU_DESCRIPTOR_HANDLE accumulation, D3D12_GPU_DESCRIPTOR_HANDLE normalDepth, D3D12_GPU_DESCRIPTOR_HANDLE output)
+{
+	// Reads what the ray dispatch wrote
+	D3D12_RESOURCE_BARRIER barrier = {};
+	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+	barrier.UAV.pResource = nullptr;
+	commandList->ResourceBarrier(1, &barrier);
+
+	// Motion vectors do not account for a change of render resolution
+	if (width != m_RenderWidth || height != m_RenderHeight)
+	{
+		m_RenderWidth = width;
+		m_RenderHeight = height;
+		m_HistoryValid = false;
+	}
+	const UINT previous = m_Current;
+	m_Current = 1 - m_Current;
+	const TemporalConstants constants = { TemporalReprojection::GetPriorMode(m_HistoryValid, sampleIndex), width, height };
+	commandList->SetComputeRootSignature(m_RootSignature.Get());
+	commandList->SetPipelineState(m_PipelineState.Get());
+	commandList->SetComputeRoot32BitConstants(ParameterConstants, sizeof(constants) / 4, &constants, 0);
+	commandList->SetComputeRootDescriptorTable(ParameterAccumulation, accumulation);
+	commandList->SetComputeRootDescriptorTable(ParameterNormalDepth, normalDepth);
+	commandList->SetComputeRootDescriptorTable(ParameterMotion, m_DescriptorHeap->GetGPUHandle(m_MotionDescriptor));
+	commandList->SetComputeRootDescriptorTable(ParameterPrior, m_DescriptorHeap->GetGPUHandle(m_PriorDescriptor));
+	commandList->SetComputeRootDescriptorTable(ParameterHistory, m_DescriptorHeap->GetGPUHandle(m_HistoryDescriptors[previous]));
+	commandList->SetComputeRootDescriptorTable(ParameterHistoryNormalDepth, m_DescriptorHeap->GetGPUHandle(m_HistoryNormalDepthDescriptors[previous]));
+	commandList->SetComputeRootDescriptorTable(ParameterResult, m_DescriptorHeap->GetGPUHandle(m_HistoryDescriptors[m_Current]));
+	commandList->SetComputeRootDescriptorTable(ParameterResultNormalDepth, m_DescriptorHeap->GetGPUHandle(m_HistoryNormalDepthDescriptors[m_Current]));
+	commandList->SetComputeRootDescriptorTable(ParameterOutput, output);
+	commandList->Dispatch((width + ThreadGroupSize - 1) / ThreadGroupSize, (height + ThreadGroupSize - 1) / ThreadGroupSize, 1);
+	m_HistoryValid = true;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE TemporalAccumulator::GetMotionDescriptor()
+{
+	return m_DescriptorHeap->GetGPUHandle(m_MotionDescriptor);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE TemporalAccumulator::GetResultDescriptor()
+{
+	return m_DescriptorHeap->GetGPUHandle(m_HistoryDescriptors[m_Current]);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "PCH.h"
+#include "OutputBuffer.h"
+#include "DescriptorHeap.h"
+#include "TemporalReprojection.h"
+
+class ShaderCompiler;
+
+// Temporal accumulation on the GPU: one compute dispatch after the ray dispatch, see TemporalAccumulate.hlsl.
+// Owns the motion vectors RayGen writes, the prior and the two history textures the frames alternate between.
+class TemporalAccumulator
+{
+public:
+	void Create(ID3D12Device11* device, DescriptorHeap* descriptorHeap, ShaderCompiler* shaderCompiler, UINT width, UINT height);
+	// The caller has flushed the queue, like SwapChain::Resize. Drops the history
+	void Resize(UINT width, UINT height);
+	// For frames the pass was skipped, the next one starts without a prior
+	inline void InvalidateHistory() { m_HistoryValid = false; }
+	// Accumulation, normal and depth and output are in UNORDERED_ACCESS, the descriptor heap is already set on the list.
+	// Works on the top left width by height pixels, the render resolution; a new one drops the history
+	void Record(ID3D12GraphicsCommandList6* commandList, UINT sampleIndex, UINT width, UINT height, D3D12_GPU_DESCRIPTOR_HANDLE accumulation, D3D12_GPU_DESCRIPTOR_HANDLE normalDepth, D3D12_GPU_DESCRIPTOR_HANDLE output);
+	D3D12_GPU_DESCRIPTOR_HANDLE GetMotionDescriptor();
+	// What the last Record wrote, in the accumulation layout
+	D3D12_GPU_DESCRIPTOR_HANDLE GetResultDescriptor();
+	inline ID3D12Resource2* GetResult() { return m_History[m_Current].GetResource(); }
+private:
+	void CreatePipeline(ShaderCompiler* shaderCompiler);
+	ID3D12Device11* m_Device = nullptr;
+	DescriptorHeap* m_DescriptorHeap = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_RootSignature;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_PipelineState;
+	OutputBuffer m_Motion;
+	OutputBuffer m_Prior;
+	OutputBuffer m_History[2];
+	OutputBuffer m_HistoryNormalDepth[2];
+	DescriptorRange m_MotionDescriptor;
+	DescriptorRange m_PriorDescriptor;
+	DescriptorRange m_HistoryDescriptors[2];
+	DescriptorRange m_HistoryNormalDepthDescriptors[2];
+	UINT m_Current = 0; // history written by the last Record
+	bool m_HistoryValid = false;
+	UINT m_Width = 0;
+	UINT m_Height = 0;
+	UINT m_RenderWidth = 0; // of the history
+	UINT m_RenderHeight = 0;
+};
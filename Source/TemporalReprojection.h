@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include "CpuMath.h"
+
+// Temporal reuse of earlier frames, shared by CpuTemporalAccumulator and TemporalAccumulate.hlsl. When the camera or
+// an instance moves, accumulation restarts; the pixel's surface is then looked up in last frame's history through its
+// motion vector, and where the history there shows a surface still present around the pixel it seeds the new
+// accumulation as a prior worth up to MaxHistory samples, its colour clamped to the range of the current samples
+// nearby. The prior stays fixed while the view is still, so its weight fades as new samples add up.
+namespace TemporalReprojection
+{
+	// Caps how long stale shading lingers after motion, in samples (TEMPORAL_MAX_HISTORY in Common.hlsl).
+	// Longer histories smear the reflections, which do not move with the surface
+	constexpr float MaxHistory = 8.0f;
+	// History is rejected where its hit distance differs from the expected one by more than this fraction
+	constexpr float DepthTolerance = 0.05f;
+	// or where the normals are further apart than this cosine
+	constexpr float NormalThreshold = 0.9f;
+	// Motion vector of pixels without a previous position, points far outside any image
+	constexpr float NoMotion = 1.0e9f;
+	// Summed bilinear weight of the accepted taps below which the history is dropped
+	constexpr float MinWeight = 0.01f;
+
+	// What the temporal pass does with the prior this frame, TemporalConstants::priorMode in the shader
+	enum PriorMode : uint32_t
+	{
+		PriorKeep, // view unchanged, keep adding to the same prior
+		PriorReproject, // accumulation restarted, fetch the prior from last frame's history
+		PriorClear // no usable history, after a resize or when the pass was off
+	};
+
+	inline PriorMode GetPriorMode(bool historyValid, uint32_t sampleIndex)
+	{
+		if (!historyValid)
+			return PriorClear;
+		return sampleIndex == 0 ? PriorReproject : PriorKeep;
+	}
+
+	// current is a normal and hit distance of this frame, history one stored where the motion vector lands.
+	// The sky has a zero normal and the maximum distance in both.
+	inline bool IsHistoryCompatible(Float4 current, float expectedDepth, Float4 history)
+	{
+		const float normalCosine = current.x * history.x + current.y * history.y + current.z * history.z;
+		const float normalLength = current.x * current.x + current.y * current.y + current.z * current.z;
+		return std::fabs(history.w - expectedDepth) <= DepthTolerance * expectedDepth && normalCosine >= NormalThreshold * normalLength;
+	}
+}
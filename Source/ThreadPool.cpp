@@ -0,0 +1,95 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include <string>
+
+ThreadPool::ThreadPool(uint32_t workerCount)
+{
+	for (uint32_t i = 0; i < workerCount; i++)
+	{
+		m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_WorkAvailable.notify_all();
+	for (std::thread& worker : m_Workers)
+	{
+		worker.join();
+	}
+}
+
+// Leaves one hardware thread for the caller
+uint32_t ThreadPool::DefaultWorkerCount()
+{
+	const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+// Only one batch runs at a time, Dispatch must not be called from inside a task
+void ThreadPool::Dispatch(uint32_t taskCount, const std::function<void(uint32_t task)>& function)
+{
+	if (!taskCount)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Function = &function;
+		m_TaskCount = taskCount;
+		m_NextTask = 0;
+		m_ActiveWorkers = (uint32_t)m_Workers.size();
+		m_Exception = nullptr;
+		m_Batch++;
+	}
+	m_WorkAvailable.notify_all();
+	RunTasks();
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_WorkDone.wait(lock, [this] { return m_ActiveWorkers == 0; });
+	m_Function = nullptr;
+	if (m_Exception)
+		std::rethrow_exception(m_Exception);
+}
+
+void ThreadPool::WorkerLoop(uint32_t worker)
+{
+	const std::string name = "Worker " + std::to_string(worker);
+	Profiler::SetThreadName(name.c_str());
+	uint64_t batch = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkAvailable.wait(lock, [&] { return m_Stopping || m_Batch != batch; });
+			if (m_Stopping)
+				return;
+			batch = m_Batch;
+		}
+		RunTasks();
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_ActiveWorkers--;
+		}
+		m_WorkDone.notify_one();
+	}
+}
+
+void ThreadPool::RunTasks()
+{
+	for (uint32_t task = m_NextTask.fetch_add(1); task < m_TaskCount; task = m_NextTask.fetch_add(1))
+	{
+		try
+		{
+			(*m_Function)(task);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (!m_Exception)
+				m_Exception = std::current_exception();
+		}
+	}
+}
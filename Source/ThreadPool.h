@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running fork-join batches. Dispatch blocks until every task of the batch
+// has run; the calling thread executes tasks too, so a pool without workers degrades to a serial loop.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(uint32_t workerCount = DefaultWorkerCount());
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	void Dispatch(uint32_t taskCount, const std::function<void(uint32_t task)>& function);
+	inline uint32_t GetWorkerCount() const { return (uint32_t)m_Workers.size(); }
+	static uint32_t DefaultWorkerCount();
+private:
+	void WorkerLoop(uint32_t worker);
+	void RunTasks();
+	std::vector<std::thread> m_Workers;
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+	std::condition_variable m_WorkDone;
+	const std::function<void(uint32_t)>* m_Function = nullptr;
+	uint32_t m_TaskCount = 0;
+	std::atomic<uint32_t> m_NextTask = 0;
+	uint32_t m_ActiveWorkers = 0;
+	uint64_t m_Batch = 0;
+	bool m_Stopping = false;
+	std::exception_ptr m_Exception;
+};
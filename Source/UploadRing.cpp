@@ -0,0 +1,30 @@
+#include "PCH.h"
+#include "UploadRing.h"
+#include "Heap.h"
+#include "DX12Utility.h"
+
+UploadRing::~UploadRing()
+{
+	if (m_Resource)
+	{
+		m_Resource->Unmap(0, nullptr);
+	}
+}
+
+void UploadRing::Create(ID3D12Device11* device, HeapManager* heap, UINT64 size)
+{
+	m_Resource = heap->CreateBufferResource(device, UploadHeap, D3D12_RESOURCE_STATE_GENERIC_READ, size);
+	const D3D12_RANGE readRange = { 0, 0 };
+	ThrowIfFailed(m_Resource->Map(0, &readRange, (void**)&m_Mapped));
+	m_Allocator.Reset(size);
+}
+
+UploadAllocation UploadRing::Allocate(UINT64 size, UINT64 alignment)
+{
+	const UINT64 offset = m_Allocator.Allocate(size, alignment);
+	if (offset == RingAllocator::InvalidOffset)
+	{
+		throw std::runtime_error("Upload ring is full");
+	}
+	return { m_Mapped + offset, m_Resource->GetGPUVirtualAddress() + offset };
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "PCH.h"
+#include "RingAllocator.h"
+
+class HeapManager;
+
+struct UploadAllocation
+{
+	void* CPUAddress;
+	D3D12_GPU_VIRTUAL_ADDRESS GPUAddress;
+};
+
+// Persistently mapped upload buffer handing out per-frame memory for data the CPU rewrites every frame.
+// A frame's region is only reused after the fence value passed to EndFrame has completed.
+class UploadRing
+{
+public:
+	~UploadRing();
+	void Create(ID3D12Device11* device, HeapManager* heap, UINT64 size);
+	UploadAllocation Allocate(UINT64 size, UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+	inline void BeginFrame(UINT64 completedFenceValue) { m_Allocator.Retire(completedFenceValue); }
+	inline void EndFrame(UINT64 fenceValue) { m_Allocator.EndFrame(fenceValue); }
+private:
+	Microsoft::WRL::ComPtr<ID3D12Resource2> m_Resource;
+	UINT8* m_Mapped = nullptr;
+	RingAllocator m_Allocator;
+};
@@ -0,0 +1,97 @@
+#include "PCH.h"
+#include "Upscaler.h"
+#include "ShaderCompiler.h"
+#include "RootSignatureGenerator.h"
+#include "DX12Utility.h"
+
+using Microsoft::WRL::ComPtr;
+
+static constexpr UINT ThreadGroupSize = 8; // numthreads in Upscale.hlsl
+
+// Root constants, same layout as UpscaleConstants in Upscale.hlsl
+struct UpscaleConstants
+{
+	UINT RenderWidth;
+	UINT RenderHeight;
+};
+
+// Root parameter order of the upscale root signature, the tables are u0 and u1 in Upscale.hlsl
+enum UpscaleParameter
+{
+	ParameterConstants,
+	ParameterOutput,
+	ParameterDisplay,
+	ParameterCount
+};
+
+void Upscaler::Create(ID3D12Device11* device, DescriptorHeap* descriptorHeap, ShaderCompiler* shaderCompiler, UINT width, UINT height)
+{
+	m_Device = device;
+	m_DescriptorHeap = descriptorHeap;
+	m_DisplayDescriptor = descriptorHeap->AllocatePersistent();
+	CreatePipeline(shaderCompiler);
+	Resize(width, height);
+}
+
+void Upscaler::CreatePipeline(ShaderCompiler* shaderCompiler)
+{
+	D3D12_ROOT_PARAMETER constants = {};
+	constants.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+	constants.Constants.ShaderRegister = 0;
+	constants.Constants.RegisterSpace = 0;
+	constants.Constants.Num32BitValues = sizeof(UpscaleConstants) / 4;
+	constants.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+	D3D12_DESCRIPTOR_RANGE ranges[ParameterCount - 1] = {};
+	RootSignatureGenerator rootSignatureGenerator(m_Device);
+	rootSignatureGenerator.AddParameter(constants);
+	for (UINT i = 0; i < ParameterCount - 1; i++)
+	{
+		ranges[i].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+		ranges[i].NumDescriptors = 1;
+		ranges[i].BaseShaderRegister = i;
+		ranges[i].RegisterSpace = 0;
+		ranges[i].OffsetInDescriptorsFromTableStart = 0;
+
+		D3D12_ROOT_PARAMETER table = {};
+		table.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+		table.DescriptorTable.NumDescriptorRanges = 1;
+		table.DescriptorTable.pDescriptorRanges = &ranges[i];
+		table.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		rootSignatureGenerator.AddParameter(table);
+	}
+	m_RootSignature = rootSignatureGenerator.Generate();
+
+	ComPtr<IDxcBlob> shader = shaderCompiler->CompileShader(L"Shaders/Upscale.hlsl", L"Upscale", ShaderCompiler::ComputeTarget);
+	D3D12_COMPUTE_PIPELINE_STATE_DESC pipelineDesc = {};
+	pipelineDesc.pRootSignature = m_RootSignature.Get();
+	pipelineDesc.CS = { shader->GetBufferPointer(), shader->GetBufferSize() };
+	ThrowIfFailed(m_Device->CreateComputePipelineState(&pipelineDesc, IID_PPV_ARGS(&m_PipelineState)));
+}
+
+void Upscaler::Resize(UINT width, UINT height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+	m_Width = width;
+	m_Height = height;
+	// Same format as the back buffers, so it can be copied to them
+	m_Display.Create(m_Device, width, height, m_DescriptorHeap->GetCPUHandle(m_DisplayDescriptor), DXGI_FORMAT_R8G8B8A8_UNORM, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+}
+
+void Upscaler::Record(ID3D12GraphicsCommandList6* commandList, D3D12_GPU_DESCRIPTOR_HANDLE output, UINT renderWidth, UINT renderHeight)
+{
+	// Reads what the ray dispatch or the passes after it wrote
+	D3D12_RESOURCE_BARRIER barrier = {};
+	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+	barrier.UAV.pResource = nullptr;
+	commandList->ResourceBarrier(1, &barrier);
+
+	const UpscaleConstants constants = { renderWidth, renderHeight };
+	commandList->SetComputeRootSignature(m_RootSignature.Get());
+	commandList->SetPipelineState(m_PipelineState.Get());
+	commandList->SetComputeRoot32BitConstants(ParameterConstants, sizeof(constants) / 4, &constants, 0);
+	commandList->SetComputeRootDescriptorTable(ParameterOutput, output);
+	commandList->SetComputeRootDescriptorTable(ParameterDisplay, m_DescriptorHeap->GetGPUHandle(m_DisplayDescriptor));
+	commandList->Dispatch((m_Width + ThreadGroupSize - 1) / ThreadGroupSize, (m_Height + ThreadGroupSize - 1) / ThreadGroupSize, 1);
+}
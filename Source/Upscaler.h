@@ -0,0 +1,31 @@
+#pragma once
+#include "PCH.h"
+#include "OutputBuffer.h"
+#include "DescriptorHeap.h"
+
+class ShaderCompiler;
+
+// Stretches the output rendered at a lower resolution to the back buffer size, one compute dispatch before
+// SwapChain::PrepareFrameEnd copies the result, see Upscale.hlsl. Owns the back buffer sized display texture.
+class Upscaler
+{
+public:
+	void Create(ID3D12Device11* device, DescriptorHeap* descriptorHeap, ShaderCompiler* shaderCompiler, UINT width, UINT height);
+	// The caller has flushed the queue, like SwapChain::Resize
+	void Resize(UINT width, UINT height);
+	// Output is in UNORDERED_ACCESS with the image in its top left renderWidth by renderHeight pixels,
+	// the descriptor heap is already set on the list
+	void Record(ID3D12GraphicsCommandList6* commandList, D3D12_GPU_DESCRIPTOR_HANDLE output, UINT renderWidth, UINT renderHeight);
+	// In UNORDERED_ACCESS, like the output
+	inline ID3D12Resource2* GetDisplay() { return m_Display.GetResource(); }
+private:
+	void CreatePipeline(ShaderCompiler* shaderCompiler);
+	ID3D12Device11* m_Device = nullptr;
+	DescriptorHeap* m_DescriptorHeap = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_RootSignature;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_PipelineState;
+	OutputBuffer m_Display;
+	DescriptorRange m_DisplayDescriptor;
+	UINT m_Width = 0;
+	UINT m_Height = 0;
+};
@@ -0,0 +1,137 @@
+// Records passes on a ThreadPool through the device-free RecordedCommandBackend, checks that lists are submitted in
+// pass order with recordLast passes recorded after all others, and prints the recording time of every pass.
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -pthread -I Source -o CommandSchedulerTest Tests/CommandSchedulerTest.cpp Source/RecordedCommandBackend.cpp Source/ThreadPool.cpp Source/Profiler.cpp && ./CommandSchedulerTest
+#include "CommandScheduler.h"
+#include "RecordedCommandBackend.h"
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	int g_Failures = 0;
+
+	void Check(bool condition, const char* message)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", message);
+			g_Failures++;
+		}
+	}
+
+	// Like Application's PassOrder
+	enum PassOrder
+	{
+		PassAccelerationStructure = 0,
+		PassRaytrace = 1,
+		PassFrameEnd = 2
+	};
+
+	struct DrawCommand
+	{
+		uint32_t Pass;
+		uint32_t Index;
+		float Constants[8];
+	};
+
+	constexpr uint32_t PassCount = 24;
+	constexpr uint32_t FrameCount = 50;
+	char g_PassNames[PassCount][16]; // pass names must outlive the scheduler's timings
+
+	// Pass i has order i % 2, added in reverse so the scheduler has to sort; one resolve pass records last
+	void TestSubmissionOrder(ThreadPool* threadPool)
+	{
+		RecordedCommandBackend backend;
+		CommandScheduler<RecordedCommandBackend> scheduler;
+		for (uint32_t pass = 0; pass < PassCount; pass++)
+		{
+			std::snprintf(g_PassNames[pass], sizeof(g_PassNames[pass]), "Pass %u", pass);
+		}
+		for (uint32_t frame = 0; frame < FrameCount; frame++)
+		{
+			backend.BeginFrame();
+			backend.ClearSubmitted();
+			std::atomic<uint32_t> recorded = 0;
+			bool resolveSawAll = false;
+			for (uint32_t pass = PassCount; pass-- > 0;)
+			{
+				scheduler.AddPass(g_PassNames[pass], pass % 2 == 0 ? PassAccelerationStructure : PassRaytrace, [pass, &recorded](RecordedCommandBackend::CommandList* list)
+				{
+					// The pass id goes first, the rest is a few thousand commands of recording work
+					for (uint32_t i = 0; i < 2000 + pass * 100; i++)
+					{
+						list->Write(pass, DrawCommand{ pass, i, {} });
+					}
+					recorded++;
+				});
+			}
+			scheduler.AddPass("Resolve", PassFrameEnd, [&](RecordedCommandBackend::CommandList* list)
+			{
+				resolveSawAll = recorded == PassCount;
+				list->Write(PassCount, DrawCommand{ PassCount, 0, {} });
+			}, true);
+			scheduler.Record(&backend, threadPool);
+			scheduler.Submit(&backend);
+
+			Check(resolveSawAll, "recordLast pass recorded after the others");
+			const std::vector<RecordedCommandBackend::SubmittedList>& submitted = backend.GetSubmitted();
+			Check(submitted.size() == PassCount + 1, "every list submitted");
+			if (submitted.size() != PassCount + 1)
+				return;
+			// Stable within an order: the odd passes were added 23, 21, ... so they keep that order
+			std::vector<uint32_t> expected;
+			for (uint32_t pass = PassCount; pass-- > 0;)
+				if (pass % 2 == 0)
+					expected.push_back(pass);
+			for (uint32_t pass = PassCount; pass-- > 0;)
+				if (pass % 2 == 1)
+					expected.push_back(pass);
+			expected.push_back(PassCount);
+			for (uint32_t i = 0; i < submitted.size(); i++)
+			{
+				Check(submitted[i].FirstOpcode == expected[i], "submitted in pass order");
+				const uint32_t commands = expected[i] == PassCount ? 1 : 2000 + expected[i] * 100;
+				Check(submitted[i].CommandCount == commands, "command count");
+			}
+		}
+		std::printf("Recording times of the last frame:\n");
+		for (const CommandScheduler<RecordedCommandBackend>::PassTiming& timing : scheduler.GetTimings())
+		{
+			std::printf("  %-8s %.3f ms\n", timing.Name, timing.RecordMilliseconds);
+		}
+	}
+
+	// A list is closed by the scheduler exactly once
+	void TestCloseTwice()
+	{
+		RecordedCommandBackend backend;
+		RecordedCommandBackend::CommandList* list = backend.Acquire();
+		backend.Close(list);
+		bool threw = false;
+		try
+		{
+			backend.Close(list);
+		}
+		catch (const std::runtime_error&)
+		{
+			threw = true;
+		}
+		Check(threw, "closing twice throws");
+	}
+}
+
+int main()
+{
+	// Fixed worker count, so the passes record concurrently on any machine
+	ThreadPool threadPool(4);
+	std::printf("%u worker threads\n", threadPool.GetWorkerCount());
+	TestSubmissionOrder(&threadPool);
+	TestCloseTwice();
+	if (g_Failures != 0)
+		return 1;
+	std::printf("CommandScheduler tests passed\n");
+	return 0;
+}
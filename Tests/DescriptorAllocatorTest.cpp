@@ -0,0 +1,98 @@
+// Checks DescriptorAllocator's persistent and transient regions against a simulated fence.
+// Build and run from the repository root:
+//   g++ -O2 -std=c++20 -I Source -o DescriptorAllocatorTest Tests/DescriptorAllocatorTest.cpp Source/DescriptorAllocator.cpp Source/OffsetAllocator.cpp Source/RingAllocator.cpp && ./DescriptorAllocatorTest
+#include "DescriptorAllocator.h"
+#include <cstdio>
+
+namespace
+{
+	int g_Failures = 0;
+
+	void Check(bool condition, const char* message)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", message);
+			g_Failures++;
+		}
+	}
+
+	bool Overlaps(const DescriptorAllocator::Range& a, const DescriptorAllocator::Range& b)
+	{
+		return a.Index < b.Index + b.Count && b.Index < a.Index + a.Count;
+	}
+
+	// A freed range is handed out again, and the heap refuses ranges it cannot fit
+	void TestReuseAfterFree()
+	{
+		DescriptorAllocator allocator;
+		allocator.Reset(16, 16);
+		const DescriptorAllocator::Range a = allocator.AllocatePersistent(8);
+		const DescriptorAllocator::Range b = allocator.AllocatePersistent(8);
+		Check(a.IsValid() && b.IsValid(), "two halves");
+		Check(!Overlaps(a, b), "halves overlap");
+		Check(allocator.GetPersistentUsed() == 16, "persistent region full");
+		Check(!allocator.AllocatePersistent(1).IsValid(), "full region refuses allocations");
+		allocator.Free(a);
+		Check(allocator.GetPersistentUsed() == 8, "used after free");
+		const DescriptorAllocator::Range c = allocator.AllocatePersistent(8);
+		Check(c.IsValid() && c.Index == a.Index, "freed range reused");
+		allocator.Free(b);
+		allocator.Free(c);
+		Check(allocator.GetPersistentUsed() == 0, "everything freed");
+		Check(allocator.AllocatePersistent(16).IsValid(), "freed halves coalesce");
+	}
+
+	// A deferred free keeps its range until the fence of the frame that freed it completes
+	void TestDeferredFree()
+	{
+		DescriptorAllocator allocator;
+		allocator.Reset(4, 16);
+		const DescriptorAllocator::Range a = allocator.AllocatePersistent(4);
+		allocator.FreeDeferred(a);
+		Check(allocator.GetPersistentUsed() == 4, "reserved until the frame ends");
+		Check(!allocator.AllocatePersistent(1).IsValid(), "pending range is not handed out");
+		allocator.EndFrame(1);
+		allocator.Retire(0);
+		Check(allocator.GetPersistentUsed() == 4, "reserved while the frame is in flight");
+		Check(!allocator.AllocatePersistent(1).IsValid(), "range in flight is not handed out");
+		allocator.EndFrame(2);
+		allocator.Retire(1);
+		Check(allocator.GetPersistentUsed() == 0, "released once its fence completed");
+		const DescriptorAllocator::Range b = allocator.AllocatePersistent(4);
+		Check(b.IsValid() && b.Index == a.Index, "retired range reused");
+	}
+
+	// Transient indices start after the persistent region, wrap around the ring and fail when it is full
+	void TestTransient()
+	{
+		DescriptorAllocator allocator;
+		allocator.Reset(100, 32);
+		Check(allocator.GetTransientCount() == 32, "transient count");
+		Check(allocator.AllocateTransient(16) == 100, "first transient index is the persistent count");
+		allocator.EndFrame(1);
+		Check(allocator.AllocateTransient(16) == 116, "second frame");
+		allocator.EndFrame(2);
+		Check(allocator.GetTransientUsed() == 32, "ring full");
+		Check(allocator.AllocateTransient(1) == DescriptorAllocator::InvalidIndex, "full ring refuses allocations");
+		allocator.Retire(1);
+		Check(allocator.AllocateTransient(16) == 100, "wraps into the retired frame");
+		Check(allocator.AllocateTransient(1) == DescriptorAllocator::InvalidIndex, "full again after the wrap");
+		allocator.EndFrame(3);
+		allocator.Retire(3);
+		Check(allocator.GetTransientUsed() == 0, "everything retired");
+		const DescriptorAllocator::Range persistent = allocator.AllocatePersistent(100);
+		Check(persistent.IsValid() && persistent.Index == 0, "transient use leaves the persistent region alone");
+	}
+}
+
+int main()
+{
+	TestReuseAfterFree();
+	TestDeferredFree();
+	TestTransient();
+	if (g_Failures != 0)
+		return 1;
+	std::printf("DescriptorAllocator tests passed\n");
+	return 0;
+}
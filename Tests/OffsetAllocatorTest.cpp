@@ -0,0 +1,195 @@
+// Drives OffsetAllocator with random allocations and frees and checks placement, coalescing and compaction.
+// Build and run from the repository root:
+//   g++ -O2 -std=c++20 -I Source -o OffsetAllocatorTest Tests/OffsetAllocatorTest.cpp Source/OffsetAllocator.cpp && ./OffsetAllocatorTest
+#include "OffsetAllocator.h"
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+	int g_Failures = 0;
+
+	void Check(bool condition, const char* message)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", message);
+			g_Failures++;
+		}
+	}
+
+	struct Block
+	{
+		uint64_t Size;
+		uint64_t Alignment;
+		uint32_t Node;
+	};
+
+	// Live allocations by offset, so an overlap only needs a look at the two neighbours
+	using BlockMap = std::map<uint64_t, Block>;
+
+	bool Insert(BlockMap* blocks, uint64_t offset, const Block& block)
+	{
+		const auto next = blocks->lower_bound(offset);
+		if (next != blocks->end() && next->first < offset + block.Size)
+			return false;
+		if (next != blocks->begin() && std::prev(next)->first + std::prev(next)->second.Size > offset)
+			return false;
+		blocks->emplace(offset, block);
+		return true;
+	}
+
+	void FreeAll(OffsetAllocator* allocator, BlockMap* blocks)
+	{
+		for (const auto& entry : *blocks)
+		{
+			OffsetAllocator::Allocation allocation;
+			allocation.Offset = entry.first;
+			allocation.Node = entry.second.Node;
+			allocator->Free(allocation);
+		}
+		blocks->clear();
+	}
+
+	// Random sizes and alignments, freed in random order, then everything freed has to merge into one block again
+	void TestRandomAllocations()
+	{
+		const uint64_t size = 1 << 20;
+		std::mt19937 random(1);
+		OffsetAllocator allocator(size);
+		BlockMap blocks;
+		uint64_t used = 0;
+		uint32_t failed = 0;
+		for (uint32_t step = 0; step < 200000; step++)
+		{
+			if (blocks.empty() || random() % 100 < 55)
+			{
+				// Mostly small blocks with the occasional large one, the way resources fill a heap
+				const uint64_t blockSize = random() % 16 == 0 ? 1 + random() % 65536 : 1 + random() % 2048;
+				const uint64_t alignment = 1ULL << (random() % 13);
+				OffsetAllocator::Allocation allocation;
+				if (!allocator.Allocate(blockSize, alignment, &allocation))
+				{
+					failed++;
+					continue;
+				}
+				Check(allocation.Offset % alignment == 0, "aligned");
+				Check(allocation.Offset + blockSize <= size, "inside the range");
+				Check(Insert(&blocks, allocation.Offset, { blockSize, alignment, allocation.Node }), "overlaps a live allocation");
+				used += blockSize;
+			}
+			else
+			{
+				auto victim = blocks.begin();
+				std::advance(victim, random() % blocks.size());
+				OffsetAllocator::Allocation allocation;
+				allocation.Offset = victim->first;
+				allocation.Node = victim->second.Node;
+				allocator.Free(allocation);
+				used -= victim->second.Size;
+				blocks.erase(victim);
+			}
+			Check(allocator.GetAllocationCount() == blocks.size(), "allocation count");
+			Check(allocator.GetUsedSize() == used, "used size");
+		}
+		Check(failed > 0, "the heap filled up at times");
+		Check(allocator.GetLargestFreeBlock() < size, "fragmented while allocations are live");
+		FreeAll(&allocator, &blocks);
+		Check(allocator.GetUsedSize() == 0, "everything freed");
+		Check(allocator.GetAllocationCount() == 0, "no allocations left");
+		Check(allocator.GetLargestFreeBlock() == size, "free blocks coalesced into one");
+		OffsetAllocator::Allocation whole;
+		Check(allocator.Allocate(size, 1, &whole) && whole.Offset == 0, "whole range allocatable");
+	}
+
+	// Compaction packs the live allocations to the front, and moving their bytes in the returned order keeps their contents
+	void TestCompact()
+	{
+		const uint64_t size = 1 << 16;
+		std::mt19937 random(2);
+		OffsetAllocator allocator(size);
+		BlockMap blocks;
+		std::vector<uint8_t> memory(size);
+		for (uint32_t i = 0; i < 400; i++)
+		{
+			const uint64_t blockSize = 1 + random() % 256;
+			const uint64_t alignment = 1ULL << (random() % 5);
+			OffsetAllocator::Allocation allocation;
+			if (!allocator.Allocate(blockSize, alignment, &allocation))
+				break;
+			Insert(&blocks, allocation.Offset, { blockSize, alignment, allocation.Node });
+		}
+		// Free every other allocation to leave holes
+		bool keep = false;
+		for (auto entry = blocks.begin(); entry != blocks.end();)
+		{
+			keep = !keep;
+			if (keep)
+			{
+				++entry;
+				continue;
+			}
+			OffsetAllocator::Allocation allocation;
+			allocation.Offset = entry->first;
+			allocation.Node = entry->second.Node;
+			allocator.Free(allocation);
+			entry = blocks.erase(entry);
+		}
+		for (const auto& entry : blocks)
+			std::memset(&memory[entry.first], (int)(entry.second.Node & 0xFF) | 1, entry.second.Size);
+		const uint64_t used = allocator.GetUsedSize();
+		const uint32_t count = allocator.GetAllocationCount();
+		Check(allocator.GetLargestFreeBlock() < size - used, "holes before compaction");
+
+		std::vector<OffsetAllocator::Relocation> relocations;
+		allocator.Compact(&relocations);
+		Check(!relocations.empty(), "allocations moved");
+		std::map<uint32_t, uint64_t> offsets;
+		for (const auto& entry : blocks)
+			offsets[entry.second.Node] = entry.first;
+		for (const OffsetAllocator::Relocation& relocation : relocations)
+		{
+			Check(offsets[relocation.Node] == relocation.SourceOffset, "relocation source");
+			Check(relocation.DestinationOffset < relocation.SourceOffset, "allocations only move towards zero");
+			std::memmove(&memory[relocation.DestinationOffset], &memory[relocation.SourceOffset], relocation.Size);
+			offsets[relocation.Node] = relocation.DestinationOffset;
+		}
+		BlockMap compacted;
+		uint64_t padding = 0;
+		uint64_t end = 0;
+		for (const auto& entry : blocks)
+		{
+			const uint64_t offset = offsets[entry.second.Node];
+			Check(offset % entry.second.Alignment == 0, "alignment kept");
+			Check(Insert(&compacted, offset, entry.second), "compacted allocations overlap");
+			padding += offset - end;
+			end = offset + entry.second.Size;
+			bool intact = true;
+			for (uint64_t i = 0; i < entry.second.Size; i++)
+				intact = intact && memory[offset + i] == ((entry.second.Node & 0xFF) | 1);
+			Check(intact, "contents survive the relocations");
+		}
+		Check(padding < 16 * count, "only alignment padding between allocations");
+		Check(allocator.GetUsedSize() == used, "used size kept");
+		Check(allocator.GetAllocationCount() == count, "allocation count kept");
+		Check(allocator.GetLargestFreeBlock() == size - end, "free space is one block at the end");
+
+		// The nodes stay valid, so freeing at the new offsets coalesces back to the full range
+		FreeAll(&allocator, &compacted);
+		Check(allocator.GetLargestFreeBlock() == size, "free blocks coalesced after compaction");
+	}
+}
+
+int main()
+{
+	TestRandomAllocations();
+	TestCompact();
+	if (g_Failures != 0)
+		return 1;
+	std::printf("OffsetAllocator tests passed\n");
+	return 0;
+}
@@ -0,0 +1,127 @@
+// Feeds ResolutionController synthetic frame timings: a cost proportional to the pixel count with Gaussian noise,
+// reported two frames late like frames in flight. Checks that the scale settles within the budget and stays put.
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -I Source -o ResolutionControllerTest Tests/ResolutionControllerTest.cpp Source/ResolutionController.cpp && ./ResolutionControllerTest
+#include "ResolutionController.h"
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <random>
+
+namespace
+{
+	int g_Failures = 0;
+
+	void Check(bool condition, const char* message)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", message);
+			g_Failures++;
+		}
+	}
+
+	constexpr uint32_t Latency = 2; // frames between choosing a scale and timing the frame rendered with it
+	constexpr float Noise = 0.05f; // standard deviation relative to the frame time
+	constexpr uint32_t SettleFrames = 300;
+	constexpr uint32_t MeasuredFrames = 1500;
+
+	// Box-Muller rather than std::normal_distribution, whose output differs between standard libraries
+	float GetNoiseFactor(std::mt19937* random)
+	{
+		const double u1 = ((*random)() + 1.0) / 4294967297.0;
+		const double u2 = (*random)() / 4294967296.0;
+		return 1.0f + Noise * (float)(std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2));
+	}
+
+	struct LoadResult
+	{
+		float Scale; // at the end
+		uint32_t Changes; // after settling
+		float MeanFrameTime; // after settling, milliseconds
+		uint32_t FramesOverBudget; // after settling, by their noise-free cost
+	};
+
+	// fullCost is the frame time at full resolution, in milliseconds
+	LoadResult RunLoad(float fullCost, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		ResolutionController controller;
+		const float budget = controller.GetSettings().TargetFrameTime;
+		std::deque<float> inFlight(Latency, 1.0f);
+		float scale = 1.0f;
+		LoadResult result = {};
+		double timeSum = 0.0;
+		for (uint32_t frame = 0; frame < SettleFrames + MeasuredFrames; frame++)
+		{
+			inFlight.push_back(scale);
+			const float renderedScale = inFlight.front();
+			inFlight.pop_front();
+			const float cost = fullCost * renderedScale * renderedScale;
+			const float nextScale = controller.Update(cost * GetNoiseFactor(&random));
+			if (frame >= SettleFrames)
+			{
+				if (nextScale != scale)
+					result.Changes++;
+				timeSum += cost;
+				if (cost > budget)
+					result.FramesOverBudget++;
+			}
+			scale = nextScale;
+		}
+		result.Scale = scale;
+		result.MeanFrameTime = (float)(timeSum / MeasuredFrames);
+		return result;
+	}
+
+	// Costs from well within the budget to twice the lowest scale's reach
+	void TestSteadyLoads()
+	{
+		const float costs[] = { 10.0f, 16.0f, 17.0f, 20.0f, 25.0f, 30.0f, 45.0f, 60.0f };
+		for (float cost : costs)
+		{
+			for (uint32_t seed = 1; seed <= 5; seed++)
+			{
+				const LoadResult result = RunLoad(cost, seed);
+				std::printf("%5.1f ms at full resolution, seed %u: scale %.2f, %.2f ms, %u changes, %u frames over budget\n", cost, seed, result.Scale, result.MeanFrameTime, result.Changes, result.FramesOverBudget);
+				// A load right at the edge of the band may cross it once in a while, a change restarts accumulation
+				Check(result.Changes <= 2, "scale stays put once settled");
+				if (cost * 0.25f < 1000.0f / 60.0f)
+					Check(result.FramesOverBudget == 0, "settled within the budget");
+				if (cost < 1000.0f / 60.0f * 0.85f)
+					Check(result.Scale == 1.0f, "full resolution when it fits");
+			}
+		}
+	}
+
+	// The load triples mid-run, the scale has to follow within a few settle periods, then come back when it drops
+	void TestLoadChange()
+	{
+		std::mt19937 random(7);
+		ResolutionController controller;
+		const float budget = controller.GetSettings().TargetFrameTime;
+		float scale = 1.0f;
+		uint32_t firstInBudget = 0;
+		for (uint32_t frame = 0; frame < 600; frame++)
+		{
+			const float fullCost = frame < 200 || frame >= 400 ? 10.0f : 30.0f;
+			const float cost = fullCost * scale * scale;
+			if (frame >= 200 && frame < 400 && firstInBudget == 0 && cost <= budget)
+				firstInBudget = frame;
+			scale = controller.Update(cost * GetNoiseFactor(&random));
+		}
+		std::printf("Load change: within budget %u frames after the load tripled, scale %.2f after it dropped\n", firstInBudget - 200, scale);
+		Check(firstInBudget != 0 && firstInBudget - 200 <= 60, "follows a load increase");
+		Check(scale == 1.0f, "returns to full resolution");
+	}
+}
+
+int main()
+{
+	TestSteadyLoads();
+	TestLoadChange();
+	if (g_Failures != 0)
+		return 1;
+	std::printf("ResolutionController tests passed\n");
+	return 0;
+}
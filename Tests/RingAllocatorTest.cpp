@@ -0,0 +1,123 @@
+// Drives RingAllocator with a simulated fence and checks that no allocation overlaps memory of a frame still in flight.
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -I Source -o RingAllocatorTest Tests/RingAllocatorTest.cpp Source/RingAllocator.cpp && ./RingAllocatorTest
+#include "RingAllocator.h"
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace
+{
+	int g_Failures = 0;
+
+	void Check(bool condition, const char* message)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", message);
+			g_Failures++;
+		}
+	}
+
+	struct Range
+	{
+		uint64_t Offset;
+		uint64_t Size;
+	};
+
+	bool Overlaps(const Range& a, const Range& b)
+	{
+		return a.Offset < b.Offset + b.Size && b.Offset < a.Offset + a.Size;
+	}
+
+	// Two frames fill the ring exactly, leaving head == tail once the first one retires
+	void TestFullAfterWrap()
+	{
+		RingAllocator ring(256);
+		Check(ring.Allocate(128, 1) == 0, "first half");
+		ring.EndFrame(1);
+		Check(ring.Allocate(128, 1) == 128, "second half");
+		ring.EndFrame(2);
+		ring.Retire(1);
+		Check(ring.Allocate(128, 1) == 0, "wrap into the retired frame");
+		Check(ring.GetUsedSize() == 256, "ring is full");
+		Check(ring.Allocate(64, 1) == RingAllocator::InvalidOffset, "full ring refuses allocations");
+		ring.EndFrame(3);
+		ring.Retire(2);
+		Check(ring.Allocate(64, 1) == 128, "space of the retired second frame");
+	}
+
+	// A frame ending exactly at the tail also fills the ring
+	void TestFullBeforeTail()
+	{
+		RingAllocator ring(256);
+		Check(ring.Allocate(192, 1) == 0, "first frame");
+		ring.EndFrame(1);
+		Check(ring.Allocate(64, 1) == 192, "second frame");
+		ring.EndFrame(2);
+		ring.Retire(1);
+		Check(ring.Allocate(192, 1) == 0, "wrapped frame");
+		ring.EndFrame(3);
+		ring.Retire(2);
+		Check(ring.Allocate(64, 1) == 192, "up to the tail");
+		Check(ring.Allocate(1, 1) == RingAllocator::InvalidOffset, "head at the tail is full, not empty");
+	}
+
+	// Random sizes and alignments with the GPU lagging a few frames behind
+	void TestSimulatedFrames()
+	{
+		std::mt19937 random(1);
+		RingAllocator ring(4096);
+		std::deque<std::pair<uint64_t, std::vector<Range>>> inFlight;
+		std::vector<Range> current;
+		uint64_t completed = 0;
+		for (uint64_t frame = 1; frame <= 10000; frame++)
+		{
+			const uint32_t count = random() % 8;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const uint64_t size = 1 + random() % 700;
+				const uint64_t alignment = 1ULL << (random() % 9);
+				const uint64_t offset = ring.Allocate(size, alignment);
+				if (offset == RingAllocator::InvalidOffset)
+					continue;
+				const Range range = { offset, size };
+				Check(offset % alignment == 0, "aligned");
+				Check(offset + size <= ring.GetSize(), "inside the ring");
+				for (const Range& other : current)
+					Check(!Overlaps(range, other), "overlaps the current frame");
+				for (const auto& previous : inFlight)
+					for (const Range& other : previous.second)
+						Check(!Overlaps(range, other), "overlaps a frame in flight");
+				current.push_back(range);
+			}
+			ring.EndFrame(frame);
+			inFlight.emplace_back(frame, std::move(current));
+			current.clear();
+			// The simulated fence completes 0 to 3 frames at a time, never more than 3 behind
+			completed += random() % 4;
+			if (completed + 3 < frame)
+				completed = frame - 3;
+			if (completed > frame)
+				completed = frame;
+			ring.Retire(completed);
+			while (!inFlight.empty() && inFlight.front().first <= completed)
+				inFlight.pop_front();
+			Check(ring.GetFramesInFlight() == inFlight.size(), "frames in flight");
+		}
+		ring.Retire(~0ULL);
+		Check(ring.GetUsedSize() == 0, "everything retired");
+	}
+}
+
+int main()
+{
+	TestFullAfterWrap();
+	TestFullBeforeTail();
+	TestSimulatedFrames();
+	if (g_Failures != 0)
+		return 1;
+	std::printf("RingAllocator tests passed\n");
+	return 0;
+}
@@ -0,0 +1,110 @@
+// Checks ShaderCache's keys and entries on shader files written to a temporary directory.
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -I Source -o ShaderCacheTest Tests/ShaderCacheTest.cpp Source/ShaderCache.cpp && ./ShaderCacheTest
+#include "ShaderCache.h"
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+	int g_Failures = 0;
+
+	void Check(bool condition, const char* message)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", message);
+			g_Failures++;
+		}
+	}
+
+	void WriteFile(const std::filesystem::path& path, const std::string& contents)
+	{
+		std::filesystem::create_directories(path.parent_path());
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file << contents;
+	}
+
+	// Main.hlsl includes Common.hlsli, which includes Lib/Math.hlsli and, through it, itself again
+	void WriteShaders(const std::filesystem::path& directory)
+	{
+		WriteFile(directory / "Main.hlsl", "#include \"Common.hlsli\"\n[shader(\"raygeneration\")] void RayGen() {}\n");
+		WriteFile(directory / "Common.hlsli", "#pragma once\n  #  include \"Lib/Math.hlsli\"\nstatic const float Pi = 3.14159265f;\n");
+		WriteFile(directory / "Lib" / "Math.hlsli", "#include \"../Common.hlsli\"\nfloat Square(float x) { return x * x; }\n");
+	}
+
+	void TestKeys(const std::filesystem::path& directory)
+	{
+		WriteShaders(directory);
+		const ShaderCache cache(directory / "Cache");
+		const std::filesystem::path source = directory / "Main.hlsl";
+		const std::vector<std::wstring> arguments = { L"-T", L"lib_6_3", L"-O3" };
+		const uint64_t key = cache.ComputeKey(source, arguments);
+		Check(cache.ComputeKey(source, arguments) == key, "key is stable");
+
+		// An edit two includes down misses the cache, undoing it hits again
+		WriteFile(directory / "Lib" / "Math.hlsli", "#include \"../Common.hlsli\"\nfloat Square(float x) { return x * x * 1.0f; }\n");
+		Check(cache.ComputeKey(source, arguments) != key, "transitive include edit changes the key");
+		WriteShaders(directory);
+		Check(cache.ComputeKey(source, arguments) == key, "reverted edit restores the key");
+
+		Check(cache.ComputeKey(source, { L"-T", L"lib_6_3", L"-O2" }) != key, "argument change changes the key");
+		Check(cache.ComputeKey(source, { L"-T", L"lib_6_3" }) != key, "dropped argument changes the key");
+		Check(cache.ComputeKey(source, { L"-T", L"lib_6_3-O3" }) != key, "arguments are not just concatenated");
+
+		// A missing include is hashed as such, so creating it later changes the key
+		WriteFile(directory / "Common.hlsli", "#include \"Missing.hlsli\"\n");
+		const uint64_t missingKey = cache.ComputeKey(source, arguments);
+		WriteFile(directory / "Missing.hlsli", "\n");
+		Check(cache.ComputeKey(source, arguments) != missingKey, "created include changes the key");
+		WriteShaders(directory);
+
+		bool threw = false;
+		try
+		{
+			cache.ComputeKey(directory / "Absent.hlsl", arguments);
+		}
+		catch (const std::runtime_error&)
+		{
+			threw = true;
+		}
+		Check(threw, "missing root file throws");
+	}
+
+	void TestEntries(const std::filesystem::path& directory)
+	{
+		const ShaderCache cache(directory / "Cache");
+		std::vector<uint8_t> binary(4099);
+		for (size_t i = 0; i < binary.size(); i++)
+			binary[i] = (uint8_t)(i * 7);
+		std::vector<uint8_t> loaded;
+		Check(!cache.Load(42, &loaded), "empty cache misses");
+		cache.Store(42, binary.data(), binary.size());
+		Check(cache.Load(42, &loaded) && loaded == binary, "stored binary loads back unchanged");
+		Check(!cache.Load(43, &loaded), "other key misses");
+
+		// Storing again replaces the entry and leaves no temporary files behind
+		binary.resize(16);
+		cache.Store(42, binary.data(), binary.size());
+		Check(cache.Load(42, &loaded) && loaded == binary, "replaced entry loads back");
+		size_t files = 0;
+		for (const auto& entry : std::filesystem::directory_iterator(directory / "Cache"))
+			files += entry.is_regular_file() ? 1 : 0;
+		Check(files == 1, "only the entry is left in the cache directory");
+	}
+}
+
+int main()
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / ("ShaderCacheTest-" + std::to_string(std::random_device()()));
+	TestKeys(directory);
+	TestEntries(directory);
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+	if (g_Failures != 0)
+		return 1;
+	std::printf("ShaderCache tests passed\n");
+	return 0;
+}
@@ -0,0 +1,101 @@
+// Checks ShaderTableLayout's strides, section offsets and size limit against the D3D12 alignment rules.
+// Build and run from the repository root:
+//   g++ -O2 -std=c++17 -I Source -o ShaderTableLayoutTest Tests/ShaderTableLayoutTest.cpp Source/ShaderTableLayout.cpp && ./ShaderTableLayoutTest
+#include "ShaderTableLayout.h"
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+	int g_Failures = 0;
+
+	void Check(bool condition, const char* message)
+	{
+		if (!condition)
+		{
+			std::printf("FAILED: %s\n", message);
+			g_Failures++;
+		}
+	}
+
+	// One raygen record with 8 bytes of arguments, three miss records without, two hit groups with 16 and 40 bytes
+	// and no callables
+	void TestLayout()
+	{
+		ShaderTableLayout layout;
+		Check(layout.AddRecord(ShaderTableLayout::SectionRayGen, 8) == 0, "raygen index");
+		for (uint32_t i = 0; i < 3; i++)
+			Check(layout.AddRecord(ShaderTableLayout::SectionMiss, 0) == i, "miss index");
+		Check(layout.AddRecord(ShaderTableLayout::SectionHitGroup, 16) == 0, "first hit group index");
+		Check(layout.AddRecord(ShaderTableLayout::SectionHitGroup, 40) == 1, "second hit group index");
+		layout.Finalize();
+
+		// The stride is the identifier plus the largest arguments in the section, rounded up to 32 bytes
+		Check(layout.GetStride(ShaderTableLayout::SectionRayGen) == 64, "raygen stride 32 + 8 rounds to 64");
+		Check(layout.GetStride(ShaderTableLayout::SectionMiss) == 32, "miss stride is the identifier alone");
+		Check(layout.GetStride(ShaderTableLayout::SectionHitGroup) == 96, "hit group stride 32 + 40 rounds to 96");
+		Check(layout.GetStride(ShaderTableLayout::SectionCallable) == 0, "empty callable stride");
+
+		// Sections follow each other in enum order, each starting on a 64 byte boundary
+		Check(layout.GetSectionOffset(ShaderTableLayout::SectionRayGen) == 0, "raygen offset");
+		Check(layout.GetSectionOffset(ShaderTableLayout::SectionMiss) == 64, "miss offset");
+		Check(layout.GetSectionSize(ShaderTableLayout::SectionMiss) == 96, "miss size");
+		Check(layout.GetSectionOffset(ShaderTableLayout::SectionHitGroup) == 192, "hit group offset rounds 160 up to 192");
+		Check(layout.GetRecordOffset(ShaderTableLayout::SectionHitGroup, 1) == 288, "second hit group record offset");
+		Check(layout.GetSectionOffset(ShaderTableLayout::SectionCallable) == 384, "empty callable section offset");
+		Check(layout.GetSectionSize(ShaderTableLayout::SectionCallable) == 0, "empty callable section size");
+		for (int section = 0; section < ShaderTableLayout::SectionCount; section++)
+			Check(layout.GetSectionOffset((ShaderTableLayout::Section)section) % ShaderTableLayout::TableAlignment == 0, "section offset aligned");
+
+		Check(layout.GetTotalSize() == 384, "total size");
+		Check(layout.GetTotalRecordCount() == 6, "total record count");
+		Check(layout.GetRecordKey(ShaderTableLayout::SectionMiss, 2) == 3, "miss record key");
+		Check(layout.GetRecordKey(ShaderTableLayout::SectionHitGroup, 0) == 4, "hit group record key");
+	}
+
+	// A section ending off a table boundary pads the total size
+	void TestTotalSizePadding()
+	{
+		ShaderTableLayout layout;
+		layout.AddRecord(ShaderTableLayout::SectionRayGen, 0);
+		layout.Finalize();
+		Check(layout.GetSectionSize(ShaderTableLayout::SectionRayGen) == 32, "single identifier");
+		Check(layout.GetTotalSize() == 64, "total size padded to 64");
+		layout.Reset();
+		layout.Finalize();
+		Check(layout.GetTotalSize() == 0, "empty after reset");
+		Check(layout.GetTotalRecordCount() == 0, "no records after reset");
+	}
+
+	// Records up to 4096 bytes are accepted, larger ones throw and leave the layout unchanged
+	void TestMaxRecordStride()
+	{
+		ShaderTableLayout layout;
+		const uint32_t largestArguments = ShaderTableLayout::MaxRecordStride - ShaderTableLayout::IdentifierSize;
+		layout.AddRecord(ShaderTableLayout::SectionHitGroup, largestArguments);
+		bool threw = false;
+		try
+		{
+			layout.AddRecord(ShaderTableLayout::SectionHitGroup, largestArguments + 1);
+		}
+		catch (const std::runtime_error&)
+		{
+			threw = true;
+		}
+		Check(threw, "record above 4096 bytes throws");
+		Check(layout.GetRecordCount(ShaderTableLayout::SectionHitGroup) == 1, "rejected record not added");
+		layout.Finalize();
+		Check(layout.GetStride(ShaderTableLayout::SectionHitGroup) == 4096, "largest stride");
+	}
+}
+
+int main()
+{
+	TestLayout();
+	TestTotalSizePadding();
+	TestMaxRecordStride();
+	if (g_Failures != 0)
+		return 1;
+	std::printf("ShaderTableLayout tests passed\n");
+	return 0;
+}